@@ -0,0 +1,2744 @@
+#include "Benchmark.h"
+#include "SceneGraph.h"
+#include "TransformHierarchy.h"
+#include "BoundingVolumeHierarchy.h"
+#include "JobSystem.h"
+#include "RenderQueue.h"
+#include "RecordingRenderDevice.h"
+#include "ShaderBytecodeCache.h"
+#include "MeshRegistry.h"
+#include "NormalGenerator.h"
+#include "MeshOptimiser.h"
+#include "ModelImporter.h"
+#include "VertexCompression.h"
+#include "MatrixKernels.h"
+#include "RingAllocator.h"
+#include "SoftwareRenderDevice.h"
+#include "OcclusionCuller.h"
+#include "FramePacer.h"
+#include "FramePipeline.h"
+#include <DirectXColors.h>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <tuple>
+
+// Leaf node used to build large scene graphs without needing a device
+
+class BenchmarkNode : public SceneNode
+{
+public:
+	BenchmarkNode(wstring name) : SceneNode(name) {};
+
+	bool Initialise() { return true; }
+	void Render() {}
+
+	// The world transformation calculated by the recursive SceneGraph::Update
+	inline const Matrix& GetRecursiveWorldTransformation() const { return _cumulativeWorldTransformation; }
+};
+
+// Returns the average time in milliseconds of calling function the specified number of times
+template <typename Function>
+static double TimeIterations(int iterations, Function function)
+{
+	auto start = chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; i++)
+	{
+		function(i);
+	}
+	auto end = chrono::high_resolution_clock::now();
+	return chrono::duration<double, milli>(end - start).count() / iterations;
+}
+
+// Build a scene graph with a similar shape to the one in DirectXApp, but much larger.  The
+// root has a number of sub-graphs (like "Main", "Arms" and "TeapotMain"), each of which
+// contains groups of leaf nodes.
+
+static SceneGraphPointer BuildBenchmarkGraph(size_t nodeCount, vector<shared_ptr<BenchmarkNode>>& leaves)
+{
+	constexpr size_t SubGraphCount = 16;
+	constexpr size_t GroupSize = 64;
+
+	SceneGraphPointer root = make_shared<SceneGraph>();
+	leaves.clear();
+	size_t leafCount = 0;
+	for (size_t i = 0; i < SubGraphCount; i++)
+	{
+		SceneGraphPointer subGraph = make_shared<SceneGraph>(L"SubGraph" + to_wstring(i));
+		subGraph->SetWorldTransform(Matrix::CreateRotationY(i * 0.1f) * Matrix::CreateTranslation(Vector3(i * 10.0f, 0, 0)));
+		root->Add(subGraph);
+		size_t subGraphEnd = (nodeCount * (i + 1)) / SubGraphCount;
+		while (leafCount < subGraphEnd)
+		{
+			SceneGraphPointer group = make_shared<SceneGraph>(L"Group" + to_wstring(leafCount));
+			group->SetWorldTransform(Matrix::CreateRotationX(leafCount * 0.01f) * Matrix::CreateTranslation(Vector3(0, leafCount * 0.5f, 0)));
+			subGraph->Add(group);
+			for (size_t j = 0; j < GroupSize && leafCount < subGraphEnd; j++, leafCount++)
+			{
+				shared_ptr<BenchmarkNode> leaf = make_shared<BenchmarkNode>(L"Leaf" + to_wstring(leafCount));
+				leaf->SetWorldTransform(Matrix::CreateScale(1.0f + j * 0.01f) * Matrix::CreateRotationZ(j * 0.2f) * Matrix::CreateTranslation(Vector3(j * 1.0f, 0, j * 2.0f)));
+				group->Add(leaf);
+				leaves.push_back(leaf);
+			}
+		}
+	}
+	return root;
+}
+
+static bool SceneGraphUpdateBenchmark(wofstream& output)
+{
+	constexpr int Iterations = 20;
+	const size_t nodeCounts[] = { 1000, 10000, 100000 };
+	unsigned int maximumThreads = thread::hardware_concurrency();
+	bool passed = true;
+
+	output << L"Scene graph update (average ms per update, all nodes dirty)" << endl;
+	for (size_t nodeCount : nodeCounts)
+	{
+		vector<shared_ptr<BenchmarkNode>> leaves;
+		SceneGraphPointer root = BuildBenchmarkGraph(nodeCount, leaves);
+		TransformHierarchy hierarchy;
+		hierarchy.Rebuild(root.get());
+		hierarchy.SetGrainSize(256);
+		size_t entryCount = hierarchy.GetCount();
+
+		// Changing the root transformation each iteration makes every node dirty
+		auto rootTransformation = [](int iteration) { return Matrix::CreateRotationY(iteration * 0.001f); };
+
+		double recursiveTime = TimeIterations(Iterations, [&](int i) { root->Update(rootTransformation(i)); });
+		double serialTime = TimeIterations(Iterations, [&](int i) { hierarchy.Update(rootTransformation(i)); });
+
+		// The flattened update must produce exactly the same matrices as the recursive one
+		bool matches = true;
+		for (const shared_ptr<BenchmarkNode>& leaf : leaves)
+		{
+			matches &= memcmp(&leaf->GetRecursiveWorldTransformation(), &leaf->GetCumulativeWorldTransformation(), sizeof(Matrix)) == 0;
+		}
+		vector<Matrix> serialResults(entryCount);
+		for (size_t i = 0; i < entryCount; i++)
+		{
+			serialResults[i] = hierarchy.GetWorldTransformation(static_cast<int>(i));
+		}
+
+		output << L"  " << nodeCount << L" nodes: recursive " << recursiveTime << L", flattened " << serialTime;
+		output << (matches ? L"" : L" (MISMATCH)") << endl;
+		passed &= matches;
+
+		for (unsigned int threadCount = 2; threadCount <= maximumThreads; threadCount *= 2)
+		{
+			JobSystem jobSystem(threadCount - 1);
+			double parallelTime = TimeIterations(Iterations, [&](int i) { hierarchy.Update(rootTransformation(i), &jobSystem); });
+
+			// The parallel update must match the serial one bit for bit
+			matches = true;
+			for (size_t i = 0; i < entryCount; i++)
+			{
+				matches &= memcmp(&serialResults[i], &hierarchy.GetWorldTransformation(static_cast<int>(i)), sizeof(Matrix)) == 0;
+			}
+			output << L"    " << threadCount << L" threads: " << parallelTime << L" (" << serialTime / parallelTime << L"x)";
+			output << (matches ? L"" : L" (MISMATCH)") << endl;
+			passed &= matches;
+		}
+
+		// Typical frame where only a few nodes move.  Only the moving nodes should be recalculated.
+		size_t movingCount = leaves.size() / 100;
+		double staticTime = TimeIterations(Iterations, [&](int i)
+			{
+				for (size_t j = 0; j < movingCount; j++)
+				{
+					leaves[j * 100]->SetWorldTransform(Matrix::CreateTranslation(Vector3(static_cast<float>(i), 0, 0)));
+				}
+				hierarchy.Update(rootTransformation(Iterations - 1));
+			});
+		output << L"    1% of nodes moving: " << staticTime << L" (" << hierarchy.GetRecomputedCount() << L" recalculated)" << endl;
+	}
+	return passed;
+}
+
+static bool SceneGraphFindBenchmark(wofstream& output)
+{
+	constexpr int Iterations = 10000;
+	vector<shared_ptr<BenchmarkNode>> leaves;
+	SceneGraphPointer root = BuildBenchmarkGraph(100000, leaves);
+	SceneGraphPointer subGraph = dynamic_pointer_cast<SceneGraph>(root->Find(L"SubGraph15"));
+
+	// Names are found from any graph above the node, and only from those
+	bool correct = subGraph != nullptr && root->Find(L"Leaf99999") == leaves[99999] && subGraph->Find(L"Leaf99999") == leaves[99999] &&
+				   subGraph->Find(L"Leaf0") == nullptr && root->FindAll(L"Leaf0").size() == 1 && subGraph->FindAll(L"Leaf0").empty();
+	double rootTime = TimeIterations(Iterations, [&](int i) { correct &= root->Find(L"Leaf" + to_wstring(i * 10)) == leaves[i * 10]; });
+	double subGraphTime = TimeIterations(Iterations, [&](int i) { correct &= subGraph->Find(L"Leaf" + to_wstring(99999 - i % 6250)) != nullptr; });
+
+	// A detached subtree is no longer found from the graphs it was in, but still from its own root
+	SceneGraphPointer group = static_pointer_cast<SceneGraph>(leaves[99999]->GetParent()->shared_from_this());
+	subGraph->Remove(group);
+	correct &= root->Find(L"Leaf99999") == nullptr && subGraph->Find(L"Leaf99999") == nullptr && group->Find(L"Leaf99999") == leaves[99999];
+
+	// Adding a node that is already in a graph, or a graph to itself, is rejected and leaves the graphs as they were
+	size_t rejected = 0;
+	for (const SceneNodePointer& node : { static_pointer_cast<SceneNode>(leaves[0]), static_pointer_cast<SceneNode>(subGraph), static_pointer_cast<SceneNode>(root) })
+	{
+		try
+		{
+			subGraph->Add(node);
+		}
+		catch (const logic_error&)
+		{
+			rejected++;
+		}
+	}
+	correct &= rejected == 3 && root->FindAll(L"Leaf0").size() == 1 && subGraph->FindAll(L"Leaf0").empty();
+	subGraph->Add(group);
+	correct &= root->Find(L"Leaf99999") == leaves[99999] && subGraph->Find(L"Leaf99999") == leaves[99999];
+
+	output << L"Scene graph find (ms per find in 100000 nodes): from the root " << rootTime << L", from a sub-graph " << subGraphTime;
+	output << (correct ? L"" : L" (INCORRECT)") << endl;
+	return correct;
+}
+
+// Classify a box against the view frustum by transforming its corners to clip space, to check Frustum::Test against.
+// Returns false if a corner is too close to a plane for rounding to be sure not to change the result.
+static bool ClassifyCorners(const AxisAlignedBox& box, const Matrix& viewProjection, FrustumTest& result)
+{
+	bool outside[6] = { true, true, true, true, true, true };
+	bool inside = true;
+	for (int corner = 0; corner < 8; corner++)
+	{
+		Vector4 position((corner & 1) ? box.Max.x : box.Min.x, (corner & 2) ? box.Max.y : box.Min.y, (corner & 4) ? box.Max.z : box.Min.z, 1.0f);
+		Vector4 clip = Vector4::Transform(position, viewProjection);
+		// Left, right, bottom, top, near and far, as Direct3D clips them
+		float distances[6] = { clip.w + clip.x, clip.w - clip.x, clip.w + clip.y, clip.w - clip.y, clip.z, clip.w - clip.z };
+		float scales[6] = { fabsf(clip.w) + fabsf(clip.x), fabsf(clip.w) + fabsf(clip.x), fabsf(clip.w) + fabsf(clip.y), fabsf(clip.w) + fabsf(clip.y),
+							fabsf(clip.z), fabsf(clip.w) + fabsf(clip.z) };
+		for (int plane = 0; plane < 6; plane++)
+		{
+			if (fabsf(distances[plane]) <= 1e-4f * scales[plane])
+			{
+				return false;
+			}
+			outside[plane] &= distances[plane] < 0;
+			inside &= distances[plane] > 0;
+		}
+	}
+	result = any_of(begin(outside), end(outside), [](bool behind) { return behind; }) ? FrustumTest::Outside : inside ? FrustumTest::Inside : FrustumTest::Intersecting;
+	return true;
+}
+
+static bool FrustumCullingBenchmark(wofstream& output)
+{
+	constexpr int Iterations = 20;
+	vector<shared_ptr<BenchmarkNode>> leaves;
+	SceneGraphPointer root = BuildBenchmarkGraph(100000, leaves);
+	for (const shared_ptr<BenchmarkNode>& leaf : leaves)
+	{
+		leaf->SetLocalBounds(AxisAlignedBox(Vector3(-0.5f, -0.5f, -0.5f), Vector3(0.5f, 0.5f, 0.5f)));
+	}
+	TransformHierarchy hierarchy;
+	hierarchy.Rebuild(root.get());
+	hierarchy.Update(Matrix::Identity);
+
+	// Looking along the groups from part way up, so that subtrees are found outside, inside and crossing the frustum
+	Matrix viewProjection = XMMatrixLookAtLH(Vector3(80.0f, 1000.0f, -400.0f), Vector3(80.0f, 1000.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f)) *
+							XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 1.0f, 2000.0f);
+	Frustum frustum;
+	frustum.Extract(viewProjection);
+
+	// Typical frame where a few nodes move, so that only their subtree bounds and those of their ancestors change
+	size_t movingCount = leaves.size() / 100;
+	double updateTime = TimeIterations(Iterations, [&](int i)
+		{
+			for (size_t j = 0; j < movingCount; j++)
+			{
+				leaves[j * 100]->SetWorldTransform(Matrix::CreateTranslation(Vector3(static_cast<float>(i), static_cast<float>(j % 7), 0)));
+			}
+			hierarchy.Update(Matrix::Identity);
+		});
+	double cullTime = TimeIterations(Iterations, [&](int) { hierarchy.Cull(frustum); });
+
+	// Check every entry against its subtree bounds merged from scratch, and its visibility against a test of those
+	int count = static_cast<int>(hierarchy.GetCount());
+	bool boundsCorrect = true;
+	bool cullCorrect = true;
+	size_t visibleCount = 0;
+	size_t culledCount = 0;
+	for (int i = 0; i < count; i++)
+	{
+		AxisAlignedBox subtreeBounds;
+		for (int j = i; j < hierarchy.GetSubtreeEnd(i); j++)
+		{
+			subtreeBounds.Merge(hierarchy.GetWorldBounds(j));
+		}
+		boundsCorrect &= memcmp(&subtreeBounds, &hierarchy.GetSubtreeBounds(i), sizeof(AxisAlignedBox)) == 0;
+		bool visible = frustum.Test(subtreeBounds) != FrustumTest::Outside;
+		cullCorrect &= hierarchy.IsVisible(i) == visible;
+		if (!hierarchy.GetWorldBounds(i).IsEmpty())
+		{
+			(visible ? visibleCount : culledCount)++;
+		}
+	}
+	cullCorrect &= visibleCount == hierarchy.GetVisibleCount() && culledCount == hierarchy.GetCulledCount() && visibleCount > 0 && culledCount > 0;
+
+	// Check Frustum::Test against the corners of each box in clip space, wherever the corners are clear of the planes
+	size_t results[3] = { 0, 0, 0 };
+	bool testCorrect = true;
+	for (int i = 0; i < count; i++)
+	{
+		for (const AxisAlignedBox* box : { &hierarchy.GetWorldBounds(i), &hierarchy.GetSubtreeBounds(i) })
+		{
+			FrustumTest expected;
+			if (!box->IsEmpty() && ClassifyCorners(*box, viewProjection, expected))
+			{
+				testCorrect &= frustum.Test(*box) == expected;
+				results[static_cast<int>(expected)]++;
+			}
+		}
+	}
+	testCorrect &= results[0] > 0 && results[1] > 0 && results[2] > 0;
+
+	bool correct = boundsCorrect && cullCorrect && testCorrect;
+	output << L"Frustum culling (ms for 100000 nodes, 1% of them moving)" << endl;
+	output << L"  update " << updateTime << L" (" << hierarchy.GetRecomputedCount() << L" recalculated), cull " << cullTime << L" (" << visibleCount << L" visible, "
+		   << culledCount << L" culled)" << (boundsCorrect && cullCorrect ? L"" : L" (INCORRECT)") << endl;
+	output << L"  boxes outside, crossing and inside the frustum " << results[0] << L", " << results[1] << L", " << results[2] << L" checked against their corners"
+		   << (testCorrect ? L"" : L" (INCORRECT)") << endl;
+	return correct;
+}
+
+// Check the frustum, sphere and ray queries of a tree against testing every entry with geometry in the hierarchy.
+// Returns the number of queries that found something.
+static size_t CheckQueries(const BoundingVolumeHierarchy& tree, const TransformHierarchy& hierarchy, const Frustum& frustum, mt19937& random, bool& correct)
+{
+	int count = static_cast<int>(hierarchy.GetCount());
+	AxisAlignedBox sceneBounds;
+	for (int i = 0; i < count; i++)
+	{
+		sceneBounds.Merge(hierarchy.GetWorldBounds(i));
+	}
+	auto sorted = [](const vector<SceneNodePointer>& nodes)
+		{
+			vector<SceneNode*> result;
+			for (const SceneNodePointer& node : nodes)
+			{
+				result.push_back(node.get());
+			}
+			sort(result.begin(), result.end());
+			return result;
+		};
+	uniform_real_distribution<float> unit(0.0f, 1.0f);
+	auto randomPoint = [&]()
+		{
+			return sceneBounds.Min + (sceneBounds.Max - sceneBounds.Min) * Vector3(unit(random), unit(random), unit(random));
+		};
+
+	size_t found = 0;
+	vector<SceneNodePointer> results;
+	tree.QueryFrustum(frustum, results);
+	vector<SceneNode*> expected;
+	for (int i = 0; i < count; i++)
+	{
+		const AxisAlignedBox& bounds = hierarchy.GetWorldBounds(i);
+		if (!bounds.IsEmpty() && frustum.Test(bounds) != FrustumTest::Outside)
+		{
+			expected.push_back(hierarchy.GetNode(i));
+		}
+	}
+	sort(expected.begin(), expected.end());
+	correct &= sorted(results) == expected;
+	found += expected.empty() ? 0 : 1;
+
+	for (int query = 0; query < 20; query++)
+	{
+		Vector3 centre = randomPoint();
+		float radius = Vector3::Distance(sceneBounds.Min, sceneBounds.Max) * 0.02f;
+		results.clear();
+		tree.QuerySphere(centre, radius, results);
+		expected.clear();
+		for (int i = 0; i < count; i++)
+		{
+			const AxisAlignedBox& bounds = hierarchy.GetWorldBounds(i);
+			Vector3 closest = Vector3::Max(bounds.Min, Vector3::Min(centre, bounds.Max));
+			if (!bounds.IsEmpty() && Vector3::DistanceSquared(closest, centre) <= radius * radius)
+			{
+				expected.push_back(hierarchy.GetNode(i));
+			}
+		}
+		sort(expected.begin(), expected.end());
+		correct &= sorted(results) == expected;
+		found += expected.empty() ? 0 : 1;
+
+		// Rays between two points in the scene, measured in multiples of the distance between them
+		Vector3 origin = randomPoint();
+		Vector3 direction = randomPoint() - origin;
+		Vector3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+		float nearest = 1.0f;
+		bool hitExpected = false;
+		for (int i = 0; i < count; i++)
+		{
+			const AxisAlignedBox& bounds = hierarchy.GetWorldBounds(i);
+			Vector3 t0 = (bounds.Min - origin) * inverseDirection;
+			Vector3 t1 = (bounds.Max - origin) * inverseDirection;
+			Vector3 tNear = Vector3::Min(t0, t1);
+			Vector3 tFar = Vector3::Max(t0, t1);
+			float entry = max(max(tNear.x, tNear.y), max(tNear.z, 0.0f));
+			float exit = min(min(tFar.x, tFar.y), min(tFar.z, 1.0f));
+			if (!bounds.IsEmpty() && entry <= exit && (!hitExpected || entry < nearest))
+			{
+				nearest = entry;
+				hitExpected = true;
+			}
+		}
+		RayHit hit;
+		bool hitFound = tree.RayCast(origin, direction, 1.0f, hit);
+		// Boxes the ray enters at the same distance are equally near, so only the distance is compared
+		correct &= hitFound == hitExpected && (!hitFound || fabsf(hit.Distance - nearest) <= 1e-5f * nearest);
+		found += hitExpected ? 1 : 0;
+	}
+	return found;
+}
+
+static bool BoundingVolumeHierarchyBenchmark(wofstream& output)
+{
+	constexpr int Iterations = 20;
+	mt19937 random(6);
+	vector<shared_ptr<BenchmarkNode>> leaves;
+	SceneGraphPointer root = BuildBenchmarkGraph(100000, leaves);
+	for (const shared_ptr<BenchmarkNode>& leaf : leaves)
+	{
+		leaf->SetLocalBounds(AxisAlignedBox(Vector3(-0.5f, -0.5f, -0.5f), Vector3(0.5f, 0.5f, 0.5f)));
+	}
+	TransformHierarchy hierarchy;
+	hierarchy.Rebuild(root.get());
+	hierarchy.Update(Matrix::Identity);
+	Matrix viewProjection = XMMatrixLookAtLH(Vector3(80.0f, 1000.0f, -400.0f), Vector3(80.0f, 1000.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f)) *
+							XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 1.0f, 2000.0f);
+	Frustum frustum;
+	frustum.Extract(viewProjection);
+
+	BoundingVolumeHierarchy tree;
+	double buildTime = TimeIterations(Iterations, [&](int) { tree.Build(hierarchy); });
+	bool correct = true;
+	size_t found = CheckQueries(tree, hierarchy, frustum, random, correct);
+
+	// Move 1% of the nodes a few times, refitting the tree after each move without letting it rebuild.  Queries on
+	// the refitted tree must find the same nodes as those on a tree built from scratch.
+	tree.SetRebuildThreshold(numeric_limits<float>::max());
+	size_t movingCount = leaves.size() / 100;
+	double refitTime = TimeIterations(Iterations, [&](int i)
+		{
+			for (size_t j = 0; j < movingCount; j++)
+			{
+				leaves[j * 100]->SetWorldTransform(Matrix::CreateTranslation(Vector3(i * 20.0f, static_cast<float>(j % 7), 0)));
+			}
+			hierarchy.Update(Matrix::Identity);
+			tree.Update(hierarchy);
+		});
+	size_t rebuildCount = tree.GetRebuildCount();
+	float refitCost = tree.GetCost();
+	BoundingVolumeHierarchy rebuilt;
+	rebuilt.Build(hierarchy);
+	mt19937 refitRandom = random;
+	found += CheckQueries(tree, hierarchy, frustum, refitRandom, correct);
+	found += CheckQueries(rebuilt, hierarchy, frustum, random, correct);
+	correct &= rebuildCount == Iterations;
+
+	// Boxes spaced further apart each time are split off a few at a time, giving a much deeper tree than the same
+	// number of boxes would usually need
+	SceneGraphPointer spreadRoot = make_shared<SceneGraph>();
+	for (int i = 0; i < 150; i++)
+	{
+		shared_ptr<BenchmarkNode> node = make_shared<BenchmarkNode>(L"Spread" + to_wstring(i));
+		node->SetWorldTransform(Matrix::CreateTranslation(Vector3(powf(2.0f, i * 0.8f), 0, 0)));
+		node->SetLocalBounds(AxisAlignedBox(Vector3(-0.5f, -0.5f, -0.5f), Vector3(0.5f, 0.5f, 0.5f)));
+		spreadRoot->Add(node);
+	}
+	TransformHierarchy spreadHierarchy;
+	spreadHierarchy.Rebuild(spreadRoot.get());
+	spreadHierarchy.Update(Matrix::Identity);
+	BoundingVolumeHierarchy spreadTree;
+	spreadTree.Update(spreadHierarchy);
+	found += CheckQueries(spreadTree, spreadHierarchy, frustum, random, correct);
+
+	// A node with infinite bounds is found by every frustum and sphere query, but never by a ray
+	SceneGraphPointer unboundedRoot = make_shared<SceneGraph>();
+	shared_ptr<BenchmarkNode> unboundedNode = make_shared<BenchmarkNode>(L"Unbounded");
+	unboundedNode->SetLocalBounds(AxisAlignedBox::Infinite());
+	unboundedRoot->Add(unboundedNode);
+	TransformHierarchy unboundedHierarchy;
+	unboundedHierarchy.Rebuild(unboundedRoot.get());
+	unboundedHierarchy.Update(Matrix::Identity);
+	BoundingVolumeHierarchy unboundedTree;
+	unboundedTree.Update(unboundedHierarchy);
+	vector<SceneNodePointer> unboundedResults;
+	unboundedTree.QueryFrustum(frustum, unboundedResults);
+	unboundedTree.QuerySphere(Vector3(0.0f, 0.0f, 0.0f), 1.0f, unboundedResults);
+	RayHit unboundedHit;
+	correct &= unboundedResults.size() == 2 && unboundedResults[0].get() == unboundedNode.get() && unboundedResults[1].get() == unboundedNode.get() &&
+			   !unboundedTree.RayCast(Vector3(0.0f, 0.0f, 0.0f), Vector3(1.0f, 0.0f, 0.0f), 100.0f, unboundedHit);
+
+	output << L"Bounding volume hierarchy (ms for 100000 nodes, 1% of them moving)" << endl;
+	output << L"  build " << buildTime << L" (cost " << rebuilt.GetCost() << L", depth " << rebuilt.GetDepth() << L"), refit " << refitTime
+		   << L" (cost " << refitCost << L")" << endl;
+	output << L"  " << found << L" queries finding nodes checked against every node, depth " << spreadTree.GetDepth() << L" for spread out nodes"
+		   << (correct ? L"" : L" (INCORRECT)") << endl;
+	return correct;
+}
+
+// Fill a render queue with packets using a mix of shaders, textures and meshes, added in
+// a random order as they would be from traversing a large scene
+static void FillRenderQueue(RenderQueue& queue, size_t packetCount, mt19937& random)
+{
+	constexpr RenderHandle ShaderCount = 8;
+	constexpr RenderHandle TextureCount = 32;
+	constexpr RenderHandle MeshCount = 64;
+	uniform_real_distribution<float> depth(1.0f, 1000.0f);
+	float material[4] = { 0 };
+	float constants[16] = { 0 };
+
+	queue.Clear();
+	for (size_t i = 0; i < packetCount; i++)
+	{
+		RenderHandle shader = random() % ShaderCount;
+		RenderHandle mesh = random() % MeshCount;
+		DrawPacket packet;
+		packet.VertexShader = 0x1000 + shader;
+		packet.PixelShader = 0x2000 + shader;
+		packet.InputLayout = 0x3000 + shader;
+		packet.VertexBuffer = 0x4000 + mesh;
+		packet.IndexBuffer = 0x5000 + mesh;
+		packet.Texture = shader % 2 == 0 ? 0x6000 + random() % TextureCount : 0;
+		packet.VertexStride = 32;
+		packet.IndexCount = 36 + static_cast<unsigned int>(mesh);
+		packet.Depth = depth(random);
+		// The object constants hold the packet number and its material, so that what is bound when it is drawn can be checked
+		material[0] = static_cast<float>(random() % 4);
+		constants[0] = static_cast<float>(i);
+		constants[1] = material[0];
+		queue.Add(packet, material, sizeof(material), constants, sizeof(constants));
+	}
+}
+
+// Follow the writes to a recorded constant buffer and check that every draw has the frame constants, and the
+// object constants and material of a different packet (see FillRenderQueue), bound when it is drawn
+static bool CheckConstants(const RecordingRenderDevice& device, RenderHandle constantBuffer, size_t capacity, size_t packetCount, float frameValue)
+{
+	vector<uint8_t> buffer(capacity);
+	size_t bound[3] = { SIZE_MAX, SIZE_MAX, SIZE_MAX };
+	vector<uint8_t> drawn(packetCount, 0);
+	bool correct = true;
+	auto boundValue = [&](unsigned int slot, size_t index)
+		{
+			return reinterpret_cast<const float*>(&buffer[bound[slot]])[index];
+		};
+	for (const RenderCommand& command : device.GetCommands())
+	{
+		switch (command.Type)
+		{
+			case RenderCommandType::WriteBuffer:
+				correct &= command.Handles[0] == constantBuffer && command.Values[2] + command.Values[1] <= static_cast<int64_t>(capacity);
+				// Anything bound before a discard is no longer there to read
+				if (command.Values[3] != 0)
+				{
+					fill(buffer.begin(), buffer.end(), static_cast<uint8_t>(0xFF));
+				}
+				memcpy(&buffer[command.Values[2]], device.GetData(command), command.Values[1]);
+				break;
+
+			case RenderCommandType::SetConstantBufferRange:
+				correct &= command.Handles[0] == constantBuffer && command.Values[1] % ConstantBufferAlignment == 0 && command.Values[2] % ConstantBufferAlignment == 0;
+				bound[command.Values[0]] = static_cast<size_t>(command.Values[1]);
+				break;
+
+			case RenderCommandType::DrawIndexed:
+			{
+				if (bound[FrameConstantsSlot] == SIZE_MAX || bound[MaterialConstantsSlot] == SIZE_MAX || bound[ObjectConstantsSlot] == SIZE_MAX)
+				{
+					return false;
+				}
+				size_t packet = static_cast<size_t>(boundValue(ObjectConstantsSlot, 0));
+				correct &= packet < packetCount && drawn[packet]++ == 0 && boundValue(MaterialConstantsSlot, 0) == boundValue(ObjectConstantsSlot, 1) &&
+						   boundValue(FrameConstantsSlot, 0) == frameValue;
+				break;
+			}
+
+			default:
+				break;
+		}
+	}
+	return correct && count(drawn.begin(), drawn.end(), 1) == static_cast<ptrdiff_t>(packetCount);
+}
+
+static bool RingAllocatorBenchmark(wofstream& output)
+{
+	constexpr size_t Capacity = 64 * 1024;
+	constexpr size_t Alignment = 256;
+	mt19937 random(5);
+	RingAllocator ring(Capacity, Alignment);
+
+	// Allocations must be aligned, must not overlap anything else allocated in the same pass through
+	// the buffer, and must only start again at the beginning when they do not fit in what is left
+	bool correct = true;
+	size_t passEnd = 0;
+	size_t wraps = 0;
+	for (int i = 0; i < 100000; i++)
+	{
+		size_t size = 1 + random() % 4000;
+		bool wrapped;
+		size_t offset = ring.Allocate(size, wrapped);
+		bool shouldWrap = i == 0 || passEnd + ring.Align(size) > Capacity;
+		correct &= wrapped == shouldWrap && offset % Alignment == 0 && offset + size <= Capacity;
+		correct &= wrapped ? offset == 0 : offset == passEnd;
+		wraps += (wrapped && i > 0);
+		passEnd = offset + ring.Align(size);
+	}
+	correct &= ring.GetWrapCount() == wraps;
+
+	// An allocation that can never fit is an error, as is an alignment that is not a power of two
+	auto throws = [](auto function)
+		{
+			try
+			{
+				function();
+			}
+			catch (const logic_error&)
+			{
+				return true;
+			}
+			return false;
+		};
+	correct &= throws([&] { bool wrapped; ring.Allocate(Capacity + 1, wrapped); });
+	correct &= throws([&] { ring.Reset(Capacity, 48); });
+	correct &= !throws([&] { bool wrapped; RingAllocator(Capacity, Alignment).Allocate(Capacity, wrapped); });
+
+	output << L"Ring allocator: 100000 allocations, " << wraps << L" wraps" << (correct ? L"" : L" (INCORRECT)") << endl;
+	return correct;
+}
+
+static bool RenderQueueBenchmark(wofstream& output)
+{
+	constexpr int Iterations = 20;
+	constexpr RenderHandle ConstantBuffer = 0x7000;
+	constexpr size_t ConstantBufferCapacity = 1024 * 1024;
+	const size_t packetCounts[] = { 1000, 10000, 100000 };
+	bool passed = true;
+	float frameConstants[16] = { 42.0f };
+
+	output << L"Render queue (average ms per frame, submitted to a recording device)" << endl;
+	for (size_t packetCount : packetCounts)
+	{
+		mt19937 random(1);
+		RenderQueue queue;
+		RecordingRenderDevice device;
+		queue.SetConstantBuffer(ConstantBuffer, ConstantBufferCapacity);
+		queue.SetFrameConstants(frameConstants, sizeof(frameConstants));
+
+		// Submitted in the order the packets were added, every packet sets most of the state
+		FillRenderQueue(queue, packetCount, random);
+		queue.Submit(device);
+		RenderQueueStatistics unsorted = queue.GetStatistics();
+
+		double sortTime = TimeIterations(Iterations, [&](int) { queue.Sort(); });
+		device.Clear();
+		queue.Submit(device);
+		RenderQueueStatistics sorted = queue.GetStatistics();
+
+		// The keys must be in order, and every packet must still be drawn exactly once with its own constants
+		bool correct = device.CountCommands(RenderCommandType::DrawIndexed) == packetCount;
+		correct &= CheckConstants(device, ConstantBuffer, ConstantBufferCapacity, packetCount, frameConstants[0]);
+		correct &= device.CountCommands(RenderCommandType::WriteBuffer) == sorted.ConstantWrites;
+		for (size_t i = 1; i < packetCount; i++)
+		{
+			correct &= queue.GetSortKey(i - 1) <= queue.GetSortKey(i);
+		}
+
+		double frameTime = TimeIterations(Iterations, [&](int)
+			{
+				FillRenderQueue(queue, packetCount, random);
+				queue.Sort();
+				device.Clear();
+				queue.Submit(device);
+			});
+
+		output << L"  " << packetCount << L" packets: sort " << sortTime << L", fill + sort + submit " << frameTime;
+		output << (correct ? L"" : L" (INCORRECT)") << endl;
+		output << L"    state changes unsorted " << unsorted.StateChanges << L" (" << unsorted.ShaderChanges << L" shader, " << unsorted.TextureChanges << L" texture)";
+		output << L", sorted " << sorted.StateChanges << L" (" << sorted.ShaderChanges << L" shader, " << sorted.TextureChanges << L" texture)";
+		output << L", " << sorted.StateChangesAvoided << L" avoided" << endl;
+		output << L"    constants: " << sorted.ConstantWrites << L" writes (" << sorted.ConstantBytes / 1024 << L" KB), "
+			   << sorted.MaterialChanges << L" material changes" << endl;
+		passed &= correct;
+	}
+
+	// Instances of the same mesh should be drawn together, with one draw call for each
+	// instance buffer's worth of instances
+	constexpr size_t InstanceCount = 10000;
+	constexpr size_t MeshCount = 4;
+	constexpr size_t InstanceSize = 80;
+	constexpr size_t InstanceBufferCapacity = 1024 * InstanceSize;
+	mt19937 random(1);
+	RenderQueue queue;
+	RecordingRenderDevice device;
+	queue.SetInstanceBuffer(0x8000, InstanceBufferCapacity);
+	queue.SetConstantBuffer(ConstantBuffer, ConstantBufferCapacity);
+	float instance[InstanceSize / sizeof(float)] = { 0 };
+	float material[4] = { 0 };
+	float constants[16] = { 0 };
+	double instancedTime = TimeIterations(Iterations, [&](int)
+		{
+			queue.Clear();
+			for (size_t i = 0; i < InstanceCount; i++)
+			{
+				RenderHandle mesh = random() % MeshCount;
+				DrawPacket packet;
+				packet.VertexShader = 0x1000;
+				packet.PixelShader = 0x2000;
+				packet.InputLayout = 0x3000;
+				packet.VertexBuffer = 0x4000 + mesh;
+				packet.IndexBuffer = 0x5000 + mesh;
+				packet.VertexStride = 32;
+				packet.IndexCount = 36;
+				instance[0] = static_cast<float>(i);
+				queue.AddInstance(packet, instance, sizeof(instance), material, sizeof(material), constants, sizeof(constants));
+			}
+			queue.Sort();
+			device.Clear();
+			queue.Submit(device);
+		});
+	const RenderQueueStatistics& statistics = queue.GetStatistics();
+	size_t maximumDraws = MeshCount * ((InstanceCount / MeshCount) / (InstanceBufferCapacity / InstanceSize) + 2);
+	bool correct = statistics.InstanceCount == InstanceCount && statistics.DrawCount == statistics.InstancedDrawCount &&
+				   statistics.DrawCount <= maximumDraws && device.CountCommands(RenderCommandType::DrawIndexedInstanced) == statistics.DrawCount &&
+				   device.CountCommands(RenderCommandType::SetConstantBufferRange) <= statistics.DrawCount * 2;
+	output << L"  " << InstanceCount << L" instances of " << MeshCount << L" meshes: " << instancedTime << L", " << statistics.DrawCount << L" draws";
+	output << (correct ? L"" : L" (INCORRECT)") << endl;
+	passed &= correct;
+
+	// Ids are only given to the materials used in a frame, so a long run of frames with new materials never
+	// runs out of them and the materials in each frame still sort apart
+	constexpr int MaterialFrames = 300;
+	bool materialsApart = true;
+	for (int frame = 0; frame < MaterialFrames; frame++)
+	{
+		queue.Clear();
+		DrawPacket packet;
+		packet.VertexShader = 0x1000;
+		packet.PixelShader = 0x2000;
+		packet.IndexCount = 36;
+		for (int i = 0; i < 2; i++)
+		{
+			material[0] = static_cast<float>(frame * 2 + i);
+			queue.Add(packet, material, sizeof(material), constants, sizeof(constants));
+		}
+		queue.Sort();
+		materialsApart &= queue.GetSortKey(0) != queue.GetSortKey(1);
+	}
+	output << L"  " << MaterialFrames * 2 << L" materials over " << MaterialFrames << L" frames sorted apart" << (materialsApart ? L"" : L" (INCORRECT)") << endl;
+	passed &= materialsApart;
+	return passed;
+}
+
+static void WriteTextFile(const wstring& fileName, const string& text)
+{
+	MappedFile::WriteFile(fileName, text.data(), text.size());
+}
+
+static bool ShaderBytecodeCacheBenchmark(wofstream& output)
+{
+	constexpr int VariantCount = 32;
+	const wstring shaderFileName = L"BenchmarkShader.hlsl";
+	const wstring includeFileName = L"BenchmarkShader.hlsli";
+	const wstring archiveFileName = L"BenchmarkShaderCache.bin";
+
+	// Stands in for the real compiler so that this does not need Direct3D.  The "bytecode" is just
+	// the description, and compiling takes a fixed time so that hits and misses can be compared.
+	size_t compileCount = 0;
+	ShaderBytecodeCache::Compiler compiler = [&](const ShaderDescription& description, vector<uint8_t>& byteCode)
+		{
+			this_thread::sleep_for(chrono::milliseconds(2));
+			wstring key = description.GetKey();
+			byteCode.assign(reinterpret_cast<const uint8_t*>(key.data()), reinterpret_cast<const uint8_t*>(key.data() + key.size()));
+			compileCount++;
+			return true;
+		};
+	auto getVariants = [&](ShaderBytecodeCache& cache)
+		{
+			bool correct = true;
+			for (int i = 0; i < VariantCount; i++)
+			{
+				ShaderDescription description = { shaderFileName, "VS", "vs_5_0", { { "VARIANT", to_string(i) } }, 0 };
+				vector<uint8_t> byteCode;
+				wstring key = description.GetKey();
+				correct &= cache.GetByteCode(description, byteCode) && byteCode.size() == key.size() * sizeof(wchar_t) &&
+						   memcmp(byteCode.data(), key.data(), byteCode.size()) == 0;
+			}
+			return correct;
+		};
+
+	WriteTextFile(shaderFileName, "#include \"BenchmarkShader.hlsli\"\nfloat4 VS(float4 position : POSITION) : SV_POSITION { return position * Scale; }\n");
+	WriteTextFile(includeFileName, "static const float Scale = 1.0f;\n");
+	remove(string(archiveFileName.begin(), archiveFileName.end()).c_str());
+
+	output << L"Shader bytecode cache (ms to get " << VariantCount << L" shaders, using a fake compiler)" << endl;
+	bool correct = true;
+	double coldTime;
+	{
+		ShaderBytecodeCache cache(compiler);
+		correct &= !cache.Load(archiveFileName);
+		coldTime = TimeIterations(1, [&](int) { correct &= getVariants(cache); });
+		correct &= compileCount == VariantCount && cache.Save(archiveFileName);
+	}
+
+	// A new cache loaded from the archive should not need to compile anything
+	compileCount = 0;
+	double warmTime;
+	{
+		ShaderBytecodeCache cache(compiler);
+		correct &= cache.Load(archiveFileName) && cache.GetArchiveEntryCount() == VariantCount;
+		warmTime = TimeIterations(1, [&](int) { correct &= getVariants(cache); });
+		correct &= compileCount == 0;
+	}
+	output << L"  cold " << coldTime << L", from archive " << warmTime << endl;
+
+	// Changing an included file must cause every shader that includes it to be recompiled
+	WriteTextFile(includeFileName, "static const float Scale = 2.0f;\n");
+	{
+		ShaderBytecodeCache cache(compiler);
+		correct &= cache.Load(archiveFileName);
+		correct &= getVariants(cache) && compileCount == VariantCount && cache.GetMissCount() == VariantCount;
+		// Entries for the old include are dropped when the archive is saved
+		correct &= cache.Save(archiveFileName) && cache.GetArchiveEntryCount() == VariantCount;
+	}
+
+	// A damaged archive must be rejected
+	{
+		MappedFile archive;
+		archive.Open(archiveFileName);
+		vector<uint8_t> data(archive.GetData(), archive.GetData() + archive.GetSize());
+		archive.Close();
+		data[data.size() - 1] ^= 0xFF;
+		MappedFile::WriteFile(archiveFileName, data.data(), data.size());
+		ShaderBytecodeCache cache(compiler);
+		correct &= !cache.Load(archiveFileName);
+	}
+	output << L"  invalidation checks " << (correct ? L"passed" : L"FAILED") << endl;
+
+	remove(string(shaderFileName.begin(), shaderFileName.end()).c_str());
+	remove(string(includeFileName.begin(), includeFileName.end()).c_str());
+	remove(string(archiveFileName.begin(), archiveFileName.end()).c_str());
+	return correct;
+}
+
+static bool MeshRegistryBenchmark(wofstream& output)
+{
+	constexpr int NodeCount = 1000;
+
+	// Without a device the meshes are only built on the CPU, which is the part the registry avoids repeating
+	MeshRegistry registry(nullptr);
+	vector<MeshPointer> meshes(NodeCount);
+	double firstTime = TimeIterations(1, [&](int) { meshes[0] = registry.GetTeapot(3.0f); });
+	double sharedTime = TimeIterations(NodeCount - 1, [&](int i) { meshes[i + 1] = registry.GetTeapot(3.0f); });
+
+	bool correct = registry.GetBuildCount() == 1 && registry.GetHitCount() == NodeCount - 1 &&
+				   meshes[0]->VertexCount > 0 && !meshes[0]->Bounds.IsEmpty();
+	for (const MeshPointer& mesh : meshes)
+	{
+		correct &= mesh == meshes[0];
+	}
+
+	// Different parameters give a different mesh, however close they are, and a mesh that is no longer used is released
+	correct &= registry.GetTeapot(2.0f) != meshes[0] && registry.GetBuildCount() == 2;
+	correct &= MeshRegistry::MakeKey("sphere", { { "diameter", 1.0f }, { "tessellation", 32.0f } }) == "sphere diameter=1 tessellation=32";
+	correct &= registry.GetTeapot(nextafterf(3.0f, 4.0f)) != meshes[0] && registry.GetBuildCount() == 3;
+	meshes.clear();
+	registry.GetTeapot(3.0f);
+	correct &= registry.GetBuildCount() == 4;
+
+	// Small meshes get 16 bit indices and large ones 32 bit indices, with the same values either way
+	MeshPointer teapot = registry.GetTeapot(3.0f);
+	MeshPointer sphere = registry.GetSphere(1.0f, 200);
+	correct &= teapot->Indices.GetFormat() == IndexFormat::UInt16 && teapot->Indices.GetSize() == teapot->GetIndexCount() * sizeof(uint16_t);
+	correct &= sphere->VertexCount >= USHRT_MAX && sphere->Indices.GetFormat() == IndexFormat::UInt32;
+	vector<UINT> indices;
+	teapot->Indices.CopyTo(indices);
+	IndexData wide;
+	wide.Assign(indices.data(), indices.size(), IndexFormat::UInt32);
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		correct &= teapot->Indices[i] == wide[i];
+	}
+	size_t indexBytes = teapot->Indices.GetSize() + sphere->Indices.GetSize();
+	size_t wideIndexBytes = (teapot->GetIndexCount() + sphere->GetIndexCount()) * sizeof(uint32_t);
+
+	// With a device, each mesh is uploaded once into immutable buffers holding exactly its data, and the
+	// buffers are released along with the mesh
+	shared_ptr<RecordingRenderDevice> device = make_shared<RecordingRenderDevice>();
+	{
+		MeshRegistry uploadRegistry(device);
+		MeshPointer box = uploadRegistry.GetBox(Vector3(1.0f, 2.0f, 3.0f));
+		correct &= uploadRegistry.GetBox(Vector3(1.0f, 2.0f, 3.0f)) == box && device->GetBufferCount() == 2;
+		for (const RenderCommand& command : device->GetCommands())
+		{
+			bool isVertices = command.Handles[0] == box->VertexBuffer;
+			size_t size = isVertices ? box->VertexCount * box->BufferStride : box->Indices.GetSize();
+			correct &= command.Type == RenderCommandType::CreateBuffer && device->GetData(command) != nullptr &&
+					   command.Values[1] == static_cast<int64_t>(isVertices ? BufferType::Vertex : BufferType::Index) &&
+					   command.Values[2] == static_cast<int64_t>(BufferUsage::Immutable) && command.Values[3] == static_cast<int64_t>(size);
+		}
+		correct &= memcmp(device->GetData(device->GetCommands()[1]), box->Indices.GetData(), box->Indices.GetSize()) == 0;
+	}
+	correct &= device->GetBufferCount() == 0 && device->CountCommands(RenderCommandType::ReleaseBuffer) == 2;
+
+	output << L"Mesh registry (ms to get the teapot for a node)" << endl;
+	output << L"  built " << firstTime << L", shared " << sharedTime << L" (" << NodeCount << L" nodes)" << endl;
+	output << L"  teapot and sphere index bytes " << indexBytes << L" (" << wideIndexBytes << L" with 32 bit indices)";
+	output << (correct ? L"" : L" (INCORRECT)") << endl;
+	return correct;
+}
+
+// Leaf node that adds its mesh to a render queue, as GeometricNode does, but without needing the framework, so
+// that whole frames can be run on a recording device.  The node adds to whichever queue renderQueue points at when
+// it is rendered, so that frames can be built in turn in the queues of a FramePipeline.
+
+class RecordedMeshNode : public SceneNode
+{
+public:
+	RecordedMeshNode(wstring name, MeshPointer mesh, RenderQueue* const& renderQueue, const Matrix& viewProjection) :
+		SceneNode(name), _mesh(mesh), _renderQueue(renderQueue), _viewProjection(viewProjection)
+	{
+		SetLocalBounds(mesh->Bounds);
+	}
+
+	bool Initialise() { return true; }
+
+	void Render()
+	{
+		Matrix worldViewProjection = GetWorldViewProjection(_viewProjection);
+		float material[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		DrawPacket packet;
+		packet.VertexShader = 0x1000;
+		packet.PixelShader = 0x2000;
+		packet.InputLayout = 0x3000;
+		packet.VertexBuffer = _mesh->VertexBuffer;
+		packet.IndexBuffer = _mesh->IndexBuffer;
+		packet.VertexStride = _mesh->BufferStride;
+		packet.IndexBufferFormat = _mesh->Indices.GetFormat();
+		packet.IndexCount = _mesh->GetLod(0).IndexCount;
+		// The w of the transformed origin is its distance in front of the camera
+		packet.Depth = worldViewProjection._44;
+		_renderQueue->Add(packet, material, sizeof(material), &worldViewProjection, sizeof(worldViewProjection));
+	}
+
+private:
+	MeshPointer				_mesh;
+	RenderQueue* const&		_renderQueue;
+	const Matrix&			_viewProjection;
+};
+
+// A grid of nodes drawing the meshes in turn, stretching away from the camera so that some are culled
+static SceneGraphPointer BuildRecordedGrid(size_t gridSize, size_t groupSize, const MeshPointer* meshes, size_t meshCount,
+										   RenderQueue* const& renderQueue, const Matrix& viewProjection)
+{
+	SceneGraphPointer root = make_shared<SceneGraph>();
+	SceneGraphPointer group;
+	for (size_t i = 0; i < gridSize * gridSize; i++)
+	{
+		if (i % groupSize == 0)
+		{
+			group = make_shared<SceneGraph>(L"Group" + to_wstring(i));
+			root->Add(group);
+		}
+		float x = static_cast<float>(i % gridSize) * 4.0f - gridSize * 2.0f;
+		float z = static_cast<float>(i / gridSize) * 4.0f;
+		shared_ptr<RecordedMeshNode> node = make_shared<RecordedMeshNode>(L"Node" + to_wstring(i), meshes[i % meshCount], renderQueue, viewProjection);
+		node->SetWorldTransform(Matrix::CreateTranslation(x, 0, z));
+		group->Add(node);
+	}
+	return root;
+}
+
+// Run the same steps as DirectXFramework::Update and Render, from updating the transformations to submitting
+// the render queue, with a recording device in place of Direct3D
+static bool HeadlessFrameBenchmark(wofstream& output)
+{
+	constexpr int Iterations = 20;
+	constexpr size_t GridSize = 100;
+	constexpr size_t GroupSize = 64;
+	constexpr size_t ConstantBufferCapacity = 4 * 1024 * 1024;
+	const float clearColour[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+	shared_ptr<RecordingRenderDevice> device = make_shared<RecordingRenderDevice>();
+	bool correct = true;
+	{
+		MeshRegistry registry(device);
+		MeshPointer meshes[] = { registry.GetTeapot(1.0f), registry.GetBox(Vector3(1.0f, 1.0f, 1.0f)), registry.GetSphere(1.0f, 16), registry.GetCylinder(1.0f, 1.0f, 16) };
+		RenderQueue renderQueue;
+		RenderQueue* currentQueue = &renderQueue;
+		RenderHandle constantBuffer = device->CreateBuffer(BufferType::Constant, BufferUsage::Dynamic, ConstantBufferCapacity, nullptr);
+		renderQueue.SetConstantBuffer(constantBuffer, ConstantBufferCapacity);
+		Matrix viewProjection = Matrix::CreateLookAt(Vector3(0, 30, -20), Vector3(0, 0, 100), Vector3(0, 1, 0)) *
+								Matrix::CreatePerspectiveFieldOfView(XM_PIDIV4, 16.0f / 9.0f, 1.0f, 1000.0f);
+		SceneGraphPointer root = BuildRecordedGrid(GridSize, GroupSize, meshes, 4, currentQueue, viewProjection);
+		TransformHierarchy hierarchy;
+		hierarchy.Rebuild(root.get());
+		Frustum frustum;
+		frustum.Extract(viewProjection);
+
+		double frameTime = TimeIterations(Iterations, [&](int i)
+			{
+				device->Clear();
+				root->SetWorldTransform(Matrix::CreateRotationY(i * 0.001f));
+				hierarchy.Update(Matrix::Identity);
+				hierarchy.Cull(frustum);
+				hierarchy.UpdateWorldViewProjections(viewProjection);
+				device->ClearTargets(clearColour, 1.0f);
+				renderQueue.Clear();
+				renderQueue.SetFrameConstants(&viewProjection, sizeof(viewProjection));
+				root->Render();
+				renderQueue.Sort();
+				renderQueue.Submit(*device);
+			});
+
+		// Every visible node is drawn once, and every buffer bound was created by the device and is still alive
+		size_t visibleCount = hierarchy.GetVisibleCount();
+		correct &= visibleCount > 0 && hierarchy.GetCulledCount() > 0 && device->CountCommands(RenderCommandType::DrawIndexed) == visibleCount;
+		for (const RenderCommand& command : device->GetCommands())
+		{
+			if (command.Type == RenderCommandType::SetVertexBuffer || command.Type == RenderCommandType::SetIndexBuffer ||
+				command.Type == RenderCommandType::WriteBuffer || command.Type == RenderCommandType::SetConstantBufferRange)
+			{
+				correct &= device->IsBuffer(command.Handles[0]);
+			}
+		}
+		output << L"Headless frame (ms per frame on a recording device)" << endl;
+		output << L"  " << GridSize * GridSize << L" nodes: " << frameTime << L" (" << visibleCount << L" visible, "
+			   << device->GetCommands().size() << L" commands)";
+		device->ReleaseBuffer(constantBuffer);
+	}
+	// Once the meshes have gone, nothing created on the device should be left
+	correct &= device->GetBufferCount() == 0;
+	output << (correct ? L"" : L" (INCORRECT)") << endl;
+	return correct;
+}
+
+// The headless frame split into its update stage (updating and culling the hierarchy and building the render
+// queue) and its render stage (submitting the queue), run one after the other and then pipelined
+static bool FramePipelineBenchmark(wofstream& output)
+{
+	constexpr int Frames = 50;
+	constexpr size_t GridSize = 100;
+	constexpr size_t GroupSize = 64;
+	constexpr size_t ConstantBufferCapacity = 4 * 1024 * 1024;
+	const float clearColour[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+	shared_ptr<RecordingRenderDevice> device = make_shared<RecordingRenderDevice>();
+	device->SetKeepRetiredBuffers(true);
+	bool correct = true;
+	output << L"Frame pipeline (ms per frame on a recording device)" << endl;
+	{
+		MeshRegistry registry(device);
+		MeshPointer meshes[] = { registry.GetTeapot(1.0f), registry.GetBox(Vector3(1.0f, 1.0f, 1.0f)), registry.GetSphere(1.0f, 16), registry.GetCylinder(1.0f, 1.0f, 16) };
+		// Each frame also draws a mesh of its own, which is let go of by the update stage as soon as it has been
+		// queued.  They are made here, since the device is not used by two threads at once.
+		vector<MeshPointer> frameMeshes;
+		for (int i = 0; i < 2 * Frames; i++)
+		{
+			frameMeshes.push_back(registry.GetBox(Vector3(2.0f + i, 1.0f, 1.0f)));
+		}
+		// The double buffered frame data, as in DirectXFramework: a render queue with a constant buffer of its own,
+		// along with the frame it was built for and the number of nodes it should draw
+		RenderQueue renderQueues[2];
+		RenderHandle constantBuffers[2];
+		int builtFrames[2] = { 0, 0 };
+		size_t visibleCounts[2] = { 0, 0 };
+		for (int i = 0; i < 2; i++)
+		{
+			constantBuffers[i] = device->CreateBuffer(BufferType::Constant, BufferUsage::Dynamic, ConstantBufferCapacity, nullptr);
+			renderQueues[i].SetConstantBuffer(constantBuffers[i], ConstantBufferCapacity);
+		}
+		RenderQueue* currentQueue = &renderQueues[0];
+		Matrix viewProjection = Matrix::CreateLookAt(Vector3(0, 30, -20), Vector3(0, 0, 100), Vector3(0, 1, 0)) *
+								Matrix::CreatePerspectiveFieldOfView(XM_PIDIV4, 16.0f / 9.0f, 1.0f, 1000.0f);
+		SceneGraphPointer root = BuildRecordedGrid(GridSize, GroupSize, meshes, 4, currentQueue, viewProjection);
+		TransformHierarchy hierarchy;
+		hierarchy.Rebuild(root.get());
+		Frustum frustum;
+		frustum.Extract(viewProjection);
+
+		// The render stage checks that it is given every frame in order, that its buffer is not changed while it is
+		// being submitted, and that the meshes it draws have not been released
+		int renderedFrame = 0;
+		bool consistent = true;
+		double renderTime = 0.0;
+		FramePipeline pipeline([&](unsigned int buffer)
+			{
+				auto start = chrono::high_resolution_clock::now();
+				int frame = builtFrames[buffer];
+				size_t packetCount = renderQueues[buffer].GetPacketCount();
+				device->Clear();
+				device->ClearTargets(clearColour, 1.0f);
+				renderQueues[buffer].Submit(*device);
+				consistent &= frame == renderedFrame + 1 && builtFrames[buffer] == frame && renderQueues[buffer].GetPacketCount() == packetCount &&
+							  device->CountCommands(RenderCommandType::DrawIndexed) == visibleCounts[buffer];
+				for (const RenderCommand& command : device->GetCommands())
+				{
+					if (command.Type == RenderCommandType::SetVertexBuffer || command.Type == RenderCommandType::SetIndexBuffer)
+					{
+						consistent &= device->IsBuffer(command.Handles[0]);
+					}
+				}
+				device->EndFrame();
+				renderedFrame = frame;
+				renderTime += chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+			});
+
+		int frame = 0;
+		double updateTime = 0.0;
+		auto update = [&]()
+			{
+				auto start = chrono::high_resolution_clock::now();
+				unsigned int buffer = pipeline.GetUpdateBuffer();
+				currentQueue = &renderQueues[buffer];
+				frame++;
+				root->SetWorldTransform(Matrix::CreateRotationY(frame * 0.001f));
+				hierarchy.Update(Matrix::Identity);
+				hierarchy.Cull(frustum);
+				hierarchy.UpdateWorldViewProjections(viewProjection);
+				currentQueue->Clear();
+				currentQueue->SetFrameConstants(&viewProjection, sizeof(viewProjection));
+				root->Render();
+				RecordedMeshNode(L"FrameMesh", frameMeshes[frame - 1], currentQueue, viewProjection).Render();
+				frameMeshes[frame - 1].reset();
+				currentQueue->Sort();
+				builtFrames[buffer] = frame;
+				visibleCounts[buffer] = hierarchy.GetVisibleCount() + 1;
+				updateTime += chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+			};
+
+		double frameTimes[2];
+		for (int threaded = 0; threaded < 2; threaded++)
+		{
+			pipeline.SetThreaded(threaded != 0);
+			updateTime = 0.0;
+			renderTime = 0.0;
+			auto start = chrono::high_resolution_clock::now();
+			for (int i = 0; i < Frames; i++)
+			{
+				update();
+				pipeline.Submit();
+			}
+			pipeline.WaitForIdle();
+			frameTimes[threaded] = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count() / Frames;
+			output << L"  " << (threaded ? L"pipelined: " : L"serial: ") << frameTimes[threaded] << L" (update " << updateTime / Frames
+				   << L", render " << renderTime / Frames << L", last wait for the render thread " << pipeline.GetStatistics().WaitTime << L")" << endl;
+		}
+		pipeline.SetThreaded(false);
+		device->SetKeepRetiredBuffers(false);
+		correct &= consistent && renderedFrame == frame && pipeline.GetCompletedFrame() == static_cast<uint64_t>(frame);
+		output << L"  " << frame << L" frames, pipelining " << frameTimes[0] / frameTimes[1] << L" times as fast on "
+			   << max(1u, thread::hardware_concurrency()) << L" hardware threads";
+		for (RenderHandle constantBuffer : constantBuffers)
+		{
+			device->ReleaseBuffer(constantBuffer);
+		}
+	}
+	correct &= device->GetBufferCount() == 0;
+	output << (correct ? L"" : L" (INCORRECT)") << endl;
+	return correct;
+}
+
+// Frames paced at a rate that does not divide into the update rate, with a short stand-in for the work of each frame
+static bool FramePacerBenchmark(wofstream& output)
+{
+	constexpr double FrameRate = 144.0;
+	constexpr double UpdateRate = 50.0;
+	constexpr int Frames = 288;
+	output << L"Frame pacer (" << FrameRate << L" frames and " << UpdateRate << L" update steps a second)" << endl;
+
+	FramePacer pacer(FrameRate, UpdateRate);
+	double simulatedTime = 0.0;
+	double frameTime = 0.0;
+	bool interpolationCorrect = true;
+	for (int i = 0; i < Frames; i++)
+	{
+		pacer.WaitForNextFrame();
+		pacer.BeginFrame();
+		simulatedTime += pacer.GetUpdateCount() * pacer.GetUpdateStep();
+		frameTime += pacer.GetFrameTime();
+		interpolationCorrect &= pacer.GetInterpolation() >= 0.0 && pacer.GetInterpolation() < 1.0;
+		// Some work that takes a varying part of the frame
+		auto workEnd = chrono::steady_clock::now() + chrono::microseconds(500 + (i % 7) * 300);
+		while (chrono::steady_clock::now() < workEnd)
+		{
+		}
+	}
+
+	// No time is lost or made up: what has not been simulated yet is what the interpolation is through a step (the
+	// first frame takes a step before any time has passed).  Frames are never late enough here for steps to be dropped.
+	double unsimulatedTime = pacer.GetInterpolation() * pacer.GetUpdateStep();
+	bool stepsCorrect = interpolationCorrect && fabs(simulatedTime + unsimulatedTime - (frameTime + pacer.GetUpdateStep())) < 1e-6;
+	// How close the frames are to the target depends on how busy the machine is, so it is reported but not checked
+	FramePacerStatistics statistics = pacer.GetStatistics();
+	output << L"  median frame time " << statistics.MedianFrameTime << L" ms (" << 1000.0 / FrameRate << L" target)" << endl;
+	output << L"  waiting " << statistics.SleepTime << L" ms asleep and " << statistics.SpinTime << L" ms spinning per frame, "
+		   << statistics.SleepSlack << L" ms sleep slack" << endl;
+	output << L"  " << simulatedTime << L" s simulated in " << frameTime << L" s" << (stepsCorrect ? L"" : L" (INCORRECT)") << endl;
+	return stepsCorrect;
+}
+
+// Mesh with the same faces and texture coordinates as _texVertices in Geometry.h (which the cubes in DirectXApp use),
+// built here since Geometry.h needs Direct3D.  Each face is the square around its normal spanned by the axes first
+// and second, whose cross product is the normal, so the triangles are clockwise seen from outside.
+static void BuildBenchmarkCube(Mesh& mesh)
+{
+	const Vector3 faces[6][3] =
+	{
+		{ Vector3(0, 0, 1), Vector3(1, 0, 0), Vector3(0, 1, 0) },
+		{ Vector3(0, 0, -1), Vector3(0, 1, 0), Vector3(1, 0, 0) },
+		{ Vector3(0, 1, 0), Vector3(0, 0, 1), Vector3(1, 0, 0) },
+		{ Vector3(0, -1, 0), Vector3(1, 0, 0), Vector3(0, 0, 1) },
+		{ Vector3(1, 0, 0), Vector3(0, 1, 0), Vector3(0, 0, 1) },
+		{ Vector3(-1, 0, 0), Vector3(0, 0, 1), Vector3(0, 1, 0) }
+	};
+	vector<ObjectVertexStruct> vertices;
+	vector<UINT> indices;
+	for (const auto& face : faces)
+	{
+		UINT first = static_cast<UINT>(vertices.size());
+		for (int corner = 0; corner < 4; corner++)
+		{
+			float a = (corner & 1) ? 1.0f : -1.0f;
+			float b = (corner & 2) ? 1.0f : -1.0f;
+			ObjectVertexStruct vertex;
+			vertex.Position = face[0] + face[1] * a + face[2] * b;
+			vertex.Normal = Vector3(0, 0, 0);
+			vertex.TextureCoordinate = Vector2((b + 1.0f) * 0.5f, (a + 1.0f) * 0.5f);
+			vertices.push_back(vertex);
+		}
+		for (UINT index : { 0u, 1u, 2u, 2u, 1u, 3u })
+		{
+			indices.push_back(first + index);
+		}
+	}
+	mesh.SetVertices(vertices.data(), vertices.size());
+	mesh.SetIndices(indices.data(), indices.size());
+	mesh.CalculateNormals();
+}
+
+// Leaf node that adds its mesh to a render queue with the same constants as CubeNode, GeometricNode and
+// TexturedCubeNode, so that the DirectXApp scene can be drawn on a software render device
+
+class ShadedMeshNode : public SceneNode
+{
+public:
+	ShadedMeshNode(wstring name, MeshPointer mesh, const MaterialConstants& material, RenderHandle pixelShader, RenderHandle texture,
+				   RenderQueue& renderQueue, const FrameConstants& frame) :
+		SceneNode(name), _mesh(mesh), _material(material), _pixelShader(pixelShader), _texture(texture), _renderQueue(renderQueue), _frame(frame)
+	{
+		SetLocalBounds(mesh->Bounds);
+	}
+
+	bool Initialise() { return true; }
+
+	void Render()
+	{
+		const Matrix& worldTransformation = GetCumulativeWorldTransformation();
+		ObjectConstants object;
+		object.WorldViewProjection = GetWorldViewProjection(_frame.ViewProjection);
+		object.World = worldTransformation;
+		object.PositionScale = _mesh->Quantisation.Scale;
+		object.PositionOffset = _mesh->Quantisation.Offset;
+
+		DrawPacket packet;
+		packet.VertexShader = 0x1000;
+		packet.PixelShader = _pixelShader;
+		packet.InputLayout = 0x3000;
+		packet.VertexBuffer = _mesh->VertexBuffer;
+		packet.IndexBuffer = _mesh->IndexBuffer;
+		packet.Texture = _texture;
+		packet.VertexStride = _mesh->BufferStride;
+		packet.IndexBufferFormat = _mesh->Indices.GetFormat();
+		packet.IndexCount = _mesh->GetLod(0).IndexCount;
+		packet.Depth = Vector3::Transform(worldTransformation.Translation(), _frame.View).z;
+		_renderQueue.Add(packet, &_material, sizeof(_material), &object, sizeof(object));
+	}
+
+private:
+	MeshPointer				_mesh;
+	MaterialConstants		_material;
+	RenderHandle			_pixelShader;
+	RenderHandle			_texture;
+	RenderQueue&			_renderQueue;
+	const FrameConstants&	_frame;
+};
+
+// The scene built by DirectXApp::CreateSceneGraph, posed as DirectXApp::UpdateSceneGraph leaves it after
+// the given number of frames, drawn through a render queue onto a software render device
+class SoftwareScene
+{
+public:
+	static constexpr RenderHandle LitShader = 0x2000;
+	static constexpr RenderHandle TexturedShader = 0x2001;
+	static constexpr RenderHandle BoxTexture = 0x4000;
+
+	SoftwareScene(shared_ptr<SoftwareRenderDevice> device, bool compressVertices, int frame) :
+		_device(device), _registry(device)
+	{
+		constexpr size_t ConstantBufferCapacity = 256 * 1024;
+
+		_device->SetPixelShader(LitShader, SoftwareShader::Lit);
+		_device->SetPixelShader(TexturedShader, SoftwareShader::Textured);
+		_registry.SetCompressVertices(compressVertices);
+		_constantBuffer = _device->CreateBuffer(BufferType::Constant, BufferUsage::Dynamic, ConstantBufferCapacity, nullptr);
+		_renderQueue.SetConstantBuffer(_constantBuffer, ConstantBufferCapacity);
+
+		// The camera and lights set up by DirectXFramework
+		float aspectRatio = static_cast<float>(_device->GetRasteriser().GetWidth()) / _device->GetRasteriser().GetHeight();
+		_frame.View = Matrix::CreateLookAt(Vector3(0.0f, 20.0f, -90.0f), Vector3(0.0f, 20.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f));
+		_frame.Projection = Matrix::CreatePerspectiveFieldOfView(XM_PIDIV4, aspectRatio, 1.0f, 10000.0f);
+		_frame.ViewProjection = _frame.View * _frame.Projection;
+		_frame.EyePosition = Vector4(0.0f, 20.0f, -90.0f, 1.0f);
+		_frame.AmbientLightColour = Vector4(0.2f, 0.2f, 0.2f, 1.0f);
+		_frame.DirectionalLightColour = Vector4(Colors::Gold);
+		_frame.DirectionalLightVector = Vector4(-1.0f, -1.0f, 1.0f, 0.0f);
+
+		MeshPointer cube = _registry.GetMesh("cube", BuildBenchmarkCube);
+		MeshPointer teapot = _registry.GetTeapot(3.0f);
+		float angle = 0.32f * frame * XM_PI / 180.0f;
+		_root = make_shared<SceneGraph>();
+		SceneGraphPointer teapotGraph = make_shared<SceneGraph>(L"TeapotMain");
+		_root->Add(teapotGraph);
+		teapotGraph->Add(MakeNode(L"Teapot01", teapot, Vector4(1.0f, 1.0f, 1.0f, 1.0f), 2.0f, LitShader, 0,
+								  Matrix::CreateScale(2.0f) * Matrix::CreateRotationY(angle) * Matrix::CreateTranslation(40.0f, 25.0f, 0.0f)));
+
+		SceneGraphPointer bodyGraph = make_shared<SceneGraph>(L"Main");
+		bodyGraph->SetWorldTransform(Matrix::CreateRotationY(angle));
+		_root->Add(bodyGraph);
+		bodyGraph->Add(MakeCube(L"Body", cube, Vector4(0, 0, 0.25f, 1.0f), Matrix::CreateScale(5.0f, 8.0f, 2.5f) * Matrix::CreateTranslation(0.0f, 23.0f, 0.0f)));
+		bodyGraph->Add(MakeCube(L"Left_Leg", cube, Vector4(0.25f, 0, 0, 1.0f), Matrix::CreateScale(1.0f, 7.5f, 1.0f) * Matrix::CreateTranslation(-4.0f, 7.5f, 0.0f)));
+		bodyGraph->Add(MakeCube(L"Right_Leg", cube, Vector4(0.25f, 0, 0, 1.0f), Matrix::CreateScale(1.0f, 7.5f, 1.0f) * Matrix::CreateTranslation(4.0f, 7.5f, 0.0f)));
+		bodyGraph->Add(MakeCube(L"Head", cube, Vector4(0, 0.25f, 0, 1.0f), Matrix::CreateScale(3.0f) * Matrix::CreateTranslation(0.0f, 34.0f, 0.0f)));
+		bodyGraph->Add(MakeCube(L"Nose", cube, Vector4(0.25f, 0, 0, 1.0f), Matrix::CreateScale(0.6f, 0.8f, 0.6f) * Matrix::CreateTranslation(0.0f, 33.0f, -3.0f)));
+
+		SceneGraphPointer armsGraph = make_shared<SceneGraph>(L"Arms");
+		armsGraph->SetWorldTransform(Matrix::CreateRotationY(angle));
+		_root->Add(armsGraph);
+		armsGraph->Add(MakeCube(L"Left_Arm", cube, Vector4(0, 0.25f, 0, 1.0f), Matrix::CreateScale(1.0f, 8.5f, 1.0f) * Matrix::CreateTranslation(0.0f, -8.0f, 0.0f) *
+								Matrix::CreateRotationX(angle) * Matrix::CreateTranslation(-6.0f, 30.0f, 0.0f)));
+		armsGraph->Add(MakeCube(L"Right_Arm", cube, Vector4(0, 0.25f, 0, 1.0f), Matrix::CreateScale(1.0f, 8.5f, 1.0f) * Matrix::CreateTranslation(0.0f, -8.0f, 0.0f) *
+								Matrix::CreateRotationX(-angle) * Matrix::CreateTranslation(6.0f, 30.0f, 0.0f)));
+
+		_root->Add(MakeNode(L"Box", cube, Vector4(1.0f, 1.0f, 1.0f, 1.0f), 8.0f, TexturedShader, BoxTexture,
+							Matrix::CreateScale(5.0f) * Matrix::CreateRotationY(angle) * Matrix::CreateTranslation(-40.0f, 25.0f, 0.0f)));
+		_hierarchy.Rebuild(_root.get());
+	}
+
+	~SoftwareScene()
+	{
+		_device->ReleaseBuffer(_constantBuffer);
+	}
+
+	// Add the draws for a frame to the device, which then has to be flushed to draw them
+	void Submit()
+	{
+		const float backgroundColour[4] = { 0.1542156899f, 0.124313750f, 0.1319411829f, 1.0f };
+		_device->ClearTargets(backgroundColour, 1.0f);
+		_hierarchy.Update(Matrix::Identity);
+		Frustum frustum;
+		frustum.Extract(_frame.ViewProjection);
+		_hierarchy.Cull(frustum);
+		_hierarchy.UpdateWorldViewProjections(_frame.ViewProjection);
+		_renderQueue.Clear();
+		_renderQueue.SetFrameConstants(&_frame, sizeof(_frame));
+		_root->Render();
+		_renderQueue.Sort();
+		_renderQueue.Submit(*_device);
+	}
+
+private:
+	shared_ptr<SoftwareRenderDevice>	_device;
+	MeshRegistry						_registry;
+	RenderQueue							_renderQueue;
+	RenderHandle						_constantBuffer;
+	FrameConstants						_frame;
+	SceneGraphPointer					_root;
+	TransformHierarchy					_hierarchy;
+
+	SceneNodePointer MakeNode(const wstring& name, MeshPointer mesh, const Vector4& colour, float specularPower, RenderHandle pixelShader,
+							  RenderHandle texture, const Matrix& transformation)
+	{
+		MaterialConstants material;
+		material.MaterialColour = colour;
+		material.SpecularColour = Vector4(1.0f, 1.0f, 1.0f, 1.0f);
+		material.SpecularPower = specularPower;
+		material.pad = Vector3(0, 0, 0);
+		shared_ptr<ShadedMeshNode> node = make_shared<ShadedMeshNode>(name, mesh, material, pixelShader, texture, _renderQueue, _frame);
+		node->SetWorldTransform(transformation);
+		return node;
+	}
+
+	// CubeNode doubles the colour it is given
+	SceneNodePointer MakeCube(const wstring& name, MeshPointer mesh, const Vector4& colour, const Matrix& transformation)
+	{
+		return MakeNode(name, mesh, Vector4(colour.x * 2.0f, colour.y * 2.0f, colour.z * 2.0f, colour.w * 2.0f), 8.0f, LitShader, 0, transformation);
+	}
+};
+
+// Shading used by the rasteriser checks.  Every pixel is white, and the first varying is checked against the
+// value it should have (see SoftwareRasteriserBenchmark).
+class CheckedShading : public PixelShading
+{
+public:
+	CheckedShading(const Matrix& projection, const Vector4& plane) : _projection(projection), _plane(plane) {}
+
+	Vector4 Shade(uint32_t draw, const float* varyings) const
+	{
+		if (draw == 1)
+		{
+			// varyings hold w, x and y in clip space, so x / w and y / w are the position on the screen.  The plane
+			// (in view space) is hit by the ray through that point at a depth of plane.w / (plane.xyz . ray).
+			Vector3 ray(varyings[1] / varyings[0] / _projection._11, varyings[2] / varyings[0] / _projection._22, 1.0f);
+			float expected = _plane.w / (_plane.x * ray.x + _plane.y * ray.y + _plane.z * ray.z);
+			lock_guard<mutex> lock(_lock);
+			_maximumError = max(_maximumError, fabsf(varyings[0] - expected) / expected);
+		}
+		return Vector4(1.0f, 1.0f, 1.0f, 1.0f);
+	}
+
+	inline float GetMaximumError() const { return _maximumError; }
+
+private:
+	Matrix				_projection;
+	Vector4				_plane;
+	mutable mutex		_lock;
+	mutable float		_maximumError{ 0.0f };
+};
+
+// The number of pixels whose channels differ by more than tolerance
+static size_t CountDifferentPixels(const vector<uint32_t>& image, const vector<uint32_t>& reference, int tolerance)
+{
+	size_t count = 0;
+	for (size_t i = 0; i < image.size(); i++)
+	{
+		for (int shift = 0; shift < 32; shift += 8)
+		{
+			if (abs(static_cast<int>((image[i] >> shift) & 0xFF) - static_cast<int>((reference[i] >> shift) & 0xFF)) > tolerance)
+			{
+				count++;
+				break;
+			}
+		}
+	}
+	return count;
+}
+
+static bool SoftwareRasteriserBenchmark(wofstream& output, bool updateGolden)
+{
+	constexpr unsigned int Width = 1280;
+	constexpr unsigned int Height = 720;
+	// The golden image is rendered smaller, so that the copy kept with the source stays small
+	constexpr unsigned int GoldenWidth = 320;
+	constexpr unsigned int GoldenHeight = 180;
+	constexpr int Iterations = 10;
+	constexpr int Frame = 100;
+	const wstring imageFileName = L"SoftwareRasteriser.tga";
+	const wstring goldenFileName = L"SoftwareRasteriserGolden.tga";
+	bool correct = true;
+
+	// A grid of triangles that covers the screen and runs out past the guard band, with jittered vertices at
+	// different depths, drawn with each triangle in front of the last.  With no gaps or overlaps along the
+	// shared edges, every pixel is drawn exactly once.
+	{
+		constexpr int GridSize = 40;
+		constexpr float GridExtent = 5.0f;
+		mt19937 random(11);
+		uniform_real_distribution<float> jitter(-0.4f, 0.4f);
+		uniform_real_distribution<float> depth(1.0f, 4.0f);
+		vector<RasterVertex> vertices((GridSize + 1) * (GridSize + 1));
+		for (int y = 0; y <= GridSize; y++)
+		{
+			for (int x = 0; x <= GridSize; x++)
+			{
+				bool edge = x == 0 || y == 0 || x == GridSize || y == GridSize;
+				float w = depth(random);
+				float ndcX = ((x + (edge ? 0.0f : jitter(random))) * 2.0f / GridSize - 1.0f) * GridExtent;
+				float ndcY = ((y + (edge ? 0.0f : jitter(random))) * 2.0f / GridSize - 1.0f) * GridExtent;
+				vertices[y * (GridSize + 1) + x].Position = Vector4(ndcX * w, ndcY * w, 0.0f, w);
+			}
+		}
+		SoftwareRasteriser rasteriser(Width - 3, Height - 5, 32);
+		const float black[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		rasteriser.Clear(black, 1.0f);
+		float triangleDepth = 0.9f;
+		for (int y = 0; y < GridSize; y++)
+		{
+			for (int x = 0; x < GridSize; x++)
+			{
+				RasterVertex corners[4] = { vertices[y * (GridSize + 1) + x], vertices[y * (GridSize + 1) + x + 1],
+											vertices[(y + 1) * (GridSize + 1) + x], vertices[(y + 1) * (GridSize + 1) + x + 1] };
+				// Clockwise on the screen, where y goes down
+				int triangles[2][3] = { { 0, 2, 1 }, { 1, 2, 3 } };
+				for (auto& triangle : triangles)
+				{
+					triangleDepth -= 1e-4f;
+					for (int corner : triangle)
+					{
+						corners[corner].Position.z = triangleDepth * corners[corner].Position.w;
+					}
+					rasteriser.AddTriangle(corners[triangle[0]], corners[triangle[1]], corners[triangle[2]], 0, 0);
+				}
+			}
+		}
+		JobSystem jobSystem;
+		rasteriser.Rasterise(CheckedShading(Matrix::Identity, Vector4(0, 0, 1, 1)), &jobSystem);
+		vector<uint32_t> image = rasteriser.GetImage();
+		size_t uncovered = count(image.begin(), image.end(), 0u);
+		size_t pixelCount = static_cast<size_t>(rasteriser.GetWidth()) * rasteriser.GetHeight();
+		bool watertight = uncovered == 0 && rasteriser.GetStatistics().PixelCount == pixelCount && rasteriser.GetStatistics().ClippedCount > 0;
+		output << L"Software rasteriser" << endl;
+		output << L"  grid of " << rasteriser.GetStatistics().TriangleCount << L" triangles (" << rasteriser.GetStatistics().ClippedCount
+			   << L" clipped): " << rasteriser.GetStatistics().PixelCount << L" pixels drawn for " << pixelCount << L", " << uncovered << L" missed"
+			   << (watertight ? L"" : L" (INCORRECT)") << endl;
+		correct &= watertight;
+	}
+
+	// A floor stretching away from the camera, with w in the varyings.  Interpolating it without perspective
+	// correction would be out by up to a factor of several.
+	{
+		Matrix projection = Matrix::CreatePerspectiveFieldOfView(XM_PIDIV4, static_cast<float>(Width) / Height, 1.0f, 1000.0f);
+		Vector3 corners[4] = { Vector3(-30.0f, -10.0f, 2.0f), Vector3(30.0f, -10.0f, 2.0f), Vector3(-30.0f, -10.0f, 200.0f), Vector3(30.0f, -10.0f, 200.0f) };
+		RasterVertex vertices[4];
+		for (int i = 0; i < 4; i++)
+		{
+			Vector4 position = Vector4::Transform(Vector4(corners[i].x, corners[i].y, corners[i].z, 1.0f), projection);
+			vertices[i].Position = position;
+			vertices[i].Varyings[0] = position.w;
+			vertices[i].Varyings[1] = position.x;
+			vertices[i].Varyings[2] = position.y;
+		}
+		SoftwareRasteriser rasteriser(Width, Height);
+		const float black[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		rasteriser.Clear(black, 1.0f);
+		// Either winding, since only one faces the camera
+		rasteriser.AddTriangle(vertices[0], vertices[2], vertices[1], 3, 1);
+		rasteriser.AddTriangle(vertices[0], vertices[1], vertices[2], 3, 1);
+		rasteriser.AddTriangle(vertices[1], vertices[2], vertices[3], 3, 1);
+		rasteriser.AddTriangle(vertices[1], vertices[3], vertices[2], 3, 1);
+		CheckedShading shading(projection, Vector4(0.0f, 1.0f, 0.0f, -10.0f));
+		rasteriser.Rasterise(shading);
+		bool perspectiveCorrect = rasteriser.GetStatistics().PixelCount > 0 && shading.GetMaximumError() < 1e-3f;
+		output << L"  floor: " << rasteriser.GetStatistics().PixelCount << L" pixels, largest relative error in w " << shading.GetMaximumError()
+			   << (perspectiveCorrect ? L"" : L" (INCORRECT)") << endl;
+		correct &= perspectiveCorrect;
+	}
+
+	// The DirectXApp scene, with a checkerboard in place of Woodbox.bmp
+	vector<uint32_t> checkerboard(64 * 64);
+	for (size_t i = 0; i < checkerboard.size(); i++)
+	{
+		checkerboard[i] = (((i % 64) / 8 + (i / 64) / 8) % 2 == 0) ? 0xFF3060A0u : 0xFFB0D0F0u;
+	}
+	shared_ptr<SoftwareRenderDevice> device = make_shared<SoftwareRenderDevice>(Width, Height);
+	device->SetTextureImage(SoftwareScene::BoxTexture, 64, 64, checkerboard.data());
+	vector<uint32_t> reference;
+	{
+		SoftwareScene scene(device, true, Frame);
+		SoftwareRasteriser::Path bestPath = SoftwareRasteriser::GetPath();
+		unsigned int hardwareThreads = max(1u, thread::hardware_concurrency());
+		vector<unsigned int> threadCounts;
+		for (unsigned int threads = 1; threads < hardwareThreads; threads *= 2)
+		{
+			threadCounts.push_back(threads);
+		}
+		threadCounts.push_back(hardwareThreads);
+		for (int path = static_cast<int>(bestPath); path >= 0; path--)
+		{
+			SoftwareRasteriser::SetPath(static_cast<SoftwareRasteriser::Path>(path));
+			for (unsigned int threads : threadCounts)
+			{
+				// The slower paths are only timed on one thread
+				if (path != static_cast<int>(bestPath) && threads > 1)
+				{
+					break;
+				}
+				unique_ptr<JobSystem> jobSystem = threads > 1 ? make_unique<JobSystem>(threads - 1) : nullptr;
+				device->SetJobSystem(jobSystem.get());
+				double submitTime = 0.0;
+				double rasteriseTime = 0.0;
+				size_t pixelCount = 0;
+				for (int i = 0; i < Iterations; i++)
+				{
+					auto start = chrono::high_resolution_clock::now();
+					scene.Submit();
+					auto submitted = chrono::high_resolution_clock::now();
+					device->Flush();
+					auto end = chrono::high_resolution_clock::now();
+					submitTime += chrono::duration<double, milli>(submitted - start).count() / Iterations;
+					rasteriseTime += chrono::duration<double, milli>(end - submitted).count() / Iterations;
+					pixelCount = device->GetRasteriser().GetStatistics().PixelCount;
+				}
+
+				// Every path and number of threads must give exactly the same image
+				vector<uint32_t> image = device->GetRasteriser().GetImage();
+				if (reference.empty())
+				{
+					reference = image;
+				}
+				bool same = image == reference;
+				correct &= same;
+				output << L"  " << SoftwareRasteriser::GetPathName(SoftwareRasteriser::GetPath()) << L", " << threads << (threads == 1 ? L" thread" : L" threads")
+					   << L": " << Width << L"x" << Height << L" scene " << submitTime << L" ms to submit, " << rasteriseTime << L" ms to rasterise ("
+					   << pixelCount / (rasteriseTime * 1000.0) << L" Mpixels/s, " << (Width * Height) / (rasteriseTime * 1000.0) << L" Mpixels/s of image)"
+					   << (same ? L"" : L" (INCORRECT)") << endl;
+				device->SetJobSystem(nullptr);
+			}
+		}
+		SoftwareRasteriser::SetPath(bestPath);
+		const RasteriserStatistics& statistics = device->GetRasteriser().GetStatistics();
+		output << L"  scene: " << statistics.TriangleCount << L" triangles, " << statistics.CulledCount << L" culled, " << statistics.ClippedCount
+			   << L" clipped, " << statistics.BinnedCount << L" binned, " << statistics.PixelCount << L" pixels drawn" << endl;
+		device->GetRasteriser().SaveImage(imageFileName);
+	}
+
+	// Compare the scene with the golden image.  A missing golden image is a failure, so that a check that has
+	// stopped being made cannot pass; the golden image is only replaced (to accept a change to the rendering)
+	// when asked for.
+	{
+		shared_ptr<SoftwareRenderDevice> goldenDevice = make_shared<SoftwareRenderDevice>(GoldenWidth, GoldenHeight);
+		goldenDevice->SetTextureImage(SoftwareScene::BoxTexture, 64, 64, checkerboard.data());
+		{
+			SoftwareScene scene(goldenDevice, true, Frame);
+			scene.Submit();
+			goldenDevice->Flush();
+		}
+		vector<uint32_t> image = goldenDevice->GetRasteriser().GetImage();
+		unsigned int goldenWidth;
+		unsigned int goldenHeight;
+		vector<uint32_t> golden;
+		if (updateGolden)
+		{
+			bool written = goldenDevice->GetRasteriser().SaveImage(goldenFileName);
+			output << L"  golden image " << (written ? L"written" : L"could not be written (INCORRECT)") << endl;
+			correct &= written;
+		}
+		else if (SoftwareRasteriser::LoadImage(goldenFileName, goldenWidth, goldenHeight, golden))
+		{
+			size_t different = goldenWidth == GoldenWidth && goldenHeight == GoldenHeight ? CountDifferentPixels(image, golden, 2) : image.size();
+			bool matches = different * 1000 < image.size();
+			output << L"  golden image (" << GoldenWidth << L"x" << GoldenHeight << L"): " << different << L" pixels differ"
+				   << (matches ? L"" : L" (INCORRECT)") << endl;
+			correct &= matches;
+		}
+		else
+		{
+			output << L"  golden image " << goldenFileName << L" is missing (INCORRECT)" << endl;
+			correct = false;
+		}
+		correct &= goldenDevice->GetBufferCount() == 0;
+	}
+
+	// Compressed vertices only move the edges of the triangles slightly
+	{
+		SoftwareScene scene(device, false, Frame);
+		scene.Submit();
+		device->Flush();
+		size_t different = CountDifferentPixels(device->GetRasteriser().GetImage(), reference, 2);
+		bool close = different * 200 < reference.size();
+		output << L"  uncompressed vertices: " << different << L" pixels differ from compressed vertices" << (close ? L"" : L" (INCORRECT)") << endl;
+		correct &= close;
+	}
+	// Nothing should be left on the device once the meshes have gone
+	correct &= device->GetBufferCount() == 0;
+	return correct;
+}
+
+// Shading that makes every pixel white, for when only the coverage and depth of what is drawn matter
+class FlatShading : public PixelShading
+{
+public:
+	Vector4 Shade(uint32_t, const float*) const { return Vector4(1.0f, 1.0f, 1.0f, 1.0f); }
+};
+
+// Add the triangles of a mesh to the rasteriser with no varyings
+static void AddMeshTriangles(SoftwareRasteriser& rasteriser, const Mesh& mesh, const Matrix& worldViewProjection)
+{
+	vector<RasterVertex> vertices(mesh.VertexCount);
+	const uint8_t* vertex = mesh.GetVertexData();
+	for (unsigned int i = 0; i < mesh.VertexCount; i++, vertex += mesh.VertexStride)
+	{
+		const Vector3& position = *reinterpret_cast<const Vector3*>(vertex);
+		vertices[i].Position = Vector4::Transform(Vector4(position.x, position.y, position.z, 1.0f), worldViewProjection);
+	}
+	// Only the full detail level, since the levels of detail are stored after it in the same index buffer
+	MeshLod lod = mesh.GetLod(0);
+	for (size_t i = lod.IndexStart; i + 2 < lod.IndexStart + lod.IndexCount; i += 3)
+	{
+		rasteriser.AddTriangle(vertices[mesh.Indices[i]], vertices[mesh.Indices[i + 1]], vertices[mesh.Indices[i + 2]], 0, 0);
+	}
+}
+
+// A row of walls in front of a field of boxes, seen from where DirectXApp puts the camera.  Some of the boxes are
+// hidden by the walls, and others are seen through the gaps between them, over their tops or to the sides.
+static bool OcclusionCullingBenchmark(wofstream& output)
+{
+	constexpr unsigned int Width = 320;
+	constexpr unsigned int Height = 180;
+	constexpr int WallCount = 5;
+	constexpr int FieldSize = 32;
+	constexpr int Iterations = 100;
+	output << L"Occlusion culling (" << WallCount << L" walls in front of " << FieldSize * FieldSize << L" boxes, " << Width << L"x" << Height << L" buffer):" << endl;
+
+	MeshRegistry registry(nullptr);
+	MeshPointer cube = registry.GetMesh("cube", BuildBenchmarkCube);
+	SceneGraphPointer root = make_shared<SceneGraph>();
+	vector<shared_ptr<BenchmarkNode>> walls;
+	vector<shared_ptr<BenchmarkNode>> boxes;
+	for (int i = 0; i < WallCount; i++)
+	{
+		shared_ptr<BenchmarkNode> wall = make_shared<BenchmarkNode>(L"Wall" + to_wstring(i));
+		wall->SetWorldTransform(Matrix::CreateScale(14.0f, 20.0f, 2.0f) * Matrix::CreateTranslation((i - WallCount / 2) * 32.0f, 10.0f, 20.0f));
+		wall->SetLocalBounds(cube->Bounds);
+		root->Add(wall);
+		walls.push_back(wall);
+	}
+	// Each row of the field is a graph of its own, so that a row hidden completely is hidden with one test
+	for (int z = 0; z < FieldSize; z++)
+	{
+		SceneGraphPointer row = make_shared<SceneGraph>(L"Row" + to_wstring(z));
+		row->SetWorldTransform(Matrix::CreateTranslation(0.0f, 0.0f, 40.0f + z * 8.0f));
+		root->Add(row);
+		for (int x = 0; x < FieldSize; x++)
+		{
+			shared_ptr<BenchmarkNode> box = make_shared<BenchmarkNode>(L"Box" + to_wstring(z * FieldSize + x));
+			float height = 1.5f + ((x * 7 + z * 3) % 5) * 2.0f;
+			box->SetWorldTransform(Matrix::CreateScale(1.5f) * Matrix::CreateTranslation((x - FieldSize / 2) * 6.0f, height, 0.0f));
+			box->SetLocalBounds(cube->Bounds);
+			row->Add(box);
+			boxes.push_back(box);
+		}
+	}
+
+	Matrix view = XMMatrixLookAtLH(Vector3(0.0f, 20.0f, -90.0f), Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f));
+	Matrix projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, static_cast<float>(Width) / Height, 1.0f, 10000.0f);
+	Matrix viewProjection = view * projection;
+	TransformHierarchy hierarchy;
+	hierarchy.Rebuild(root.get());
+	hierarchy.Update(Matrix::Identity);
+	Frustum frustum;
+	frustum.Extract(viewProjection);
+	OcclusionCuller culler(Width, Height);
+	bool correct = true;
+	MeshLod lod = cube->GetLod(0);
+	for (const auto& wall : walls)
+	{
+		cube->Indices.Visit([&](const auto* indices, size_t)
+			{
+				correct &= culler.AddOccluder(wall, cube->GetVertexData(), cube->VertexCount, cube->VertexStride, indices + lod.IndexStart, lod.IndexCount);
+			});
+	}
+	// An occluder with an index past its last vertex is rejected, rather than read out of bounds when it is drawn
+	const uint32_t badIndices[] = { 0, 1, static_cast<uint32_t>(cube->VertexCount) };
+	correct &= !culler.AddOccluder(boxes[0], cube->GetVertexData(), cube->VertexCount, cube->VertexStride, badIndices, 3) &&
+			   culler.GetOccluderCount() == walls.size();
+
+	vector<bool> referenceHidden;
+	vector<float> referenceDepths;
+	OcclusionCuller::Path bestPath = OcclusionCuller::GetPath();
+	for (int path = static_cast<int>(bestPath); path >= 0; path--)
+	{
+		OcclusionCuller::SetPath(static_cast<OcclusionCuller::Path>(path));
+		double rasteriseTime = 0.0;
+		double testTime = 0.0;
+		size_t frustumVisible = 0;
+		for (int i = 0; i < Iterations; i++)
+		{
+			hierarchy.Cull(frustum);
+			frustumVisible = hierarchy.GetVisibleCount();
+			culler.Cull(hierarchy, viewProjection);
+			rasteriseTime += culler.GetStatistics().RasteriseTime / Iterations;
+			testTime += culler.GetStatistics().TestTime / Iterations;
+		}
+
+		// Every path must draw the same buffer and hide the same boxes
+		vector<bool> hidden;
+		for (const auto& box : boxes)
+		{
+			hidden.push_back(!box->IsVisible());
+		}
+		vector<float> depths;
+		for (unsigned int y = 0; y < Height; y += OcclusionCuller::TileHeight)
+		{
+			for (unsigned int x = 0; x < Width; x += OcclusionCuller::TileWidth)
+			{
+				depths.push_back(culler.GetTileDepth(x, y));
+			}
+		}
+		if (referenceHidden.empty())
+		{
+			referenceHidden = hidden;
+			referenceDepths = depths;
+		}
+		bool same = hidden == referenceHidden && depths == referenceDepths;
+		correct &= same;
+		const OcclusionStatistics& statistics = culler.GetStatistics();
+		output << L"  " << OcclusionCuller::GetPathName(OcclusionCuller::GetPath()) << L": " << statistics.OccluderCount << L" occluders ("
+			   << statistics.TriangleCount << L" triangles) drawn in " << rasteriseTime << L" ms, " << statistics.TestCount << L" boxes tested in "
+			   << testTime << L" ms, " << statistics.OccludedCount << L" of " << frustumVisible << L" visible nodes hidden" << (same ? L"" : L" (INCORRECT)") << endl;
+		correct &= statistics.OccludedCount > 0;
+	}
+	OcclusionCuller::SetPath(bestPath);
+
+	// Occluders must never hide themselves (they are side by side, so none can hide another)
+	bool wallsVisible = all_of(walls.begin(), walls.end(), [](const shared_ptr<BenchmarkNode>& wall) { return wall->IsVisible(); });
+
+	// The culling must be conservative: drawing the bounding box of a hidden box into a full resolution depth
+	// buffer holding the walls must not change any pixel
+	SoftwareRasteriser rasteriser(Width, Height);
+	FlatShading shading;
+	const float black[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	rasteriser.Clear(black, 1.0f);
+	for (const auto& wall : walls)
+	{
+		AddMeshTriangles(rasteriser, *cube, wall->GetCumulativeWorldTransformation() * viewProjection);
+	}
+	rasteriser.Rasterise(shading);
+	size_t hiddenCount = 0;
+	size_t wronglyHidden = 0;
+	for (size_t i = 0; i < boxes.size(); i++)
+	{
+		if (referenceHidden[i])
+		{
+			AxisAlignedBox bounds = boxes[i]->GetLocalBounds().Transform(boxes[i]->GetCumulativeWorldTransformation());
+			Matrix boxTransformation = Matrix::CreateScale(bounds.GetExtents()) * Matrix::CreateTranslation(bounds.GetCentre());
+			size_t pixelCount = rasteriser.GetStatistics().PixelCount;
+			AddMeshTriangles(rasteriser, *cube, boxTransformation * viewProjection);
+			rasteriser.Rasterise(shading);
+			hiddenCount++;
+			wronglyHidden += rasteriser.GetStatistics().PixelCount > pixelCount;
+		}
+	}
+	bool conservative = wallsVisible && wronglyHidden == 0;
+	output << L"  " << hiddenCount << L" boxes hidden, " << wronglyHidden << L" of them visible at full resolution"
+		   << (wallsVisible ? L"" : L", walls hidden") << (conservative ? L"" : L" (INCORRECT)") << endl;
+	correct &= conservative;
+	return correct;
+}
+
+// A grid of quads with random heights, used for the mesh processing benchmarks
+struct BenchmarkVertex
+{
+	Vector3		Position;
+	Vector3		Normal;
+};
+
+static void BuildBenchmarkGrid(size_t size, vector<BenchmarkVertex>& vertices, vector<UINT>& indices, mt19937& random)
+{
+	uniform_real_distribution<float> height(-0.5f, 0.5f);
+	vertices.resize((size + 1) * (size + 1));
+	for (size_t z = 0; z <= size; z++)
+	{
+		for (size_t x = 0; x <= size; x++)
+		{
+			vertices[z * (size + 1) + x].Position = Vector3(static_cast<float>(x), height(random), static_cast<float>(z));
+		}
+	}
+	indices.clear();
+	indices.reserve(size * size * 6);
+	for (size_t z = 0; z < size; z++)
+	{
+		for (size_t x = 0; x < size; x++)
+		{
+			UINT corner = static_cast<UINT>(z * (size + 1) + x);
+			UINT above = corner + static_cast<UINT>(size + 1);
+			indices.insert(indices.end(), { corner, above, corner + 1, corner + 1, above, above + 1 });
+		}
+	}
+}
+
+static bool NormalGeneratorBenchmark(wofstream& output)
+{
+	constexpr size_t GridSize = 1024;
+	constexpr int Iterations = 5;
+
+	mt19937 random(3);
+	vector<BenchmarkVertex> vertices;
+	vector<UINT> indices;
+	BuildBenchmarkGrid(GridSize, vertices, indices, random);
+
+	// The loop that the generator replaces: scatter each triangle normal into its vertices, then normalise
+	vector<Vector3> reference(vertices.size());
+	double scatterTime = TimeIterations(Iterations, [&](int)
+		{
+			fill(reference.begin(), reference.end(), Vector3(0, 0, 0));
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				const Vector3& p0 = vertices[indices[i]].Position;
+				Vector3 normal = (vertices[indices[i + 1]].Position - p0).Cross(vertices[indices[i + 2]].Position - p0);
+				reference[indices[i]] += normal;
+				reference[indices[i + 1]] += normal;
+				reference[indices[i + 2]] += normal;
+			}
+			for (Vector3& normal : reference)
+			{
+				normal.Normalize();
+			}
+		});
+
+	auto maximumError = [&](const vector<Vector3>& expected)
+		{
+			float error = 0.0f;
+			for (size_t i = 0; i < vertices.size(); i++)
+			{
+				error = max(error, Vector3::Distance(vertices[i].Normal, expected[i]));
+			}
+			return error;
+		};
+
+	NormalGenerator generator;
+	double adjacencyTime = TimeIterations(1, [&](int) { generator.SetTriangles(indices.data(), indices.size(), vertices.size()); });
+	auto generate = [&](NormalWeighting weighting, JobSystem* jobSystem)
+		{
+			return TimeIterations(Iterations, [&](int) { generator.Generate(&vertices[0].Position, &vertices[0].Normal, sizeof(BenchmarkVertex), weighting, jobSystem); });
+		};
+
+	generator.SetVectorised(false);
+	double scalarTime = generate(NormalWeighting::Area, nullptr);
+	bool correct = maximumError(reference) < 1e-4f;
+	generator.SetVectorised(true);
+	double vectorTime = generate(NormalWeighting::Area, nullptr);
+	correct &= maximumError(reference) < 1e-4f;
+	JobSystem jobSystem;
+	double parallelTime = generate(NormalWeighting::Area, &jobSystem);
+	correct &= maximumError(reference) < 1e-4f;
+
+	// Angle weighting uses an approximate acos in the vectorised kernel, so compare it with the scalar kernel
+	generator.SetVectorised(false);
+	double scalarAngleTime = generate(NormalWeighting::Angle, nullptr);
+	vector<Vector3> angleReference(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		angleReference[i] = vertices[i].Normal;
+	}
+	generator.SetVectorised(true);
+	double parallelAngleTime = generate(NormalWeighting::Angle, &jobSystem);
+	correct &= maximumError(angleReference) < 1e-3f;
+
+	// A flat grid must have normals pointing straight up whichever weighting is used
+	for (BenchmarkVertex& vertex : vertices)
+	{
+		vertex.Position.y = 0.0f;
+	}
+	generator.Generate(&vertices[0].Position, &vertices[0].Normal, sizeof(BenchmarkVertex), NormalWeighting::Angle, &jobSystem);
+	correct &= maximumError(vector<Vector3>(vertices.size(), Vector3(0, 1, 0))) < 1e-5f;
+
+	output << L"Vertex normals (ms for " << indices.size() / 3 << L" triangles, " << NormalGenerator::GetInstructionSet()
+		   << L", " << jobSystem.GetThreadCount() << L" threads)" << endl;
+	output << L"  scatter loop " << scatterTime << L", adjacency " << adjacencyTime << endl;
+	output << L"  area: scalar " << scalarTime << L", vectorised " << vectorTime << L", vectorised + threads " << parallelTime << endl;
+	output << L"  angle: scalar " << scalarAngleTime << L", vectorised + threads " << parallelAngleTime;
+	output << (correct ? L"" : L" (INCORRECT)") << endl;
+	return correct;
+}
+
+// Each triangle of a mesh, rotated so that its lowest vertex comes first (which keeps the winding), in sorted order
+static vector<tuple<UINT, UINT, UINT>> SortedTriangles(const vector<UINT>& indices, const vector<UINT>& vertexIds)
+{
+	vector<tuple<UINT, UINT, UINT>> triangles;
+	triangles.reserve(indices.size() / 3);
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		UINT a = vertexIds[indices[i]];
+		UINT b = vertexIds[indices[i + 1]];
+		UINT c = vertexIds[indices[i + 2]];
+		if (b < a && b < c)
+		{
+			triangles.emplace_back(b, c, a);
+		}
+		else if (c < a && c < b)
+		{
+			triangles.emplace_back(c, a, b);
+		}
+		else
+		{
+			triangles.emplace_back(a, b, c);
+		}
+	}
+	sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+static bool MeshOptimiserBenchmark(wofstream& output)
+{
+	constexpr size_t GridSize = 256;
+
+	// A grid whose triangles are in random order, like a mesh exported without any optimisation.  The
+	// vertex's original number is kept in its normal, so the triangles can be compared afterwards.
+	mt19937 random(5);
+	vector<BenchmarkVertex> vertices;
+	vector<UINT> indices;
+	BuildBenchmarkGrid(GridSize, vertices, indices, random);
+	vector<size_t> order(indices.size() / 3);
+	iota(order.begin(), order.end(), 0);
+	shuffle(order.begin(), order.end(), random);
+	vector<UINT> shuffled;
+	shuffled.reserve(indices.size());
+	for (size_t triangle : order)
+	{
+		shuffled.insert(shuffled.end(), indices.begin() + triangle * 3, indices.begin() + triangle * 3 + 3);
+	}
+	indices.swap(shuffled);
+	vector<UINT> originalIds(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		vertices[i].Normal.x = static_cast<float>(i);
+		originalIds[i] = static_cast<UINT>(i);
+	}
+	auto before = SortedTriangles(indices, originalIds);
+	VertexCacheStatistics gridBefore = MeshOptimiser::AnalyseVertexCache(indices.data(), indices.size(), vertices.size());
+
+	double optimiseTime = TimeIterations(1, [&](int) { MeshOptimiser::Optimise(vertices, indices); });
+	VertexCacheStatistics gridAfter = MeshOptimiser::AnalyseVertexCache(indices.data(), indices.size(), vertices.size());
+
+	// The same triangles must be drawn, and the vertices must be in the order they are first used
+	vector<UINT> newIds(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		newIds[i] = static_cast<UINT>(vertices[i].Normal.x);
+	}
+	bool correct = vertices.size() == originalIds.size() && SortedTriangles(indices, newIds) == before;
+	UINT firstUnused = 0;
+	for (UINT index : indices)
+	{
+		correct &= index <= firstUnused;
+		firstUnused = max(firstUnused, index + 1);
+	}
+	correct &= gridAfter.ACMR < gridBefore.ACMR * 0.5f && gridAfter.ATVR < 1.5f;
+
+	// The meshes in the registry, built without and with optimisation
+	MeshRegistry registry(nullptr);
+	auto analyse = [](const MeshPointer& mesh)
+		{
+			vector<UINT> meshIndices;
+			mesh->Indices.CopyTo(meshIndices);
+			meshIndices.resize(mesh->GetLod(0).IndexCount);
+			return MeshOptimiser::AnalyseVertexCache(meshIndices.data(), meshIndices.size(), mesh->VertexCount);
+		};
+	registry.SetOptimiseMeshes(false);
+	MeshPointer teapot = registry.GetTeapot(3.0f);
+	MeshPointer sphere = registry.GetSphere(1.0f, 64);
+	VertexCacheStatistics teapotBefore = analyse(teapot);
+	VertexCacheStatistics sphereBefore = analyse(sphere);
+	teapot.reset();
+	sphere.reset();
+	registry.SetOptimiseMeshes(true);
+	teapot = registry.GetTeapot(3.0f);
+	sphere = registry.GetSphere(1.0f, 64);
+	VertexCacheStatistics teapotAfter = analyse(teapot);
+	VertexCacheStatistics sphereAfter = analyse(sphere);
+	// The teapot's patches are already in a good order, which the optimiser must not make worse
+	correct &= registry.GetBuildCount() == 4 && teapotAfter.ACMR <= teapotBefore.ACMR && sphereAfter.ACMR < sphereBefore.ACMR;
+
+	output << L"Mesh optimiser (ACMR / ATVR for a 16 entry FIFO cache, before -> after)" << endl;
+	output << L"  shuffled grid " << gridBefore.ACMR << L" / " << gridBefore.ATVR << L" -> " << gridAfter.ACMR << L" / " << gridAfter.ATVR
+		   << L" in " << optimiseTime << L" ms for " << indices.size() / 3 << L" triangles" << endl;
+	output << L"  teapot " << teapotBefore.ACMR << L" / " << teapotBefore.ATVR << L" -> " << teapotAfter.ACMR << L" / " << teapotAfter.ATVR << endl;
+	output << L"  sphere " << sphereBefore.ACMR << L" / " << sphereBefore.ATVR << L" -> " << sphereAfter.ACMR << L" / " << sphereAfter.ATVR;
+	output << (correct ? L"" : L" (INCORRECT)") << endl;
+	return correct;
+}
+
+static inline const Vector3& GetPosition(const Mesh& mesh, UINT vertex)
+{
+	return *reinterpret_cast<const Vector3*>(mesh.GetVertexData() + static_cast<size_t>(vertex) * mesh.VertexStride);
+}
+
+// Signed volume of a closed triangle list, which is positive if the triangles are wound clockwise seen from outside
+static double GetVolume(const Mesh& mesh, const MeshLod& lod)
+{
+	double volume = 0.0;
+	for (size_t i = lod.IndexStart; i < lod.IndexStart + lod.IndexCount; i += 3)
+	{
+		const Vector3& p0 = GetPosition(mesh, mesh.Indices[i]);
+		const Vector3& p1 = GetPosition(mesh, mesh.Indices[i + 1]);
+		const Vector3& p2 = GetPosition(mesh, mesh.Indices[i + 2]);
+		volume += p0.Dot(p2.Cross(p1)) / 6.0;
+	}
+	return volume;
+}
+
+static bool MeshSimplifierBenchmark(wofstream& output)
+{
+	bool correct = true;
+	MeshRegistry registry(nullptr);
+	registry.SetGenerateLods(false);
+	MeshPointer sphere = registry.GetSphere(1.0f, 256);
+	MeshPointer teapot = registry.GetTeapot(3.0f);
+	double sphereTime = TimeIterations(1, [&](int) { sphere->GenerateLods(); });
+	double teapotTime = TimeIterations(1, [&](int) { teapot->GenerateLods(); });
+
+	// Every level has fewer triangles and more error than the one before, uses valid vertices, keeps the shape (the
+	// sphere's volume) and does not turn any triangles over
+	for (const MeshPointer& mesh : { sphere, teapot })
+	{
+		correct &= mesh->GetLodCount() >= 4 && mesh->Lods[0].IndexStart == 0 && mesh->Lods[0].Error == 0.0f;
+		double fullVolume = GetVolume(*mesh, mesh->GetLod(0));
+		for (size_t level = 1; level < mesh->GetLodCount(); level++)
+		{
+			MeshLod lod = mesh->GetLod(level);
+			MeshLod previous = mesh->GetLod(level - 1);
+			correct &= lod.IndexCount % 3 == 0 && lod.IndexCount < previous.IndexCount && lod.Error >= previous.Error;
+			correct &= lod.IndexStart == previous.IndexStart + previous.IndexCount && lod.IndexStart + lod.IndexCount <= mesh->GetIndexCount();
+			for (size_t i = lod.IndexStart; i < lod.IndexStart + lod.IndexCount; i++)
+			{
+				correct &= mesh->Indices[i] < mesh->VertexCount;
+			}
+		}
+		if (mesh == sphere)
+		{
+			// Triangles that face the centre of the sphere have been turned over (the full detail sphere has a few slivers at
+			// the poles that already do)
+			auto countInverted = [&](const MeshLod& lod)
+				{
+					size_t inverted = 0;
+					for (size_t i = lod.IndexStart; i < lod.IndexStart + lod.IndexCount; i += 3)
+					{
+						const Vector3& p0 = GetPosition(*mesh, mesh->Indices[i]);
+						const Vector3& p1 = GetPosition(*mesh, mesh->Indices[i + 1]);
+						const Vector3& p2 = GetPosition(*mesh, mesh->Indices[i + 2]);
+						inverted += (p2 - p0).Cross(p1 - p0).Dot(p0 + p1 + p2) * fullVolume < 0.0;
+					}
+					return inverted;
+				};
+			MeshLod coarsest = mesh->GetLod(mesh->GetLodCount() - 1);
+			correct &= fabs(GetVolume(*mesh, coarsest) / fullVolume - 1.0) < 0.1 && countInverted(coarsest) <= countInverted(mesh->GetLod(0));
+		}
+	}
+
+	// Levels get coarser as the mesh gets smaller on screen, and the hysteresis stops a mesh that moves back and forth
+	// across a boundary from switching between levels
+	Mesh chain;
+	chain.Lods = { { 0, 300, 0.0f, 0 }, { 300, 150, 0.01f, 0 }, { 450, 75, 0.02f, 0 } };
+	size_t level = 0;
+	vector<size_t> levels;
+	for (float pixelsPerUnit : { 1000.0f, 90.0f, 70.0f, 90.0f, 70.0f, 110.0f, 10.0f, 0.0f, 1.0e10f })
+	{
+		level = chain.SelectLod(pixelsPerUnit, level);
+		levels.push_back(level);
+	}
+	correct &= levels == vector<size_t>{ 0, 0, 1, 1, 1, 0, 2, 2, 0 };
+	correct &= Mesh().SelectLod(0.0f, 3) == 0 && Mesh().GetLod(0).IndexCount == 0;
+
+	output << L"Mesh simplifier (ms to build the levels of detail)" << endl;
+	for (const MeshPointer& mesh : { sphere, teapot })
+	{
+		output << (mesh == sphere ? L"  sphere " : L"\n  teapot ") << (mesh == sphere ? sphereTime : teapotTime) << L", triangles";
+		for (size_t i = 0; i < mesh->GetLodCount(); i++)
+		{
+			output << L" " << mesh->GetLod(i).IndexCount / 3;
+		}
+	}
+	output << (correct ? L"" : L" (INCORRECT)") << endl;
+	return correct;
+}
+
+static bool MeshFileBenchmark(wofstream& output)
+{
+	const wstring fileName = L"BenchmarkMesh.mesh";
+	const vector<MeshVertexElement> layout = {
+		MeshFile::MakeElement("POSITION", 0, MeshElementFormat::Float3, 0),
+		MeshFile::MakeElement("NORMAL", 0, MeshElementFormat::Float3, sizeof(Vector3))
+	};
+
+	// A large mesh, built the way meshes are built at startup and then baked
+	MeshRegistry registry(nullptr);
+	MeshPointer built;
+	double buildTime = TimeIterations(1, [&](int) { built = registry.GetSphere(1.0f, 500); });
+	bool correct = true;
+	double saveTime = TimeIterations(1, [&](int) { correct &= built->Save(fileName, layout); });
+	uint32_t stride = static_cast<uint32_t>(built->VertexStride);
+
+	// Loading maps the file and checks the indices, without copying anything
+	MeshPointer loaded;
+	double loadTime = TimeIterations(1, [&](int) { loaded = registry.LoadMesh(fileName, layout, stride); });
+	correct &= loaded != nullptr && registry.GetLoadCount() == 1;
+	if (loaded)
+	{
+		correct &= loaded->VertexCount == built->VertexCount && loaded->VertexStride == built->VertexStride &&
+				   loaded->Indices.GetFormat() == built->Indices.GetFormat() && loaded->GetIndexCount() == built->GetIndexCount() &&
+				   loaded->Bounds.Min == built->Bounds.Min && loaded->Bounds.Max == built->Bounds.Max &&
+				   loaded->Lods.size() == built->Lods.size() && loaded->Lods.size() > 1 &&
+				   memcmp(loaded->Lods.data(), built->Lods.data(), built->Lods.size() * sizeof(MeshLod)) == 0;
+		correct &= loaded->GetVertexData() == loaded->File->GetVertexData() && loaded->Indices.GetData() == loaded->File->GetIndexData();
+		correct &= reinterpret_cast<uintptr_t>(loaded->GetVertexData()) % MeshFile::StreamAlignment == 0 &&
+				   reinterpret_cast<uintptr_t>(loaded->Indices.GetData()) % MeshFile::StreamAlignment == 0;
+		correct &= memcmp(loaded->GetVertexData(), built->GetVertexData(), built->GetVertexDataSize()) == 0 &&
+				   memcmp(loaded->Indices.GetData(), built->Indices.GetData(), built->Indices.GetSize()) == 0;
+		correct &= loaded->File->GetElementCount() == 2 && strcmp(loaded->File->GetElements()[1].Semantic, "NORMAL") == 0;
+		correct &= registry.LoadMesh(fileName, layout, stride) == loaded;
+
+		// A mesh whose elements are in a different place must not be drawn as if it had the layout asked for,
+		// whether or not it has already been loaded
+		const vector<MeshVertexElement> swappedLayout = {
+			MeshFile::MakeElement("NORMAL", 0, MeshElementFormat::Float3, 0),
+			MeshFile::MakeElement("POSITION", 0, MeshElementFormat::Float3, sizeof(Vector3))
+		};
+		MeshRegistry otherRegistry(nullptr);
+		correct &= registry.LoadMesh(fileName, swappedLayout, stride) == nullptr && otherRegistry.LoadMesh(fileName, swappedLayout, stride) == nullptr &&
+				   otherRegistry.LoadMesh(fileName, layout, stride + 4) == nullptr && otherRegistry.GetLoadCount() == 0;
+
+		// Loaded meshes are uploaded as they are stored, without going through vertex compression
+		shared_ptr<RecordingRenderDevice> device = make_shared<RecordingRenderDevice>();
+		MeshRegistry uploadRegistry(device);
+		MeshPointer uploaded = uploadRegistry.LoadMesh(fileName, layout, stride);
+		correct &= uploaded != nullptr && !uploaded->CompressedVertices && uploaded->BufferStride == uploaded->VertexStride &&
+				   device->IsBuffer(uploaded->VertexBuffer);
+	}
+	size_t fileSize = built->GetVertexDataSize() + built->Indices.GetSize();
+	loaded.reset();
+
+	// Damaged files must be rejected
+	{
+		MappedFile file;
+		file.Open(fileName);
+		vector<uint8_t> data(file.GetData(), file.GetData() + file.GetSize());
+		file.Close();
+		MeshFile meshFile;
+		MappedFile::WriteFile(fileName, data.data(), data.size() - 1);
+		correct &= !meshFile.Open(fileName);
+		// The index stream is at the end of the file, so this makes the last index refer to the vertex after the last one
+		vector<uint8_t> badIndex = data;
+		UINT vertexCount = static_cast<UINT>(built->VertexCount);
+		memcpy(badIndex.data() + badIndex.size() - built->Indices.GetElementSize(), &vertexCount, built->Indices.GetElementSize());
+		MappedFile::WriteFile(fileName, badIndex.data(), badIndex.size());
+		correct &= !meshFile.Open(fileName);
+		data[0] ^= 0xFF;
+		MappedFile::WriteFile(fileName, data.data(), data.size());
+		correct &= !meshFile.Open(fileName) && registry.LoadMesh(fileName, layout, stride) == nullptr;
+	}
+	correct &= registry.LoadMesh(L"BenchmarkMissing.mesh", layout, stride) == nullptr;
+	remove(string(fileName.begin(), fileName.end()).c_str());
+
+	output << L"Mesh files (ms for a " << built->VertexCount << L" vertex mesh, " << fileSize / (1024 * 1024) << L" MB)" << endl;
+	output << L"  generate " << buildTime << L", save " << saveTime << L", load " << loadTime;
+	output << (correct ? L"" : L" (INCORRECT)") << endl;
+	return correct;
+}
+
+// Write a grid of quads with normals and texture coordinates as an OBJ file.  The grid is written in right handed
+// coordinates, so it should import as the same grid as BuildBenchmarkGrid makes.  The first half of the rows use
+// one material and the second half another, and a second object has a single quad that uses negative indices.
+static string BuildBenchmarkObj(size_t size)
+{
+	string text = "# Benchmark grid\no Grid\n";
+	char line[128];
+	for (size_t z = 0; z <= size; z++)
+	{
+		for (size_t x = 0; x <= size; x++)
+		{
+			snprintf(line, sizeof(line), "v %zu %.4f -%zu\nvt %.6f %.6f\nvn 0 1 0\n", x, (x * 7 + z * 3) % 10 * 0.1f - 0.5f, z,
+					 static_cast<float>(x) / size, static_cast<float>(z) / size);
+			text += line;
+		}
+	}
+	for (size_t z = 0; z < size; z++)
+	{
+		if (z == 0 || z == size / 2)
+		{
+			text += z == 0 ? "usemtl Near\n" : "usemtl Far\n";
+		}
+		for (size_t x = 0; x < size; x++)
+		{
+			size_t corner = z * (size + 1) + x + 1;
+			size_t above = corner + size + 1;
+			snprintf(line, sizeof(line), "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", corner, corner, corner, above, above, above,
+					 above + 1, above + 1, above + 1, corner + 1, corner + 1, corner + 1);
+			text += line;
+		}
+	}
+	text += "o Quad\nv 0 0 0\nv 0 0 -1\nv 1 0 -1\nv 1 0 0\nf -4 -3 -2 -1\n";
+	return text;
+}
+
+static string EncodeBase64(const vector<uint8_t>& data)
+{
+	static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	string text;
+	for (size_t i = 0; i < data.size(); i += 3)
+	{
+		uint32_t bits = data[i] << 16 | (i + 1 < data.size() ? data[i + 1] << 8 : 0) | (i + 2 < data.size() ? data[i + 2] : 0);
+		text += digits[bits >> 18];
+		text += digits[(bits >> 12) & 63];
+		text += i + 1 < data.size() ? digits[(bits >> 6) & 63] : '=';
+		text += i + 2 < data.size() ? digits[bits & 63] : '=';
+	}
+	return text;
+}
+
+template <typename T>
+static void AppendBytes(vector<uint8_t>& data, const T* values, size_t count)
+{
+	data.insert(data.end(), reinterpret_cast<const uint8_t*>(values), reinterpret_cast<const uint8_t*>(values + count));
+	data.resize((data.size() + 3) & ~static_cast<size_t>(3));
+}
+
+// The glTF description of a mesh with positions, normals, texture coordinates and 32 bit indices stored one after
+// the other in buffer 0, used by a child node of a translated root node
+static string BuildBenchmarkGltfJson(size_t vertexCount, size_t indexCount, size_t bufferSize, const string& bufferUri)
+{
+	size_t positionsSize = vertexCount * sizeof(Vector3);
+	size_t textureCoordinatesSize = vertexCount * sizeof(Vector2);
+	string json = "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],";
+	json += "\"nodes\":[{\"name\":\"Root\",\"translation\":[1,2,3],\"children\":[1]},";
+	json += "{\"name\":\"Grid\",\"mesh\":0,\"matrix\":[2,0,0,0, 0,2,0,0, 0,0,2,0, 0,0,5,1]}],";
+	json += "\"meshes\":[{\"name\":\"Grid\",\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1,\"TEXCOORD_0\":2},\"indices\":3,\"material\":0}]}],";
+	json += "\"materials\":[{\"name\":\"Ground\"}],";
+	json += "\"buffers\":[{" + bufferUri + "\"byteLength\":" + to_string(bufferSize) + "}],";
+	json += "\"bufferViews\":[";
+	json += "{\"buffer\":0,\"byteOffset\":0,\"byteLength\":" + to_string(positionsSize * 2) + ",\"byteStride\":12},";
+	json += "{\"buffer\":0,\"byteOffset\":" + to_string(positionsSize * 2) + ",\"byteLength\":" + to_string(textureCoordinatesSize) + "},";
+	json += "{\"buffer\":0,\"byteOffset\":" + to_string(positionsSize * 2 + textureCoordinatesSize) + ",\"byteLength\":" + to_string(indexCount * 4) + "}],";
+	json += "\"accessors\":[";
+	json += "{\"bufferView\":0,\"componentType\":5126,\"count\":" + to_string(vertexCount) + ",\"type\":\"VEC3\"},";
+	json += "{\"bufferView\":0,\"byteOffset\":" + to_string(positionsSize) + ",\"componentType\":5126,\"count\":" + to_string(vertexCount) + ",\"type\":\"VEC3\"},";
+	json += "{\"bufferView\":1,\"componentType\":5126,\"count\":" + to_string(vertexCount) + ",\"type\":\"VEC2\"},";
+	json += "{\"bufferView\":2,\"componentType\":5125,\"count\":" + to_string(indexCount) + ",\"type\":\"SCALAR\"}]}";
+	return json;
+}
+
+// Write a grid as a .glb file, with every triangle having its own three vertices so that the importer has to
+// merge them
+static void WriteBenchmarkGlb(const wstring& fileName, const vector<BenchmarkVertex>& gridVertices, const vector<UINT>& gridIndices)
+{
+	vector<Vector3> positions;
+	vector<Vector3> normals;
+	vector<Vector2> textureCoordinates;
+	vector<UINT> indices;
+	for (UINT index : gridIndices)
+	{
+		const Vector3& position = gridVertices[index].Position;
+		positions.push_back(Vector3(position.x, position.y, -position.z));
+		normals.push_back(Vector3(0, 1, 0));
+		textureCoordinates.push_back(Vector2(position.x, position.z));
+		indices.push_back(static_cast<UINT>(indices.size()));
+	}
+	vector<uint8_t> binary;
+	AppendBytes(binary, positions.data(), positions.size());
+	AppendBytes(binary, normals.data(), normals.size());
+	AppendBytes(binary, textureCoordinates.data(), textureCoordinates.size());
+	AppendBytes(binary, indices.data(), indices.size());
+
+	string json = BuildBenchmarkGltfJson(positions.size(), indices.size(), binary.size(), "");
+	json.resize((json.size() + 3) & ~static_cast<size_t>(3), ' ');
+	uint32_t header[] = { 0x46546C67, 2, static_cast<uint32_t>(12 + 8 + json.size() + 8 + binary.size()) };
+	uint32_t jsonChunk[] = { static_cast<uint32_t>(json.size()), 0x4E4F534A };
+	uint32_t binaryChunk[] = { static_cast<uint32_t>(binary.size()), 0x004E4942 };
+	vector<uint8_t> file;
+	AppendBytes(file, header, 3);
+	AppendBytes(file, jsonChunk, 2);
+	AppendBytes(file, json.data(), json.size());
+	AppendBytes(file, binaryChunk, 2);
+	AppendBytes(file, binary.data(), binary.size());
+	MappedFile::WriteFile(fileName, file.data(), file.size());
+}
+
+// Checks that an imported grid matches the one BuildBenchmarkGrid makes: same size, faces pointing up (so the
+// winding has been kept clockwise) and the normals of the file
+static bool IsImportedGrid(const ImportedPrimitive& primitive, size_t vertexCount, size_t triangleCount)
+{
+	bool correct = primitive.Vertices.size() == vertexCount && primitive.Indices.size() == triangleCount * 3;
+	for (size_t i = 0; correct && i < primitive.Indices.size(); i += 3)
+	{
+		const ObjectVertexStruct& v0 = primitive.Vertices[primitive.Indices[i]];
+		const ObjectVertexStruct& v1 = primitive.Vertices[primitive.Indices[i + 1]];
+		const ObjectVertexStruct& v2 = primitive.Vertices[primitive.Indices[i + 2]];
+		correct = (v1.Position - v0.Position).Cross(v2.Position - v0.Position).y > 0.0f && v0.Normal.y == 1.0f && v0.Position.z >= 0.0f;
+	}
+	return correct;
+}
+
+static bool ModelImporterBenchmark(wofstream& output)
+{
+	constexpr size_t GridSize = 512;
+	const wstring objFileName = L"BenchmarkModel.obj";
+	const wstring glbFileName = L"BenchmarkModel.glb";
+	const wstring gltfFileName = L"BenchmarkModel.gltf";
+	const wstring binFileName = L"Benchmark Model.bin";
+	JobSystem jobSystem;
+	bool correct = true;
+
+	// A large OBJ file, imported on one thread and on the job system
+	string obj = BuildBenchmarkObj(GridSize);
+	WriteTextFile(objFileName, obj);
+	ImportedScene serialScene;
+	ImportedScene parallelScene;
+	double objSerialTime = TimeIterations(1, [&](int) { correct &= ModelImporter::Import(objFileName, serialScene); });
+	double objParallelTime = TimeIterations(1, [&](int) { correct &= ModelImporter::Import(objFileName, parallelScene, &jobSystem); });
+	for (const ImportedScene* scene : { &serialScene, &parallelScene })
+	{
+		correct &= scene->Meshes.size() == 2 && scene->Nodes.size() == 2 && scene->Roots.size() == 2;
+		if (scene->Meshes.size() == 2)
+		{
+			const ImportedMesh& grid = scene->Meshes[0];
+			correct &= grid.Name == "Grid" && grid.Primitives.size() == 2 && scene->Meshes[1].Primitives.size() == 1;
+			if (grid.Primitives.size() == 2 && scene->Meshes[1].Primitives.size() == 1)
+			{
+				correct &= grid.Primitives[0].Material == "Near" && grid.Primitives[1].Material == "Far";
+				correct &= IsImportedGrid(grid.Primitives[0], (GridSize / 2 + 1) * (GridSize + 1), GridSize / 2 * GridSize * 2);
+				correct &= IsImportedGrid(grid.Primitives[1], (GridSize - GridSize / 2 + 1) * (GridSize + 1), (GridSize - GridSize / 2) * GridSize * 2);
+				// Texture coordinates are flipped vertically
+				const ObjectVertexStruct& first = grid.Primitives[0].Vertices[0];
+				correct &= first.Position == Vector3(0, -0.5f, 0) && first.TextureCoordinate.x == 0.0f && first.TextureCoordinate.y == 1.0f;
+				// The quad has no normals, so they are calculated
+				const ImportedPrimitive& quad = scene->Meshes[1].Primitives[0];
+				correct &= quad.Vertices.size() == 4 && quad.Indices.size() == 6 && quad.Vertices[0].Normal.y > 0.999f;
+			}
+		}
+	}
+	double objMegabytes = obj.size() / (1024.0 * 1024.0);
+	obj.clear();
+	obj.shrink_to_fit();
+
+	// The same grid in a .glb file, with the vertices of each triangle written separately
+	mt19937 random(16);
+	vector<BenchmarkVertex> gridVertices;
+	vector<UINT> gridIndices;
+	BuildBenchmarkGrid(GridSize, gridVertices, gridIndices, random);
+	WriteBenchmarkGlb(glbFileName, gridVertices, gridIndices);
+	ImportedScene glbScene;
+	double glbTime = TimeIterations(1, [&](int) { correct &= ModelImporter::Import(glbFileName, glbScene, &jobSystem); });
+	MappedFile glbFile;
+	glbFile.Open(glbFileName);
+	double glbMegabytes = glbFile.GetSize() / (1024.0 * 1024.0);
+	glbFile.Close();
+	auto isGltfScene = [&](const ImportedScene& scene, size_t vertexCount, size_t triangleCount)
+	{
+		bool valid = scene.Meshes.size() == 1 && scene.Meshes[0].Primitives.size() == 1 && scene.Nodes.size() == 2 &&
+					 scene.Roots == vector<int>{ 0 } && scene.Nodes[0].Children == vector<int>{ 1 } && scene.Nodes[1].Mesh == 0;
+		if (valid)
+		{
+			// Translations are converted to left handed coordinates with everything else
+			const Matrix& root = scene.Nodes[0].Transformation;
+			const Matrix& child = scene.Nodes[1].Transformation;
+			valid = root.Translation() == Vector3(1, 2, -3) && child.Translation() == Vector3(0, 0, -5) && child._11 == 2.0f && child._33 == 2.0f;
+			valid &= scene.Meshes[0].Primitives[0].Material == "Ground" && IsImportedGrid(scene.Meshes[0].Primitives[0], vertexCount, triangleCount);
+		}
+		return valid;
+	};
+	correct &= isGltfScene(glbScene, gridVertices.size(), gridIndices.size() / 3);
+
+	// A small .gltf file, with its buffer in a separate file and then embedded as base64
+	vector<BenchmarkVertex> quadVertices;
+	vector<UINT> quadIndices;
+	BuildBenchmarkGrid(1, quadVertices, quadIndices, random);
+	vector<uint8_t> buffer;
+	for (int attribute = 0; attribute < 3; attribute++)
+	{
+		for (const BenchmarkVertex& vertex : quadVertices)
+		{
+			Vector3 values[] = { Vector3(vertex.Position.x, vertex.Position.y, -vertex.Position.z), Vector3(0, 1, 0), Vector3(vertex.Position.x, vertex.Position.z, 0) };
+			AppendBytes(buffer, &values[attribute].x, attribute == 2 ? 2 : 3);
+		}
+	}
+	AppendBytes(buffer, quadIndices.data(), quadIndices.size());
+	MappedFile::WriteFile(binFileName, buffer.data(), buffer.size());
+	ImportedScene gltfScene;
+	WriteTextFile(gltfFileName, BuildBenchmarkGltfJson(quadVertices.size(), quadIndices.size(), buffer.size(), "\"uri\":\"Benchmark%20Model.bin\","));
+	correct &= ModelImporter::Import(gltfFileName, gltfScene) && isGltfScene(gltfScene, 4, 2);
+	WriteTextFile(gltfFileName, BuildBenchmarkGltfJson(quadVertices.size(), quadIndices.size(), buffer.size(),
+													   "\"uri\":\"data:application/octet-stream;base64," + EncodeBase64(buffer) + "\","));
+	correct &= ModelImporter::Import(gltfFileName, gltfScene) && isGltfScene(gltfScene, 4, 2);
+
+	// Files that are not valid are rejected rather than read out of bounds
+	WriteTextFile(gltfFileName, BuildBenchmarkGltfJson(quadVertices.size() + 1, quadIndices.size(), buffer.size(), "\"uri\":\"Benchmark%20Model.bin\","));
+	correct &= !ModelImporter::Import(gltfFileName, gltfScene);
+	// Offsets and counts that are negative, fractional, too large or not finite must not be truncated into valid ones
+	const string validJson = BuildBenchmarkGltfJson(quadVertices.size(), quadIndices.size(), buffer.size(), "\"uri\":\"Benchmark%20Model.bin\",");
+	const string count = "\"count\":" + to_string(quadVertices.size()) + ",";
+	const pair<string, string> badValues[] = {
+		{ "\"byteOffset\":0,", "\"byteOffset\":-0.5," }, { count, "\"count\":4.5," }, { count, "\"count\":1e300," }, { count, "\"count\":1e999," },
+		{ count, "\"count\":\"4\"," }, { "\"byteStride\":12", "\"byteStride\":-12" }
+	};
+	for (const pair<string, string>& badValue : badValues)
+	{
+		string json = validJson;
+		json.replace(json.find(badValue.first), badValue.first.size(), badValue.second);
+		WriteTextFile(gltfFileName, json);
+		correct &= !ModelImporter::Import(gltfFileName, gltfScene);
+	}
+	WriteTextFile(objFileName, "v 0 0 0\nf 1 2 3\n");
+	correct &= !ModelImporter::Import(objFileName, parallelScene);
+	correct &= !ModelImporter::Import(L"BenchmarkMissing.obj", parallelScene);
+
+	for (const wstring& fileName : { objFileName, glbFileName, gltfFileName, binFileName })
+	{
+		remove(string(fileName.begin(), fileName.end()).c_str());
+	}
+
+	output << L"Model importer (ms, MB/s)" << endl;
+	output << L"  OBJ " << objMegabytes << L" MB: one thread " << objSerialTime << L" (" << objMegabytes * 1000.0 / objSerialTime << L")";
+	output << L", " << jobSystem.GetThreadCount() << L" threads " << objParallelTime << L" (" << objMegabytes * 1000.0 / objParallelTime << L")" << endl;
+	output << L"  GLB " << glbMegabytes << L" MB: " << glbTime << L" (" << glbMegabytes * 1000.0 / glbTime << L")";
+	output << (correct ? L"" : L" (INCORRECT)") << endl;
+	return correct;
+}
+
+// A vertex with the same layout as ObjectVertexStruct
+struct BenchmarkTexturedVertex
+{
+	Vector3		Position;
+	Vector3		Normal;
+	Vector2		TextureCoordinate;
+};
+
+static bool VertexCompressionBenchmark(wofstream& output)
+{
+	constexpr size_t GridSize = 1024;
+	constexpr int Iterations = 5;
+	bool correct = true;
+
+	// Every half converts back to itself, apart from NaNs, which only have to stay NaNs.  Rounding is to the nearest
+	// half with ties to even, including for denormals and at the top of the range.
+	for (uint32_t i = 0; i < 0x10000; i++)
+	{
+		float value = VertexCompression::DecodeHalf(static_cast<uint16_t>(i));
+		uint16_t encoded = VertexCompression::EncodeHalf(value);
+		correct &= value == value ? encoded == i : (encoded & 0x7FFF) > 0x7C00;
+	}
+	correct &= VertexCompression::EncodeHalf(1.0f + 1.0f / 2048.0f) == 0x3C00 && VertexCompression::EncodeHalf(1.0f + 3.0f / 2048.0f) == 0x3C02;
+	correct &= VertexCompression::EncodeHalf(ldexpf(1.0f, -25)) == 0 && VertexCompression::EncodeHalf(ldexpf(3.0f, -25)) == 2;
+	correct &= VertexCompression::EncodeHalf(65519.0f) == 0x7BFF && VertexCompression::EncodeHalf(-65520.0f) == 0xFC00;
+	correct &= VertexCompression::DecodeSnorm16(-32768) == -1.0f && VertexCompression::EncodeSnorm16(2.0f) == 32767;
+
+	// Random directions, plus the axes and points on the folds of the octahedron, which are the awkward cases
+	mt19937 random(5);
+	normal_distribution<float> gaussian;
+	vector<Vector3> directions;
+	for (float x : { -1.0f, -0.5f, 0.0f, 0.5f, 1.0f })
+	{
+		for (float y : { -1.0f, -0.5f, 0.0f, 0.5f, 1.0f })
+		{
+			for (float z : { -1.0f, -1.0e-6f, 0.0f, 1.0e-6f, 1.0f })
+			{
+				if (x != 0.0f || y != 0.0f || z != 0.0f)
+				{
+					directions.push_back(Vector3(x, y, z));
+				}
+			}
+		}
+	}
+	while (directions.size() < 1000000)
+	{
+		directions.push_back(Vector3(gaussian(random), gaussian(random), gaussian(random)));
+	}
+	double largestAngle = 0.0;
+	for (Vector3& direction : directions)
+	{
+		direction.Normalize();
+		int16_t encoded[2];
+		VertexCompression::EncodeOctahedral(direction, encoded);
+		// The angle is measured with the cross product as well, since the dot product alone is too close to 1 for single
+		// precision to resolve it
+		Vector3 decoded = VertexCompression::DecodeOctahedral(encoded);
+		largestAngle = max(largestAngle, atan2(decoded.Cross(direction).Length(), decoded.Dot(direction)) * 180.0 / 3.14159265358979);
+	}
+	correct &= largestAngle < 0.01;
+
+	// A grid of vertices with texture coordinates, compressed and decompressed
+	vector<BenchmarkVertex> gridVertices;
+	vector<UINT> gridIndices;
+	BuildBenchmarkGrid(GridSize, gridVertices, gridIndices, random);
+	uniform_real_distribution<float> unit(0.0f, 1.0f);
+	vector<BenchmarkTexturedVertex> vertices(gridVertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		vertices[i].Position = gridVertices[i].Position;
+		vertices[i].Normal = directions[i % directions.size()];
+		vertices[i].TextureCoordinate = Vector2(unit(random), unit(random));
+	}
+	AxisAlignedBox bounds = AxisAlignedBox::FromPoints(&vertices[0].Position, vertices.size(), sizeof(BenchmarkTexturedVertex));
+	VertexQuantisation quantisation = VertexCompression::GetQuantisation(bounds);
+	size_t compressedStride = VertexCompression::GetCompressedStride(sizeof(BenchmarkTexturedVertex));
+	vector<uint8_t> compressed(vertices.size() * compressedStride);
+	vector<BenchmarkTexturedVertex> decompressed(vertices.size());
+	double compressTime = TimeIterations(Iterations, [&](int) { VertexCompression::Compress(vertices.data(), vertices.size(), sizeof(BenchmarkTexturedVertex), quantisation, compressed.data()); });
+	double decompressTime = TimeIterations(Iterations, [&](int) { VertexCompression::Decompress(compressed.data(), vertices.size(), sizeof(BenchmarkTexturedVertex), quantisation, decompressed.data()); });
+
+	// Positions are within half a step of the quantisation grid (plus rounding), and texture coordinates in [0, 1]
+	// within half a step of the half float grid at 1
+	Vector3 step = Vector3(quantisation.Scale.x, quantisation.Scale.y, quantisation.Scale.z) / 32767.0f;
+	Vector3 largestPositionError;
+	float largestTextureError = 0.0f;
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		Vector3 error = decompressed[i].Position - vertices[i].Position;
+		largestPositionError = Vector3::Max(largestPositionError, Vector3(fabs(error.x), fabs(error.y), fabs(error.z)));
+		Vector2 textureError = decompressed[i].TextureCoordinate - vertices[i].TextureCoordinate;
+		largestTextureError = max(largestTextureError, max(fabs(textureError.x), fabs(textureError.y)));
+		correct &= decompressed[i].Normal.Dot(vertices[i].Normal) > 0.99999f;
+	}
+	correct &= largestPositionError.x <= step.x * 0.51f && largestPositionError.y <= step.y * 0.51f && largestPositionError.z <= step.z * 0.51f;
+	correct &= largestTextureError <= 1.0f / 4096.0f;
+
+	// Vertices without texture coordinates are compressed the same way, and anything else is left alone
+	correct &= VertexCompression::GetCompressedStride(sizeof(BenchmarkVertex)) == sizeof(BenchmarkVertex) / 2 && VertexCompression::GetCompressedStride(20) == 0;
+	vector<uint8_t> compressedGrid(gridVertices.size() * sizeof(CompressedGeoStruct));
+	vector<BenchmarkVertex> decompressedGrid(gridVertices.size());
+	VertexCompression::Compress(gridVertices.data(), gridVertices.size(), sizeof(BenchmarkVertex), quantisation, compressedGrid.data());
+	VertexCompression::Decompress(compressedGrid.data(), gridVertices.size(), sizeof(BenchmarkVertex), quantisation, decompressedGrid.data());
+	for (size_t i = 0; i < gridVertices.size(); i++)
+	{
+		correct &= Vector3::Distance(decompressedGrid[i].Position, gridVertices[i].Position) <= step.Length() * 0.51f;
+	}
+
+	output << L"Vertex compression (ms for " << vertices.size() << L" vertices, " << vertices.size() * sizeof(BenchmarkTexturedVertex) / 1024
+		   << L" KB to " << compressed.size() / 1024 << L" KB)" << endl;
+	output << L"  compress " << compressTime << L", decompress " << decompressTime << L", largest normal error " << largestAngle << L" degrees";
+	output << (correct ? L"" : L" (INCORRECT)") << endl;
+	return correct;
+}
+
+static bool MatrixKernelsBenchmark(wofstream& output)
+{
+	constexpr size_t Count = 100000;
+	constexpr int Iterations = 20;
+
+	// Rotations, scales and translations like those in a scene graph.  Every eighth entry is attached to
+	// the root and the rest to an earlier entry, as in a flattened hierarchy.
+	mt19937 random(7);
+	uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+	uniform_real_distribution<float> scale(0.5f, 2.0f);
+	uniform_real_distribution<float> position(-100.0f, 100.0f);
+	vector<Matrix> local(Count);
+	vector<int> parents(Count);
+	vector<AxisAlignedBox> boxes(Count);
+	for (size_t i = 0; i < Count; i++)
+	{
+		local[i] = Matrix::CreateScale(scale(random), scale(random), scale(random)) * Matrix::CreateFromYawPitchRoll(angle(random), angle(random), angle(random)) *
+				   Matrix::CreateTranslation(position(random), position(random), position(random));
+		parents[i] = (i % 8 == 0) ? -1 : static_cast<int>(random() % i);
+		Vector3 corner(position(random), position(random), position(random));
+		boxes[i] = AxisAlignedBox(corner, corner + Vector3(scale(random), scale(random), scale(random)));
+	}
+	boxes[1] = AxisAlignedBox::Empty();
+	boxes[2] = AxisAlignedBox::Infinite();
+	Matrix root = Matrix::CreateRotationY(0.5f);
+	Matrix viewProjection = Matrix::CreateLookAt(Vector3(0, 50, -500), Vector3(0, 0, 0), Vector3(0, 1, 0)) *
+							Matrix::CreatePerspectiveFieldOfView(XM_PIDIV4, 16.0f / 9.0f, 1.0f, 10000.0f);
+
+	// The same operations one matrix at a time with SimpleMath
+	vector<Matrix> expectedWorld(Count);
+	double simpleParentsTime = TimeIterations(Iterations, [&](int)
+		{
+			for (size_t i = 0; i < Count; i++)
+			{
+				expectedWorld[i] = local[i] * (parents[i] < 0 ? root : expectedWorld[parents[i]]);
+			}
+		});
+	vector<Matrix> expectedProducts(Count);
+	double simpleAllTime = TimeIterations(Iterations, [&](int)
+		{
+			for (size_t i = 0; i < Count; i++)
+			{
+				expectedProducts[i] = expectedWorld[i] * viewProjection;
+			}
+		});
+	vector<Matrix> expectedNormals(Count);
+	double simpleInverseTime = TimeIterations(Iterations, [&](int)
+		{
+			for (size_t i = 0; i < Count; i++)
+			{
+				expectedNormals[i] = local[i].Invert().Transpose();
+			}
+		});
+	vector<AxisAlignedBox> expectedBoxes(Count);
+	double simpleBoxesTime = TimeIterations(Iterations, [&](int)
+		{
+			for (size_t i = 0; i < Count; i++)
+			{
+				expectedBoxes[i] = boxes[i].Transform(expectedWorld[i]);
+			}
+		});
+	output << L"Matrix kernels (ms for " << Count << L" matrices)" << endl;
+	output << L"  SimpleMath: parents " << simpleParentsTime << L", multiply all " << simpleAllTime << L", inverse transpose " << simpleInverseTime
+		   << L", boxes " << simpleBoxesTime << endl;
+
+	// Products and boxes must match SimpleMath exactly.  The inverse transposes are calculated differently,
+	// so only have to be close (the 3x3 part of the transposed inverse, with no translation).
+	auto normalsClose = [&](const vector<Matrix>& normals)
+		{
+			for (size_t i = 0; i < Count; i++)
+			{
+				for (int row = 0; row < 3; row++)
+				{
+					for (int column = 0; column < 3; column++)
+					{
+						if (fabsf(normals[i].m[row][column] - expectedNormals[i].m[row][column]) > 1e-4f * max(1.0f, fabsf(expectedNormals[i].m[row][column])))
+						{
+							return false;
+						}
+					}
+				}
+				if (normals[i]._41 != 0.0f || normals[i]._42 != 0.0f || normals[i]._43 != 0.0f || normals[i]._44 != 1.0f)
+				{
+					return false;
+				}
+			}
+			return true;
+		};
+
+	bool correct = true;
+	MatrixKernels::Path bestPath = MatrixKernels::GetPath();
+	vector<Matrix> world(Count);
+	vector<Matrix> products(Count);
+	vector<Matrix> normals(Count);
+	vector<AxisAlignedBox> worldBoxes(Count);
+	for (int path = 0; path <= static_cast<int>(bestPath); path++)
+	{
+		MatrixKernels::SetPath(static_cast<MatrixKernels::Path>(path));
+		double parentsTime = TimeIterations(Iterations, [&](int) { MatrixKernels::MultiplyByParents(local.data(), parents.data(), 0, Count, root, world.data()); });
+		double allTime = TimeIterations(Iterations, [&](int) { MatrixKernels::MultiplyAll(world.data(), Count, viewProjection, products.data()); });
+		double inverseTime = TimeIterations(Iterations, [&](int) { MatrixKernels::InverseTranspose(local.data(), Count, normals.data()); });
+		double boxesTime = TimeIterations(Iterations, [&](int) { MatrixKernels::TransformBoxes(boxes.data(), world.data(), Count, worldBoxes.data()); });
+		bool pathCorrect = memcmp(world.data(), expectedWorld.data(), Count * sizeof(Matrix)) == 0 &&
+						   memcmp(products.data(), expectedProducts.data(), Count * sizeof(Matrix)) == 0 &&
+						   memcmp(worldBoxes.data(), expectedBoxes.data(), Count * sizeof(AxisAlignedBox)) == 0 &&
+						   normalsClose(normals);
+		output << L"  " << MatrixKernels::GetPathName(MatrixKernels::GetPath()) << L": parents " << parentsTime << L", multiply all " << allTime
+			   << L", inverse transpose " << inverseTime << L", boxes " << boxesTime << (pathCorrect ? L"" : L" (INCORRECT)") << endl;
+		correct &= pathCorrect;
+	}
+	MatrixKernels::SetPath(bestPath);
+	return correct;
+}
+
+int RunBenchmarks(const wstring& outputFileName, bool updateGolden)
+{
+#ifdef _WIN32
+	wofstream output(outputFileName);
+#else
+	// Only the Microsoft library opens streams by wide names.  The name is expected to be ASCII.
+	wofstream output(string(outputFileName.begin(), outputFileName.end()));
+#endif
+	bool passed = true;
+	passed &= SceneGraphUpdateBenchmark(output);
+	passed &= SceneGraphFindBenchmark(output);
+	passed &= FrustumCullingBenchmark(output);
+	passed &= BoundingVolumeHierarchyBenchmark(output);
+	passed &= RingAllocatorBenchmark(output);
+	passed &= RenderQueueBenchmark(output);
+	passed &= ShaderBytecodeCacheBenchmark(output);
+	passed &= MeshRegistryBenchmark(output);
+	passed &= HeadlessFrameBenchmark(output);
+	passed &= FramePipelineBenchmark(output);
+	passed &= FramePacerBenchmark(output);
+	passed &= SoftwareRasteriserBenchmark(output, updateGolden);
+	passed &= OcclusionCullingBenchmark(output);
+	passed &= NormalGeneratorBenchmark(output);
+	passed &= MeshOptimiserBenchmark(output);
+	passed &= MeshSimplifierBenchmark(output);
+	passed &= MeshFileBenchmark(output);
+	passed &= ModelImporterBenchmark(output);
+	passed &= VertexCompressionBenchmark(output);
+	passed &= MatrixKernelsBenchmark(output);
+	output << (passed ? L"All checks passed" : L"Some checks FAILED") << endl;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <string>
+
+using namespace std;
+
+// CPU benchmarks for the engine.  These are run instead of the application when
+// it is started with -benchmark on the command line.  Results are written to the
+// specified file.  Returns 0 if all of the results checks passed.
+//
+// Images are checked against golden images in the current directory.  If updateGolden
+// is set (-updategolden on the command line), the golden images are written instead.
+
+int RunBenchmarks(const wstring& outputFileName, bool updateGolden);
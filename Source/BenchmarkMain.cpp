@@ -0,0 +1,21 @@
+#include "Benchmark.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Entry point of the benchmarks when they are built without Windows (see CMakeLists.txt).  They are
+// run as they are by DirectX_Base -benchmark, and the results are also written to the console.
+// -updategolden writes the golden images rather than checking against them.
+
+int main(int argc, char* argv[])
+{
+	bool updateGolden = false;
+	for (int i = 1; i < argc; i++)
+	{
+		updateGolden |= strcmp(argv[i], "-updategolden") == 0;
+	}
+	int result = RunBenchmarks(L"Benchmark.txt", updateGolden);
+	ifstream results("Benchmark.txt");
+	cout << results.rdbuf();
+	return result;
+}
@@ -0,0 +1,394 @@
+#include "BoundingVolumeHierarchy.h"
+#include "SceneNode.h"
+#include <algorithm>
+#include <cassert>
+
+// Leaves are created once a node has this many items or fewer
+constexpr int MaximumLeafItems = 4;
+// Number of bins used when estimating the surface area heuristic
+constexpr int BinCount = 16;
+// Nodes at this depth are made leaves whatever their item count.  Well balanced trees never get near it,
+// but a few nodes spaced further and further apart can make the surface area heuristic peel them off one
+// at a time.
+constexpr int MaximumDepth = 64;
+// The queries push both children of each node they go into, so this is the most their stacks can hold
+constexpr int MaximumStackDepth = MaximumDepth + 1;
+
+static float SurfaceArea(const AxisAlignedBox& box)
+{
+	if (box.IsEmpty())
+	{
+		return 0.0f;
+	}
+	Vector3 size = box.Max - box.Min;
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+// Returns the distance along the ray at which it enters the box, or -1 if it misses
+static float IntersectRay(const AxisAlignedBox& box, const Vector3& origin, const Vector3& inverseDirection, float maxDistance)
+{
+	Vector3 t0 = (box.Min - origin) * inverseDirection;
+	Vector3 t1 = (box.Max - origin) * inverseDirection;
+	Vector3 tNear = Vector3::Min(t0, t1);
+	Vector3 tFar = Vector3::Max(t0, t1);
+	float entry = max(max(tNear.x, tNear.y), max(tNear.z, 0.0f));
+	float exit = min(min(tFar.x, tFar.y), min(tFar.z, maxDistance));
+	return entry <= exit ? entry : -1.0f;
+}
+
+static bool IntersectSphere(const AxisAlignedBox& box, const Vector3& centre, float radius)
+{
+	// Distance from the centre to the closest point in the box
+	Vector3 closest = Vector3::Max(box.Min, Vector3::Min(centre, box.Max));
+	return Vector3::DistanceSquared(closest, centre) <= radius * radius;
+}
+
+void BoundingVolumeHierarchy::Update(const TransformHierarchy& hierarchy)
+{
+	if (&hierarchy != _hierarchy || hierarchy.GetRevision() != _hierarchyRevision)
+	{
+		// Nodes have been added or removed
+		Build(hierarchy);
+	}
+	else if (hierarchy.GetBoundsRevision() != _boundsRevision)
+	{
+		// Nodes have moved.  Refitting is much cheaper than rebuilding, but the tree
+		// gets worse as nodes move away from the ones they were grouped with.
+		Refit(hierarchy);
+		if (_cost > _builtCost * _rebuildThreshold)
+		{
+			Build(hierarchy);
+		}
+	}
+}
+
+void BoundingVolumeHierarchy::Build(const TransformHierarchy& hierarchy)
+{
+	_hierarchy = &hierarchy;
+	_hierarchyRevision = hierarchy.GetRevision();
+	_boundsRevision = hierarchy.GetBoundsRevision();
+	_depth = 0;
+	_nodes.clear();
+	_items.clear();
+	_unboundedItems.clear();
+
+	// Only entries with geometry of their own go in the tree
+	int count = static_cast<int>(hierarchy.GetCount());
+	vector<Vector3> centres(count);
+	for (int i = 0; i < count; i++)
+	{
+		const AxisAlignedBox& bounds = hierarchy.GetWorldBounds(i);
+		if (bounds.IsInfinite())
+		{
+			_unboundedItems.push_back(i);
+		}
+		else if (!bounds.IsEmpty())
+		{
+			_items.push_back(i);
+			centres[i] = bounds.GetCentre();
+		}
+	}
+	if (!_items.empty())
+	{
+		BuildNode(centres, 0, static_cast<int>(_items.size()), 0);
+	}
+	_builtCost = _cost = CalculateCost();
+	_rebuildCount++;
+}
+
+int BoundingVolumeHierarchy::BuildNode(const vector<Vector3>& centres, int begin, int end, int depth)
+{
+	int nodeIndex = static_cast<int>(_nodes.size());
+	_nodes.push_back({ AxisAlignedBox(), -1, begin, end - begin });
+
+	AxisAlignedBox bounds;
+	AxisAlignedBox centreBounds;
+	for (int i = begin; i < end; i++)
+	{
+		bounds.Merge(_hierarchy->GetWorldBounds(_items[i]));
+		centreBounds.Merge(centres[_items[i]]);
+	}
+	_nodes[nodeIndex].Bounds = bounds;
+	_depth = max(_depth, depth);
+	int count = end - begin;
+	if (count <= MaximumLeafItems || depth == MaximumDepth)
+	{
+		return nodeIndex;
+	}
+
+	// Split along the axis where the centres are most spread out
+	Vector3 centreExtent = centreBounds.Max - centreBounds.Min;
+	int axis = 0;
+	if (centreExtent.y > centreExtent.x)
+	{
+		axis = 1;
+	}
+	if (centreExtent.z > (&centreExtent.x)[axis])
+	{
+		axis = 2;
+	}
+	float axisMinimum = (&centreBounds.Min.x)[axis];
+	float axisExtent = (&centreExtent.x)[axis];
+
+	int middle = begin;
+	if (axisExtent > 0.0f)
+	{
+		// Put the centres into bins along the axis
+		int binCounts[BinCount] = { 0 };
+		AxisAlignedBox binBounds[BinCount];
+		auto binOf = [&](int item)
+			{
+				int bin = static_cast<int>(((&centres[item].x)[axis] - axisMinimum) / axisExtent * BinCount);
+				return min(bin, BinCount - 1);
+			};
+		for (int i = begin; i < end; i++)
+		{
+			int bin = binOf(_items[i]);
+			binCounts[bin]++;
+			binBounds[bin].Merge(_hierarchy->GetWorldBounds(_items[i]));
+		}
+
+		// Sweep from the right to get the area and count to the right of each split
+		float rightCosts[BinCount];
+		AxisAlignedBox rightBounds;
+		int rightCount = 0;
+		for (int bin = BinCount - 1; bin > 0; bin--)
+		{
+			rightBounds.Merge(binBounds[bin]);
+			rightCount += binCounts[bin];
+			rightCosts[bin] = SurfaceArea(rightBounds) * rightCount;
+		}
+
+		// Then sweep from the left to find the split with the lowest cost
+		float bestCost = SurfaceArea(bounds) * count;
+		int bestSplit = -1;
+		AxisAlignedBox leftBounds;
+		int leftCount = 0;
+		for (int bin = 0; bin < BinCount - 1; bin++)
+		{
+			leftBounds.Merge(binBounds[bin]);
+			leftCount += binCounts[bin];
+			float cost = SurfaceArea(leftBounds) * leftCount + rightCosts[bin + 1];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = bin;
+			}
+		}
+		if (bestSplit >= 0)
+		{
+			middle = static_cast<int>(partition(_items.begin() + begin, _items.begin() + end,
+												[&](int item) { return binOf(item) <= bestSplit; }) - _items.begin());
+		}
+	}
+
+	// If no split was found (e.g. all of the centres are in the same place), just split the items in half
+	if (middle == begin || middle == end)
+	{
+		middle = (begin + end) / 2;
+		nth_element(_items.begin() + begin, _items.begin() + middle, _items.begin() + end,
+					[&](int a, int b) { return (&centres[a].x)[axis] < (&centres[b].x)[axis]; });
+	}
+
+	BuildNode(centres, begin, middle, depth + 1);
+	int rightChild = BuildNode(centres, middle, end, depth + 1);
+	_nodes[nodeIndex].RightChild = rightChild;
+	return nodeIndex;
+}
+
+void BoundingVolumeHierarchy::Refit(const TransformHierarchy& hierarchy)
+{
+	// Children always come after their parents, so working backwards
+	// means that both children have been refitted before their parent
+	for (size_t i = _nodes.size(); i-- > 0;)
+	{
+		Node& node = _nodes[i];
+		AxisAlignedBox bounds;
+		if (node.RightChild < 0)
+		{
+			for (int item = node.FirstItem; item < node.FirstItem + node.ItemCount; item++)
+			{
+				bounds.Merge(hierarchy.GetWorldBounds(_items[item]));
+			}
+		}
+		else
+		{
+			bounds.Merge(_nodes[i + 1].Bounds);
+			bounds.Merge(_nodes[node.RightChild].Bounds);
+		}
+		node.Bounds = bounds;
+	}
+	_boundsRevision = hierarchy.GetBoundsRevision();
+	_cost = CalculateCost();
+}
+
+float BoundingVolumeHierarchy::CalculateCost() const
+{
+	// The surface area heuristic estimates the cost of a query as the probability of visiting each
+	// node (proportional to its surface area) multiplied by the work done there
+	if (_nodes.empty())
+	{
+		return 0.0f;
+	}
+	float rootArea = SurfaceArea(_nodes[0].Bounds);
+	if (rootArea <= 0.0f)
+	{
+		return 0.0f;
+	}
+	float cost = 0.0f;
+	for (const Node& node : _nodes)
+	{
+		cost += SurfaceArea(node.Bounds) * (node.RightChild < 0 ? node.ItemCount : 1);
+	}
+	return cost / rootArea;
+}
+
+void BoundingVolumeHierarchy::AddResult(int item, vector<SceneNodePointer>& results) const
+{
+	results.push_back(_hierarchy->GetNode(item)->shared_from_this());
+}
+
+void BoundingVolumeHierarchy::QueryFrustum(const Frustum& frustum, vector<SceneNodePointer>& results) const
+{
+	for (int item : _unboundedItems)
+	{
+		AddResult(item, results);
+	}
+	if (_nodes.empty())
+	{
+		return;
+	}
+	int stack[MaximumStackDepth];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const Node& node = _nodes[stack[--stackSize]];
+		FrustumTest result = frustum.Test(node.Bounds);
+		if (result == FrustumTest::Outside)
+		{
+			continue;
+		}
+		if (result == FrustumTest::Inside || node.RightChild < 0)
+		{
+			// Everything below a node that is completely inside is also inside.  For leaves that
+			// are only partly inside, we test the items individually.
+			for (int i = node.FirstItem; i < node.FirstItem + node.ItemCount; i++)
+			{
+				if (result == FrustumTest::Inside || frustum.Test(_hierarchy->GetWorldBounds(_items[i])) != FrustumTest::Outside)
+				{
+					AddResult(_items[i], results);
+				}
+			}
+			continue;
+		}
+		assert(stackSize + 2 <= MaximumStackDepth);
+		stack[stackSize++] = node.RightChild;
+		stack[stackSize++] = static_cast<int>(&node - &_nodes[0]) + 1;
+	}
+}
+
+void BoundingVolumeHierarchy::QuerySphere(const Vector3& centre, float radius, vector<SceneNodePointer>& results) const
+{
+	for (int item : _unboundedItems)
+	{
+		AddResult(item, results);
+	}
+	if (_nodes.empty())
+	{
+		return;
+	}
+	int stack[MaximumStackDepth];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		int nodeIndex = stack[--stackSize];
+		const Node& node = _nodes[nodeIndex];
+		if (!IntersectSphere(node.Bounds, centre, radius))
+		{
+			continue;
+		}
+		if (node.RightChild < 0)
+		{
+			for (int i = node.FirstItem; i < node.FirstItem + node.ItemCount; i++)
+			{
+				if (IntersectSphere(_hierarchy->GetWorldBounds(_items[i]), centre, radius))
+				{
+					AddResult(_items[i], results);
+				}
+			}
+			continue;
+		}
+		assert(stackSize + 2 <= MaximumStackDepth);
+		stack[stackSize++] = node.RightChild;
+		stack[stackSize++] = nodeIndex + 1;
+	}
+}
+
+bool BoundingVolumeHierarchy::RayCast(const Vector3& origin, const Vector3& direction, float maxDistance, RayHit& hit) const
+{
+	hit.Node = nullptr;
+	hit.Distance = maxDistance;
+	if (_nodes.empty())
+	{
+		return false;
+	}
+	// Division by zero gives infinity, which the slab test handles correctly
+	Vector3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+	int nearestItem = -1;
+
+	int stack[MaximumStackDepth];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		int nodeIndex = stack[--stackSize];
+		const Node& node = _nodes[nodeIndex];
+		// Skip nodes that are further away than the nearest hit found so far
+		if (IntersectRay(node.Bounds, origin, inverseDirection, hit.Distance) < 0.0f)
+		{
+			continue;
+		}
+		if (node.RightChild < 0)
+		{
+			for (int i = node.FirstItem; i < node.FirstItem + node.ItemCount; i++)
+			{
+				float distance = IntersectRay(_hierarchy->GetWorldBounds(_items[i]), origin, inverseDirection, hit.Distance);
+				if (distance >= 0.0f && (nearestItem < 0 || distance < hit.Distance))
+				{
+					hit.Distance = distance;
+					nearestItem = _items[i];
+				}
+			}
+			continue;
+		}
+
+		// Visit the nearer child first so that more of the tree can be skipped
+		int leftChild = nodeIndex + 1;
+		int rightChild = node.RightChild;
+		float leftDistance = IntersectRay(_nodes[leftChild].Bounds, origin, inverseDirection, hit.Distance);
+		float rightDistance = IntersectRay(_nodes[rightChild].Bounds, origin, inverseDirection, hit.Distance);
+		assert(stackSize + 2 <= MaximumStackDepth);
+		if (leftDistance >= 0.0f && rightDistance >= 0.0f)
+		{
+			bool leftFirst = leftDistance <= rightDistance;
+			stack[stackSize++] = leftFirst ? rightChild : leftChild;
+			stack[stackSize++] = leftFirst ? leftChild : rightChild;
+		}
+		else if (leftDistance >= 0.0f)
+		{
+			stack[stackSize++] = leftChild;
+		}
+		else if (rightDistance >= 0.0f)
+		{
+			stack[stackSize++] = rightChild;
+		}
+	}
+	if (nearestItem < 0)
+	{
+		return false;
+	}
+	hit.Node = _hierarchy->GetNode(nearestItem)->shared_from_this();
+	return true;
+}
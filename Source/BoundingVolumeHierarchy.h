@@ -0,0 +1,91 @@
+#pragma once
+#include "TransformHierarchy.h"
+#include "Frustum.h"
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+class SceneNode;
+typedef shared_ptr<SceneNode>	SceneNodePointer;
+
+// Result of a ray cast against the bounding volume hierarchy
+struct RayHit
+{
+	SceneNodePointer	Node;
+	float				Distance;
+};
+
+// Bounding volume hierarchy over the world space bounds of the nodes in a TransformHierarchy.
+//
+// This sits alongside the scene graph and answers spatial queries (what is in the
+// frustum, what does this ray hit, what is near this point) without visiting every
+// node.  The tree is built using the surface area heuristic.  When nodes move, the
+// bounds in the tree are refitted rather than the tree being rebuilt; if refitting
+// makes the tree noticeably worse than when it was built, it is rebuilt.  The depth of
+// the tree is limited (nodes at the limit become leaves whatever their size), so that
+// the queries can walk it with a fixed size stack however the nodes are laid out.
+//
+// Queries test against the bounding boxes of the nodes, not their triangles.
+
+class BoundingVolumeHierarchy
+{
+public:
+	BoundingVolumeHierarchy() {};
+	~BoundingVolumeHierarchy(void) {};
+
+	// Bring the tree up to date with the hierarchy.  This only needs calling before the tree is queried, not
+	// after every TransformHierarchy::Update, since it refits for all of the moves made since it was last called.
+	void Update(const TransformHierarchy& hierarchy);
+
+	void Build(const TransformHierarchy& hierarchy);
+	void Refit(const TransformHierarchy& hierarchy);
+
+	void QueryFrustum(const Frustum& frustum, vector<SceneNodePointer>& results) const;
+	void QuerySphere(const Vector3& centre, float radius, vector<SceneNodePointer>& results) const;
+
+	// Find the nearest node whose bounds are hit by the ray.  direction does not need to be normalised,
+	// but distances are measured in multiples of its length.  Nodes with infinite bounds are never hit,
+	// since there is no distance at which the ray enters them.
+	bool RayCast(const Vector3& origin, const Vector3& direction, float maxDistance, RayHit& hit) const;
+
+	// Rebuild when the cost of the tree is more than this multiple of its cost when built
+	inline void SetRebuildThreshold(float threshold) { _rebuildThreshold = threshold; }
+
+	inline size_t GetNodeCount() const { return _nodes.size(); }
+	inline int GetDepth() const { return _depth; }
+	inline size_t GetRebuildCount() const { return _rebuildCount; }
+	inline float GetCost() const { return _cost; }
+
+private:
+	// Nodes are stored depth first, so the left child of an interior node immediately follows it.
+	// The items of every node (leaf or interior) are contiguous in _items.
+	struct Node
+	{
+		AxisAlignedBox	Bounds;
+		int				RightChild;			// -1 for leaves
+		int				FirstItem;
+		int				ItemCount;
+	};
+
+	vector<Node>			_nodes;
+	// Indices into the transform hierarchy of the entries in each leaf
+	vector<int>				_items;
+	// Entries with infinite bounds cannot be placed in the tree, so are always returned by frustum and
+	// sphere queries.  Ray casts skip them.
+	vector<int>				_unboundedItems;
+	// Needed to convert entries back to scene nodes
+	const TransformHierarchy* _hierarchy{ nullptr };
+
+	unsigned int			_hierarchyRevision{ 0 };
+	unsigned int			_boundsRevision{ 0 };
+	int						_depth{ 0 };
+	float					_builtCost{ 0 };
+	float					_cost{ 0 };
+	float					_rebuildThreshold{ 1.5f };
+	size_t					_rebuildCount{ 0 };
+
+	int BuildNode(const vector<Vector3>& centres, int begin, int end, int depth);
+	float CalculateCost() const;
+	void AddResult(int item, vector<SceneNodePointer>& results) const;
+};
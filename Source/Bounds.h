@@ -0,0 +1,74 @@
+#pragma once
+#include "SimpleMath.h"
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+using namespace SimpleMath;
+
+// Axis-aligned bounding box stored as minimum and maximum corners.
+//
+// An empty box (minimum greater than maximum) contains nothing and is used for nodes
+// that have no geometry of their own, such as scene graphs.  An infinite box is used
+// for nodes whose extent is unknown so that they are never culled.
+
+struct AxisAlignedBox
+{
+	Vector3		Min;
+	Vector3		Max;
+
+	AxisAlignedBox() : Min(FLT_MAX, FLT_MAX, FLT_MAX), Max(-FLT_MAX, -FLT_MAX, -FLT_MAX) {}
+	AxisAlignedBox(const Vector3& minimum, const Vector3& maximum) : Min(minimum), Max(maximum) {}
+
+	static AxisAlignedBox Empty() { return AxisAlignedBox(); }
+	static AxisAlignedBox Infinite() { return AxisAlignedBox(Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX), Vector3(FLT_MAX, FLT_MAX, FLT_MAX)); }
+
+	// Calculate the bounds of an array of vertices.  firstPosition points to the position of
+	// the first vertex and stride is the size of each vertex in bytes.
+	static AxisAlignedBox FromPoints(const Vector3* firstPosition, size_t count, size_t stride)
+	{
+		AxisAlignedBox box;
+		const char* position = reinterpret_cast<const char*>(firstPosition);
+		for (size_t i = 0; i < count; i++, position += stride)
+		{
+			box.Merge(*reinterpret_cast<const Vector3*>(position));
+		}
+		return box;
+	}
+
+	inline bool IsEmpty() const { return Min.x > Max.x || Min.y > Max.y || Min.z > Max.z; }
+	inline bool IsInfinite() const { return Min.x == -FLT_MAX || Max.x == FLT_MAX; }
+
+	inline Vector3 GetCentre() const { return (Min + Max) * 0.5f; }
+	inline Vector3 GetExtents() const { return (Max - Min) * 0.5f; }
+
+	inline void Merge(const Vector3& point)
+	{
+		Min = Vector3::Min(Min, point);
+		Max = Vector3::Max(Max, point);
+	}
+
+	inline void Merge(const AxisAlignedBox& box)
+	{
+		Min = Vector3::Min(Min, box.Min);
+		Max = Vector3::Max(Max, box.Max);
+	}
+
+	// Returns the axis-aligned box that encloses this box after it has been transformed.
+	// This uses Arvo's method: the centre is transformed as a point and the new extents
+	// are the old extents multiplied by the absolute values of the rotation/scale part.
+	AxisAlignedBox Transform(const Matrix& transformation) const
+	{
+		if (IsEmpty() || IsInfinite())
+		{
+			return *this;
+		}
+		Vector3 centre = Vector3::Transform(GetCentre(), transformation);
+		Vector3 extents = GetExtents();
+		Vector3 newExtents(
+			fabsf(transformation._11) * extents.x + fabsf(transformation._21) * extents.y + fabsf(transformation._31) * extents.z,
+			fabsf(transformation._12) * extents.x + fabsf(transformation._22) * extents.y + fabsf(transformation._32) * extents.z,
+			fabsf(transformation._13) * extents.x + fabsf(transformation._23) * extents.y + fabsf(transformation._33) * extents.z);
+		return AxisAlignedBox(centre - newExtents, centre + newExtents);
+	}
+};
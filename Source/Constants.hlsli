@@ -0,0 +1,34 @@
+// The constants used by the shaders, which match the structures in ShaderTypes.h.  They are split
+// into blocks by how often they change, and the render queue binds each block to its own slot.
+
+// The same for everything drawn in a frame
+cbuffer FrameConstants : register(b0)
+{
+    matrix view;
+    matrix projection;
+    matrix viewProjection;
+    float4 eyePosition;
+    float4 ambientLightColour;
+    float4 DirectionalLightColour;
+    float4 DirectionalLightVector;
+};
+
+// Shared by everything drawn with the same material
+cbuffer MaterialConstants : register(b1)
+{
+    float4 materialColour;
+    float4 specColour;
+    float SpecularPower;
+    float3 pad;
+};
+
+// Different for each object drawn
+cbuffer ObjectConstants : register(b2)
+{
+    matrix worldViewProjection;
+    matrix world;
+
+    // Only used with compressed vertices
+    float4 positionScale;
+    float4 positionOffset;
+};
@@ -1,225 +1,148 @@
-#include "CubeNode.h"
-#include "Geometry.h"
-
-bool CubeNode::Initialise() {
-	_device = DirectXFramework::GetDXFramework()->GetDevice();
-	_deviceContext = DirectXFramework::GetDXFramework()->GetDeviceContext();
-	if (_device.Get() == nullptr || _deviceContext.Get() == nullptr) {
-		return false;
-	}
-	BuildVertexNormals();
-	BuildGeometryBuffers();
-	BuildShaders();
-	BuildVertexLayout();
-	BuildConstantBuffer();
-
-
-	return true;
-}
-
-void CubeNode::Render()
-{
-
-
-	Matrix projectionTransformation = DirectXFramework::GetDXFramework()->GetProjectionTransformation();
-	Matrix viewTransformation = DirectXFramework::GetDXFramework()->GetViewTransformation();
-
-	//storing CBuffer information
-	CBuffer constantBuffer;
-	constantBuffer.WorldViewProjection = _cumulativeWorldTransformation * viewTransformation * projectionTransformation;
-	constantBuffer.World = _cumulativeWorldTransformation;
-	constantBuffer.MaterialColour = _matColour *2 ;
-	constantBuffer.AmbientLightColour = Vector4(0.2f, 0.2f, 0.2f, 1.0f);
-	constantBuffer.DirectionalLightVector = Vector4(-1.0f, -1.0f, 1.0f, 0.0f);
-	constantBuffer.DirectionalLightColour = Vector4(Colors::Gold);
-	constantBuffer.specColour = Vector4(Colors::White);
-	constantBuffer.specularPower = 8.0f;
-
-	// Update the constant buffer. Note the layout of the constant buffer must match that in the shader
-	_deviceContext->VSSetConstantBuffers(0, 1, _constantBuffer.GetAddressOf());
-	_deviceContext->PSSetConstantBuffers(0, 1, _constantBuffer.GetAddressOf());
-	_deviceContext->UpdateSubresource(_constantBuffer.Get(), 0, 0, &constantBuffer, 0, 0);
-
-
-	// Now render the cube
-	// Specify the distance between vertices and the starting point in the vertex buffer
-	UINT stride = sizeof(ObjectVertexStruct);
-	UINT offset = 0;
-	// Set the vertex buffer and index buffer we are going to use
-	_deviceContext->IASetVertexBuffers(0, 1, _vertexBuffer.GetAddressOf(), &stride, &offset);
-	_deviceContext->IASetIndexBuffer(_indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
-
-	// Specify the layout of the polygons (it will rarely be different to this)
-	_deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-	// Specify the layout of the input vertices.  This must match the layout of the input vertices in the shader
-	_deviceContext->IASetInputLayout(_layout.Get());
-
-	// Specify the vertex and pixel shaders we are going to use
-	_deviceContext->VSSetShader(_vertexShader.Get(), 0, 0);
-	_deviceContext->PSSetShader(_pixelShader.Get(), 0, 0);
-
-	_deviceContext->DrawIndexed(ARRAYSIZE(indices), 0, 0);
-}
-
-void CubeNode::BuildGeometryBuffers()
-{
-	// This method uses the arrays defined in Geometry.h
-	// 
-	// Setup the structure that specifies how big the vertex 
-	// buffer should be
-	D3D11_BUFFER_DESC vertexBufferDescriptor = { 0 };
-	vertexBufferDescriptor.Usage = D3D11_USAGE_IMMUTABLE;
-	vertexBufferDescriptor.ByteWidth = sizeof(ObjectVertexStruct) * ARRAYSIZE(vertices);
-	vertexBufferDescriptor.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vertexBufferDescriptor.CPUAccessFlags = 0;
-	vertexBufferDescriptor.MiscFlags = 0;
-	vertexBufferDescriptor.StructureByteStride = 0;
-
-	// Now set up a structure that tells DirectX where to get the
-	// data for the vertices from
-	D3D11_SUBRESOURCE_DATA vertexInitialisationData = { 0 };
-	vertexInitialisationData.pSysMem = &vertices;
-
-	// and create the vertex buffer
-	ThrowIfFailed(_device->CreateBuffer(&vertexBufferDescriptor, &vertexInitialisationData, _vertexBuffer.GetAddressOf()));
-
-	// Setup the structure that specifies how big the index 
-	// buffer should be
-	D3D11_BUFFER_DESC indexBufferDescriptor = { 0 };
-	indexBufferDescriptor.Usage = D3D11_USAGE_IMMUTABLE;
-	indexBufferDescriptor.ByteWidth = sizeof(UINT) * ARRAYSIZE(indices);
-	indexBufferDescriptor.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	indexBufferDescriptor.CPUAccessFlags = 0;
-	indexBufferDescriptor.MiscFlags = 0;
-	indexBufferDescriptor.StructureByteStride = 0;
-
-	// Now set up a structure that tells DirectX where to get the
-	// data for the indices from
-	D3D11_SUBRESOURCE_DATA indexInitialisationData;
-	indexInitialisationData.pSysMem = &indices;
-
-	// and create the index buffer
-	ThrowIfFailed(_device->CreateBuffer(&indexBufferDescriptor, &indexInitialisationData, _indexBuffer.GetAddressOf()));
-}
-
-void CubeNode::BuildShaders()
-{
-	DWORD shaderCompileFlags = 0;
-#if defined( _DEBUG )
-	shaderCompileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-
-	ComPtr<ID3DBlob> compilationMessages = nullptr;
-
-	//Compile vertex shader
-	HRESULT hr = D3DCompileFromFile(ShaderFileName,
-		nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE,
-		VertexShaderName, "vs_5_0",
-		shaderCompileFlags, 0,
-		_vertexShaderByteCode.GetAddressOf(),
-		compilationMessages.GetAddressOf());
-
-	if (compilationMessages.Get() != nullptr)
-	{
-		// If there were any compilation messages, display them
-		MessageBoxA(0, (char*)compilationMessages->GetBufferPointer(), 0, 0);
-	}
-	// Even if there are no compiler messages, check to make sure there were no other errors.
-	ThrowIfFailed(hr);
-	ThrowIfFailed(_device->CreateVertexShader(_vertexShaderByteCode->GetBufferPointer(), _vertexShaderByteCode->GetBufferSize(), NULL, _vertexShader.GetAddressOf()));
-
-	// Compile pixel shader
-	hr = D3DCompileFromFile(ShaderFileName,
-		nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE,
-		PixelShaderName, "ps_5_0",
-		shaderCompileFlags, 0,
-		_pixelShaderByteCode.GetAddressOf(),
-		compilationMessages.GetAddressOf());
-
-	if (compilationMessages.Get() != nullptr)
-	{
-		// If there were any compilation messages, display them
-		MessageBoxA(0, (char*)compilationMessages->GetBufferPointer(), 0, 0);
-	}
-	ThrowIfFailed(hr);
-	ThrowIfFailed(_device->CreatePixelShader(_pixelShaderByteCode->GetBufferPointer(), _pixelShaderByteCode->GetBufferSize(), NULL, _pixelShader.GetAddressOf()));
-}
-
-void CubeNode::BuildVertexLayout()
-{
-	// Create the vertex input layout. This tells DirectX the format
-	// of each of the vertices we are sending to it. The vertexDesc array is
-	// defined in Geometry.h
-
-	ThrowIfFailed(_device->CreateInputLayout(vertexDesc, ARRAYSIZE(vertexDesc), _vertexShaderByteCode->GetBufferPointer(), _vertexShaderByteCode->GetBufferSize(), _layout.GetAddressOf()));
-}
-
-void CubeNode::BuildConstantBuffer()
-{
-	D3D11_BUFFER_DESC bufferDesc;
-	ZeroMemory(&bufferDesc, sizeof(bufferDesc));
-	bufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	bufferDesc.ByteWidth = sizeof(CBuffer);
-	bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-
-	ThrowIfFailed(_device->CreateBuffer(&bufferDesc, NULL, _constantBuffer.GetAddressOf()));
-}
-
-void CubeNode::BuildVertexNormals()
-{
-
-	// Calculate vertex normals
-
-	std::vector<int> vertexContributingCount(ARRAYSIZE(vertices));
-
-	for (int i = 0; i < ARRAYSIZE(vertices); i++) {
-
-		vertexContributingCount[i] = 0;
-
-	}
-
-	int polygonCount = ARRAYSIZE(vertices) / 3;
-
-	for (int i = 0; i < polygonCount; i++)
-
-	{
-
-		int index0 = indices[i * 3];
-
-		int index1 = indices[i * 3 + 1];
-
-		int index2 = indices[i * 3 + 2];
-
-		Vector3 y = vertices[index1].Position - vertices[index0].Position;
-
-		Vector3 z = vertices[index2].Position - vertices[index0].Position;
-
-		Vector3 normal = y.Cross(z);
-
-		vertices[index0].Normal += normal;
-
-		vertexContributingCount[index0]++;
-
-		vertices[index1].Normal += normal;
-
-		vertexContributingCount[index1]++;
-
-		vertices[index2].Normal += normal;
-
-		vertexContributingCount[index2]++;
-
-	}
-
-	// vertex normals divided by contributing counts, then normalise
-
-	for (int i = 0; i < ARRAYSIZE(vertices); i++)
-
-	{
-
-		vertices[i].Normal / (float)vertexContributingCount[i];
-
-		vertices[i].Normal.Normalize();
-
-	}
-}
\ No newline at end of file
+#include "CubeNode.h"
+#include "Geometry.h"
+
+bool CubeNode::Initialise() {
+	_device = DirectXFramework::GetDXFramework()->GetDevice();
+	_deviceContext = DirectXFramework::GetDXFramework()->GetDeviceContext();
+	if (_device.Get() == nullptr || _deviceContext.Get() == nullptr) {
+		return false;
+	}
+	_instanced = DirectXFramework::GetDXFramework()->IsInstancedRendering();
+	// The vertices and indices are the same for every cube, so the mesh is built by the first
+	// cube to be initialised and shared with the others.  Sharing the mesh also means that
+	// cubes can be drawn as instances of each other.
+	_mesh = DirectXFramework::GetDXFramework()->GetMeshRegistry().GetMesh("cube", BuildMesh);
+	SetLocalBounds(_mesh->Bounds);
+	// Occluders are drawn in full by the occlusion culler to hide the nodes behind them
+	if (IsOccluder())
+	{
+		DirectXFramework::GetDXFramework()->AddOccluder(shared_from_this(), _mesh);
+	}
+	BuildShaders();
+	BuildVertexLayout();
+
+
+	return true;
+}
+
+void CubeNode::Render()
+{
+
+
+	Matrix projectionTransformation = DirectXFramework::GetDXFramework()->GetProjectionTransformation();
+	Matrix viewTransformation = DirectXFramework::GetDXFramework()->GetViewTransformation();
+	const Matrix& worldTransformation = GetCumulativeWorldTransformation();
+
+	if (_instanced)
+	{
+		RenderInstance();
+		return;
+	}
+
+	// The camera and lights are in the frame constants, which the render queue binds for every draw
+	MaterialConstants material;
+	material.MaterialColour = _matColour * 2;
+	material.SpecularColour = Vector4(Colors::White);
+	material.SpecularPower = 8.0f;
+
+	ObjectConstants object;
+	object.WorldViewProjection = GetWorldViewProjection(viewTransformation * projectionTransformation);
+	object.World = worldTransformation;
+	object.PositionScale = _mesh->Quantisation.Scale;
+	object.PositionOffset = _mesh->Quantisation.Offset;
+
+	// Rather than drawing the cube now, add a packet describing how to draw it to the
+	// render queue.  The queue sorts the packets and sets any state that changes.
+	DrawPacket packet;
+	packet.VertexShader = D3D11RenderDevice::ToHandle(_vertexShader->VertexShader);
+	packet.PixelShader = D3D11RenderDevice::ToHandle(_pixelShader->PixelShader);
+	packet.InputLayout = D3D11RenderDevice::ToHandle(_layout->Layout);
+	packet.VertexBuffer = _mesh->VertexBuffer;
+	packet.IndexBuffer = _mesh->IndexBuffer;
+	packet.VertexStride = _mesh->BufferStride;
+	packet.IndexCount = _mesh->GetLod(0).IndexCount;
+	packet.IndexBufferFormat = _mesh->Indices.GetFormat();
+	packet.Depth = Vector3::Transform(worldTransformation.Translation(), viewTransformation).z;
+	DirectXFramework::GetDXFramework()->GetRenderQueue().Add(packet, &material, sizeof(material), &object, sizeof(object));
+}
+
+void CubeNode::RenderInstance()
+{
+	// The world transformation and colour are per instance.  The constants only hold what is the
+	// same for every cube, so one copy of them is used for all of the instances.  The shader takes
+	// the view x projection transformation from the frame constants.
+	InstanceData instance;
+	instance.World = GetCumulativeWorldTransformation();
+	instance.MaterialColour = _matColour * 2;
+
+	MaterialConstants material;
+	material.MaterialColour = Vector4(1.0f, 1.0f, 1.0f, 1.0f);
+	material.SpecularColour = Vector4(Colors::White);
+	material.SpecularPower = 8.0f;
+
+	ObjectConstants object;
+	object.WorldViewProjection = Matrix::Identity;
+	object.World = Matrix::Identity;
+	object.PositionScale = _mesh->Quantisation.Scale;
+	object.PositionOffset = _mesh->Quantisation.Offset;
+
+	DrawPacket packet;
+	packet.VertexShader = D3D11RenderDevice::ToHandle(_vertexShader->VertexShader);
+	packet.PixelShader = D3D11RenderDevice::ToHandle(_pixelShader->PixelShader);
+	packet.InputLayout = D3D11RenderDevice::ToHandle(_layout->Layout);
+	packet.VertexBuffer = _mesh->VertexBuffer;
+	packet.IndexBuffer = _mesh->IndexBuffer;
+	packet.VertexStride = _mesh->BufferStride;
+	packet.IndexCount = _mesh->GetLod(0).IndexCount;
+	packet.IndexBufferFormat = _mesh->Indices.GetFormat();
+	DirectXFramework::GetDXFramework()->GetRenderQueue().AddInstance(packet, &instance, sizeof(instance), &material, sizeof(material), &object, sizeof(object));
+}
+
+void CubeNode::BuildMesh(Mesh& mesh)
+{
+	// The cube uses the arrays defined in Geometry.h
+	mesh.SetVertices(vertices, ARRAYSIZE(vertices));
+	mesh.SetIndices(indices, ARRAYSIZE(indices));
+	mesh.CalculateNormals();
+}
+
+void CubeNode::BuildShaders()
+{
+	// Shaders are shared between all nodes that use the same file and entry points, so
+	// they are only compiled for the first node.  The instanced version of the shader
+	// reads the world transformation and colour from the instance buffer.
+	ShaderCache& shaderCache = DirectXFramework::GetDXFramework()->GetShaderCache();
+	vector<pair<string, string>> defines;
+	if (_instanced)
+	{
+		defines.push_back({ "INSTANCED", "1" });
+	}
+	if (_mesh->CompressedVertices)
+	{
+		defines.push_back({ "COMPRESSED_VERTICES", "1" });
+	}
+	_vertexShader = shaderCache.GetVertexShader(ShaderFileName, VertexShaderName, defines);
+	_pixelShader = shaderCache.GetPixelShader(ShaderFileName, PixelShaderName, defines);
+}
+
+void CubeNode::BuildVertexLayout()
+{
+	// Create the vertex input layout. This tells DirectX the format
+	// of each of the vertices we are sending to it. The vertexDesc array is
+	// defined in Geometry.h
+
+	ShaderCache& shaderCache = DirectXFramework::GetDXFramework()->GetShaderCache();
+	if (_mesh->CompressedVertices)
+	{
+		_layout = _instanced ? shaderCache.GetInputLayout(compressedInstancedVertexDesc, ARRAYSIZE(compressedInstancedVertexDesc), _vertexShader)
+							 : shaderCache.GetInputLayout(compressedVertexDesc, ARRAYSIZE(compressedVertexDesc), _vertexShader);
+	}
+	else if (_instanced)
+	{
+		_layout = shaderCache.GetInputLayout(instancedVertexDesc, ARRAYSIZE(instancedVertexDesc), _vertexShader);
+	}
+	else
+	{
+		_layout = shaderCache.GetInputLayout(vertexDesc, ARRAYSIZE(vertexDesc), _vertexShader);
+	}
+}
@@ -0,0 +1,183 @@
+#include "D3D11RenderDevice.h"
+#include "HelperFunctions.h"
+
+D3D11RenderDevice::D3D11RenderDevice(ComPtr<ID3D11DeviceContext> deviceContext) : _deviceContext(deviceContext)
+{
+	ThrowIfFailed(_deviceContext.As(&_deviceContext1));
+	_deviceContext->GetDevice(_device.GetAddressOf());
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = { 0 };
+	ThrowIfFailed(_device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options)));
+	if (!options.ConstantBufferOffsetting)
+	{
+		ThrowIfFailed(DXGI_ERROR_UNSUPPORTED);
+	}
+	_noOverwriteConstants = options.MapNoOverwriteOnDynamicConstantBuffer != 0;
+}
+
+RenderHandle D3D11RenderDevice::CreateBuffer(BufferType type, BufferUsage usage, size_t size, const void* data)
+{
+	static const UINT bindFlags[] = { D3D11_BIND_VERTEX_BUFFER, D3D11_BIND_INDEX_BUFFER, D3D11_BIND_CONSTANT_BUFFER };
+	static const D3D11_USAGE usages[] = { D3D11_USAGE_IMMUTABLE, D3D11_USAGE_DEFAULT, D3D11_USAGE_DYNAMIC };
+
+	D3D11_BUFFER_DESC bufferDescriptor = { 0 };
+	bufferDescriptor.Usage = usages[static_cast<int>(usage)];
+	bufferDescriptor.ByteWidth = static_cast<UINT>(size);
+	bufferDescriptor.BindFlags = bindFlags[static_cast<int>(type)];
+	bufferDescriptor.CPUAccessFlags = usage == BufferUsage::Dynamic ? D3D11_CPU_ACCESS_WRITE : 0;
+
+	D3D11_SUBRESOURCE_DATA initialisationData = { 0 };
+	initialisationData.pSysMem = data;
+	ComPtr<ID3D11Buffer> buffer;
+	ThrowIfFailed(_device->CreateBuffer(&bufferDescriptor, data != nullptr ? &initialisationData : nullptr, buffer.GetAddressOf()));
+	// The reference is kept by the handle until ReleaseBuffer
+	return reinterpret_cast<RenderHandle>(buffer.Detach());
+}
+
+void D3D11RenderDevice::ReleaseBuffer(RenderHandle buffer)
+{
+	if (buffer != 0)
+	{
+		FromHandle<ID3D11Buffer>(buffer)->Release();
+	}
+}
+
+void D3D11RenderDevice::ClearTargets(const float colour[4], float depth)
+{
+	_deviceContext->ClearRenderTargetView(_renderTargetView.Get(), colour);
+	_deviceContext->ClearDepthStencilView(_depthStencilView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, depth, 0);
+}
+
+void D3D11RenderDevice::SetViewport(float width, float height)
+{
+	D3D11_VIEWPORT viewPort = { 0 };
+	viewPort.Width = width;
+	viewPort.Height = height;
+	viewPort.MinDepth = 0.0f;
+	viewPort.MaxDepth = 1.0f;
+	viewPort.TopLeftX = 0;
+	viewPort.TopLeftY = 0;
+	_deviceContext->RSSetViewports(1, &viewPort);
+}
+
+void D3D11RenderDevice::SetRenderTargets(ComPtr<ID3D11RenderTargetView> renderTargetView, ComPtr<ID3D11DepthStencilView> depthStencilView)
+{
+	_renderTargetView = renderTargetView;
+	_depthStencilView = depthStencilView;
+	_deviceContext->OMSetRenderTargets(1, _renderTargetView.GetAddressOf(), _depthStencilView.Get());
+}
+
+void D3D11RenderDevice::SetShaders(RenderHandle vertexShader, RenderHandle pixelShader)
+{
+	_deviceContext->VSSetShader(FromHandle<ID3D11VertexShader>(vertexShader), 0, 0);
+	_deviceContext->PSSetShader(FromHandle<ID3D11PixelShader>(pixelShader), 0, 0);
+}
+
+void D3D11RenderDevice::SetInputLayout(RenderHandle inputLayout)
+{
+	_deviceContext->IASetInputLayout(FromHandle<ID3D11InputLayout>(inputLayout));
+}
+
+void D3D11RenderDevice::SetPrimitiveTopology(PrimitiveTopology topology)
+{
+	static const D3D11_PRIMITIVE_TOPOLOGY topologies[] =
+	{
+		D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST,
+		D3D11_PRIMITIVE_TOPOLOGY_LINELIST,
+		D3D11_PRIMITIVE_TOPOLOGY_POINTLIST
+	};
+	_deviceContext->IASetPrimitiveTopology(topologies[static_cast<int>(topology)]);
+}
+
+void D3D11RenderDevice::SetVertexBuffer(RenderHandle vertexBuffer, unsigned int stride, unsigned int offset)
+{
+	ID3D11Buffer* buffer = FromHandle<ID3D11Buffer>(vertexBuffer);
+	_deviceContext->IASetVertexBuffers(0, 1, &buffer, &stride, &offset);
+}
+
+void D3D11RenderDevice::SetInstanceBuffer(RenderHandle instanceBuffer, unsigned int stride, unsigned int offset)
+{
+	ID3D11Buffer* buffer = FromHandle<ID3D11Buffer>(instanceBuffer);
+	_deviceContext->IASetVertexBuffers(1, 1, &buffer, &stride, &offset);
+}
+
+void D3D11RenderDevice::SetIndexBuffer(RenderHandle indexBuffer, IndexFormat format, unsigned int offset)
+{
+	_deviceContext->IASetIndexBuffer(FromHandle<ID3D11Buffer>(indexBuffer), format == IndexFormat::UInt16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, offset);
+}
+
+void D3D11RenderDevice::SetTexture(unsigned int slot, RenderHandle texture)
+{
+	ID3D11ShaderResourceView* view = FromHandle<ID3D11ShaderResourceView>(texture);
+	_deviceContext->PSSetShaderResources(slot, 1, &view);
+}
+
+void D3D11RenderDevice::SetConstantBuffer(unsigned int slot, RenderHandle constantBuffer)
+{
+	ID3D11Buffer* buffer = FromHandle<ID3D11Buffer>(constantBuffer);
+	_deviceContext->VSSetConstantBuffers(slot, 1, &buffer);
+	_deviceContext->PSSetConstantBuffers(slot, 1, &buffer);
+}
+
+void D3D11RenderDevice::SetConstantBufferRange(unsigned int slot, RenderHandle constantBuffer, unsigned int offset, unsigned int size)
+{
+	// Offsets and sizes are given to Direct3D in constants of 16 bytes
+	ID3D11Buffer* buffer = FromHandle<ID3D11Buffer>(constantBuffer);
+	UINT firstConstant = offset / 16;
+	UINT constantCount = size / 16;
+	_deviceContext1->VSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &constantCount);
+	_deviceContext1->PSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &constantCount);
+}
+
+void D3D11RenderDevice::UpdateBuffer(RenderHandle buffer, const void* data, size_t size)
+{
+	// Constant buffers cannot be partly updated, but other buffers (such as instance
+	// buffers) are often only partly used, so only copy the part that is used
+	ID3D11Buffer* d3dBuffer = FromHandle<ID3D11Buffer>(buffer);
+	D3D11_BUFFER_DESC bufferDesc;
+	d3dBuffer->GetDesc(&bufferDesc);
+	if (bufferDesc.BindFlags & D3D11_BIND_CONSTANT_BUFFER)
+	{
+		_deviceContext->UpdateSubresource(d3dBuffer, 0, 0, data, 0, 0);
+	}
+	else
+	{
+		D3D11_BOX box = { 0, 0, 0, static_cast<UINT>(size), 1, 1 };
+		_deviceContext->UpdateSubresource(d3dBuffer, 0, &box, data, 0, 0);
+	}
+}
+
+void D3D11RenderDevice::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	_deviceContext->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+void D3D11RenderDevice::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance)
+{
+	_deviceContext->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+}
+
+void D3D11RenderDevice::WriteBuffer(RenderHandle buffer, size_t offset, const void* data, size_t size, bool discard)
+{
+	// Without support for D3D11_MAP_WRITE_NO_OVERWRITE on constant buffers, every write discards the
+	// buffer.  This is still correct, since the render queue issues the draws that use each write before
+	// making the next one, but the driver has to find new memory every time.
+	ID3D11Buffer* d3dBuffer = FromHandle<ID3D11Buffer>(buffer);
+	D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+	if (discard)
+	{
+		mapType = D3D11_MAP_WRITE_DISCARD;
+	}
+	else if (!_noOverwriteConstants)
+	{
+		D3D11_BUFFER_DESC bufferDesc;
+		d3dBuffer->GetDesc(&bufferDesc);
+		if (bufferDesc.BindFlags & D3D11_BIND_CONSTANT_BUFFER)
+		{
+			mapType = D3D11_MAP_WRITE_DISCARD;
+		}
+	}
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	ThrowIfFailed(_deviceContext->Map(d3dBuffer, 0, mapType, 0, &mapped));
+	memcpy(static_cast<uint8_t*>(mapped.pData) + offset, data, size);
+	_deviceContext->Unmap(d3dBuffer, 0);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "DirectXCore.h"
+#include <d3d11_1.h>
+#include "RenderDevice.h"
+
+// Render device that issues commands to a Direct3D 11 device context.  Handles are
+// the Direct3D interface pointers; a buffer created by the device holds a reference
+// to its interface until it is released.
+//
+// The render target and depth buffer belong to the swap chain, so the framework
+// passes them in with SetRenderTargets whenever they are created.
+//
+// Binding part of a constant buffer needs the Direct3D 11.1 runtime (Windows 8 or later).
+
+class D3D11RenderDevice : public RenderDevice
+{
+public:
+	D3D11RenderDevice(ComPtr<ID3D11DeviceContext> deviceContext);
+
+	RenderHandle CreateBuffer(BufferType type, BufferUsage usage, size_t size, const void* data);
+	void ReleaseBuffer(RenderHandle buffer);
+	void ClearTargets(const float colour[4], float depth);
+	void SetViewport(float width, float height);
+
+	void SetShaders(RenderHandle vertexShader, RenderHandle pixelShader);
+	void SetInputLayout(RenderHandle inputLayout);
+	void SetPrimitiveTopology(PrimitiveTopology topology);
+	void SetVertexBuffer(RenderHandle vertexBuffer, unsigned int stride, unsigned int offset);
+	void SetInstanceBuffer(RenderHandle instanceBuffer, unsigned int stride, unsigned int offset);
+	void SetIndexBuffer(RenderHandle indexBuffer, IndexFormat format, unsigned int offset);
+	void SetTexture(unsigned int slot, RenderHandle texture);
+	void SetConstantBuffer(unsigned int slot, RenderHandle constantBuffer);
+	void SetConstantBufferRange(unsigned int slot, RenderHandle constantBuffer, unsigned int offset, unsigned int size);
+	void UpdateBuffer(RenderHandle buffer, const void* data, size_t size);
+	void WriteBuffer(RenderHandle buffer, size_t offset, const void* data, size_t size, bool discard);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance);
+
+	// Bind the views that are drawn to and cleared by ClearTargets
+	void SetRenderTargets(ComPtr<ID3D11RenderTargetView> renderTargetView, ComPtr<ID3D11DepthStencilView> depthStencilView);
+
+	// Convert between Direct3D interface pointers and handles
+	template <typename T>
+	static inline RenderHandle ToHandle(const ComPtr<T>& object) { return reinterpret_cast<RenderHandle>(object.Get()); }
+	template <typename T>
+	static inline T* FromHandle(RenderHandle handle) { return reinterpret_cast<T*>(handle); }
+
+private:
+	ComPtr<ID3D11Device>			_device;
+	ComPtr<ID3D11DeviceContext>		_deviceContext;
+	ComPtr<ID3D11DeviceContext1>	_deviceContext1;
+	ComPtr<ID3D11RenderTargetView>	_renderTargetView;
+	ComPtr<ID3D11DepthStencilView>	_depthStencilView;
+	// False if the driver cannot map dynamic constant buffers with D3D11_MAP_WRITE_NO_OVERWRITE
+	bool							_noOverwriteConstants{ false };
+};
@@ -1,16 +1,19 @@
-#pragma once
-#include "DirectXFramework.h"
-
-class DirectXApp : public DirectXFramework
-{
-public:
-	void CreateSceneGraph();
-	void UpdateSceneGraph();
-
-	float _rotationAngle{ 0 };
-	float _yOffset{ 0 };
-	float _boxOffset{ 0 };
-	bool _isGoingUp;
-
-};
-
+#pragma once
+#include "DirectXFramework.h"
+
+class DirectXApp : public DirectXFramework
+{
+public:
+	void CreateSceneGraph();
+	void Simulate(double step);
+	void UpdateSceneGraph();
+
+	// The angle after the last two simulation steps, which the scene is posed between
+	float _previousRotationAngle{ 0 };
+	float _rotationAngle{ 0 };
+	float _yOffset{ 0 };
+	float _boxOffset{ 0 };
+	bool _isGoingUp;
+
+};
+
@@ -1,252 +1,357 @@
-#include "DirectXFramework.h"
-
-// DirectX libraries that are needed
-#pragma comment(lib, "d3d11.lib")
-#pragma comment(lib, "d3dcompiler.lib")
-
-DirectXFramework * _dxFramework = nullptr;
-
-DirectXFramework::DirectXFramework() : DirectXFramework(800, 600)
-{
-}
-
-DirectXFramework::DirectXFramework(unsigned int width, unsigned int height) : Framework(width, height)
-{
-	_dxFramework = this;
-
-	// Set default background colour
-	_backgroundColour[0] = 0.0f;
-	_backgroundColour[1] = 0.0f;
-	_backgroundColour[2] = 0.0f;
-	_backgroundColour[3] = 0.0f;
-
-	// Initialise vectors used to create camera.  We will move these
-	// to a separate Camera class later
-	_eyePosition = Vector3(0.0f, 20.0f, -90.0f);
-	_focalPointPosition = Vector3(0.0f, 20.0f, 0.0f); //welllll
-	_upVector = Vector3(0.0f, 1.0f, 0.0f);
-}
-
-void DirectXFramework::SetCameraPosition(Vector3 cameraPosition)
-{
-	_eyePosition = cameraPosition;
-	_viewTransformation = XMMatrixLookAtLH(_eyePosition, _focalPointPosition, _upVector);
-}
-
-void DirectXFramework::SetCameraFocalPoint(Vector3 cameraFocalPoint)
-{
-	_focalPointPosition = cameraFocalPoint;
-	_viewTransformation = XMMatrixLookAtLH(_eyePosition, _focalPointPosition, _upVector);
-}
-
-void DirectXFramework::SetCameraUpVector(Vector3 cameraUpVector)
-{
-	_upVector = cameraUpVector;
-	_viewTransformation = XMMatrixLookAtLH(_eyePosition, _focalPointPosition, _upVector);
-}
-
-DirectXFramework * DirectXFramework::GetDXFramework()
-{
-	return _dxFramework;
-}
-
-const Matrix& DirectXFramework::GetViewTransformation() const
-{
-	return _viewTransformation;
-}
-
-const Matrix& DirectXFramework::GetProjectionTransformation() const
-{
-	return _projectionTransformation;
-}
-
-void DirectXFramework::SetBackgroundColour(Vector4 backgroundColour)
-{
-	_backgroundColour[0] = backgroundColour.x;
-	_backgroundColour[1] = backgroundColour.y;
-	_backgroundColour[2] = backgroundColour.z;
-	_backgroundColour[3] = backgroundColour.w;
-}
-
-void DirectXFramework::CreateSceneGraph()
-{
-}
-
-void DirectXFramework::UpdateSceneGraph()
-{
-}
-
-bool DirectXFramework::Initialise()
-{
-	// The call to CoInitializeEx is needed if we are using
-	// textures since the WIC library used requires it, so we
-	// take care of initialising it here
-	if FAILED(CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED))
-	{
-		return false;
-	}
-	if (!GetDeviceAndSwapChain())
-	{
-		return false;
-	}
-	OnResize(SIZE_RESTORED);
-
-	_sceneGraph = make_shared<SceneGraph>();
-	CreateSceneGraph();
-	return _sceneGraph->Initialise();
-}
-
-void DirectXFramework::Shutdown()
-{
-	// Required because we called CoInitialize above
-	_sceneGraph->Shutdown();
-	CoUninitialize();
-}
-
-void DirectXFramework::Update()
-{
-	// Do any updates to the scene graph nodes
-	UpdateSceneGraph();
-	// Now apply any updates that have been made to world transformations
-	// to all the nodes
-	Matrix identity;
-	_sceneGraph->Update(identity);
-}
-
-void DirectXFramework::Render()
-{
-	// Clear the render target and the depth stencil view
-	_deviceContext->ClearRenderTargetView(_renderTargetView.Get(), _backgroundColour);
-	_deviceContext->ClearDepthStencilView(_depthStencilView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
-	// Now recurse through the scene graph, rendering each object
-	_sceneGraph->Render();
-	// Now display the scene
-	ThrowIfFailed(_swapChain->Present(0, 0));
-}
-
-void DirectXFramework::OnResize(WPARAM wParam)
-{
-	if (wParam == SIZE_MINIMIZED)
-	{
-		return;
-	}
-
-	// Update view and projection matrices to allow for the window size change
-	_viewTransformation = XMMatrixLookAtLH(_eyePosition, _focalPointPosition, _upVector);
-	_projectionTransformation = XMMatrixPerspectiveFovLH(XM_PIDIV4, (float)GetWindowWidth() / GetWindowHeight(), 1.0f, 10000.0f);
-		
-
-	// This will free any existing render and depth views (which
-	// would be the case if the window was being resized)
-	_renderTargetView = nullptr;
-	_depthStencilView = nullptr;
-	_depthStencilBuffer = nullptr;
-
-	ThrowIfFailed(_swapChain->ResizeBuffers(1, GetWindowWidth(), GetWindowHeight(), DXGI_FORMAT_R8G8B8A8_UNORM, 0));
-
-	// Create a drawing surface for DirectX to render to
-	ComPtr<ID3D11Texture2D> backBuffer;
-	ThrowIfFailed(_swapChain->GetBuffer(0, IID_PPV_ARGS(&backBuffer)));
-	ThrowIfFailed(_device->CreateRenderTargetView(backBuffer.Get(), NULL, _renderTargetView.GetAddressOf()));
-	
-	// The depth buffer is used by DirectX to ensure
-	// that pixels of closer objects are drawn over pixels of more
-	// distant objects.
-
-	// First, we need to create a texture (bitmap) for the depth buffer
-	D3D11_TEXTURE2D_DESC depthBufferTexture = { 0 };
-	depthBufferTexture.Width = GetWindowWidth();
-	depthBufferTexture.Height = GetWindowHeight();
-	depthBufferTexture.ArraySize = 1;
-	depthBufferTexture.MipLevels = 1;
-	depthBufferTexture.SampleDesc.Count = 4;
-	depthBufferTexture.Format = DXGI_FORMAT_D32_FLOAT;
-	depthBufferTexture.Usage = D3D11_USAGE_DEFAULT;
-	depthBufferTexture.BindFlags = D3D11_BIND_DEPTH_STENCIL;
-
-	// Create the depth buffer.  
-	ComPtr<ID3D11Texture2D> depthBuffer;
-	ThrowIfFailed(_device->CreateTexture2D(&depthBufferTexture, NULL, depthBuffer.GetAddressOf()));
-	ThrowIfFailed(_device->CreateDepthStencilView(depthBuffer.Get(), 0, _depthStencilView.GetAddressOf()));
-
-	// Bind the render target view buffer and the depth stencil view buffer to the output-merger stage
-	// of the pipeline. 
-	_deviceContext->OMSetRenderTargets(1, _renderTargetView.GetAddressOf(), _depthStencilView.Get());
-
-	// Specify a viewport of the required size
-	D3D11_VIEWPORT viewPort = { 0 };
-	viewPort.Width = static_cast<float>(GetWindowWidth());
-	viewPort.Height = static_cast<float>(GetWindowHeight());
-	viewPort.MinDepth = 0.0f;
-	viewPort.MaxDepth = 1.0f;
-	viewPort.TopLeftX = 0;
-	viewPort.TopLeftY = 0;
-	_deviceContext->RSSetViewports(1, &viewPort);
-}
-
-bool DirectXFramework::GetDeviceAndSwapChain()
-{
-	UINT createDeviceFlags = 0;
-
-	// We are going to only accept a hardware driver or a WARP
-	// driver
-	D3D_DRIVER_TYPE driverTypes[] =
-	{
-		D3D_DRIVER_TYPE_HARDWARE,
-		D3D_DRIVER_TYPE_WARP
-	};
-	unsigned int totalDriverTypes = ARRAYSIZE(driverTypes);
-
-	D3D_FEATURE_LEVEL featureLevels[] =
-	{
-		D3D_FEATURE_LEVEL_11_0
-	};
-	unsigned int totalFeatureLevels = ARRAYSIZE(featureLevels);
-
-	DXGI_SWAP_CHAIN_DESC swapChainDesc = { 0 };
-	swapChainDesc.BufferCount = 1;
-	swapChainDesc.BufferDesc.Width = GetWindowWidth();
-	swapChainDesc.BufferDesc.Height = GetWindowHeight();
-	swapChainDesc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	// Set the refresh rate to 0 and let DXGI determine the best option (refer to DXGI best practices)
-	swapChainDesc.BufferDesc.RefreshRate.Numerator = 0;
-	swapChainDesc.BufferDesc.RefreshRate.Denominator = 0;
-	swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-	swapChainDesc.OutputWindow = GetHWnd();
-	// Start out windowed
-	swapChainDesc.Windowed = true;
-	// Enable multi-sampling to give smoother lines (set to 1 if performance becomes an issue)
-	swapChainDesc.SampleDesc.Count = 4;
-	swapChainDesc.SampleDesc.Quality = 0;
-
-	// Loop through the driver types to determine which one is available to us
-	D3D_DRIVER_TYPE driverType = D3D_DRIVER_TYPE_UNKNOWN;
-
-	for (unsigned int driver = 0; driver < totalDriverTypes && driverType == D3D_DRIVER_TYPE_UNKNOWN; driver++)
-	{
-		if (SUCCEEDED(D3D11CreateDeviceAndSwapChain(0,
-			driverTypes[driver],
-			0,
-			createDeviceFlags,
-			featureLevels,
-			totalFeatureLevels,
-			D3D11_SDK_VERSION,
-			&swapChainDesc,
-			_swapChain.GetAddressOf(),
-			_device.GetAddressOf(),
-			0,
-			_deviceContext.GetAddressOf()
-		)))
-
-		{
-			driverType = driverTypes[driver];
-		}
-	}
-	if (driverType == D3D_DRIVER_TYPE_UNKNOWN)
-	{
-		// Unable to find a suitable device driver
-		return false;
-	}
-	return true;
-}
-
+#include "DirectXFramework.h"
+#include "Geometry.h"
+
+// DirectX libraries that are needed
+#pragma comment(lib, "d3d11.lib")
+#pragma comment(lib, "d3dcompiler.lib")
+
+DirectXFramework * _dxFramework = nullptr;
+
+// Size in bytes of the buffer used for instance data.  Larger groups of instances are split into several draws.
+constexpr UINT InstanceBufferSize = 256 * 1024;
+// Size in bytes of the ring buffer that constants are written to.  Each draw uses at least 256 bytes.
+constexpr UINT ConstantBufferSize = 4 * 1024 * 1024;
+
+DirectXFramework::DirectXFramework() : DirectXFramework(800, 600)
+{
+}
+
+DirectXFramework::DirectXFramework(unsigned int width, unsigned int height) : Framework(width, height)
+{
+	_dxFramework = this;
+
+	// Set default background colour
+	_backgroundColour[0] = 0.0f;
+	_backgroundColour[1] = 0.0f;
+	_backgroundColour[2] = 0.0f;
+	_backgroundColour[3] = 0.0f;
+
+	// Initialise vectors used to create camera.  We will move these
+	// to a separate Camera class later
+	_eyePosition = Vector3(0.0f, 20.0f, -90.0f);
+	_focalPointPosition = Vector3(0.0f, 20.0f, 0.0f); //welllll
+	_upVector = Vector3(0.0f, 1.0f, 0.0f);
+}
+
+void DirectXFramework::SetCameraPosition(Vector3 cameraPosition)
+{
+	_eyePosition = cameraPosition;
+	_viewTransformation = XMMatrixLookAtLH(_eyePosition, _focalPointPosition, _upVector);
+}
+
+void DirectXFramework::SetCameraFocalPoint(Vector3 cameraFocalPoint)
+{
+	_focalPointPosition = cameraFocalPoint;
+	_viewTransformation = XMMatrixLookAtLH(_eyePosition, _focalPointPosition, _upVector);
+}
+
+void DirectXFramework::SetCameraUpVector(Vector3 cameraUpVector)
+{
+	_upVector = cameraUpVector;
+	_viewTransformation = XMMatrixLookAtLH(_eyePosition, _focalPointPosition, _upVector);
+}
+
+DirectXFramework * DirectXFramework::GetDXFramework()
+{
+	return _dxFramework;
+}
+
+const Matrix& DirectXFramework::GetViewTransformation() const
+{
+	return _viewTransformation;
+}
+
+const Matrix& DirectXFramework::GetProjectionTransformation() const
+{
+	return _projectionTransformation;
+}
+
+void DirectXFramework::SetBackgroundColour(Vector4 backgroundColour)
+{
+	_backgroundColour[0] = backgroundColour.x;
+	_backgroundColour[1] = backgroundColour.y;
+	_backgroundColour[2] = backgroundColour.z;
+	_backgroundColour[3] = backgroundColour.w;
+}
+
+void DirectXFramework::SetParallelUpdate(bool enabled, size_t grainSize)
+{
+	_parallelUpdate = enabled;
+	_transformHierarchy.SetGrainSize(grainSize);
+}
+
+void DirectXFramework::CreateSceneGraph()
+{
+}
+
+void DirectXFramework::UpdateSceneGraph()
+{
+}
+
+bool DirectXFramework::Initialise()
+{
+	// The call to CoInitializeEx is needed if we are using
+	// textures since the WIC library used requires it, so we
+	// take care of initialising it here
+	if FAILED(CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED))
+	{
+		return false;
+	}
+	if (!GetDeviceAndSwapChain())
+	{
+		return false;
+	}
+	// The render device is needed by OnResize to bind the render targets
+	_renderDevice = make_shared<D3D11RenderDevice>(_deviceContext);
+	// Meshes can be released by Update while the render thread is drawing them
+	_renderDevice->SetKeepRetiredBuffers(true);
+	OnResize(SIZE_RESTORED);
+	_shaderCache = make_unique<ShaderCache>(_device);
+	_meshRegistry = make_unique<MeshRegistry>(_renderDevice);
+
+	// Instance data is copied into this buffer before each instanced draw.  Only the render stage
+	// uses it, so the queues can share it.
+	_instanceBuffer = _renderDevice->CreateBuffer(BufferType::Vertex, BufferUsage::Default, InstanceBufferSize, nullptr);
+	// The constants for every draw in a frame are written into a constant buffer, and each draw binds its part
+	// of it.  Each queue has a buffer of its own, since its ring allocator assumes that nothing else writes there.
+	for (int i = 0; i < 2; i++)
+	{
+		_constantBuffers[i] = _renderDevice->CreateBuffer(BufferType::Constant, BufferUsage::Dynamic, ConstantBufferSize, nullptr);
+		_renderQueues[i].SetInstanceBuffer(_instanceBuffer, InstanceBufferSize);
+		_renderQueues[i].SetConstantBuffer(_constantBuffers[i], ConstantBufferSize);
+	}
+
+	// Create the worker threads used to spread work across all of the cores
+	_jobSystem = make_unique<JobSystem>();
+
+	_sceneGraph = make_shared<SceneGraph>();
+	CreateSceneGraph();
+	if (!_sceneGraph->Initialise())
+	{
+		return false;
+	}
+	_transformHierarchy.Rebuild(_sceneGraph.get());
+	// All of the shaders needed by the scene have now been compiled or loaded
+	_shaderCache->SaveByteCode();
+	return true;
+}
+
+void DirectXFramework::Shutdown()
+{
+	// Required because we called CoInitialize above
+	_sceneGraph->Shutdown();
+	_jobSystem.reset();
+	// Nothing is being rendered now, so buffers can be released at once
+	_renderDevice->SetKeepRetiredBuffers(false);
+	// Meshes hold their own reference to the render device, so it stays alive until they have released their buffers
+	_renderDevice->ReleaseBuffer(_instanceBuffer);
+	_renderDevice->ReleaseBuffer(_constantBuffers[0]);
+	_renderDevice->ReleaseBuffer(_constantBuffers[1]);
+	_renderDevice.reset();
+	_shaderCache.reset();
+	_meshRegistry.reset();
+	CoUninitialize();
+}
+
+void DirectXFramework::Update()
+{
+	// Do any updates to the scene graph nodes
+	UpdateSceneGraph();
+	// If nodes have been added or removed, flatten the scene graph again
+	if (_transformHierarchy.IsStructureChanged())
+	{
+		_transformHierarchy.Rebuild(_sceneGraph.get());
+	}
+	// Now apply any updates that have been made to world transformations
+	// to all the nodes in a single pass over the flattened hierarchy
+	Matrix identity;
+	_transformHierarchy.Update(identity, _parallelUpdate ? _jobSystem.get() : nullptr);
+	BuildRenderQueue();
+}
+
+bool DirectXFramework::AddOccluder(const SceneNodePointer& node, const MeshPointer& mesh)
+{
+	// The simplified levels of detail may not stay inside the full mesh, so they could hide things that are visible
+	MeshLod lod = mesh->GetLod(0);
+	bool added = false;
+	mesh->Indices.Visit([&](const auto* indices, size_t)
+		{
+			added = _occlusionCuller.AddOccluder(node, mesh->GetVertexData(), mesh->VertexCount, mesh->VertexStride, indices + lod.IndexStart, lod.IndexCount);
+		});
+	return added;
+}
+
+// Nothing in the frame itself queries the spatial index, so rather than refitting it every frame,
+// it is brought up to date with whatever has moved when it is asked for
+BoundingVolumeHierarchy& DirectXFramework::GetBoundingVolumeHierarchy()
+{
+	_boundingVolumeHierarchy.Update(_transformHierarchy);
+	return _boundingVolumeHierarchy;
+}
+
+// Build the draw packets for the frame in the render queue of the update buffer.  The packets
+// and their constants hold everything the render stage needs (the world transformations, the
+// materials and the camera), so the scene graph is not touched while the frame is rendered.
+void DirectXFramework::BuildRenderQueue()
+{
+	// Work out which nodes are inside the view frustum.  The visible and culled
+	// counts are available from the transform hierarchy.
+	Matrix viewProjection = _viewTransformation * _projectionTransformation;
+	_frustum.Extract(viewProjection);
+	_transformHierarchy.Cull(_frustum);
+	// Then hide whatever is behind the occluders.  The time this takes and the number of nodes hidden
+	// are available from the occlusion culler's statistics.
+	if (_occlusionCulling)
+	{
+		_occlusionCuller.Cull(_transformHierarchy, viewProjection);
+	}
+	// Multiply the world transformations of everything that survived culling by the view and
+	// projection transformations in one batch, ready for the nodes to pick up as they render
+	_transformHierarchy.UpdateWorldViewProjections(viewProjection);
+	// Now recurse through the scene graph.  Each visible object adds its draw packets to the
+	// render queue, which is then sorted by state and submitted.  The number of state changes
+	// avoided is available from the render queue statistics.
+	RenderQueue& renderQueue = GetRenderQueue();
+	renderQueue.Clear();
+	FrameConstants frameConstants;
+	frameConstants.View = _viewTransformation;
+	frameConstants.Projection = _projectionTransformation;
+	frameConstants.ViewProjection = viewProjection;
+	frameConstants.EyePosition = Vector4(_eyePosition.x, _eyePosition.y, _eyePosition.z, 1.0f);
+	frameConstants.AmbientLightColour = _ambientLightColour;
+	frameConstants.DirectionalLightColour = _directionalLightColour;
+	frameConstants.DirectionalLightVector = _directionalLightVector;
+	renderQueue.SetFrameConstants(&frameConstants, sizeof(frameConstants));
+	_sceneGraph->Render();
+	renderQueue.Sort();
+}
+
+void DirectXFramework::Render()
+{
+	// Clear the render target and the depth stencil view, and submit the packets built by the last Update
+	_renderDevice->ClearTargets(_backgroundColour, 1.0f);
+	_renderQueues[GetRenderBuffer()].Submit(*_renderDevice);
+	// Now display the scene
+	ThrowIfFailed(_swapChain->Present(0, 0));
+	_renderDevice->EndFrame();
+}
+
+void DirectXFramework::OnResize(WPARAM wParam)
+{
+	if (wParam == SIZE_MINIMIZED)
+	{
+		return;
+	}
+
+	// Update view and projection matrices to allow for the window size change
+	_viewTransformation = XMMatrixLookAtLH(_eyePosition, _focalPointPosition, _upVector);
+	_projectionTransformation = XMMatrixPerspectiveFovLH(XM_PIDIV4, (float)GetWindowWidth() / GetWindowHeight(), 1.0f, 10000.0f);
+		
+
+	// This will free any existing render and depth views (which
+	// would be the case if the window was being resized)
+	_renderTargetView = nullptr;
+	_depthStencilView = nullptr;
+	_depthStencilBuffer = nullptr;
+
+	ThrowIfFailed(_swapChain->ResizeBuffers(1, GetWindowWidth(), GetWindowHeight(), DXGI_FORMAT_R8G8B8A8_UNORM, 0));
+
+	// Create a drawing surface for DirectX to render to
+	ComPtr<ID3D11Texture2D> backBuffer;
+	ThrowIfFailed(_swapChain->GetBuffer(0, IID_PPV_ARGS(&backBuffer)));
+	ThrowIfFailed(_device->CreateRenderTargetView(backBuffer.Get(), NULL, _renderTargetView.GetAddressOf()));
+	
+	// The depth buffer is used by DirectX to ensure
+	// that pixels of closer objects are drawn over pixels of more
+	// distant objects.
+
+	// First, we need to create a texture (bitmap) for the depth buffer
+	D3D11_TEXTURE2D_DESC depthBufferTexture = { 0 };
+	depthBufferTexture.Width = GetWindowWidth();
+	depthBufferTexture.Height = GetWindowHeight();
+	depthBufferTexture.ArraySize = 1;
+	depthBufferTexture.MipLevels = 1;
+	depthBufferTexture.SampleDesc.Count = 4;
+	depthBufferTexture.Format = DXGI_FORMAT_D32_FLOAT;
+	depthBufferTexture.Usage = D3D11_USAGE_DEFAULT;
+	depthBufferTexture.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+
+	// Create the depth buffer.  
+	ComPtr<ID3D11Texture2D> depthBuffer;
+	ThrowIfFailed(_device->CreateTexture2D(&depthBufferTexture, NULL, depthBuffer.GetAddressOf()));
+	ThrowIfFailed(_device->CreateDepthStencilView(depthBuffer.Get(), 0, _depthStencilView.GetAddressOf()));
+
+	// Bind the render target view buffer and the depth stencil view buffer to the output-merger stage
+	// of the pipeline. 
+	_renderDevice->SetRenderTargets(_renderTargetView, _depthStencilView);
+
+	// Specify a viewport of the required size
+	_renderDevice->SetViewport(static_cast<float>(GetWindowWidth()), static_cast<float>(GetWindowHeight()));
+}
+
+bool DirectXFramework::GetDeviceAndSwapChain()
+{
+	UINT createDeviceFlags = 0;
+
+	// We are going to only accept a hardware driver or a WARP
+	// driver
+	D3D_DRIVER_TYPE driverTypes[] =
+	{
+		D3D_DRIVER_TYPE_HARDWARE,
+		D3D_DRIVER_TYPE_WARP
+	};
+	unsigned int totalDriverTypes = ARRAYSIZE(driverTypes);
+
+	D3D_FEATURE_LEVEL featureLevels[] =
+	{
+		D3D_FEATURE_LEVEL_11_0
+	};
+	unsigned int totalFeatureLevels = ARRAYSIZE(featureLevels);
+
+	DXGI_SWAP_CHAIN_DESC swapChainDesc = { 0 };
+	swapChainDesc.BufferCount = 1;
+	swapChainDesc.BufferDesc.Width = GetWindowWidth();
+	swapChainDesc.BufferDesc.Height = GetWindowHeight();
+	swapChainDesc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	// Set the refresh rate to 0 and let DXGI determine the best option (refer to DXGI best practices)
+	swapChainDesc.BufferDesc.RefreshRate.Numerator = 0;
+	swapChainDesc.BufferDesc.RefreshRate.Denominator = 0;
+	swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+	swapChainDesc.OutputWindow = GetHWnd();
+	// Start out windowed
+	swapChainDesc.Windowed = true;
+	// Enable multi-sampling to give smoother lines (set to 1 if performance becomes an issue)
+	swapChainDesc.SampleDesc.Count = 4;
+	swapChainDesc.SampleDesc.Quality = 0;
+
+	// Loop through the driver types to determine which one is available to us
+	D3D_DRIVER_TYPE driverType = D3D_DRIVER_TYPE_UNKNOWN;
+
+	for (unsigned int driver = 0; driver < totalDriverTypes && driverType == D3D_DRIVER_TYPE_UNKNOWN; driver++)
+	{
+		if (SUCCEEDED(D3D11CreateDeviceAndSwapChain(0,
+			driverTypes[driver],
+			0,
+			createDeviceFlags,
+			featureLevels,
+			totalFeatureLevels,
+			D3D11_SDK_VERSION,
+			&swapChainDesc,
+			_swapChain.GetAddressOf(),
+			_device.GetAddressOf(),
+			0,
+			_deviceContext.GetAddressOf()
+		)))
+
+		{
+			driverType = driverTypes[driver];
+		}
+	}
+	if (driverType == D3D_DRIVER_TYPE_UNKNOWN)
+	{
+		// Unable to find a suitable device driver
+		return false;
+	}
+	return true;
+}
+
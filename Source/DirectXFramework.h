@@ -1,60 +1,111 @@
-#pragma once
-#include <vector>
-#include "Framework.h"
-#include "DirectXCore.h"
-#include "SceneGraph.h"
-
-class DirectXFramework : public Framework
-{
-public:
-	DirectXFramework();
-	DirectXFramework(unsigned int width, unsigned int height);
-
-	virtual void CreateSceneGraph();
-	virtual void UpdateSceneGraph();
-
-	bool Initialise();
-	void Update();
-	void Render();
-	void OnResize(WPARAM wParam);
-	void Shutdown();
-
-	static DirectXFramework *			GetDXFramework();
-
-	inline SceneGraphPointer			GetSceneGraph() { return _sceneGraph; }
-	inline ComPtr<ID3D11Device>			GetDevice() { return _device; }
-	inline ComPtr<ID3D11DeviceContext>	GetDeviceContext() { return _deviceContext; }
-
-	void SetCameraPosition(Vector3 cameraPosition);
-	void SetCameraFocalPoint(Vector3 cameraFocalPoint);
-	void SetCameraUpVector(Vector3 cameraUpVector);
-
-	const Matrix&						GetViewTransformation() const;
-	const Matrix&						GetProjectionTransformation() const;
-
-	void								SetBackgroundColour(Vector4 backgroundColour);
-
-private:
-	ComPtr<ID3D11Device>				_device;
-	ComPtr<ID3D11DeviceContext>			_deviceContext;
-	ComPtr<IDXGISwapChain>				_swapChain;
-	ComPtr<ID3D11Texture2D>				_depthStencilBuffer;
-	ComPtr<ID3D11RenderTargetView>		_renderTargetView;
-	ComPtr<ID3D11DepthStencilView>		_depthStencilView;
-
-	D3D11_VIEWPORT						_screenViewport{ 0 };
-
-	Vector3								_eyePosition;
-	Vector3								_focalPointPosition;
-	Vector3								_upVector;
-
-	Matrix								_viewTransformation;
-	Matrix								_projectionTransformation;
-
-	SceneGraphPointer					_sceneGraph;
-
-	float							    _backgroundColour[4];
-
-	bool GetDeviceAndSwapChain();
-};
-
+#pragma once
+#include <vector>
+#include "Framework.h"
+#include "DirectXCore.h"
+#include "SceneGraph.h"
+#include "JobSystem.h"
+#include "BoundingVolumeHierarchy.h"
+#include "OcclusionCuller.h"
+#include "RenderQueue.h"
+#include "D3D11RenderDevice.h"
+#include "ShaderCache.h"
+#include "MeshRegistry.h"
+
+class DirectXFramework : public Framework
+{
+public:
+	DirectXFramework();
+	DirectXFramework(unsigned int width, unsigned int height);
+
+	virtual void CreateSceneGraph();
+	virtual void UpdateSceneGraph();
+
+	bool Initialise();
+	void Update();
+	void Render();
+	void OnResize(WPARAM wParam);
+	void Shutdown();
+
+	static DirectXFramework *			GetDXFramework();
+
+	inline SceneGraphPointer			GetSceneGraph() { return _sceneGraph; }
+	inline TransformHierarchy&			GetTransformHierarchy() { return _transformHierarchy; }
+	BoundingVolumeHierarchy&			GetBoundingVolumeHierarchy();
+	inline OcclusionCuller&				GetOcclusionCuller() { return _occlusionCuller; }
+	inline JobSystem *					GetJobSystem() { return _jobSystem.get(); }
+	// The queue that nodes add their draw packets to, which is the one for the frame being updated
+	inline RenderQueue&					GetRenderQueue() { return _renderQueues[GetUpdateBuffer()]; }
+	inline RenderDevice *				GetRenderDevice() { return _renderDevice.get(); }
+	inline ShaderCache&					GetShaderCache() { return *_shaderCache; }
+	inline MeshRegistry&				GetMeshRegistry() { return *_meshRegistry; }
+
+	// When enabled, subtrees with at least grainSize nodes are updated in parallel on the job system
+	void								SetParallelUpdate(bool enabled, size_t grainSize = 1024);
+	// When enabled, nodes that support it are drawn as instances.  This must be set before the scene graph is initialised.
+	inline void							SetInstancedRendering(bool enabled) { _instancedRendering = enabled; }
+	inline bool							IsInstancedRendering() const { return _instancedRendering; }
+	// When enabled, nodes hidden behind the occluders (see SceneNode::SetOccluder) are not rendered
+	inline void							SetOcclusionCulling(bool enabled) { _occlusionCulling = enabled; }
+	inline bool							IsOcclusionCulling() const { return _occlusionCulling; }
+	// Give the occlusion culler the full detail level of a node's mesh to draw.  Returns false if the mesh has indices
+	// that are out of range, in which case the node does not hide anything.
+	bool								AddOccluder(const SceneNodePointer& node, const MeshPointer& mesh);
+	inline ComPtr<ID3D11Device>			GetDevice() { return _device; }
+	inline ComPtr<ID3D11DeviceContext>	GetDeviceContext() { return _deviceContext; }
+
+	void SetCameraPosition(Vector3 cameraPosition);
+	void SetCameraFocalPoint(Vector3 cameraFocalPoint);
+	void SetCameraUpVector(Vector3 cameraUpVector);
+
+	const Matrix&						GetViewTransformation() const;
+	const Matrix&						GetProjectionTransformation() const;
+
+	void								SetBackgroundColour(Vector4 backgroundColour);
+	// The lights are passed to the shaders in the frame constants
+	inline void							SetAmbientLight(Vector4 colour) { _ambientLightColour = colour; }
+	inline void							SetDirectionalLight(Vector4 direction, Vector4 colour) { _directionalLightVector = direction; _directionalLightColour = colour; }
+
+private:
+	ComPtr<ID3D11Device>				_device;
+	ComPtr<ID3D11DeviceContext>			_deviceContext;
+	ComPtr<IDXGISwapChain>				_swapChain;
+	ComPtr<ID3D11Texture2D>				_depthStencilBuffer;
+	ComPtr<ID3D11RenderTargetView>		_renderTargetView;
+	ComPtr<ID3D11DepthStencilView>		_depthStencilView;
+
+	D3D11_VIEWPORT						_screenViewport{ 0 };
+
+	Vector3								_eyePosition;
+	Vector3								_focalPointPosition;
+	Vector3								_upVector;
+
+	Matrix								_viewTransformation;
+	Matrix								_projectionTransformation;
+
+	SceneGraphPointer					_sceneGraph;
+	TransformHierarchy					_transformHierarchy;
+	BoundingVolumeHierarchy				_boundingVolumeHierarchy;
+	Frustum								_frustum;
+	OcclusionCuller						_occlusionCuller;
+	bool								_occlusionCulling{ true };
+	unique_ptr<JobSystem>				_jobSystem;
+	bool								_parallelUpdate{ true };
+	// The draw packets and constants of each frame are built by Update and submitted by Render, so
+	// there is a queue (and a constant buffer for it to write into) for each frame buffer
+	RenderQueue							_renderQueues[2];
+	shared_ptr<D3D11RenderDevice>		_renderDevice;
+	unique_ptr<ShaderCache>				_shaderCache;
+	unique_ptr<MeshRegistry>			_meshRegistry;
+	RenderHandle						_instanceBuffer{ 0 };
+	RenderHandle						_constantBuffers[2]{ 0, 0 };
+	bool								_instancedRendering{ true };
+
+	float							    _backgroundColour[4];
+	Vector4								_ambientLightColour{ 0.2f, 0.2f, 0.2f, 1.0f };
+	Vector4								_directionalLightColour{ Colors::Gold };
+	Vector4								_directionalLightVector{ -1.0f, -1.0f, 1.0f, 0.0f };
+
+	bool GetDeviceAndSwapChain();
+	void BuildRenderQueue();
+};
+
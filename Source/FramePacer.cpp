@@ -0,0 +1,208 @@
+#include "FramePacer.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+constexpr size_t FramePacer::HistorySize;
+constexpr double FramePacer::InitialSleepSlack;
+constexpr double FramePacer::MinimumSleep;
+constexpr size_t FramePacer::SlackHistorySize;
+constexpr double FramePacer::SlackPercentile;
+
+static inline double ToMilliseconds(chrono::steady_clock::duration duration)
+{
+	return chrono::duration<double, milli>(duration).count();
+}
+
+FramePacer::FramePacer(double frameRate, double updateRate)
+{
+	SetFrameRate(frameRate);
+	SetUpdateRate(updateRate);
+	_frameTimes.reserve(HistorySize);
+	_oversleeps.reserve(SlackHistorySize);
+}
+
+void FramePacer::SetFrameRate(double frameRate)
+{
+	_frameRate = max(frameRate, 0.0);
+	_framePeriod = _frameRate > 0 ? chrono::duration_cast<Clock::duration>(chrono::duration<double>(1.0 / _frameRate)) : Clock::duration::zero();
+}
+
+void FramePacer::SetUpdateRate(double updateRate)
+{
+	_updateRate = max(updateRate, 0.0);
+	_accumulator = 0;
+}
+
+double FramePacer::GetUpdateStep() const
+{
+	return _updateRate > 0 ? 1.0 / _updateRate : _frameTime;
+}
+
+bool FramePacer::WaitForNextFrame(const SleepFunction& sleep)
+{
+	if (!_started || _frameRate <= 0)
+	{
+		return true;
+	}
+	while (true)
+	{
+		Clock::time_point now = Clock::now();
+		double remaining = ToMilliseconds(_nextFrame - now);
+		if (remaining <= 0)
+		{
+			return true;
+		}
+		double sleepTime = remaining - GetSleepSlack();
+		if (sleepTime < MinimumSleep)
+		{
+			break;
+		}
+		bool slept = true;
+		if (sleep)
+		{
+			slept = sleep(sleepTime);
+		}
+		else
+		{
+			this_thread::sleep_for(chrono::duration<double, milli>(sleepTime));
+		}
+		double sleptTime = ToMilliseconds(Clock::now() - now);
+		_sleepTime += sleptTime;
+		if (!slept)
+		{
+			return false;
+		}
+		// Only full sleeps show how late the OS wakes threads.  Sleeps that end early are not counted as negative,
+		// so that one early wake up does not hide how late the others were.
+		double oversleep = max(sleptTime - sleepTime, 0.0);
+		if (_oversleeps.size() < SlackHistorySize)
+		{
+			_oversleeps.push_back(oversleep);
+		}
+		else
+		{
+			_oversleeps[_nextOversleep] = oversleep;
+			_nextOversleep = (_nextOversleep + 1) % SlackHistorySize;
+		}
+	}
+
+	// Spin for the rest of the time, letting anything else that is ready run meanwhile
+	Clock::time_point spinStart = Clock::now();
+	while (Clock::now() < _nextFrame)
+	{
+		this_thread::yield();
+	}
+	_spinTime += ToMilliseconds(Clock::now() - spinStart);
+	return true;
+}
+
+void FramePacer::BeginFrame()
+{
+	Clock::time_point now = Clock::now();
+	if (!_started)
+	{
+		// The first frame takes one update step, so that there is something to show
+		_started = true;
+		_frameTime = 0;
+		_accumulator = GetUpdateStep();
+		_nextFrame = now;
+	}
+	else
+	{
+		_frameTime = chrono::duration<double>(now - _lastFrame).count();
+		if (_frameTimes.size() < HistorySize)
+		{
+			_frameTimes.push_back(_frameTime * 1000.0);
+		}
+		else
+		{
+			_frameTimes[_nextFrameTime] = _frameTime * 1000.0;
+			_nextFrameTime = (_nextFrameTime + 1) % HistorySize;
+		}
+	}
+	_lastFrame = now;
+	_statisticsFrames++;
+
+	// Schedule the next frame.  If we get more than a frame behind, frames are dropped to catch up rather
+	// than started as soon as possible until the error has been made up.
+	_nextFrame += _framePeriod;
+	if (_nextFrame < now)
+	{
+		_nextFrame = now + _framePeriod;
+	}
+
+	if (_updateRate <= 0)
+	{
+		_updateCount = 1;
+		_interpolation = 1.0;
+		return;
+	}
+	double step = 1.0 / _updateRate;
+	_accumulator += _frameTime;
+	double stepCount = floor(_accumulator / step);
+	if (stepCount > _maximumUpdateCount)
+	{
+		// Too far behind.  The time that cannot be simulated this frame is dropped.
+		stepCount = _maximumUpdateCount;
+		_accumulator = stepCount * step + fmod(_accumulator, step);
+	}
+	_updateCount = static_cast<unsigned int>(stepCount);
+	_accumulator = max(_accumulator - stepCount * step, 0.0);
+	_interpolation = min(_accumulator / step, 1.0);
+}
+
+FramePacerStatistics FramePacer::GetStatistics() const
+{
+	FramePacerStatistics statistics;
+	statistics.FrameCount = _frameTimes.size();
+	statistics.SleepSlack = GetSleepSlack();
+	if (_statisticsFrames > 0)
+	{
+		statistics.SleepTime = _sleepTime / _statisticsFrames;
+		statistics.SpinTime = _spinTime / _statisticsFrames;
+	}
+	if (_frameTimes.empty())
+	{
+		return statistics;
+	}
+	vector<double> frameTimes = _frameTimes;
+	sort(frameTimes.begin(), frameTimes.end());
+	double total = 0;
+	for (double frameTime : frameTimes)
+	{
+		total += frameTime;
+	}
+	// Nearest rank percentiles
+	auto percentile = [&frameTimes](double fraction)
+		{
+			size_t rank = static_cast<size_t>(ceil(fraction * frameTimes.size()));
+			return frameTimes[min(max(rank, static_cast<size_t>(1)), frameTimes.size()) - 1];
+		};
+	statistics.MeanFrameTime = total / frameTimes.size();
+	statistics.MedianFrameTime = percentile(0.5);
+	statistics.Percentile99FrameTime = percentile(0.99);
+	statistics.MaximumFrameTime = frameTimes.back();
+	return statistics;
+}
+
+void FramePacer::ResetStatistics()
+{
+	_frameTimes.clear();
+	_nextFrameTime = 0;
+	_statisticsFrames = 0;
+	_sleepTime = 0;
+	_spinTime = 0;
+}
+
+double FramePacer::GetSleepSlack() const
+{
+	if (_oversleeps.empty())
+	{
+		return InitialSleepSlack;
+	}
+	vector<double> oversleeps = _oversleeps;
+	auto slack = oversleeps.begin() + static_cast<size_t>(SlackPercentile * (oversleeps.size() - 1));
+	nth_element(oversleeps.begin(), slack, oversleeps.end());
+	return *slack;
+}
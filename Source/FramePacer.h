@@ -0,0 +1,119 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+struct FramePacerStatistics
+{
+	// Frames measured (the most recent FramePacer::HistorySize at most)
+	size_t				FrameCount{ 0 };
+	// Time from the start of one frame to the start of the next, in milliseconds
+	double				MeanFrameTime{ 0 };
+	double				MedianFrameTime{ 0 };
+	double				Percentile99FrameTime{ 0 };
+	double				MaximumFrameTime{ 0 };
+	// How long before a frame is due the pacer stops sleeping and starts spinning, in milliseconds
+	double				SleepSlack{ 0 };
+	// Average time per frame spent asleep and spinning while waiting for frames to be due, in milliseconds
+	double				SleepTime{ 0 };
+	double				SpinTime{ 0 };
+};
+
+// Paces the frames of the main loop and steps the simulation at a fixed rate.
+//
+// Frames are started at a target rate.  Waiting for the next frame is done by sleeping until
+// shortly before it is due and then spinning for the rest of the time, since the OS only wakes
+// a sleeping thread when the scheduler next runs, which can be a millisecond or more late.  How
+// late it has been is measured on every sleep, and the slack left for spinning covers nine in
+// ten of the recent oversleeps, so the thread sleeps as much as it can without often starting
+// frames late.  The rare wake ups that are much later than the rest are left to show in the
+// statistics rather than making every frame spin for longer.
+//
+// The simulation is advanced in steps of a fixed length, however long the frames take: each
+// frame, the time since the last one is added to an accumulator, and a step is taken for each
+// whole step that it holds.  The remainder (as a fraction of a step) is the interpolation, with
+// which the frame can be posed between the last two steps so that motion stays smooth when the
+// frame and update rates differ.  If frames fall far behind, steps are dropped rather than the
+// simulation trying to catch up without end.
+//
+// The time between frames is kept for the last HistorySize frames for the jitter statistics.
+
+class FramePacer
+{
+public:
+	// Sleep for about the given time, returning false if woken early (for example by a window message)
+	typedef function<bool(double milliseconds)>	SleepFunction;
+
+	static constexpr size_t HistorySize = 1024;
+
+	// A frame rate of 0 starts frames as soon as they are asked for.  An update rate of 0 makes one
+	// update step per frame, as long as the frame.
+	FramePacer(double frameRate = 60.0, double updateRate = 60.0);
+
+	void SetFrameRate(double frameRate);
+	inline double GetFrameRate() const { return _frameRate; }
+	void SetUpdateRate(double updateRate);
+	inline double GetUpdateRate() const { return _updateRate; }
+	// The most update steps taken in a frame, beyond which the simulation falls behind
+	inline void SetMaximumUpdateCount(unsigned int count) { _maximumUpdateCount = count > 0 ? count : 1; }
+
+	// Wait until the next frame is due.  If sleep is given, it is used instead of sleeping the thread.
+	// Returns false if sleep was woken early, and should then be called again after whatever woke it is
+	// dealt with.
+	bool WaitForNextFrame(const SleepFunction& sleep = nullptr);
+
+	// Start a frame: measure the time since the last one, schedule the next, and work out the update steps that are due
+	void BeginFrame();
+
+	// The number of update steps to take this frame and the length of each, in seconds
+	inline unsigned int GetUpdateCount() const { return _updateCount; }
+	double GetUpdateStep() const;
+	// How far the frame is from the last update step towards the next one (0 to 1)
+	inline double GetInterpolation() const { return _interpolation; }
+	// The time since the previous frame, in seconds
+	inline double GetFrameTime() const { return _frameTime; }
+
+	FramePacerStatistics GetStatistics() const;
+	// Clear the frame times and sleep and spin totals (but not the measured slack)
+	void ResetStatistics();
+
+private:
+	typedef chrono::steady_clock	Clock;
+
+	// Used until the first sleeps have been measured
+	static constexpr double InitialSleepSlack = 2.0;
+	// Sleeping for less than this is left to the spinning, since OS sleeps come in whole milliseconds at best
+	static constexpr double MinimumSleep = 1.0;
+	static constexpr size_t SlackHistorySize = 64;
+	static constexpr double SlackPercentile = 0.9;
+
+	double					_frameRate;
+	double					_updateRate;
+	unsigned int			_maximumUpdateCount{ 5 };
+	Clock::duration			_framePeriod;
+
+	bool					_started{ false };
+	Clock::time_point		_lastFrame;
+	Clock::time_point		_nextFrame;
+	double					_frameTime{ 0 };
+	// Time not yet simulated, in seconds
+	double					_accumulator{ 0 };
+	unsigned int			_updateCount{ 0 };
+	double					_interpolation{ 1.0 };
+
+	// The last frame times (in a ring), and the frames started and the sleep and spin totals since the statistics
+	// were reset, in milliseconds
+	vector<double>			_frameTimes;
+	size_t					_nextFrameTime{ 0 };
+	size_t					_statisticsFrames{ 0 };
+	double					_sleepTime{ 0 };
+	double					_spinTime{ 0 };
+	// How much later than asked for the last sleeps ended (in a ring), in milliseconds
+	vector<double>			_oversleeps;
+	size_t					_nextOversleep{ 0 };
+
+	double GetSleepSlack() const;
+};
@@ -0,0 +1,148 @@
+#include "FramePipeline.h"
+#include <chrono>
+
+FramePipeline::FramePipeline(const function<void(unsigned int buffer)>& render) : _render(render)
+{
+}
+
+FramePipeline::~FramePipeline()
+{
+	// Any exception from the last frames is dropped, since it cannot be thrown from here
+	if (IsThreaded())
+	{
+		{
+			lock_guard<mutex> lock(_lock);
+			_stopping = true;
+		}
+		_submitted.notify_one();
+		_thread.join();
+	}
+}
+
+void FramePipeline::SetThreaded(bool threaded)
+{
+	if (threaded == IsThreaded())
+	{
+		return;
+	}
+	if (threaded)
+	{
+		_stopping = false;
+		_thread = thread(&FramePipeline::RenderLoop, this);
+		return;
+	}
+	// The render thread finishes the frame it has been given before it stops
+	{
+		lock_guard<mutex> lock(_lock);
+		_stopping = true;
+	}
+	_submitted.notify_one();
+	_thread.join();
+	lock_guard<mutex> lock(_lock);
+	ThrowRenderException();
+}
+
+void FramePipeline::Submit()
+{
+	uint64_t frame = _submittedFrame + 1;
+	unsigned int buffer = _updateBuffer;
+	if (!IsThreaded())
+	{
+		RenderFrame(buffer);
+		lock_guard<mutex> lock(_lock);
+		_completedFrame = frame;
+		_submittedFrame = frame;
+		_updateBuffer ^= 1;
+		return;
+	}
+
+	// The frame before this one is still reading the other buffer, so it must finish before the update stage can
+	// be given that buffer back
+	auto start = chrono::high_resolution_clock::now();
+	unique_lock<mutex> lock(_lock);
+	_completed.wait(lock, [this, frame] { return _completedFrame + 1 >= frame; });
+	_statistics.WaitTime = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+	ThrowRenderException();
+	_pendingFrame = frame;
+	_pendingBuffer = buffer;
+	_submittedFrame = frame;
+	_updateBuffer ^= 1;
+	lock.unlock();
+	_submitted.notify_one();
+}
+
+void FramePipeline::WaitForFrame(uint64_t frame)
+{
+	unique_lock<mutex> lock(_lock);
+	_completed.wait(lock, [this, frame] { return _completedFrame >= frame; });
+	ThrowRenderException();
+}
+
+uint64_t FramePipeline::GetCompletedFrame() const
+{
+	lock_guard<mutex> lock(_lock);
+	return _completedFrame;
+}
+
+FramePipelineStatistics FramePipeline::GetStatistics() const
+{
+	lock_guard<mutex> lock(_lock);
+	return _statistics;
+}
+
+void FramePipeline::RenderFrame(unsigned int buffer)
+{
+	auto start = chrono::high_resolution_clock::now();
+	_render(buffer);
+	double renderTime = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+	lock_guard<mutex> lock(_lock);
+	_statistics.RenderTime = renderTime;
+	_statistics.FrameCount++;
+}
+
+void FramePipeline::RenderLoop()
+{
+	unique_lock<mutex> lock(_lock);
+	while (true)
+	{
+		_submitted.wait(lock, [this] { return _stopping || _pendingFrame > _completedFrame; });
+		if (_pendingFrame > _completedFrame)
+		{
+			uint64_t frame = _pendingFrame;
+			unsigned int buffer = _pendingBuffer;
+			lock.unlock();
+			exception_ptr exception;
+			try
+			{
+				RenderFrame(buffer);
+			}
+			catch (...)
+			{
+				exception = current_exception();
+			}
+			lock.lock();
+			if (exception && !_exception)
+			{
+				_exception = exception;
+			}
+			_completedFrame = frame;
+			_completed.notify_all();
+		}
+		else
+		{
+			// Stopping, with nothing left to render
+			return;
+		}
+	}
+}
+
+// Must be called with _lock held
+void FramePipeline::ThrowRenderException()
+{
+	if (_exception)
+	{
+		exception_ptr exception = _exception;
+		_exception = nullptr;
+		rethrow_exception(exception);
+	}
+}
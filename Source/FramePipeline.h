@@ -0,0 +1,82 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+struct FramePipelineStatistics
+{
+	// Frames rendered since the pipeline was created
+	uint64_t			FrameCount{ 0 };
+	// Time the last frame took to render, and the time that Submit spent waiting for the frame before it
+	// to finish rendering, in milliseconds.  When the wait is close to zero, updating is the slower stage.
+	double				RenderTime{ 0 };
+	double				WaitTime{ 0 };
+};
+
+// Runs the render stage of each frame on a thread of its own, so that the next frame can be
+// updated while the previous one is being rendered.
+//
+// Anything that the update stage produces for the render stage is double buffered.  The update
+// stage writes into buffer GetUpdateBuffer() and then calls Submit, which hands that buffer to
+// the render thread and gives the update stage the other buffer for the next frame.  At most
+// one frame is rendered while the next is updated: Submit first waits on the fence of the
+// frame submitted before, so the buffer that the update stage gets back is never still being
+// read.  Frames are numbered from 1, and WaitForFrame waits for the fence of any frame.
+//
+// When the pipeline is not threaded, Submit renders the frame itself before returning, so the
+// stages run one after the other exactly as they would without the pipeline.  Exceptions thrown
+// by the render stage on the render thread are thrown again by the next Submit or wait.
+
+class FramePipeline
+{
+public:
+	// render is called with the buffer to read for each frame submitted
+	FramePipeline(const function<void(unsigned int buffer)>& render);
+	~FramePipeline();
+
+	// Start or stop the render thread.  Frames already submitted are rendered first.
+	void SetThreaded(bool threaded);
+	inline bool IsThreaded() const { return _thread.joinable(); }
+
+	// The buffer that the frame being updated is written into, and the one holding the last frame submitted
+	inline unsigned int GetUpdateBuffer() const { return _updateBuffer; }
+	inline unsigned int GetRenderBuffer() const { return _updateBuffer ^ 1; }
+
+	// Hand the frame in the update buffer to the render stage and swap the buffers
+	void Submit();
+
+	// Wait for a frame (or every frame submitted) to finish rendering.  After WaitForIdle the render thread is
+	// not touching anything, so the update stage can use whatever the render stage does (such as the device).
+	void WaitForFrame(uint64_t frame);
+	inline void WaitForIdle() { WaitForFrame(_submittedFrame); }
+
+	inline uint64_t GetSubmittedFrame() const { return _submittedFrame; }
+	uint64_t GetCompletedFrame() const;
+	FramePipelineStatistics GetStatistics() const;
+
+private:
+	function<void(unsigned int)>	_render;
+	thread							_thread;
+	mutable mutex					_lock;
+	condition_variable				_submitted;
+	condition_variable				_completed;
+	bool							_stopping{ false };
+	// Only changed by the update stage
+	unsigned int					_updateBuffer{ 0 };
+	uint64_t						_submittedFrame{ 0 };
+	// The frame that the render thread has been given, and the last one it finished, guarded by _lock
+	uint64_t						_pendingFrame{ 0 };
+	unsigned int					_pendingBuffer{ 0 };
+	uint64_t						_completedFrame{ 0 };
+	exception_ptr					_exception;
+	FramePipelineStatistics			_statistics;
+
+	void RenderFrame(unsigned int buffer);
+	void RenderLoop();
+	void ThrowRenderException();
+};
@@ -1,53 +1,85 @@
-#pragma once
-#include "Core.h"
-
-using namespace std;
-
-class Framework
-{
-public:
-	Framework();
-	Framework(unsigned int width, unsigned int height);
-	virtual ~Framework();
-
-	int Run(HINSTANCE hInstance, int nCmdShow);
-
-	LRESULT MsgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
-
-	inline unsigned int GetWindowWidth() { return _width; }
-	inline unsigned int GetWindowHeight() { return _height; }
-	inline HWND GetHWnd() {	return _hWnd; }
-
-	// Initialise the application.  Called after the window and bitmap has been
-	// created, but before the main loop starts
-	//
-	// Return false if the application cannot be initialised.
-	virtual bool Initialise() {	return true; }
-
-	// Perform any updates to the structures that will be used
-	// to render the window (i.e. transformation matrices, etc).
-	virtual void Update() {}
-
-	// Render the contents of the window. 
-	virtual void Render() {};
-
-	// Perform any application shutdown or cleanup that is needed
-	virtual void Shutdown() {}
-
-	// Handlers for Windows messages. If you need more, add them
-	// here and call them from MsgProc. The only one we need to handle is WM_SIZE
-	virtual void OnResize(WPARAM wParam) {}
-
-private:
-	HINSTANCE		_hInstance;
-	HWND			_hWnd;
-	unsigned int	_width;
-	unsigned int	_height;
-
-	// Used in timing loop
-	double			_timeSpan;
-
-	bool InitialiseMainWindow(int nCmdShow);
-	int MainLoop();
-};
-
+#pragma once
+#include "Core.h"
+#include "FramePacer.h"
+#include "FramePipeline.h"
+#include <memory>
+
+using namespace std;
+
+class Framework
+{
+public:
+	Framework();
+	Framework(unsigned int width, unsigned int height);
+	virtual ~Framework();
+
+	int Run(HINSTANCE hInstance, int nCmdShow);
+
+	LRESULT MsgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+
+	inline unsigned int GetWindowWidth() { return _width; }
+	inline unsigned int GetWindowHeight() { return _height; }
+	inline HWND GetHWnd() {	return _hWnd; }
+
+	// Initialise the application.  Called after the window and bitmap has been
+	// created, but before the main loop starts
+	//
+	// Return false if the application cannot be initialised.
+	virtual bool Initialise() {	return true; }
+
+	// Advance the simulation by a fixed step (in seconds).  Called
+	// before Update as many times as steps have become due, so that
+	// the simulation runs at the same speed whatever the frame rate.
+	virtual void Simulate(double step) {}
+
+	// Perform any updates to the structures that will be used
+	// to render the window (i.e. transformation matrices, etc).
+	// GetInterpolation gives how far the frame is between the last
+	// two simulation steps.  Anything that Render reads must be
+	// written into the buffer given by GetUpdateBuffer.
+	virtual void Update() {}
+
+	// Render the contents of the window from the buffer given by
+	// GetRenderBuffer.  When the frames are pipelined, this is called
+	// on the render thread while the next frame is being updated.
+	virtual void Render() {};
+
+	// Perform any application shutdown or cleanup that is needed
+	virtual void Shutdown() {}
+
+	// Handlers for Windows messages. If you need more, add them
+	// here and call them from MsgProc. The only one we need to handle is WM_SIZE
+	virtual void OnResize(WPARAM wParam) {}
+
+	// When pipelined (the default on machines with more than one core), each frame is
+	// rendered on a thread of its own while the next frame is updated.  See FramePipeline.
+	void SetPipelined(bool pipelined);
+	inline bool IsPipelined() const { return _pipelined; }
+	// The buffer (0 or 1) of the double buffered frame data that Update writes and Render reads
+	inline unsigned int GetUpdateBuffer() const { return _pipeline ? _pipeline->GetUpdateBuffer() : 0; }
+	inline unsigned int GetRenderBuffer() const { return _pipeline ? _pipeline->GetRenderBuffer() : 0; }
+	// Wait for the frames being rendered to finish.  Update must call this before it touches
+	// anything that Render uses other than its own buffer (for example the device context).
+	void WaitForRender();
+	inline const FramePipeline* GetFramePipeline() const { return _pipeline.get(); }
+
+	// The frame and simulation rates are set on the frame pacer, which also has the frame time statistics
+	inline FramePacer& GetFramePacer() { return _pacer; }
+	inline double GetInterpolation() const { return _pacer.GetInterpolation(); }
+	// The time since the previous frame, in seconds
+	inline double GetFrameTime() const { return _pacer.GetFrameTime(); }
+
+private:
+	HINSTANCE		_hInstance;
+	HWND			_hWnd;
+	unsigned int	_width;
+	unsigned int	_height;
+
+	FramePacer					_pacer;
+	bool						_pipelined;
+	unique_ptr<FramePipeline>	_pipeline;
+
+	bool InitialiseMainWindow(int nCmdShow);
+	int MainLoop();
+};
+
@@ -0,0 +1,105 @@
+#include "Frustum.h"
+
+Frustum::Frustum()
+{
+	// With all planes zero, everything is considered to be inside the frustum
+	for (int group = 0; group < 2; group++)
+	{
+		_planeX[group] = XMVectorZero();
+		_planeY[group] = XMVectorZero();
+		_planeZ[group] = XMVectorZero();
+		_planeW[group] = XMVectorZero();
+	}
+}
+
+void Frustum::Extract(const Matrix& viewProjectionTransformation)
+{
+	// Since we transform row vectors (v * M), the clip space coordinates are the dot products
+	// of the vertex with the columns of the matrix.  The planes are then combinations of the
+	// columns (Gribb and Hartmann).  Direct3D clips z to 0 <= z <= w, so the near plane is just
+	// the third column.
+	const Matrix& m = viewProjectionTransformation;
+	Vector4 column0(m._11, m._21, m._31, m._41);
+	Vector4 column1(m._12, m._22, m._32, m._42);
+	Vector4 column2(m._13, m._23, m._33, m._43);
+	Vector4 column3(m._14, m._24, m._34, m._44);
+
+	Vector4 planes[8] =
+	{
+		column3 + column0,		// Left
+		column3 - column0,		// Right
+		column3 + column1,		// Bottom
+		column3 - column1,		// Top
+		column2,				// Near
+		column3 - column2,		// Far
+		column3 - column2,		// Padding
+		column3 - column2		// Padding
+	};
+
+	for (Vector4& plane : planes)
+	{
+		float length = Vector3(plane.x, plane.y, plane.z).Length();
+		if (length > 0.0f)
+		{
+			plane /= length;
+		}
+	}
+
+	// Store the planes transposed so that four planes can be tested at once
+	for (int group = 0; group < 2; group++)
+	{
+		const Vector4* p = &planes[group * 4];
+		_planeX[group] = XMVectorSet(p[0].x, p[1].x, p[2].x, p[3].x);
+		_planeY[group] = XMVectorSet(p[0].y, p[1].y, p[2].y, p[3].y);
+		_planeZ[group] = XMVectorSet(p[0].z, p[1].z, p[2].z, p[3].z);
+		_planeW[group] = XMVectorSet(p[0].w, p[1].w, p[2].w, p[3].w);
+	}
+}
+
+FrustumTest Frustum::Test(const AxisAlignedBox& box) const
+{
+	if (box.IsEmpty())
+	{
+		return FrustumTest::Outside;
+	}
+	if (box.IsInfinite())
+	{
+		return FrustumTest::Intersecting;
+	}
+
+	Vector3 centre = box.GetCentre();
+	Vector3 extents = box.GetExtents();
+	XMVECTOR centreX = XMVectorReplicate(centre.x);
+	XMVECTOR centreY = XMVectorReplicate(centre.y);
+	XMVECTOR centreZ = XMVectorReplicate(centre.z);
+	XMVECTOR extentsX = XMVectorReplicate(extents.x);
+	XMVECTOR extentsY = XMVectorReplicate(extents.y);
+	XMVECTOR extentsZ = XMVectorReplicate(extents.z);
+	XMVECTOR zero = XMVectorZero();
+
+	bool inside = true;
+	for (int group = 0; group < 2; group++)
+	{
+		// Signed distance of the centre of the box from each of the four planes
+		XMVECTOR distance = XMVectorMultiplyAdd(_planeX[group], centreX,
+							XMVectorMultiplyAdd(_planeY[group], centreY,
+							XMVectorMultiplyAdd(_planeZ[group], centreZ, _planeW[group])));
+
+		// Distance from the centre to the corner of the box furthest along each plane normal
+		XMVECTOR radius = XMVectorMultiplyAdd(XMVectorAbs(_planeX[group]), extentsX,
+						  XMVectorMultiplyAdd(XMVectorAbs(_planeY[group]), extentsY,
+						  XMVectorMultiply(XMVectorAbs(_planeZ[group]), extentsZ)));
+
+		// If the box is completely behind any of the planes, it is outside the frustum
+		if (!XMComparisonAllTrue(XMVector4GreaterOrEqualR(XMVectorAdd(distance, radius), zero)))
+		{
+			return FrustumTest::Outside;
+		}
+		// It is only completely inside if it is in front of all of the planes
+		if (!XMComparisonAllTrue(XMVector4GreaterOrEqualR(XMVectorSubtract(distance, radius), zero)))
+		{
+			inside = false;
+		}
+	}
+	return inside ? FrustumTest::Inside : FrustumTest::Intersecting;
+}
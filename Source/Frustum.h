@@ -0,0 +1,35 @@
+#pragma once
+#include "Bounds.h"
+
+// Result of testing a bounding volume against the view frustum
+enum class FrustumTest
+{
+	Outside,
+	Intersecting,
+	Inside
+};
+
+// View frustum used for culling.
+//
+// The six planes are extracted from the combined view and projection transformation.
+// They are stored transposed (all of the x components together, then all of the y
+// components, and so on) so that a box can be tested against four planes at a time
+// using SIMD operations.
+
+class Frustum
+{
+public:
+	Frustum();
+
+	// Extract the planes from a view x projection transformation
+	void Extract(const Matrix& viewProjectionTransformation);
+
+	FrustumTest Test(const AxisAlignedBox& box) const;
+
+private:
+	// Two groups of four planes.  The last two planes of the second group repeat the far plane.
+	XMVECTOR	_planeX[2];
+	XMVECTOR	_planeY[2];
+	XMVECTOR	_planeZ[2];
+	XMVECTOR	_planeW[2];
+};
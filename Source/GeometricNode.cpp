@@ -1,185 +1,189 @@
-#include "GeometricNode.h"
-#include "Geometry.h"
-#include "GeometricObject.h"
-
-std::vector<GeoStruct> teapotVertices;
-std::vector<UINT>				teapotIndices;
-
-bool GeometricNode::Initialise()
-{
-	_device = DirectXFramework::GetDXFramework()->GetDevice();
-	_deviceContext = DirectXFramework::GetDXFramework()->GetDeviceContext();
-	if (_device.Get() == nullptr || _deviceContext.Get() == nullptr)
-	{
-		return false;
-	}
-
-	ComputeTeapot(teapotVertices, teapotIndices, 3.0f);
-	CalculateNormals(teapotVertices, teapotIndices); //optimised and defined in the geometricobject class
-	BuildGeometryBuffers();
-	BuildShaders();
-	BuildVertexLayout();
-	BuildConstantBuffer();
-	return true;
-
-}
-
-
-void GeometricNode::Render()
-{
-	// Calculate the world x view x projection transformation 
-	Matrix projectionTransformation = DirectXFramework::GetDXFramework()->GetProjectionTransformation();
-	Matrix viewTransformation = DirectXFramework::GetDXFramework()->GetViewTransformation();
-
-	Matrix _completeTransformation = _cumulativeWorldTransformation * viewTransformation * projectionTransformation;
-
-	CBuffer constantBuffer;
-	constantBuffer.World = _completeTransformation;
-	constantBuffer.WorldViewProjection = _cumulativeWorldTransformation * viewTransformation * projectionTransformation;
-	constantBuffer.MaterialColour = Vector4(1.0f, 1.0f, 1.0f, 1.0f);
-	//constantBuffer.AmbientLightColour = _ambientColour;
-	constantBuffer.AmbientLightColour = Vector4(0.2f, 0.2f, 0.2f, 1.0f);
-	constantBuffer.DirectionalLightVector = Vector4(-1.0f, -1.0f, 1.0f, 0.0f);
-	constantBuffer.DirectionalLightColour = Vector4(Colors::Gold);
-	constantBuffer.specColour = Vector4(Colors::White);
-
-	constantBuffer.specularPower = 2.0f;
-
-
-	// Update the constant buffer. Note the layout of the constant buffer must match that in the shader
-	_deviceContext->VSSetConstantBuffers(0, 1, _constantBuffer.GetAddressOf());
-	_deviceContext->PSSetConstantBuffers(0, 1, _constantBuffer.GetAddressOf());
-	_deviceContext->UpdateSubresource(_constantBuffer.Get(), 0, 0, &constantBuffer, 0, 0);
-
-	//_deviceContext->PSSetShaderResources(0, 1, _texture.GetAddressOf());
-
-	// Now render the cube
-	// Specify the distance between vertices and the starting point in the vertex buffer
-	UINT stride = sizeof(GeoStruct);
-	UINT offset = 0;
-
-	// Set the vertex buffer and index buffer we are going to use
-	_deviceContext->IASetVertexBuffers(0, 1, _vertexBuffer.GetAddressOf(), &stride, &offset);
-	_deviceContext->IASetIndexBuffer(_indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
-
-
-	// Specify the layout of the polygons (it will rarely be different to this)
-	_deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-	// Specify the layout of the input vertices.  This must match the layout of the input vertices in the shader
-	_deviceContext->IASetInputLayout(_layout.Get());
-
-	// Specify the vertex and pixel shaders we are going to use
-	_deviceContext->VSSetShader(_vertexShader.Get(), 0, 0);
-	_deviceContext->PSSetShader(_pixelShader.Get(), 0, 0);
-
-	// Now draw the first cube
-	_deviceContext->DrawIndexed(teapotIndices.size(), 0, 0);
-
-}
-
-void GeometricNode::BuildGeometryBuffers()
-{
-	// This method uses the arrays defined in Geometry.h
-	// 
-	// Setup the structure that specifies how big the vertex 
-	// buffer should be
-	D3D11_BUFFER_DESC vertexBufferDescriptor = { 0 };
-	vertexBufferDescriptor.Usage = D3D11_USAGE_IMMUTABLE;
-	vertexBufferDescriptor.ByteWidth = sizeof(GeoStruct) * teapotVertices.size();
-	vertexBufferDescriptor.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vertexBufferDescriptor.CPUAccessFlags = 0;
-	vertexBufferDescriptor.MiscFlags = 0;
-	vertexBufferDescriptor.StructureByteStride = 0;
-
-	// Now set up a structure that tells DirectX where to get the
-	// data for the vertices from
-	D3D11_SUBRESOURCE_DATA vertexInitialisationData = { 0 };
-	vertexInitialisationData.pSysMem = teapotVertices.data();
-
-	// and create the vertex buffer
-	ThrowIfFailed(_device->CreateBuffer(&vertexBufferDescriptor, &vertexInitialisationData, _vertexBuffer.GetAddressOf()));
-
-	// Setup the structure that specifies how big the index 
-	// buffer should be
-	D3D11_BUFFER_DESC indexBufferDescriptor = { 0 };
-	indexBufferDescriptor.Usage = D3D11_USAGE_IMMUTABLE;
-	indexBufferDescriptor.ByteWidth = sizeof(UINT) * teapotIndices.size();
-	indexBufferDescriptor.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	indexBufferDescriptor.CPUAccessFlags = 0;
-	indexBufferDescriptor.MiscFlags = 0;
-	indexBufferDescriptor.StructureByteStride = 0;
-
-	// Now set up a structure that tells DirectX where to get the
-	// data for the indices from
-	D3D11_SUBRESOURCE_DATA indexInitialisationData;
-	indexInitialisationData.pSysMem = teapotIndices.data();
-
-	// and create the index buffer
-	ThrowIfFailed(_device->CreateBuffer(&indexBufferDescriptor, &indexInitialisationData, _indexBuffer.GetAddressOf()));
-
-}
-
-
-void GeometricNode::BuildShaders()
-{
-	DWORD shaderCompileFlags = 0;
-#if defined( _DEBUG )
-	shaderCompileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-
-	ComPtr<ID3DBlob> compilationMessages = nullptr;
-
-	//Compile vertex shader
-	HRESULT hr = D3DCompileFromFile(ShaderFileName,
-		nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE,
-		VertexShaderName, "vs_5_0",
-		shaderCompileFlags, 0,
-		_vertexShaderByteCode.GetAddressOf(),
-		compilationMessages.GetAddressOf());
-
-	if (compilationMessages.Get() != nullptr)
-	{
-		// If there were any compilation messages, display them
-		MessageBoxA(0, (char*)compilationMessages->GetBufferPointer(), 0, 0);
-	}
-	// Even if there are no compiler messages, check to make sure there were no other errors.
-	ThrowIfFailed(hr);
-	ThrowIfFailed(_device->CreateVertexShader(_vertexShaderByteCode->GetBufferPointer(), _vertexShaderByteCode->GetBufferSize(), NULL, _vertexShader.GetAddressOf()));
-
-	// Compile pixel shader
-	hr = D3DCompileFromFile(ShaderFileName,
-		nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE,
-		PixelShaderName, "ps_5_0",
-		shaderCompileFlags, 0,
-		_pixelShaderByteCode.GetAddressOf(),
-		compilationMessages.GetAddressOf());
-
-	if (compilationMessages.Get() != nullptr)
-	{
-		// If there were any compilation messages, display them
-		MessageBoxA(0, (char*)compilationMessages->GetBufferPointer(), 0, 0);
-	}
-	ThrowIfFailed(hr);
-	ThrowIfFailed(_device->CreatePixelShader(_pixelShaderByteCode->GetBufferPointer(), _pixelShaderByteCode->GetBufferSize(), NULL, _pixelShader.GetAddressOf()));
-}
-
-void GeometricNode::BuildVertexLayout()
-{
-	// Create the vertex input layout. This tells DirectX the format
-	// of each of the vertices we are sending to it. The vertexDesc array is
-	// defined in Geometry.h
-
-	ThrowIfFailed(_device->CreateInputLayout(vertexDesc, ARRAYSIZE(vertexDesc), _vertexShaderByteCode->GetBufferPointer(), _vertexShaderByteCode->GetBufferSize(), _layout.GetAddressOf()));
-}
-
-void GeometricNode::BuildConstantBuffer()
-{
-	D3D11_BUFFER_DESC bufferDesc;
-	ZeroMemory(&bufferDesc, sizeof(bufferDesc));
-	bufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	bufferDesc.ByteWidth = sizeof(CBuffer);
-	bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-
-	ThrowIfFailed(_device->CreateBuffer(&bufferDesc, NULL, _constantBuffer.GetAddressOf()));
-}
+#include "GeometricNode.h"
+#include "Geometry.h"
+#include "GeometricObject.h"
+#include "MeshBaker.h"
+#include "ModelImporter.h"
+
+bool GeometricNode::Initialise()
+{
+	_device = DirectXFramework::GetDXFramework()->GetDevice();
+	_deviceContext = DirectXFramework::GetDXFramework()->GetDeviceContext();
+	if (_device.Get() == nullptr || _deviceContext.Get() == nullptr)
+	{
+		return false;
+	}
+
+	// The teapot is only loaded (or generated, if it has not been baked with -bakemeshes) and uploaded by
+	// the first node that uses it
+	if (!_mesh)
+	{
+		MeshRegistry& meshRegistry = DirectXFramework::GetDXFramework()->GetMeshRegistry();
+		_mesh = meshRegistry.LoadMesh(L"teapot.mesh", GetGeoStructLayout(), sizeof(GeoStruct));
+		if (!_mesh)
+		{
+			_mesh = meshRegistry.GetTeapot(3.0f);
+		}
+	}
+	SetLocalBounds(_mesh->Bounds);
+	// Occluders are drawn in full by the occlusion culler to hide the nodes behind them
+	if (IsOccluder())
+	{
+		DirectXFramework::GetDXFramework()->AddOccluder(shared_from_this(), _mesh);
+	}
+	BuildShaders();
+	BuildVertexLayout();
+	return true;
+
+}
+
+static SceneGraphPointer BuildModelNode(const ImportedScene& scene, const vector<MeshPointer>& meshes, const vector<size_t>& firstPrimitives, int nodeIndex)
+{
+	const ImportedNode& node = scene.Nodes[nodeIndex];
+	SceneGraphPointer graph = make_shared<SceneGraph>(wstring(node.Name.begin(), node.Name.end()));
+	graph->SetWorldTransform(node.Transformation);
+	if (node.Mesh >= 0)
+	{
+		const ImportedMesh& mesh = scene.Meshes[node.Mesh];
+		for (size_t i = 0; i < mesh.Primitives.size(); i++)
+		{
+			MeshPointer primitiveMesh = meshes[firstPrimitives[node.Mesh] + i];
+			if (primitiveMesh)
+			{
+				graph->Add(make_shared<GeometricNode>(wstring(mesh.Name.begin(), mesh.Name.end()) + L"_" + to_wstring(i), primitiveMesh));
+			}
+		}
+	}
+	for (int child : node.Children)
+	{
+		graph->Add(BuildModelNode(scene, meshes, firstPrimitives, child));
+	}
+	return graph;
+}
+
+SceneGraphPointer GeometricNode::LoadModel(const wstring& fileName)
+{
+	DirectXFramework* framework = DirectXFramework::GetDXFramework();
+	ImportedScene scene;
+	if (!ModelImporter::Import(fileName, scene, framework->GetJobSystem()))
+	{
+		return nullptr;
+	}
+
+	// Every primitive is registered as a mesh of its own, so loading the same model again shares the buffers
+	MeshRegistry& meshRegistry = framework->GetMeshRegistry();
+	string file(fileName.begin(), fileName.end());
+	vector<MeshPointer> meshes;
+	vector<size_t> firstPrimitives;
+	for (size_t i = 0; i < scene.Meshes.size(); i++)
+	{
+		firstPrimitives.push_back(meshes.size());
+		for (size_t j = 0; j < scene.Meshes[i].Primitives.size(); j++)
+		{
+			const ImportedPrimitive& primitive = scene.Meshes[i].Primitives[j];
+			if (primitive.Indices.empty())
+			{
+				meshes.push_back(nullptr);
+				continue;
+			}
+			meshes.push_back(meshRegistry.GetMesh("model " + file + " mesh " + to_string(i) + " primitive " + to_string(j),
+				[&primitive](Mesh& mesh)
+				{
+					mesh.SetVertices(primitive.Vertices.data(), primitive.Vertices.size());
+					mesh.SetIndices(primitive.Indices.data(), primitive.Indices.size());
+				}));
+		}
+	}
+
+	SceneGraphPointer model = make_shared<SceneGraph>(fileName);
+	for (int root : scene.Roots)
+	{
+		model->Add(BuildModelNode(scene, meshes, firstPrimitives, root));
+	}
+	return model;
+}
+
+// The size on screen, in pixels, of one unit of the mesh at the distance of its centre
+float GeometricNode::GetPixelsPerUnit(const Matrix& worldTransformation, const Matrix& viewTransformation, const Matrix& projectionTransformation) const
+{
+	float depth = Vector3::Transform(Vector3::Transform(_mesh->Bounds.GetCentre(), worldTransformation), viewTransformation).z;
+	if (depth <= 0.0f)
+	{
+		return FLT_MAX;
+	}
+	// The largest scale of the world transformation, so non-uniformly scaled meshes err on the side of detail
+	float scale = max(Vector3(worldTransformation._11, worldTransformation._12, worldTransformation._13).Length(),
+					  max(Vector3(worldTransformation._21, worldTransformation._22, worldTransformation._23).Length(),
+						  Vector3(worldTransformation._31, worldTransformation._32, worldTransformation._33).Length()));
+	float screenHeight = static_cast<float>(DirectXFramework::GetDXFramework()->GetWindowHeight());
+	return scale * projectionTransformation._22 * screenHeight * 0.5f / depth;
+}
+
+void GeometricNode::Render()
+{
+	// Calculate the world x view x projection transformation 
+	Matrix projectionTransformation = DirectXFramework::GetDXFramework()->GetProjectionTransformation();
+	Matrix viewTransformation = DirectXFramework::GetDXFramework()->GetViewTransformation();
+	const Matrix& worldTransformation = GetCumulativeWorldTransformation();
+
+	// The camera and lights are in the frame constants, which the render queue binds for every draw
+	MaterialConstants material;
+	material.MaterialColour = Vector4(1.0f, 1.0f, 1.0f, 1.0f);
+	material.SpecularColour = Vector4(Colors::White);
+	material.SpecularPower = 2.0f;
+
+	ObjectConstants object;
+	object.WorldViewProjection = GetWorldViewProjection(viewTransformation * projectionTransformation);
+	object.World = worldTransformation;
+	object.PositionScale = _mesh->Quantisation.Scale;
+	object.PositionOffset = _mesh->Quantisation.Offset;
+
+
+	// Add a packet describing how to draw the object to the render queue
+	DrawPacket packet;
+	packet.VertexShader = D3D11RenderDevice::ToHandle(_vertexShader->VertexShader);
+	packet.PixelShader = D3D11RenderDevice::ToHandle(_pixelShader->PixelShader);
+	packet.InputLayout = D3D11RenderDevice::ToHandle(_layout->Layout);
+	packet.VertexBuffer = _mesh->VertexBuffer;
+	packet.IndexBuffer = _mesh->IndexBuffer;
+	packet.VertexStride = _mesh->BufferStride;
+	packet.IndexBufferFormat = _mesh->Indices.GetFormat();
+	packet.Depth = Vector3::Transform(worldTransformation.Translation(), viewTransformation).z;
+
+	// Draw the level of detail that suits the size of the mesh on screen
+	_lodLevel = _mesh->SelectLod(GetPixelsPerUnit(worldTransformation, viewTransformation, projectionTransformation), _lodLevel);
+	MeshLod lod = _mesh->GetLod(_lodLevel);
+	packet.StartIndex = lod.IndexStart;
+	packet.IndexCount = lod.IndexCount;
+	DirectXFramework::GetDXFramework()->GetRenderQueue().Add(packet, &material, sizeof(material), &object, sizeof(object));
+}
+
+void GeometricNode::BuildShaders()
+{
+	// Shaders are shared between all nodes that use the same file and entry points, so
+	// they are only compiled for the first node
+	ShaderCache& shaderCache = DirectXFramework::GetDXFramework()->GetShaderCache();
+	vector<pair<string, string>> defines;
+	if (_mesh->CompressedVertices)
+	{
+		defines.push_back({ "COMPRESSED_VERTICES", "1" });
+	}
+	_vertexShader = shaderCache.GetVertexShader(ShaderFileName, VertexShaderName, defines);
+	_pixelShader = shaderCache.GetPixelShader(ShaderFileName, PixelShaderName, defines);
+}
+
+void GeometricNode::BuildVertexLayout()
+{
+	// Create the vertex input layout. This tells DirectX the format
+	// of each of the vertices we are sending to it. The vertexDesc array is
+	// defined in Geometry.h
+
+	ShaderCache& shaderCache = DirectXFramework::GetDXFramework()->GetShaderCache();
+	if (_mesh->CompressedVertices)
+	{
+		_layout = shaderCache.GetInputLayout(compressedGeoVertexDesc, ARRAYSIZE(compressedGeoVertexDesc), _vertexShader);
+	}
+	else
+	{
+		_layout = shaderCache.GetInputLayout(vertexDesc, ARRAYSIZE(vertexDesc), _vertexShader);
+	}
+}
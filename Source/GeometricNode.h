@@ -1,45 +1,51 @@
-#pragma once
-
-#pragma once 
-#include "SceneNode.h"
-#include "DirectXFramework.h"
-
-class GeometricNode : public SceneNode
-{
-public:
-	GeometricNode(wstring name) : GeometricNode(name, Vector4(0.25f, 0.25f, 0.25f, 1.0f)) {};
-	GeometricNode(wstring name, const Vector4 matColour) : SceneNode(name) { _matColour = matColour; };
-	~GeometricNode(void) {};
-	bool Initialise();
-	void Render();
-	//virtual void Shutdown() {};
-
-
-private:
-
-	ComPtr<ID3D11Device>			_device;
-	ComPtr<ID3D11DeviceContext>		_deviceContext;
-	//ComPtr<ID3D11ShaderResourceView> _texture;
-	wstring _shapeName;
-
-	ComPtr<ID3D11Buffer>			_vertexBuffer;
-	ComPtr<ID3D11Buffer>			_indexBuffer;
-
-	ComPtr<ID3DBlob>				_vertexShaderByteCode = nullptr;
-	ComPtr<ID3DBlob>				_pixelShaderByteCode = nullptr;
-	ComPtr<ID3D11VertexShader>		_vertexShader;
-	ComPtr<ID3D11PixelShader>		_pixelShader;
-	ComPtr<ID3D11InputLayout>		_layout;
-	ComPtr<ID3D11Buffer>			_constantBuffer;
-
-	Vector4							_matColour;
-	Vector4							_ambientColour;
-
-
-
-	void BuildGeometryBuffers();
-	void BuildShaders();
-	void BuildVertexLayout();
-	void BuildConstantBuffer();
-
-};
+#pragma once
+
+#pragma once 
+#include "SceneNode.h"
+#include "DirectXFramework.h"
+#include "SceneGraph.h"
+
+class GeometricNode : public SceneNode
+{
+public:
+	GeometricNode(wstring name) : GeometricNode(name, Vector4(0.25f, 0.25f, 0.25f, 1.0f)) {};
+	GeometricNode(wstring name, const Vector4 matColour) : SceneNode(name) { _matColour = matColour; };
+	// Draw a mesh from the registry rather than the teapot.  The vertices must be ObjectVertexStructs.
+	GeometricNode(wstring name, MeshPointer mesh) : GeometricNode(name) { _mesh = mesh; };
+	~GeometricNode(void) {};
+	bool Initialise();
+	void Render();
+	//virtual void Shutdown() {};
+
+	// Import a model file (see ModelImporter.h) as a scene graph with a graph for each node in the file and
+	// a GeometricNode for each primitive.  Returns nullptr if the file cannot be imported.
+	static SceneGraphPointer LoadModel(const wstring& fileName);
+
+
+private:
+
+	ComPtr<ID3D11Device>			_device;
+	ComPtr<ID3D11DeviceContext>		_deviceContext;
+	//ComPtr<ID3D11ShaderResourceView> _texture;
+	wstring _shapeName;
+
+	// Shared with every other node that draws the same mesh
+	MeshPointer						_mesh;
+
+	CompiledShaderPointer			_vertexShader;
+	CompiledShaderPointer			_pixelShader;
+	InputLayoutPointer				_layout;
+
+	// The level of detail drawn last frame
+	size_t							_lodLevel{ 0 };
+
+	Vector4							_matColour;
+	Vector4							_ambientColour;
+
+
+
+	void BuildShaders();
+	void BuildVertexLayout();
+	float GetPixelsPerUnit(const Matrix& worldTransformation, const Matrix& viewTransformation, const Matrix& projectionTransformation) const;
+
+};
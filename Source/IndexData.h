@@ -0,0 +1,146 @@
+#pragma once
+#include "RenderDevice.h"
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+typedef unsigned int UINT;
+
+// The indices of a mesh, stored as 16 bit values when the mesh has few enough vertices
+// and as 32 bit values otherwise.
+//
+// Meshes are built with 32 bit indices; Assign picks the smallest format that can
+// address every vertex, which halves the size of the index buffer (and the bandwidth
+// used to read it) for most generated meshes.  0xFFFF is never used as a 16 bit index,
+// since some feature level 9_x hardware does not support it.
+//
+// Reference uses indices that are stored elsewhere (such as a memory mapped mesh file)
+// without copying them.
+
+class IndexData
+{
+public:
+	IndexData() {};
+
+	static inline IndexFormat ChooseFormat(size_t vertexCount)
+	{
+		return vertexCount < USHRT_MAX ? IndexFormat::UInt16 : IndexFormat::UInt32;
+	}
+
+	static inline size_t GetElementSize(IndexFormat format)
+	{
+		return format == IndexFormat::UInt16 ? sizeof(uint16_t) : sizeof(uint32_t);
+	}
+
+	// Store indices into a mesh of vertexCount vertices, using the smallest format that will hold them
+	template <typename Index>
+	void Assign(const Index* indices, size_t count, size_t vertexCount)
+	{
+		Assign(indices, count, ChooseFormat(vertexCount));
+	}
+
+	template <typename Index>
+	void Assign(const Index* indices, size_t count, IndexFormat format)
+	{
+		_format = format;
+		_count = count;
+		_external = nullptr;
+		_data.resize(count * GetElementSize(format));
+		if (format == IndexFormat::UInt16)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				if (static_cast<size_t>(indices[i]) >= USHRT_MAX)
+				{
+					throw out_of_range("Index does not fit in 16 bits");
+				}
+			}
+			Convert(indices, count, reinterpret_cast<uint16_t*>(_data.data()));
+		}
+		else
+		{
+			Convert(indices, count, reinterpret_cast<uint32_t*>(_data.data()));
+		}
+	}
+
+	// Use indices that are already in the given format.  The data is not copied, so it must stay valid
+	// for as long as this is used.
+	void Reference(const void* indices, size_t count, IndexFormat format)
+	{
+		_data.clear();
+		_format = format;
+		_count = count;
+		_external = indices;
+	}
+
+	inline void Clear()
+	{
+		_data.clear();
+		_count = 0;
+		_external = nullptr;
+	}
+
+	inline IndexFormat GetFormat() const { return _format; }
+	inline size_t GetCount() const { return _count; }
+	inline bool IsEmpty() const { return _count == 0; }
+	inline size_t GetElementSize() const { return GetElementSize(_format); }
+	// The data to upload to an index buffer
+	inline const void* GetData() const { return _external ? _external : _data.data(); }
+	inline size_t GetSize() const { return _count * GetElementSize(_format); }
+
+	inline UINT operator[](size_t i) const
+	{
+		if (_format == IndexFormat::UInt16)
+		{
+			return static_cast<const uint16_t*>(GetData())[i];
+		}
+		return static_cast<const uint32_t*>(GetData())[i];
+	}
+
+	// The indices as 32 bit values, for processing that only handles one format
+	void CopyTo(vector<UINT>& indices) const
+	{
+		indices.resize(_count);
+		if (_format == IndexFormat::UInt16)
+		{
+			Convert(static_cast<const uint16_t*>(GetData()), _count, indices.data());
+		}
+		else if (_count > 0)
+		{
+			memcpy(indices.data(), GetData(), GetSize());
+		}
+	}
+
+	// Call function with a pointer to the indices in their stored type (const uint16_t* or const uint32_t*)
+	template <typename Function>
+	void Visit(Function function) const
+	{
+		if (_format == IndexFormat::UInt16)
+		{
+			function(static_cast<const uint16_t*>(GetData()), _count);
+		}
+		else
+		{
+			function(static_cast<const uint32_t*>(GetData()), _count);
+		}
+	}
+
+private:
+	IndexFormat			_format{ IndexFormat::UInt32 };
+	size_t				_count{ 0 };
+	vector<uint8_t>		_data;
+	// Set if the indices are not stored in _data
+	const void*			_external{ nullptr };
+
+	template <typename Source, typename Destination>
+	static void Convert(const Source* source, size_t count, Destination* destination)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			destination[i] = static_cast<Destination>(source[i]);
+		}
+	}
+};
@@ -0,0 +1,128 @@
+#include "JobSystem.h"
+
+// The queue used by the current thread.  Queue 0 is shared by all threads that are not
+// workers belonging to this job system; workers use queues 1 to n.
+static thread_local const JobSystem *	currentJobSystem = nullptr;
+static thread_local unsigned int		currentQueueIndex = 0;
+
+JobSystem::JobSystem(unsigned int workerCount)
+{
+	if (workerCount == 0)
+	{
+		unsigned int hardwareThreads = thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+	for (unsigned int i = 0; i <= workerCount; i++)
+	{
+		_queues.push_back(make_unique<WorkQueue>());
+	}
+	for (unsigned int i = 1; i <= workerCount; i++)
+	{
+		_workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+}
+
+JobSystem::~JobSystem(void)
+{
+	{
+		lock_guard<mutex> lock(_wakeLock);
+		_stopping = true;
+	}
+	_wakeCondition.notify_all();
+	for (thread& worker : _workers)
+	{
+		worker.join();
+	}
+}
+
+void JobSystem::Submit(function<void()> job, JobCounter& counter)
+{
+	counter++;
+	_queuedJobCount++;
+	WorkQueue& queue = *_queues[GetQueueIndex()];
+	{
+		lock_guard<mutex> lock(queue.Lock);
+		queue.Jobs.push_back({ move(job), &counter });
+	}
+
+	// Taking the lock ensures that a worker that has just found nothing to do
+	// cannot miss this notification before it starts waiting
+	{
+		lock_guard<mutex> lock(_wakeLock);
+	}
+	_wakeCondition.notify_one();
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	// Help with the work rather than blocking.  This also allows jobs to wait for
+	// jobs they have submitted themselves without deadlocking.
+	unsigned int queueIndex = GetQueueIndex();
+	while (counter.load() > 0)
+	{
+		if (!TryRunJob(queueIndex))
+		{
+			this_thread::yield();
+		}
+	}
+}
+
+unsigned int JobSystem::GetQueueIndex() const
+{
+	return currentJobSystem == this ? currentQueueIndex : 0;
+}
+
+bool JobSystem::TryRunJob(unsigned int queueIndex)
+{
+	Job job;
+	bool found = false;
+
+	// Take the most recently submitted job from our own queue first
+	{
+		WorkQueue& queue = *_queues[queueIndex];
+		lock_guard<mutex> lock(queue.Lock);
+		if (!queue.Jobs.empty())
+		{
+			job = move(queue.Jobs.back());
+			queue.Jobs.pop_back();
+			found = true;
+		}
+	}
+
+	// Otherwise steal the oldest job from another queue
+	size_t queueCount = _queues.size();
+	for (size_t i = 1; i < queueCount && !found; i++)
+	{
+		WorkQueue& queue = *_queues[(queueIndex + i) % queueCount];
+		lock_guard<mutex> lock(queue.Lock);
+		if (!queue.Jobs.empty())
+		{
+			job = move(queue.Jobs.front());
+			queue.Jobs.pop_front();
+			found = true;
+		}
+	}
+
+	if (!found)
+	{
+		return false;
+	}
+	_queuedJobCount--;
+	job.Function();
+	(*job.Counter)--;
+	return true;
+}
+
+void JobSystem::WorkerLoop(unsigned int queueIndex)
+{
+	currentJobSystem = this;
+	currentQueueIndex = queueIndex;
+	while (!_stopping)
+	{
+		if (!TryRunJob(queueIndex))
+		{
+			unique_lock<mutex> lock(_wakeLock);
+			_wakeCondition.wait(lock, [this] { return _stopping || _queuedJobCount.load() > 0; });
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Counter used to wait for a group of jobs.  It is incremented when a job is
+// submitted and decremented when that job has finished.
+typedef atomic<int>		JobCounter;
+
+// A work-stealing thread pool.
+//
+// Every worker thread has its own queue of jobs.  Workers take jobs from the back
+// of their own queue (so recently submitted, cache-warm work is done first) and,
+// when their queue is empty, steal from the front of the other queues.  Threads that
+// are not workers (e.g. the main thread) share an extra queue.  A thread that waits
+// for a counter runs jobs while it waits rather than blocking, so jobs can safely
+// submit and wait for further jobs.
+
+class JobSystem
+{
+public:
+	// If workerCount is 0, one worker is created for each hardware thread other than the calling thread
+	JobSystem(unsigned int workerCount = 0);
+	~JobSystem(void);
+
+	void Submit(function<void()> job, JobCounter& counter);
+	void Wait(JobCounter& counter);
+
+	// The number of threads that can run jobs, including the thread that waits for them
+	inline unsigned int GetThreadCount() const { return static_cast<unsigned int>(_workers.size()) + 1; }
+
+private:
+	struct Job
+	{
+		function<void()>	Function;
+		JobCounter*			Counter;
+	};
+
+	struct WorkQueue
+	{
+		mutex				Lock;
+		deque<Job>			Jobs;
+	};
+
+	vector<unique_ptr<WorkQueue>>	_queues;
+	vector<thread>					_workers;
+
+	mutex							_wakeLock;
+	condition_variable				_wakeCondition;
+	atomic<int>						_queuedJobCount{ 0 };
+	atomic<bool>					_stopping{ false };
+
+	unsigned int GetQueueIndex() const;
+	bool TryRunJob(unsigned int queueIndex);
+	void WorkerLoop(unsigned int queueIndex);
+};
@@ -0,0 +1,326 @@
+#include "Json.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+static const JsonValue NullValue;
+
+// Documents nested deeper than this are rejected rather than risking running out of stack
+constexpr int MaximumDepth = 256;
+
+class JsonParser
+{
+public:
+	JsonParser(const char* text, size_t length) : _position(text), _end(text + length) {};
+
+	bool ParseDocument(JsonValue& value)
+	{
+		if (!ParseValue(value, 0))
+		{
+			return false;
+		}
+		SkipWhitespace();
+		return _position == _end;
+	}
+
+private:
+	const char*		_position;
+	const char*		_end;
+
+	void SkipWhitespace()
+	{
+		while (_position < _end && (*_position == ' ' || *_position == '\t' || *_position == '\n' || *_position == '\r'))
+		{
+			_position++;
+		}
+	}
+
+	bool Match(const char* literal)
+	{
+		size_t length = strlen(literal);
+		if (static_cast<size_t>(_end - _position) < length || memcmp(_position, literal, length) != 0)
+		{
+			return false;
+		}
+		_position += length;
+		return true;
+	}
+
+	bool ParseValue(JsonValue& value, int depth)
+	{
+		SkipWhitespace();
+		if (_position == _end || depth > MaximumDepth)
+		{
+			return false;
+		}
+		switch (*_position)
+		{
+			case '{':
+				return ParseObject(value, depth);
+
+			case '[':
+				return ParseArray(value, depth);
+
+			case '"':
+				value._type = JsonValue::Type::String;
+				return ParseString(value._string);
+
+			case 't':
+				value._type = JsonValue::Type::Boolean;
+				value._boolean = true;
+				return Match("true");
+
+			case 'f':
+				value._type = JsonValue::Type::Boolean;
+				value._boolean = false;
+				return Match("false");
+
+			case 'n':
+				value._type = JsonValue::Type::Null;
+				return Match("null");
+
+			default:
+				value._type = JsonValue::Type::Number;
+				return ParseNumber(value._number);
+		}
+	}
+
+	bool ParseObject(JsonValue& value, int depth)
+	{
+		value._type = JsonValue::Type::Object;
+		_position++;
+		SkipWhitespace();
+		if (_position < _end && *_position == '}')
+		{
+			_position++;
+			return true;
+		}
+		while (true)
+		{
+			SkipWhitespace();
+			string name;
+			if (_position == _end || *_position != '"' || !ParseString(name))
+			{
+				return false;
+			}
+			SkipWhitespace();
+			if (_position == _end || *_position++ != ':')
+			{
+				return false;
+			}
+			value._members.emplace_back(move(name), JsonValue());
+			if (!ParseValue(value._members.back().second, depth + 1))
+			{
+				return false;
+			}
+			SkipWhitespace();
+			if (_position == _end)
+			{
+				return false;
+			}
+			char separator = *_position++;
+			if (separator == '}')
+			{
+				return true;
+			}
+			if (separator != ',')
+			{
+				return false;
+			}
+		}
+	}
+
+	bool ParseArray(JsonValue& value, int depth)
+	{
+		value._type = JsonValue::Type::Array;
+		_position++;
+		SkipWhitespace();
+		if (_position < _end && *_position == ']')
+		{
+			_position++;
+			return true;
+		}
+		while (true)
+		{
+			value._elements.emplace_back();
+			if (!ParseValue(value._elements.back(), depth + 1))
+			{
+				return false;
+			}
+			SkipWhitespace();
+			if (_position == _end)
+			{
+				return false;
+			}
+			char separator = *_position++;
+			if (separator == ']')
+			{
+				return true;
+			}
+			if (separator != ',')
+			{
+				return false;
+			}
+		}
+	}
+
+	static int HexDigit(char c)
+	{
+		if (c >= '0' && c <= '9')
+		{
+			return c - '0';
+		}
+		if (c >= 'a' && c <= 'f')
+		{
+			return c - 'a' + 10;
+		}
+		if (c >= 'A' && c <= 'F')
+		{
+			return c - 'A' + 10;
+		}
+		return -1;
+	}
+
+	bool ParseCodeUnit(uint32_t& codeUnit)
+	{
+		if (_end - _position < 4)
+		{
+			return false;
+		}
+		codeUnit = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			int digit = HexDigit(*_position++);
+			if (digit < 0)
+			{
+				return false;
+			}
+			codeUnit = codeUnit * 16 + digit;
+		}
+		return true;
+	}
+
+	static void AppendUtf8(string& text, uint32_t c)
+	{
+		if (c < 0x80)
+		{
+			text += static_cast<char>(c);
+		}
+		else if (c < 0x800)
+		{
+			text += static_cast<char>(0xC0 | (c >> 6));
+			text += static_cast<char>(0x80 | (c & 0x3F));
+		}
+		else if (c < 0x10000)
+		{
+			text += static_cast<char>(0xE0 | (c >> 12));
+			text += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			text += static_cast<char>(0x80 | (c & 0x3F));
+		}
+		else
+		{
+			text += static_cast<char>(0xF0 | (c >> 18));
+			text += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+			text += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			text += static_cast<char>(0x80 | (c & 0x3F));
+		}
+	}
+
+	// Strings are stored as UTF-8, as they are in the document
+	bool ParseString(string& text)
+	{
+		_position++;
+		while (_position < _end)
+		{
+			char c = *_position++;
+			if (c == '"')
+			{
+				return true;
+			}
+			if (c != '\\')
+			{
+				text += c;
+				continue;
+			}
+			if (_position == _end)
+			{
+				return false;
+			}
+			switch (*_position++)
+			{
+				case '"':	text += '"'; break;
+				case '\\':	text += '\\'; break;
+				case '/':	text += '/'; break;
+				case 'b':	text += '\b'; break;
+				case 'f':	text += '\f'; break;
+				case 'n':	text += '\n'; break;
+				case 'r':	text += '\r'; break;
+				case 't':	text += '\t'; break;
+				case 'u':
+				{
+					uint32_t c;
+					if (!ParseCodeUnit(c))
+					{
+						return false;
+					}
+					// Characters outside the basic multilingual plane are written as a surrogate pair
+					if (c >= 0xD800 && c < 0xDC00)
+					{
+						uint32_t low;
+						if (!Match("\\u") || !ParseCodeUnit(low) || low < 0xDC00 || low >= 0xE000)
+						{
+							return false;
+						}
+						c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+					}
+					AppendUtf8(text, c);
+					break;
+				}
+				default:
+					return false;
+			}
+		}
+		return false;
+	}
+
+	bool ParseNumber(double& number)
+	{
+		// strtod needs a terminated string; numbers are short, so copy the characters that can be part of one
+		char buffer[64];
+		size_t length = 0;
+		while (_position < _end && length < sizeof(buffer) - 1 && *_position != 0 && strchr("+-0123456789.eE", *_position) != nullptr)
+		{
+			buffer[length++] = *_position++;
+		}
+		buffer[length] = 0;
+		char* end;
+		number = strtod(buffer, &end);
+		// Numbers too large for a double overflow to infinity, which JSON cannot represent
+		return length > 0 && end == buffer + length && isfinite(number);
+	}
+};
+
+bool JsonValue::Parse(const char* text, size_t length, JsonValue& value)
+{
+	value = JsonValue();
+	JsonParser parser(text, length);
+	return parser.ParseDocument(value);
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const
+{
+	return index < _elements.size() ? _elements[index] : NullValue;
+}
+
+const JsonValue& JsonValue::operator[](const char* name) const
+{
+	for (const pair<string, JsonValue>& member : _members)
+	{
+		if (member.first == name)
+		{
+			return member.second;
+		}
+	}
+	return NullValue;
+}
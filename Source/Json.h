@@ -0,0 +1,57 @@
+#pragma once
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Minimal JSON document model, used to read the descriptions in glTF files.
+//
+// The whole document is parsed into a tree of values.  Looking up a member or element
+// that does not exist returns a null value rather than failing, so optional properties
+// can be read with a default, e.g. node["mesh"].GetNumber(-1).
+
+class JsonValue
+{
+public:
+	enum class Type
+	{
+		Null,
+		Boolean,
+		Number,
+		String,
+		Array,
+		Object
+	};
+
+	JsonValue() {};
+
+	// Returns false if text is not a valid JSON document
+	static bool Parse(const char* text, size_t length, JsonValue& value);
+
+	inline Type GetType() const { return _type; }
+	inline bool IsNull() const { return _type == Type::Null; }
+	inline bool IsArray() const { return _type == Type::Array; }
+	inline bool IsObject() const { return _type == Type::Object; }
+
+	inline bool GetBoolean(bool defaultValue = false) const { return _type == Type::Boolean ? _boolean : defaultValue; }
+	inline double GetNumber(double defaultValue = 0.0) const { return _type == Type::Number ? _number : defaultValue; }
+	// Empty if the value is not a string
+	inline const string& GetString() const { return _string; }
+
+	// Number of elements of an array
+	inline size_t GetSize() const { return _elements.size(); }
+	const JsonValue& operator[](size_t index) const;
+	const JsonValue& operator[](const char* name) const;
+	inline const vector<pair<string, JsonValue>>& GetMembers() const { return _members; }
+
+private:
+	Type								_type{ Type::Null };
+	bool								_boolean{ false };
+	double								_number{ 0.0 };
+	string								_string;
+	vector<JsonValue>					_elements;
+	vector<pair<string, JsonValue>>		_members;
+
+	friend class JsonParser;
+};
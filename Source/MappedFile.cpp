@@ -0,0 +1,190 @@
+#include "MappedFile.h"
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// POSIX file functions take narrow strings.  File names are assumed to be ASCII or UTF-8.
+static string NarrowFileName(const wstring& fileName)
+{
+	string narrow;
+	for (wchar_t character : fileName)
+	{
+		uint32_t c = static_cast<uint32_t>(character);
+		if (c < 0x80)
+		{
+			narrow += static_cast<char>(c);
+		}
+		else if (c < 0x800)
+		{
+			narrow += static_cast<char>(0xC0 | (c >> 6));
+			narrow += static_cast<char>(0x80 | (c & 0x3F));
+		}
+		else if (c < 0x10000)
+		{
+			narrow += static_cast<char>(0xE0 | (c >> 12));
+			narrow += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			narrow += static_cast<char>(0x80 | (c & 0x3F));
+		}
+		else
+		{
+			narrow += static_cast<char>(0xF0 | (c >> 18));
+			narrow += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+			narrow += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			narrow += static_cast<char>(0x80 | (c & 0x3F));
+		}
+	}
+	return narrow;
+}
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const wstring& fileName)
+{
+	Close();
+	HANDLE file = CreateFileW(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		return false;
+	}
+	_file = file;
+	_size = static_cast<size_t>(size.QuadPart);
+	_open = true;
+	if (_size == 0)
+	{
+		// Empty files cannot be mapped
+		return true;
+	}
+	_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (_mapping != nullptr)
+	{
+		_data = static_cast<const uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+	}
+	if (_data == nullptr)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (_data != nullptr)
+	{
+		UnmapViewOfFile(_data);
+	}
+	if (_mapping != nullptr)
+	{
+		CloseHandle(_mapping);
+	}
+	if (_file != nullptr)
+	{
+		CloseHandle(_file);
+	}
+	_data = nullptr;
+	_mapping = nullptr;
+	_file = nullptr;
+	_size = 0;
+	_open = false;
+}
+
+bool MappedFile::WriteFile(const wstring& fileName, const void* data, size_t size)
+{
+	wstring temporaryFileName = fileName + L".tmp";
+	FILE* file = nullptr;
+	if (_wfopen_s(&file, temporaryFileName.c_str(), L"wb") != 0 || file == nullptr)
+	{
+		return false;
+	}
+	bool written = fwrite(data, 1, size, file) == size;
+	written &= fclose(file) == 0;
+	if (!written || !MoveFileExW(temporaryFileName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFileW(temporaryFileName.c_str());
+		return false;
+	}
+	return true;
+}
+
+#else
+
+bool MappedFile::Open(const wstring& fileName)
+{
+	Close();
+	int file = open(NarrowFileName(fileName).c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+	struct stat status;
+	if (fstat(file, &status) != 0)
+	{
+		close(file);
+		return false;
+	}
+	_size = static_cast<size_t>(status.st_size);
+	_open = true;
+	if (_size > 0)
+	{
+		void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+		_data = data == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(data);
+	}
+	// The mapping stays valid after the file is closed
+	close(file);
+	if (_size > 0 && _data == nullptr)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (_data != nullptr)
+	{
+		munmap(const_cast<uint8_t*>(_data), _size);
+	}
+	_data = nullptr;
+	_size = 0;
+	_open = false;
+}
+
+bool MappedFile::WriteFile(const wstring& fileName, const void* data, size_t size)
+{
+	string narrowFileName = NarrowFileName(fileName);
+	string temporaryFileName = narrowFileName + ".tmp";
+	FILE* file = fopen(temporaryFileName.c_str(), "wb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+	bool written = fwrite(data, 1, size, file) == size;
+	written &= fclose(file) == 0;
+	if (!written || rename(temporaryFileName.c_str(), narrowFileName.c_str()) != 0)
+	{
+		remove(temporaryFileName.c_str());
+		return false;
+	}
+	return true;
+}
+
+#endif
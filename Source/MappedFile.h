@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// Read-only memory mapped file.
+//
+// The contents of the file are mapped into the address space of the process rather
+// than read into a buffer, so only the pages that are actually touched are loaded
+// and several caches can share the same pages.  This does not depend on Direct3D and
+// works on both Windows and POSIX systems.
+
+class MappedFile
+{
+public:
+	MappedFile() {};
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Returns false if the file does not exist or cannot be mapped
+	bool Open(const wstring& fileName);
+	void Close();
+
+	inline bool IsOpen() const { return _open; }
+	inline const uint8_t* GetData() const { return _data; }
+	inline size_t GetSize() const { return _size; }
+
+	// Write a file so that readers either see the old contents or the new contents, never a
+	// partly written file.  The data is written to a temporary file which then replaces the original.
+	static bool WriteFile(const wstring& fileName, const void* data, size_t size);
+
+private:
+	const uint8_t*	_data{ nullptr };
+	size_t			_size{ 0 };
+	// An empty file is open, but has no data to map
+	bool			_open{ false };
+#ifdef _WIN32
+	void*			_file{ nullptr };
+	void*			_mapping{ nullptr };
+#endif
+};
@@ -0,0 +1,517 @@
+#include "MatrixKernels.h"
+#include "Simd.h"
+#include <cstring>
+#include <cmath>
+
+// The AVX2 kernels are compiled with FMA enabled (see Simd.h), and GCC would otherwise fuse their multiplies and adds,
+// which changes the results slightly
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+static MatrixKernels::Path BestPath()
+{
+#if defined(SIMD_AVX2)
+	if (CpuSupportsAvx2())
+	{
+		return MatrixKernels::Path::Avx2;
+	}
+#endif
+#if defined(SIMD_SSE)
+	return MatrixKernels::Path::Sse;
+#else
+	return MatrixKernels::Path::Portable;
+#endif
+}
+
+static MatrixKernels::Path CurrentPath = BestPath();
+
+void MatrixKernels::SetPath(Path path)
+{
+	Path best = BestPath();
+	CurrentPath = path > best ? best : path;
+}
+
+MatrixKernels::Path MatrixKernels::GetPath()
+{
+	return CurrentPath;
+}
+
+const char* MatrixKernels::GetPathName(Path path)
+{
+	switch (path)
+	{
+		case Path::Avx2:
+			return "AVX2";
+
+		case Path::Sse:
+			return "SSE";
+
+		default:
+			return "Portable";
+	}
+}
+
+static inline bool IsSpecial(const AxisAlignedBox& box)
+{
+	return box.IsEmpty() || box.IsInfinite();
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+// Portable versions.  These are also used for anything the vectorised loops leave over.
+
+static inline void MultiplyPortable(const Matrix& a, const Matrix& b, Matrix& result)
+{
+	const float* left = &a._11;
+	const float* right = &b._11;
+	float product[16];
+	for (int row = 0; row < 4; row++)
+	{
+		const float* r = left + row * 4;
+		for (int column = 0; column < 4; column++)
+		{
+			// Terms paired the same way as XMMatrixMultiply
+			product[row * 4 + column] = (r[0] * right[column] + r[2] * right[8 + column]) + (r[1] * right[4 + column] + r[3] * right[12 + column]);
+		}
+	}
+	// a or b may be result
+	memcpy(&result._11, product, sizeof(product));
+}
+
+static inline void InverseTransposePortable(const Matrix& m, Matrix& result)
+{
+	Vector3 r0(m._11, m._12, m._13);
+	Vector3 r1(m._21, m._22, m._23);
+	Vector3 r2(m._31, m._32, m._33);
+	// The rows of the cofactor matrix are the cross products of the other two rows
+	Vector3 c0 = r1.Cross(r2);
+	Vector3 c1 = r2.Cross(r0);
+	Vector3 c2 = r0.Cross(r1);
+	float determinant = r0.Dot(c0);
+	float scale = determinant != 0.0f ? 1.0f / determinant : 1.0f;
+	c0 *= scale;
+	c1 *= scale;
+	c2 *= scale;
+	result = Matrix(c0.x, c0.y, c0.z, 0.0f,
+					c1.x, c1.y, c1.z, 0.0f,
+					c2.x, c2.y, c2.z, 0.0f,
+					0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+static inline void TransformBoxPortable(const AxisAlignedBox& box, const Matrix& m, AxisAlignedBox& result)
+{
+	if (IsSpecial(box))
+	{
+		result = box;
+		return;
+	}
+	Vector3 centre = box.GetCentre();
+	Vector3 extents = box.GetExtents();
+	// The centre is transformed in the same order as XMVector3TransformCoord, which Vector3::Transform uses
+	float w = ((centre.z * m._34 + m._44) + centre.y * m._24) + centre.x * m._14;
+	Vector3 newCentre((((centre.z * m._31 + m._41) + centre.y * m._21) + centre.x * m._11) / w,
+					  (((centre.z * m._32 + m._42) + centre.y * m._22) + centre.x * m._12) / w,
+					  (((centre.z * m._33 + m._43) + centre.y * m._23) + centre.x * m._13) / w);
+	Vector3 newExtents(fabsf(m._11) * extents.x + fabsf(m._21) * extents.y + fabsf(m._31) * extents.z,
+					   fabsf(m._12) * extents.x + fabsf(m._22) * extents.y + fabsf(m._32) * extents.z,
+					   fabsf(m._13) * extents.x + fabsf(m._23) * extents.y + fabsf(m._33) * extents.z);
+	result = AxisAlignedBox(newCentre - newExtents, newCentre + newExtents);
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+// SSE versions, one row per register
+
+#if defined(SIMD_SSE)
+static inline void LoadRows(const Matrix& m, __m128 rows[4])
+{
+	const float* p = &m._11;
+	rows[0] = _mm_loadu_ps(p);
+	rows[1] = _mm_loadu_ps(p + 4);
+	rows[2] = _mm_loadu_ps(p + 8);
+	rows[3] = _mm_loadu_ps(p + 12);
+}
+
+static inline __m128 MultiplyRow(__m128 row, const __m128 right[4])
+{
+	__m128 x = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), right[0]);
+	__m128 y = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), right[1]);
+	__m128 z = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), right[2]);
+	__m128 w = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), right[3]);
+	return _mm_add_ps(_mm_add_ps(x, z), _mm_add_ps(y, w));
+}
+
+// Each row of a is loaded just before its product is stored, so result may be a
+static inline void MultiplySse(const Matrix& a, const __m128 right[4], Matrix& result)
+{
+	const float* left = &a._11;
+	float* destination = &result._11;
+	for (int row = 0; row < 4; row++)
+	{
+		_mm_storeu_ps(destination + row * 4, MultiplyRow(_mm_loadu_ps(left + row * 4), right));
+	}
+}
+
+static inline __m128 Cross(__m128 a, __m128 b)
+{
+	__m128 aYzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 bYzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 c = _mm_sub_ps(_mm_mul_ps(a, bYzx), _mm_mul_ps(aYzx, b));
+	return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+static void MultiplyByParentsSse(const Matrix* local, const int* parents, size_t begin, size_t end, const Matrix& root, Matrix* world)
+{
+	__m128 rootRows[4];
+	LoadRows(root, rootRows);
+	for (size_t i = begin; i < end; i++)
+	{
+		if (parents[i] < 0)
+		{
+			MultiplySse(local[i], rootRows, world[i]);
+		}
+		else
+		{
+			__m128 parentRows[4];
+			LoadRows(world[parents[i]], parentRows);
+			MultiplySse(local[i], parentRows, world[i]);
+		}
+	}
+}
+
+static void MultiplyAllSse(const Matrix* matrices, size_t count, const Matrix& right, Matrix* result)
+{
+	__m128 rightRows[4];
+	LoadRows(right, rightRows);
+	for (size_t i = 0; i < count; i++)
+	{
+		MultiplySse(matrices[i], rightRows, result[i]);
+	}
+}
+
+static void InverseTransposeSse(const Matrix* matrices, size_t count, Matrix* result)
+{
+	const __m128 xyzMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	const __m128 one = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+	for (size_t i = 0; i < count; i++)
+	{
+		__m128 rows[4];
+		LoadRows(matrices[i], rows);
+		__m128 c0 = Cross(rows[1], rows[2]);
+		__m128 c1 = Cross(rows[2], rows[0]);
+		__m128 c2 = Cross(rows[0], rows[1]);
+		// The w of each cross product is 0, so the dot product can include it
+		__m128 products = _mm_mul_ps(rows[0], c0);
+		__m128 sum = _mm_add_ps(products, _mm_shuffle_ps(products, products, _MM_SHUFFLE(2, 3, 0, 1)));
+		__m128 determinant = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+		__m128 singular = _mm_cmpeq_ps(determinant, _mm_setzero_ps());
+		__m128 scale = _mm_or_ps(_mm_and_ps(singular, _mm_set1_ps(1.0f)), _mm_andnot_ps(singular, _mm_div_ps(_mm_set1_ps(1.0f), determinant)));
+		float* destination = &result[i]._11;
+		_mm_storeu_ps(destination, _mm_and_ps(_mm_mul_ps(c0, scale), xyzMask));
+		_mm_storeu_ps(destination + 4, _mm_and_ps(_mm_mul_ps(c1, scale), xyzMask));
+		_mm_storeu_ps(destination + 8, _mm_and_ps(_mm_mul_ps(c2, scale), xyzMask));
+		_mm_storeu_ps(destination + 12, one);
+	}
+}
+
+// A box is six floats.  The first four are loaded from its start and the last four from two floats in, so nothing
+// outside the box is read.
+static inline void LoadBox(const AxisAlignedBox& box, __m128& minimum, __m128& maximum)
+{
+	const float* p = &box.Min.x;
+	minimum = _mm_loadu_ps(p);
+	__m128 upper = _mm_loadu_ps(p + 2);
+	maximum = _mm_shuffle_ps(upper, upper, _MM_SHUFFLE(3, 3, 2, 1));
+}
+
+static inline void StoreBox(__m128 minimum, __m128 maximum, AxisAlignedBox& box)
+{
+	float* p = &box.Min.x;
+	// (min.x, min.y, min.z, max.x) then (max.y, max.z)
+	__m128 joint = _mm_shuffle_ps(minimum, maximum, _MM_SHUFFLE(0, 0, 2, 2));
+	_mm_storeu_ps(p, _mm_shuffle_ps(minimum, joint, _MM_SHUFFLE(2, 0, 1, 0)));
+	_mm_storel_pi(reinterpret_cast<__m64*>(p + 4), _mm_shuffle_ps(maximum, maximum, _MM_SHUFFLE(3, 3, 2, 1)));
+}
+
+static inline void TransformBoxSse(const AxisAlignedBox& box, const Matrix& m, AxisAlignedBox& result)
+{
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	__m128 rows[4];
+	LoadRows(m, rows);
+	__m128 minimum, maximum;
+	LoadBox(box, minimum, maximum);
+	__m128 centre = _mm_mul_ps(_mm_add_ps(minimum, maximum), half);
+	__m128 extents = _mm_mul_ps(_mm_sub_ps(maximum, minimum), half);
+	__m128 newCentre = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(centre, centre, _MM_SHUFFLE(2, 2, 2, 2)), rows[2]), rows[3]);
+	newCentre = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(centre, centre, _MM_SHUFFLE(1, 1, 1, 1)), rows[1]), newCentre);
+	newCentre = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(centre, centre, _MM_SHUFFLE(0, 0, 0, 0)), rows[0]), newCentre);
+	newCentre = _mm_div_ps(newCentre, _mm_shuffle_ps(newCentre, newCentre, _MM_SHUFFLE(3, 3, 3, 3)));
+	__m128 newExtents = _mm_mul_ps(_mm_andnot_ps(signMask, rows[0]), _mm_shuffle_ps(extents, extents, _MM_SHUFFLE(0, 0, 0, 0)));
+	newExtents = _mm_add_ps(newExtents, _mm_mul_ps(_mm_andnot_ps(signMask, rows[1]), _mm_shuffle_ps(extents, extents, _MM_SHUFFLE(1, 1, 1, 1))));
+	newExtents = _mm_add_ps(newExtents, _mm_mul_ps(_mm_andnot_ps(signMask, rows[2]), _mm_shuffle_ps(extents, extents, _MM_SHUFFLE(2, 2, 2, 2))));
+	StoreBox(_mm_sub_ps(newCentre, newExtents), _mm_add_ps(newCentre, newExtents), result);
+}
+
+static void TransformBoxesSse(const AxisAlignedBox* boxes, const Matrix* transformations, size_t count, AxisAlignedBox* result)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		if (IsSpecial(boxes[i]))
+		{
+			result[i] = boxes[i];
+		}
+		else
+		{
+			TransformBoxSse(boxes[i], transformations[i], result[i]);
+		}
+	}
+}
+#endif
+
+//-------------------------------------------------------------------------------------------------------------------
+// AVX2 versions.  Matrices are multiplied two rows at a time, with the right hand matrix repeated in both halves of
+// each register; the inverse transpose and boxes are done two at a time, one in each half.
+
+#if defined(SIMD_AVX2)
+SIMD_AVX2_TARGET static inline void LoadRowsTwice(const Matrix& m, __m256 rows[4])
+{
+	const float* p = &m._11;
+	rows[0] = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(p));
+	rows[1] = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(p + 4));
+	rows[2] = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(p + 8));
+	rows[3] = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(p + 12));
+}
+
+SIMD_AVX2_TARGET static inline __m256 MultiplyRows(__m256 rows, const __m256 right[4])
+{
+	__m256 x = _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, _MM_SHUFFLE(0, 0, 0, 0)), right[0]);
+	__m256 y = _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, _MM_SHUFFLE(1, 1, 1, 1)), right[1]);
+	__m256 z = _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, _MM_SHUFFLE(2, 2, 2, 2)), right[2]);
+	__m256 w = _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, _MM_SHUFFLE(3, 3, 3, 3)), right[3]);
+	return _mm256_add_ps(_mm256_add_ps(x, z), _mm256_add_ps(y, w));
+}
+
+SIMD_AVX2_TARGET static inline void MultiplyAvx2(const Matrix& a, const __m256 right[4], Matrix& result)
+{
+	const float* left = &a._11;
+	float* destination = &result._11;
+	// Both pairs of rows are loaded before either is stored, so result may be a
+	__m256 top = _mm256_loadu_ps(left);
+	__m256 bottom = _mm256_loadu_ps(left + 8);
+	_mm256_storeu_ps(destination, MultiplyRows(top, right));
+	_mm256_storeu_ps(destination + 8, MultiplyRows(bottom, right));
+}
+
+SIMD_AVX2_TARGET static inline __m256 Load2(const float* low, const float* high)
+{
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(low)), _mm_loadu_ps(high), 1);
+}
+
+SIMD_AVX2_TARGET static inline void Store2(float* low, float* high, __m256 value)
+{
+	_mm_storeu_ps(low, _mm256_castps256_ps128(value));
+	_mm_storeu_ps(high, _mm256_extractf128_ps(value, 1));
+}
+
+SIMD_AVX2_TARGET static inline __m256 Cross2(__m256 a, __m256 b)
+{
+	__m256 aYzx = _mm256_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	__m256 bYzx = _mm256_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	__m256 c = _mm256_sub_ps(_mm256_mul_ps(a, bYzx), _mm256_mul_ps(aYzx, b));
+	return _mm256_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+SIMD_AVX2_KERNEL static void MultiplyByParentsAvx2(const Matrix* local, const int* parents, size_t begin, size_t end, const Matrix& root, Matrix* world)
+{
+	__m256 rootRows[4];
+	LoadRowsTwice(root, rootRows);
+	for (size_t i = begin; i < end; i++)
+	{
+		if (parents[i] < 0)
+		{
+			MultiplyAvx2(local[i], rootRows, world[i]);
+		}
+		else
+		{
+			__m256 parentRows[4];
+			LoadRowsTwice(world[parents[i]], parentRows);
+			MultiplyAvx2(local[i], parentRows, world[i]);
+		}
+	}
+}
+
+SIMD_AVX2_KERNEL static void MultiplyAllAvx2(const Matrix* matrices, size_t count, const Matrix& right, Matrix* result)
+{
+	__m256 rightRows[4];
+	LoadRowsTwice(right, rightRows);
+	for (size_t i = 0; i < count; i++)
+	{
+		MultiplyAvx2(matrices[i], rightRows, result[i]);
+	}
+}
+
+SIMD_AVX2_KERNEL static size_t InverseTransposeAvx2(const Matrix* matrices, size_t count, Matrix* result)
+{
+	const __m256 xyzMask = _mm256_castsi256_ps(_mm256_set_epi32(0, -1, -1, -1, 0, -1, -1, -1));
+	const __m128 one = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		const float* first = &matrices[i]._11;
+		const float* second = &matrices[i + 1]._11;
+		__m256 r0 = Load2(first, second);
+		__m256 r1 = Load2(first + 4, second + 4);
+		__m256 r2 = Load2(first + 8, second + 8);
+		__m256 c0 = Cross2(r1, r2);
+		__m256 c1 = Cross2(r2, r0);
+		__m256 c2 = Cross2(r0, r1);
+		__m256 products = _mm256_mul_ps(r0, c0);
+		__m256 sum = _mm256_add_ps(products, _mm256_shuffle_ps(products, products, _MM_SHUFFLE(2, 3, 0, 1)));
+		__m256 determinant = _mm256_add_ps(sum, _mm256_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+		__m256 singular = _mm256_cmp_ps(determinant, _mm256_setzero_ps(), _CMP_EQ_OQ);
+		__m256 scale = _mm256_blendv_ps(_mm256_div_ps(_mm256_set1_ps(1.0f), determinant), _mm256_set1_ps(1.0f), singular);
+		float* firstResult = &result[i]._11;
+		float* secondResult = &result[i + 1]._11;
+		Store2(firstResult, secondResult, _mm256_and_ps(_mm256_mul_ps(c0, scale), xyzMask));
+		Store2(firstResult + 4, secondResult + 4, _mm256_and_ps(_mm256_mul_ps(c1, scale), xyzMask));
+		Store2(firstResult + 8, secondResult + 8, _mm256_and_ps(_mm256_mul_ps(c2, scale), xyzMask));
+		_mm_storeu_ps(firstResult + 12, one);
+		_mm_storeu_ps(secondResult + 12, one);
+	}
+	return i;
+}
+
+SIMD_AVX2_KERNEL static size_t TransformBoxesAvx2(const AxisAlignedBox* boxes, const Matrix* transformations, size_t count, AxisAlignedBox* result)
+{
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		if (IsSpecial(boxes[i]) || IsSpecial(boxes[i + 1]))
+		{
+			TransformBoxPortable(boxes[i], transformations[i], result[i]);
+			TransformBoxPortable(boxes[i + 1], transformations[i + 1], result[i + 1]);
+			continue;
+		}
+		const float* first = &transformations[i]._11;
+		const float* second = &transformations[i + 1]._11;
+		__m256 r0 = Load2(first, second);
+		__m256 r1 = Load2(first + 4, second + 4);
+		__m256 r2 = Load2(first + 8, second + 8);
+		__m256 r3 = Load2(first + 12, second + 12);
+		// See LoadBox
+		const float* firstBox = &boxes[i].Min.x;
+		const float* secondBox = &boxes[i + 1].Min.x;
+		__m256 minimum = Load2(firstBox, secondBox);
+		__m256 upper = Load2(firstBox + 2, secondBox + 2);
+		__m256 maximum = _mm256_shuffle_ps(upper, upper, _MM_SHUFFLE(3, 3, 2, 1));
+		__m256 centre = _mm256_mul_ps(_mm256_add_ps(minimum, maximum), half);
+		__m256 extents = _mm256_mul_ps(_mm256_sub_ps(maximum, minimum), half);
+		__m256 newCentre = _mm256_add_ps(_mm256_mul_ps(_mm256_shuffle_ps(centre, centre, _MM_SHUFFLE(2, 2, 2, 2)), r2), r3);
+		newCentre = _mm256_add_ps(_mm256_mul_ps(_mm256_shuffle_ps(centre, centre, _MM_SHUFFLE(1, 1, 1, 1)), r1), newCentre);
+		newCentre = _mm256_add_ps(_mm256_mul_ps(_mm256_shuffle_ps(centre, centre, _MM_SHUFFLE(0, 0, 0, 0)), r0), newCentre);
+		newCentre = _mm256_div_ps(newCentre, _mm256_shuffle_ps(newCentre, newCentre, _MM_SHUFFLE(3, 3, 3, 3)));
+		__m256 newExtents = _mm256_mul_ps(_mm256_andnot_ps(signMask, r0), _mm256_shuffle_ps(extents, extents, _MM_SHUFFLE(0, 0, 0, 0)));
+		newExtents = _mm256_add_ps(newExtents, _mm256_mul_ps(_mm256_andnot_ps(signMask, r1), _mm256_shuffle_ps(extents, extents, _MM_SHUFFLE(1, 1, 1, 1))));
+		newExtents = _mm256_add_ps(newExtents, _mm256_mul_ps(_mm256_andnot_ps(signMask, r2), _mm256_shuffle_ps(extents, extents, _MM_SHUFFLE(2, 2, 2, 2))));
+		__m256 newMinimum = _mm256_sub_ps(newCentre, newExtents);
+		__m256 newMaximum = _mm256_add_ps(newCentre, newExtents);
+		StoreBox(_mm256_castps256_ps128(newMinimum), _mm256_castps256_ps128(newMaximum), result[i]);
+		StoreBox(_mm256_extractf128_ps(newMinimum, 1), _mm256_extractf128_ps(newMaximum, 1), result[i + 1]);
+	}
+	return i;
+}
+#endif
+
+//-------------------------------------------------------------------------------------------------------------------
+
+void MatrixKernels::MultiplyByParents(const Matrix* local, const int* parents, size_t begin, size_t end, const Matrix& root, Matrix* world)
+{
+#if defined(SIMD_AVX2)
+	if (CurrentPath == Path::Avx2)
+	{
+		MultiplyByParentsAvx2(local, parents, begin, end, root, world);
+		return;
+	}
+#endif
+#if defined(SIMD_SSE)
+	if (CurrentPath == Path::Sse)
+	{
+		MultiplyByParentsSse(local, parents, begin, end, root, world);
+		return;
+	}
+#endif
+	for (size_t i = begin; i < end; i++)
+	{
+		MultiplyPortable(local[i], parents[i] < 0 ? root : world[parents[i]], world[i]);
+	}
+}
+
+void MatrixKernels::MultiplyAll(const Matrix* matrices, size_t count, const Matrix& right, Matrix* result)
+{
+#if defined(SIMD_AVX2)
+	if (CurrentPath == Path::Avx2)
+	{
+		MultiplyAllAvx2(matrices, count, right, result);
+		return;
+	}
+#endif
+#if defined(SIMD_SSE)
+	if (CurrentPath == Path::Sse)
+	{
+		MultiplyAllSse(matrices, count, right, result);
+		return;
+	}
+#endif
+	// right is copied in case it is one of the results
+	Matrix rightCopy = right;
+	for (size_t i = 0; i < count; i++)
+	{
+		MultiplyPortable(matrices[i], rightCopy, result[i]);
+	}
+}
+
+void MatrixKernels::InverseTranspose(const Matrix* matrices, size_t count, Matrix* result)
+{
+	size_t next = 0;
+#if defined(SIMD_AVX2)
+	if (CurrentPath == Path::Avx2)
+	{
+		next = InverseTransposeAvx2(matrices, count, result);
+	}
+#endif
+#if defined(SIMD_SSE)
+	if (CurrentPath != Path::Portable)
+	{
+		InverseTransposeSse(matrices + next, count - next, result + next);
+		return;
+	}
+#endif
+	for (size_t i = next; i < count; i++)
+	{
+		InverseTransposePortable(matrices[i], result[i]);
+	}
+}
+
+void MatrixKernels::TransformBoxes(const AxisAlignedBox* boxes, const Matrix* transformations, size_t count, AxisAlignedBox* result)
+{
+	size_t next = 0;
+#if defined(SIMD_AVX2)
+	if (CurrentPath == Path::Avx2)
+	{
+		next = TransformBoxesAvx2(boxes, transformations, count, result);
+	}
+#endif
+#if defined(SIMD_SSE)
+	if (CurrentPath != Path::Portable)
+	{
+		TransformBoxesSse(boxes + next, transformations + next, count - next, result + next);
+		return;
+	}
+#endif
+	for (size_t i = next; i < count; i++)
+	{
+		TransformBoxPortable(boxes[i], transformations[i], result[i]);
+	}
+}
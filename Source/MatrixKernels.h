@@ -0,0 +1,52 @@
+#pragma once
+#include "SimpleMath.h"
+#include "Bounds.h"
+
+using namespace std;
+using namespace DirectX;
+using namespace SimpleMath;
+
+// Kernels that work on contiguous arrays of matrices and boxes, for the transform and culling stages.
+//
+// SimpleMath works on one matrix at a time, loading it into registers and storing it again for
+// every operation.  These kernels keep whatever is shared (the parent or right hand matrix) in
+// registers and stream the arrays through, two rows at a time with AVX2 (chosen at run time, see
+// Simd.h), a row at a time with SSE, or with plain C++ elsewhere.
+//
+// Products and box transformations add their terms in the same order as DirectXMath's SSE code,
+// without fused multiply-adds, so every path gives exactly the same results as the equivalent
+// SimpleMath operations.
+//
+// As with SimpleMath, vectors are rows, so a * b applies a and then b.
+
+class MatrixKernels
+{
+public:
+	enum class Path
+	{
+		Portable,
+		Sse,
+		Avx2
+	};
+
+	// world[i] = local[i] * world[parents[i]] for i from begin to end - 1, or local[i] * root where parents[i] is negative.
+	// Parents must come before their children (or be outside the range and already calculated).
+	static void MultiplyByParents(const Matrix* local, const int* parents, size_t begin, size_t end, const Matrix& root, Matrix* world);
+
+	// result[i] = matrices[i] * right.  result may be the same array as matrices.
+	static void MultiplyAll(const Matrix* matrices, size_t count, const Matrix& right, Matrix* result);
+
+	// The inverse transpose of the upper 3x3 part of each matrix (which transforms normals), with no translation.
+	// Singular matrices give the transposed cofactors without dividing by the determinant, which still points
+	// normals the right way.
+	static void InverseTranspose(const Matrix* matrices, size_t count, Matrix* result);
+
+	// result[i] = boxes[i].Transform(transformations[i]).  Empty and infinite boxes are copied unchanged.
+	static void TransformBoxes(const AxisAlignedBox* boxes, const Matrix* transformations, size_t count, AxisAlignedBox* result);
+
+	// The kernels use the fastest path the processor supports unless told otherwise.  A path that is not supported
+	// falls back to the next fastest one that is.  This is not thread safe, and is meant for comparing the paths.
+	static void SetPath(Path path);
+	static Path GetPath();
+	static const char* GetPathName(Path path);
+};
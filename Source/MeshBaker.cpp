@@ -0,0 +1,48 @@
+#include "MeshBaker.h"
+#include "MeshRegistry.h"
+#include "GeometricObject.h"
+#include "CubeNode.h"
+#include "TexturedCubeNode.h"
+#include <cstddef>
+
+// Layout of GeoStruct
+vector<MeshVertexElement> GetGeoStructLayout()
+{
+	return {
+		MeshFile::MakeElement("POSITION", 0, MeshElementFormat::Float3, offsetof(GeoStruct, Position)),
+		MeshFile::MakeElement("NORMAL", 0, MeshElementFormat::Float3, offsetof(GeoStruct, Normal))
+	};
+}
+
+// Layout of ObjectVertexStruct (the same as vertexDesc in Geometry.h)
+vector<MeshVertexElement> GetObjectVertexLayout()
+{
+	return {
+		MeshFile::MakeElement("POSITION", 0, MeshElementFormat::Float3, offsetof(ObjectVertexStruct, Position)),
+		MeshFile::MakeElement("NORMAL", 0, MeshElementFormat::Float3, offsetof(ObjectVertexStruct, Normal)),
+		MeshFile::MakeElement("TEXCOORD", 0, MeshElementFormat::Float2, offsetof(ObjectVertexStruct, TextureCoordinate))
+	};
+}
+
+int BakeMeshes(const wstring& directory)
+{
+	wstring prefix = directory;
+	if (!prefix.empty() && prefix.back() != L'\\' && prefix.back() != L'/')
+	{
+		prefix += L'\\';
+	}
+
+	// The meshes are built (and optimised) exactly as they are at startup, without a device
+	MeshRegistry registry(nullptr);
+	vector<MeshVertexElement> geoStructLayout = GetGeoStructLayout();
+	vector<MeshVertexElement> objectVertexLayout = GetObjectVertexLayout();
+	bool written = true;
+	written &= registry.GetTeapot(3.0f)->Save(prefix + L"teapot.mesh", geoStructLayout);
+	written &= registry.GetBox(Vector3(1.0f, 1.0f, 1.0f))->Save(prefix + L"box.mesh", geoStructLayout);
+	written &= registry.GetSphere(1.0f, 32)->Save(prefix + L"sphere.mesh", geoStructLayout);
+	written &= registry.GetCylinder(1.0f, 1.0f, 32)->Save(prefix + L"cylinder.mesh", geoStructLayout);
+	written &= registry.GetCone(1.0f, 1.0f, 32)->Save(prefix + L"cone.mesh", geoStructLayout);
+	written &= registry.GetMesh("cube", CubeNode::BuildMesh)->Save(prefix + L"cube.mesh", objectVertexLayout);
+	written &= registry.GetMesh("texturedcube", TexturedCubeNode::BuildMesh)->Save(prefix + L"texturedcube.mesh", objectVertexLayout);
+	return written ? 0 : 1;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "MeshFile.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Writes the meshes that are otherwise built at startup (the teapot, the primitives in
+// GeometricObject.h and the cubes in Geometry.h) to mesh files in the specified directory,
+// so they can be loaded with MeshRegistry::LoadMesh.  This is run instead of the application
+// when it is started with -bakemeshes on the command line.  Returns 0 if every file was written.
+
+int BakeMeshes(const wstring& directory);
+
+// The vertex layouts the meshes are baked with.  Nodes pass them to MeshRegistry::LoadMesh, so that files
+// with any other layout are not used.
+vector<MeshVertexElement> GetGeoStructLayout();
+vector<MeshVertexElement> GetObjectVertexLayout();
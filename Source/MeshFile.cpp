@@ -0,0 +1,247 @@
+#include "MeshFile.h"
+#include <algorithm>
+#include <cstring>
+
+constexpr uint32_t MeshFile::Magic;
+constexpr uint32_t MeshFile::Version;
+constexpr size_t MeshFile::StreamAlignment;
+
+// Limits used to reject damaged files before anything is allocated or indexed
+constexpr uint32_t MaximumElementCount = 32;
+constexpr uint32_t MaximumLodCount = 32;
+
+struct MeshFile::Header
+{
+	uint32_t	Magic;
+	uint32_t	Version;
+	uint32_t	VertexStride;
+	uint32_t	VertexCount;
+	uint32_t	IndexSize;
+	uint32_t	IndexCount;
+	uint32_t	ElementCount;
+	uint32_t	LodCount;
+	float		BoundsMinimum[3];
+	float		BoundsMaximum[3];
+	// Offsets of the streams from the start of the file
+	uint64_t	VertexOffset;
+	uint64_t	IndexOffset;
+};
+
+static inline uint64_t Align(uint64_t offset)
+{
+	return (offset + MeshFile::StreamAlignment - 1) & ~static_cast<uint64_t>(MeshFile::StreamAlignment - 1);
+}
+
+// True if size bytes starting at offset are inside a file of fileSize bytes
+static inline bool InFile(uint64_t offset, uint64_t size, uint64_t fileSize)
+{
+	return offset <= fileSize && size <= fileSize - offset;
+}
+
+// True if every index refers to one of the vertices, so that a damaged index stream cannot make anything reading
+// the vertices through it (the GPU, or the CPU when meshes are simplified or rasterised) read past the end
+template <typename Index>
+static bool IndicesInRange(const uint8_t* data, uint32_t count, uint32_t vertexCount)
+{
+	const Index* indices = reinterpret_cast<const Index*>(data);
+	Index maximum = 0;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		maximum = max(maximum, indices[i]);
+	}
+	return count == 0 || maximum < vertexCount;
+}
+
+size_t MeshFile::GetFormatSize(MeshElementFormat format)
+{
+	switch (format)
+	{
+		case MeshElementFormat::Float4:
+			return 16;
+		case MeshElementFormat::Float3:
+			return 12;
+		case MeshElementFormat::Float2:
+			return 8;
+	}
+	return 0;
+}
+
+MeshVertexElement MeshFile::MakeElement(const char* semantic, uint32_t semanticIndex, MeshElementFormat format, uint32_t offset)
+{
+	MeshVertexElement element = { { 0 }, semanticIndex, format, offset };
+	memcpy(element.Semantic, semantic, min(strlen(semantic), sizeof(element.Semantic) - 1));
+	return element;
+}
+
+bool MeshFile::Open(const wstring& fileName)
+{
+	Close();
+	if (!_file.Open(fileName))
+	{
+		return false;
+	}
+
+	const uint8_t* data = _file.GetData();
+	uint64_t size = _file.GetSize();
+	const Header* header = reinterpret_cast<const Header*>(data);
+	bool valid = size >= sizeof(Header) && header->Magic == Magic && header->Version == Version;
+	valid = valid && header->VertexStride > 0 && (header->IndexSize == 2 || header->IndexSize == 4) &&
+			header->ElementCount > 0 && header->ElementCount <= MaximumElementCount && header->LodCount <= MaximumLodCount;
+	uint64_t tableSize = valid ? header->ElementCount * sizeof(MeshVertexElement) + header->LodCount * sizeof(MeshLod) : 0;
+	valid = valid && InFile(sizeof(Header), tableSize, size) &&
+			header->VertexOffset % StreamAlignment == 0 && header->VertexOffset >= sizeof(Header) + tableSize &&
+			InFile(header->VertexOffset, static_cast<uint64_t>(header->VertexStride) * header->VertexCount, size) &&
+			header->IndexOffset % StreamAlignment == 0 &&
+			header->IndexOffset >= header->VertexOffset + static_cast<uint64_t>(header->VertexStride) * header->VertexCount &&
+			InFile(header->IndexOffset, static_cast<uint64_t>(header->IndexSize) * header->IndexCount, size);
+	if (valid)
+	{
+		const MeshVertexElement* elements = reinterpret_cast<const MeshVertexElement*>(data + sizeof(Header));
+		for (uint32_t i = 0; i < header->ElementCount && valid; i++)
+		{
+			const MeshVertexElement& element = elements[i];
+			size_t formatSize = GetFormatSize(element.Format);
+			valid = memchr(element.Semantic, 0, sizeof(element.Semantic)) != nullptr && element.Semantic[0] != 0 &&
+					formatSize != 0 && element.Offset <= header->VertexStride && formatSize <= header->VertexStride - element.Offset;
+		}
+		const MeshLod* lods = reinterpret_cast<const MeshLod*>(elements + header->ElementCount);
+		for (uint32_t i = 0; i < header->LodCount && valid; i++)
+		{
+			valid = lods[i].IndexStart <= header->IndexCount && lods[i].IndexCount <= header->IndexCount - lods[i].IndexStart;
+		}
+		if (valid)
+		{
+			const uint8_t* indexData = data + header->IndexOffset;
+			valid = header->IndexSize == 2 ? IndicesInRange<uint16_t>(indexData, header->IndexCount, header->VertexCount)
+										   : IndicesInRange<uint32_t>(indexData, header->IndexCount, header->VertexCount);
+		}
+		if (valid)
+		{
+			_header = header;
+			_elements = elements;
+			_lods = lods;
+			_vertexData = data + header->VertexOffset;
+			_indexData = data + header->IndexOffset;
+		}
+	}
+	if (!valid)
+	{
+		_file.Close();
+	}
+	return valid;
+}
+
+void MeshFile::Close()
+{
+	_file.Close();
+	_header = nullptr;
+	_elements = nullptr;
+	_lods = nullptr;
+	_vertexData = nullptr;
+	_indexData = nullptr;
+}
+
+uint32_t MeshFile::GetVertexStride() const
+{
+	return _header ? _header->VertexStride : 0;
+}
+
+uint32_t MeshFile::GetVertexCount() const
+{
+	return _header ? _header->VertexCount : 0;
+}
+
+uint32_t MeshFile::GetIndexSize() const
+{
+	return _header ? _header->IndexSize : 0;
+}
+
+uint32_t MeshFile::GetIndexCount() const
+{
+	return _header ? _header->IndexCount : 0;
+}
+
+AxisAlignedBox MeshFile::GetBounds() const
+{
+	if (!_header)
+	{
+		return AxisAlignedBox::Empty();
+	}
+	return AxisAlignedBox(Vector3(_header->BoundsMinimum[0], _header->BoundsMinimum[1], _header->BoundsMinimum[2]),
+						  Vector3(_header->BoundsMaximum[0], _header->BoundsMaximum[1], _header->BoundsMaximum[2]));
+}
+
+size_t MeshFile::GetElementCount() const
+{
+	return _header ? _header->ElementCount : 0;
+}
+
+bool MeshFile::HasLayout(const vector<MeshVertexElement>& layout) const
+{
+	if (GetElementCount() != layout.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < layout.size(); i++)
+	{
+		const MeshVertexElement& element = _elements[i];
+		if (strncmp(element.Semantic, layout[i].Semantic, sizeof(element.Semantic)) != 0 || element.SemanticIndex != layout[i].SemanticIndex ||
+			element.Format != layout[i].Format || element.Offset != layout[i].Offset)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t MeshFile::GetLodCount() const
+{
+	return _header ? _header->LodCount : 0;
+}
+
+bool MeshFile::Write(const wstring& fileName, const MeshFileContents& contents)
+{
+	Header header = { 0 };
+	header.Magic = Magic;
+	header.Version = Version;
+	header.VertexStride = contents.VertexStride;
+	header.VertexCount = contents.VertexCount;
+	header.IndexSize = contents.IndexSize;
+	header.IndexCount = contents.IndexCount;
+	header.ElementCount = static_cast<uint32_t>(contents.Elements.size());
+	header.LodCount = static_cast<uint32_t>(contents.Lods.size());
+	header.BoundsMinimum[0] = contents.Bounds.Min.x;
+	header.BoundsMinimum[1] = contents.Bounds.Min.y;
+	header.BoundsMinimum[2] = contents.Bounds.Min.z;
+	header.BoundsMaximum[0] = contents.Bounds.Max.x;
+	header.BoundsMaximum[1] = contents.Bounds.Max.y;
+	header.BoundsMaximum[2] = contents.Bounds.Max.z;
+
+	size_t elementsSize = contents.Elements.size() * sizeof(MeshVertexElement);
+	size_t lodsSize = contents.Lods.size() * sizeof(MeshLod);
+	size_t vertexSize = static_cast<size_t>(contents.VertexStride) * contents.VertexCount;
+	size_t indexSize = static_cast<size_t>(contents.IndexSize) * contents.IndexCount;
+	header.VertexOffset = Align(sizeof(Header) + elementsSize + lodsSize);
+	header.IndexOffset = Align(header.VertexOffset + vertexSize);
+
+	// The padding between the sections is zeroed by the resize
+	vector<uint8_t> file(static_cast<size_t>(header.IndexOffset) + indexSize);
+	memcpy(file.data(), &header, sizeof(header));
+	if (elementsSize > 0)
+	{
+		memcpy(file.data() + sizeof(Header), contents.Elements.data(), elementsSize);
+	}
+	if (lodsSize > 0)
+	{
+		memcpy(file.data() + sizeof(Header) + elementsSize, contents.Lods.data(), lodsSize);
+	}
+	if (vertexSize > 0)
+	{
+		memcpy(file.data() + header.VertexOffset, contents.Vertices, vertexSize);
+	}
+	if (indexSize > 0)
+	{
+		memcpy(file.data() + header.IndexOffset, contents.Indices, indexSize);
+	}
+	return MappedFile::WriteFile(fileName, file.data(), file.size());
+}
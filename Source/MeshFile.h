@@ -0,0 +1,115 @@
+#pragma once
+#include "MappedFile.h"
+#include "Bounds.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Format of a vertex element.  The values are the matching DXGI_FORMAT values, so they can
+// be used directly in a D3D11_INPUT_ELEMENT_DESC.
+enum class MeshElementFormat : uint32_t
+{
+	Float4 = 2,			// DXGI_FORMAT_R32G32B32A32_FLOAT
+	Float3 = 6,			// DXGI_FORMAT_R32G32B32_FLOAT
+	Float2 = 16			// DXGI_FORMAT_R32G32_FLOAT
+};
+
+// One element of the vertex layout of a mesh file
+struct MeshVertexElement
+{
+	char				Semantic[16];		// Null terminated
+	uint32_t			SemanticIndex;
+	MeshElementFormat	Format;
+	uint32_t			Offset;				// From the start of the vertex, in bytes
+};
+
+// One level of detail.  Every level uses the same vertices; its triangles are a range of the index stream.
+struct MeshLod
+{
+	uint32_t			IndexStart;
+	uint32_t			IndexCount;
+	float				Error;				// Simplification error in object space units (0 for full detail)
+	uint32_t			Reserved;
+};
+
+// What to write to a mesh file.  The pointers are only used during MeshFile::Write.
+struct MeshFileContents
+{
+	vector<MeshVertexElement>	Elements;
+	uint32_t					VertexStride{ 0 };
+	uint32_t					VertexCount{ 0 };
+	const void*					Vertices{ nullptr };
+	uint32_t					IndexSize{ 4 };		// 2 or 4 bytes
+	uint32_t					IndexCount{ 0 };
+	const void*					Indices{ nullptr };
+	AxisAlignedBox				Bounds;
+	vector<MeshLod>				Lods;
+};
+
+// Binary mesh container (".mesh" files).
+//
+// A file is a header, the vertex layout, the LOD table (which may be empty), the vertex
+// stream and then the index stream.  Both streams start on a StreamAlignment boundary
+// and are stored exactly as they are uploaded to the vertex and index buffers, so a
+// loaded file is used in place: Open maps the file, checks that the header and tables
+// are consistent and that every index is less than the vertex count, and returns
+// pointers into the mapped pages.  Nothing is parsed or copied, and the vertex data is
+// not touched until the buffers are created, so opening a file only costs one pass over
+// the indices.  All values are little endian.
+//
+// Change Version if the layout of the file changes.
+
+class MeshFile
+{
+public:
+	static constexpr uint32_t Magic = 0x4853454D;		// "MESH"
+	static constexpr uint32_t Version = 1;
+	static constexpr size_t StreamAlignment = 16;
+
+	MeshFile() {};
+
+	MeshFile(const MeshFile&) = delete;
+	MeshFile& operator=(const MeshFile&) = delete;
+
+	// Returns false if the file does not exist or is not a valid mesh file
+	bool Open(const wstring& fileName);
+	void Close();
+
+	inline bool IsOpen() const { return _header != nullptr; }
+
+	uint32_t GetVertexStride() const;
+	uint32_t GetVertexCount() const;
+	uint32_t GetIndexSize() const;
+	uint32_t GetIndexCount() const;
+	AxisAlignedBox GetBounds() const;
+
+	inline const MeshVertexElement* GetElements() const { return _elements; }
+	size_t GetElementCount() const;
+	// True if the vertex layout is exactly layout, with the same elements in the same order
+	bool HasLayout(const vector<MeshVertexElement>& layout) const;
+	inline const MeshLod* GetLods() const { return _lods; }
+	size_t GetLodCount() const;
+
+	// The streams, pointing into the mapped file
+	inline const uint8_t* GetVertexData() const { return _vertexData; }
+	inline const uint8_t* GetIndexData() const { return _indexData; }
+
+	static bool Write(const wstring& fileName, const MeshFileContents& contents);
+
+	// Semantics longer than 15 characters are truncated
+	static MeshVertexElement MakeElement(const char* semantic, uint32_t semanticIndex, MeshElementFormat format, uint32_t offset);
+
+	// Size in bytes of an element format, or 0 if the format is not known
+	static size_t GetFormatSize(MeshElementFormat format);
+
+private:
+	struct Header;
+
+	MappedFile					_file;
+	const Header*				_header{ nullptr };
+	const MeshVertexElement*	_elements{ nullptr };
+	const MeshLod*				_lods{ nullptr };
+	const uint8_t*				_vertexData{ nullptr };
+	const uint8_t*				_indexData{ nullptr };
+};
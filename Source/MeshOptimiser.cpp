@@ -0,0 +1,328 @@
+#include "MeshOptimiser.h"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+
+// FIFO post-transform cache simulation.  Rather than moving entries, each vertex remembers the
+// miss count when it was last transformed; it is still in the cache if fewer than cacheSize
+// misses have happened since.
+class FifoCache
+{
+public:
+	FifoCache(size_t vertexCount, unsigned int cacheSize) : _cacheSize(cacheSize), _time(cacheSize + 1), _timestamps(vertexCount, 0) {}
+
+	// Returns 1 if the vertex had to be transformed
+	inline unsigned int Use(UINT vertex)
+	{
+		if (_time - _timestamps[vertex] > _cacheSize)
+		{
+			_timestamps[vertex] = _time++;
+			return 1;
+		}
+		return 0;
+	}
+
+	// Empty the cache
+	inline void Flush() { _time += _cacheSize + 1; }
+
+private:
+	unsigned int		_cacheSize;
+	size_t				_time;
+	vector<size_t>		_timestamps;
+};
+
+VertexCacheStatistics MeshOptimiser::AnalyseVertexCache(const UINT* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+	VertexCacheStatistics statistics;
+	FifoCache cache(vertexCount, cacheSize);
+	vector<bool> used(vertexCount, false);
+	size_t usedCount = 0;
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		statistics.TransformCount += cache.Use(indices[i]);
+		if (!used[indices[i]])
+		{
+			used[indices[i]] = true;
+			usedCount++;
+		}
+	}
+	size_t triangleCount = indexCount / 3;
+	statistics.ACMR = triangleCount > 0 ? static_cast<float>(statistics.TransformCount) / triangleCount : 0.0f;
+	statistics.ATVR = usedCount > 0 ? static_cast<float>(statistics.TransformCount) / usedCount : 0.0f;
+	return statistics;
+}
+
+void MeshOptimiser::OptimiseVertexCache(UINT* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize, vector<UINT>* clusters)
+{
+	size_t triangleCount = indexCount / 3;
+	if (clusters)
+	{
+		clusters->clear();
+	}
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	// Triangles that use each vertex, and how many of them have not been emitted yet
+	vector<UINT> liveCounts(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		liveCounts[indices[i]]++;
+	}
+	vector<UINT> offsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		offsets[v + 1] = offsets[v] + liveCounts[v];
+	}
+	vector<UINT> adjacency(triangleCount * 3);
+	vector<UINT> next(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		adjacency[next[indices[i]]++] = static_cast<UINT>(i / 3);
+	}
+
+	vector<size_t> cacheTimes(vertexCount, 0);
+	vector<bool> emitted(triangleCount, false);
+	vector<UINT> deadEnds;
+	vector<UINT> candidates;
+	vector<UINT> output;
+	output.reserve(triangleCount * 3);
+	size_t time = cacheSize + 1;
+	size_t cursor = 0;
+
+	// Find a vertex with triangles left to emit when the current fan has run out of candidates: first the
+	// most recently used vertices, then the next one in input order
+	auto skipDeadEnd = [&]() -> long long
+		{
+			while (!deadEnds.empty())
+			{
+				UINT vertex = deadEnds.back();
+				deadEnds.pop_back();
+				if (liveCounts[vertex] > 0)
+				{
+					return vertex;
+				}
+			}
+			while (cursor < vertexCount)
+			{
+				if (liveCounts[cursor] > 0)
+				{
+					return static_cast<long long>(cursor);
+				}
+				cursor++;
+			}
+			return -1;
+		};
+
+	long long fan = skipDeadEnd();
+	bool startsCluster = true;
+	while (fan >= 0)
+	{
+		if (startsCluster && clusters)
+		{
+			clusters->push_back(static_cast<UINT>(output.size() / 3));
+		}
+
+		// Emit all of the remaining triangles around the fanning vertex
+		candidates.clear();
+		for (UINT i = offsets[fan]; i < offsets[fan + 1]; i++)
+		{
+			UINT triangle = adjacency[i];
+			if (emitted[triangle])
+			{
+				continue;
+			}
+			for (int corner = 0; corner < 3; corner++)
+			{
+				UINT vertex = indices[triangle * 3 + corner];
+				output.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				liveCounts[vertex]--;
+				if (time - cacheTimes[vertex] > cacheSize)
+				{
+					cacheTimes[vertex] = time++;
+				}
+			}
+			emitted[triangle] = true;
+		}
+
+		// Choose the next fanning vertex from the vertices just used: the one that has been in the cache the
+		// longest but will still be there after its remaining triangles have been emitted
+		long long best = -1;
+		long long bestPriority = -1;
+		for (UINT vertex : candidates)
+		{
+			if (liveCounts[vertex] == 0)
+			{
+				continue;
+			}
+			long long priority = 0;
+			long long age = static_cast<long long>(time - cacheTimes[vertex]);
+			if (age + 2 * static_cast<long long>(liveCounts[vertex]) <= static_cast<long long>(cacheSize))
+			{
+				priority = age;
+			}
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				best = vertex;
+			}
+		}
+		startsCluster = best < 0;
+		fan = best >= 0 ? best : skipDeadEnd();
+	}
+	memcpy(indices, output.data(), output.size() * sizeof(UINT));
+}
+
+void MeshOptimiser::OptimiseOverdraw(UINT* indices, size_t indexCount, const Vector3* positions, size_t stride, size_t vertexCount,
+									 const vector<UINT>& clusters, unsigned int cacheSize, float threshold)
+{
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	// Tipsify's clusters are usually large.  Split them further wherever the ACMR of the triangles since
+	// the last split is already within threshold of the ACMR of the whole cluster, so that the extra cache
+	// misses from reordering the pieces are limited.
+	vector<UINT> boundaries(clusters);
+	if (boundaries.empty() || boundaries[0] != 0)
+	{
+		boundaries.insert(boundaries.begin(), 0);
+	}
+	boundaries.push_back(static_cast<UINT>(triangleCount));
+	vector<UINT> splits;
+	FifoCache cache(vertexCount, cacheSize);
+	for (size_t c = 0; c + 1 < boundaries.size(); c++)
+	{
+		UINT begin = boundaries[c];
+		UINT end = boundaries[c + 1];
+		size_t misses = 0;
+		cache.Flush();
+		for (UINT triangle = begin; triangle < end; triangle++)
+		{
+			misses += cache.Use(indices[triangle * 3]) + cache.Use(indices[triangle * 3 + 1]) + cache.Use(indices[triangle * 3 + 2]);
+		}
+		float clusterThreshold = threshold * misses / (end - begin);
+
+		splits.push_back(begin);
+		UINT start = begin;
+		misses = 0;
+		cache.Flush();
+		for (UINT triangle = begin; triangle < end; triangle++)
+		{
+			misses += cache.Use(indices[triangle * 3]) + cache.Use(indices[triangle * 3 + 1]) + cache.Use(indices[triangle * 3 + 2]);
+			if (triangle + 1 < end && static_cast<float>(misses) / (triangle + 1 - start) <= clusterThreshold)
+			{
+				start = triangle + 1;
+				splits.push_back(start);
+				misses = 0;
+				cache.Flush();
+			}
+		}
+	}
+	splits.push_back(static_cast<UINT>(triangleCount));
+
+	// Sort the clusters by how far their area weighted centre is in front of the centre of the mesh,
+	// along their average normal
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(positions);
+	auto position = [&](UINT vertex) -> const Vector3& { return *reinterpret_cast<const Vector3*>(bytes + vertex * stride); };
+	size_t clusterCount = splits.size() - 1;
+	vector<Vector3> clusterCentres(clusterCount);
+	vector<Vector3> clusterNormals(clusterCount);
+	Vector3 meshCentre(0, 0, 0);
+	float meshArea = 0.0f;
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		Vector3 centre(0, 0, 0);
+		Vector3 normal(0, 0, 0);
+		float area = 0.0f;
+		for (UINT triangle = splits[c]; triangle < splits[c + 1]; triangle++)
+		{
+			const Vector3& p0 = position(indices[triangle * 3]);
+			const Vector3& p1 = position(indices[triangle * 3 + 1]);
+			const Vector3& p2 = position(indices[triangle * 3 + 2]);
+			Vector3 triangleNormal = (p1 - p0).Cross(p2 - p0);
+			float triangleArea = triangleNormal.Length();
+			centre += (p0 + p1 + p2) * (triangleArea / 3.0f);
+			normal += triangleNormal;
+			area += triangleArea;
+		}
+		meshCentre += centre;
+		meshArea += area;
+		clusterCentres[c] = area > 0.0f ? centre / area : centre;
+		normal.Normalize();
+		clusterNormals[c] = normal;
+	}
+	if (meshArea > 0.0f)
+	{
+		meshCentre /= meshArea;
+	}
+	vector<float> sortKeys(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		sortKeys[c] = (clusterCentres[c] - meshCentre).Dot(clusterNormals[c]);
+	}
+	vector<UINT> order(clusterCount);
+	iota(order.begin(), order.end(), 0);
+	stable_sort(order.begin(), order.end(), [&](UINT a, UINT b) { return sortKeys[a] > sortKeys[b]; });
+
+	vector<UINT> output;
+	output.reserve(triangleCount * 3);
+	for (UINT c : order)
+	{
+		output.insert(output.end(), indices + splits[c] * 3, indices + splits[c + 1] * 3);
+	}
+	memcpy(indices, output.data(), output.size() * sizeof(UINT));
+}
+
+size_t MeshOptimiser::OptimiseVertexFetch(void* vertices, size_t vertexCount, size_t stride, UINT* indices, size_t indexCount)
+{
+	vector<UINT> remap(vertexCount, UINT_MAX);
+	UINT nextVertex = 0;
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		UINT& newIndex = remap[indices[i]];
+		if (newIndex == UINT_MAX)
+		{
+			newIndex = nextVertex++;
+		}
+		indices[i] = newIndex;
+	}
+
+	uint8_t* bytes = reinterpret_cast<uint8_t*>(vertices);
+	vector<uint8_t> reordered(nextVertex * stride);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		if (remap[v] != UINT_MAX)
+		{
+			memcpy(&reordered[remap[v] * stride], bytes + v * stride, stride);
+		}
+	}
+	memcpy(bytes, reordered.data(), reordered.size());
+	return nextVertex;
+}
+
+size_t MeshOptimiser::Optimise(void* vertices, size_t vertexCount, size_t stride, UINT* indices, size_t indexCount, const Options& options)
+{
+	// Meshes that are already in a cache friendly order (such as the teapot, which is built from patches) can come
+	// out of Tipsify and the overdraw sort worse than they went in.  They are left in their own order.
+	vector<UINT> originalIndices(indices, indices + indexCount);
+	float originalACMR = AnalyseVertexCache(indices, indexCount, vertexCount, options.CacheSize).ACMR;
+	vector<UINT> clusters;
+	OptimiseVertexCache(indices, indexCount, vertexCount, options.CacheSize, &clusters);
+	if (options.OverdrawThreshold > 1.0f)
+	{
+		OptimiseOverdraw(indices, indexCount, reinterpret_cast<const Vector3*>(vertices), stride, vertexCount, clusters, options.CacheSize, options.OverdrawThreshold);
+	}
+	if (AnalyseVertexCache(indices, indexCount, vertexCount, options.CacheSize).ACMR > originalACMR)
+	{
+		copy(originalIndices.begin(), originalIndices.end(), indices);
+	}
+	return OptimiseVertexFetch(vertices, vertexCount, stride, indices, indexCount);
+}
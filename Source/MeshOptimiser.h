@@ -0,0 +1,71 @@
+#pragma once
+#include "SimpleMath.h"
+#include <vector>
+
+using namespace std;
+using namespace DirectX;
+using namespace SimpleMath;
+
+typedef unsigned int UINT;
+
+// Results of running an index list through a simulated FIFO post-transform vertex cache
+struct VertexCacheStatistics
+{
+	size_t		TransformCount{ 0 };	// Vertices run through the vertex shader
+	float		ACMR{ 0 };				// Average cache miss ratio: transforms per triangle (0.5 is ideal for large grids, 3 is worst)
+	float		ATVR{ 0 };				// Average transform to vertex ratio: transforms per vertex used (1 is ideal)
+};
+
+// Reorders meshes so that they are cheaper to draw.
+//
+// OptimiseVertexCache reorders the triangles using Tipsify (Sander, Nehab and Barczak,
+// "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007), so that the
+// vertices a triangle uses are likely to still be in the post-transform cache and the
+// vertex shader runs fewer times.  OptimiseOverdraw then splits the result into clusters
+// and sorts them so that triangles facing out from the centre of the mesh are drawn first,
+// which lets early depth rejection skip more of the pixels behind them without losing
+// much of the cache locality.  OptimiseVertexFetch finally renumbers the vertices in the
+// order they are first used, so the vertex buffer is read sequentially.
+//
+// All of these work on 32 bit index lists and on vertices of any structure that starts
+// with its position.
+
+class MeshOptimiser
+{
+public:
+	struct Options
+	{
+		// Size of the cache to optimise for (Tipsify's k) and to simulate
+		unsigned int	CacheSize{ 16 };
+		// How much worse than the cache optimised order a cluster may make the ACMR.  1 disables overdraw optimisation.
+		float			OverdrawThreshold{ 1.05f };
+	};
+
+	static VertexCacheStatistics AnalyseVertexCache(const UINT* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = 16);
+
+	// Reorder the triangles for the vertex cache.  If clusters is not null, it receives the index of the first
+	// triangle of each run that Tipsify started from a dead end; OptimiseOverdraw uses these.
+	static void OptimiseVertexCache(UINT* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = 16, vector<UINT>* clusters = nullptr);
+
+	// Reorder the clusters of a cache optimised index list, front facing (outermost) clusters first
+	static void OptimiseOverdraw(UINT* indices, size_t indexCount, const Vector3* positions, size_t stride, size_t vertexCount,
+								 const vector<UINT>& clusters, unsigned int cacheSize = 16, float threshold = 1.05f);
+
+	// Renumber the vertices in the order they are first used.  Vertices that are not used are removed.
+	// vertices points to vertexCount vertices of stride bytes.  Returns the new vertex count.
+	static size_t OptimiseVertexFetch(void* vertices, size_t vertexCount, size_t stride, UINT* indices, size_t indexCount);
+
+	// Run all three optimisations.  If the triangle order that results misses the cache more often than the
+	// original order did, the original order is kept.
+	static size_t Optimise(void* vertices, size_t vertexCount, size_t stride, UINT* indices, size_t indexCount, const Options& options);
+
+	template <typename Vertex>
+	static void Optimise(vector<Vertex>& vertices, vector<UINT>& indices, const Options& options = Options())
+	{
+		if (vertices.empty() || indices.empty())
+		{
+			return;
+		}
+		vertices.resize(Optimise(vertices.data(), vertices.size(), sizeof(Vertex), indices.data(), indices.size(), options));
+	}
+};
@@ -0,0 +1,271 @@
+#include "MeshRegistry.h"
+#include "GeometricObject.h"
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+Mesh::~Mesh()
+{
+	// The last node using the mesh may be destroyed while a frame that draws it is still being rendered
+	if (Device)
+	{
+		Device->RetireBuffer(VertexBuffer);
+		Device->RetireBuffer(IndexBuffer);
+	}
+}
+
+void Mesh::CalculateNormals(NormalWeighting weighting, JobSystem* jobSystem)
+{
+	if (File)
+	{
+		throw logic_error("Meshes loaded from files cannot be modified");
+	}
+	if (VertexCount == 0)
+	{
+		return;
+	}
+	// The normal immediately follows the position
+	Vector3* positions = reinterpret_cast<Vector3*>(Vertices.data());
+	// Only the full detail triangles are used; the other levels use the same vertices
+	vector<UINT> indices;
+	Indices.CopyTo(indices);
+	indices.resize(GetLod(0).IndexCount);
+	NormalGenerator generator;
+	generator.SetTriangles(indices.data(), indices.size(), VertexCount);
+	generator.Generate(positions, positions + 1, VertexStride, weighting, jobSystem);
+}
+
+void Mesh::Optimise(const MeshOptimiser::Options& options)
+{
+	if (File)
+	{
+		throw logic_error("Meshes loaded from files cannot be modified");
+	}
+	if (!Lods.empty())
+	{
+		throw logic_error("Meshes must be optimised before their levels of detail are generated");
+	}
+	if (VertexCount == 0 || Indices.IsEmpty())
+	{
+		return;
+	}
+	vector<UINT> indices;
+	Indices.CopyTo(indices);
+	VertexCount = static_cast<unsigned int>(MeshOptimiser::Optimise(Vertices.data(), VertexCount, VertexStride, indices.data(), indices.size(), options));
+	Vertices.resize(VertexCount * VertexStride);
+	Indices.Assign(indices.data(), indices.size(), VertexCount);
+}
+
+void Mesh::GenerateLods(const MeshSimplifier::Options& options)
+{
+	if (File)
+	{
+		throw logic_error("Meshes loaded from files cannot be modified");
+	}
+	if (!Lods.empty() || VertexCount == 0 || Indices.IsEmpty())
+	{
+		return;
+	}
+	vector<UINT> indices;
+	Indices.CopyTo(indices);
+	vector<MeshLod> lods = MeshSimplifier::BuildLodChain(Vertices.data(), VertexCount, VertexStride, indices, options);
+	if (lods.size() > 1)
+	{
+		Indices.Assign(indices.data(), indices.size(), VertexCount);
+		Lods = lods;
+	}
+}
+
+size_t Mesh::SelectLod(float pixelsPerUnit, size_t currentLevel, float pixelError, float hysteresis) const
+{
+	if (Lods.empty())
+	{
+		return 0;
+	}
+	// The errors increase with the level, so finer levels are used while the current one is too coarse...
+	size_t level = min(currentLevel, Lods.size() - 1);
+	while (level > 0 && Lods[level].Error * pixelsPerUnit > pixelError)
+	{
+		level--;
+	}
+	// ...and coarser levels once they are comfortably within the limit
+	while (level + 1 < Lods.size() && Lods[level + 1].Error * pixelsPerUnit <= pixelError * (1.0f - hysteresis))
+	{
+		level++;
+	}
+	return level;
+}
+
+bool Mesh::Save(const wstring& fileName, const vector<MeshVertexElement>& layout) const
+{
+	MeshFileContents contents;
+	contents.Elements = layout;
+	contents.VertexStride = VertexStride;
+	contents.VertexCount = VertexCount;
+	contents.Vertices = GetVertexData();
+	contents.IndexSize = static_cast<uint32_t>(Indices.GetElementSize());
+	contents.IndexCount = static_cast<uint32_t>(Indices.GetCount());
+	contents.Indices = Indices.GetData();
+	contents.Bounds = Bounds;
+	contents.Lods = Lods;
+	return MeshFile::Write(fileName, contents);
+}
+
+MeshRegistry::MeshRegistry(shared_ptr<RenderDevice> device) :
+	_device(device)
+{
+}
+
+MeshPointer MeshRegistry::GetMesh(const string& key, const Builder& builder)
+{
+	MeshPointer mesh = _meshes[key].lock();
+	if (mesh)
+	{
+		_hitCount++;
+		return mesh;
+	}
+
+	mesh = make_shared<Mesh>();
+	mesh->Key = key;
+	builder(*mesh);
+	_buildCount++;
+	if (_optimiseMeshes)
+	{
+		mesh->Optimise();
+	}
+	if (_generateLods)
+	{
+		mesh->GenerateLods();
+	}
+	if (mesh->VertexCount > 0)
+	{
+		mesh->Bounds = AxisAlignedBox::FromPoints(reinterpret_cast<const Vector3*>(mesh->Vertices.data()), mesh->VertexCount, mesh->VertexStride);
+	}
+	if (_device)
+	{
+		BuildBuffers(*mesh);
+	}
+	_meshes[key] = mesh;
+	return mesh;
+}
+
+MeshPointer MeshRegistry::LoadMesh(const wstring& fileName, const vector<MeshVertexElement>& layout, uint32_t vertexStride)
+{
+	string key = "file " + string(fileName.begin(), fileName.end());
+	MeshPointer mesh = _meshes[key].lock();
+	if (mesh)
+	{
+		if (!mesh->File->HasLayout(layout) || mesh->VertexStride != vertexStride)
+		{
+			return nullptr;
+		}
+		_hitCount++;
+		return mesh;
+	}
+
+	// A file with any other layout would be drawn with the wrong input layout, even if its stride is the same
+	shared_ptr<MeshFile> file = make_shared<MeshFile>();
+	if (!file->Open(fileName) || !file->HasLayout(layout) || file->GetVertexStride() != vertexStride)
+	{
+		_meshes.erase(key);
+		return nullptr;
+	}
+	mesh = make_shared<Mesh>();
+	mesh->Key = key;
+	mesh->VertexStride = file->GetVertexStride();
+	mesh->VertexCount = file->GetVertexCount();
+	mesh->Indices.Reference(file->GetIndexData(), file->GetIndexCount(), file->GetIndexSize() == 2 ? IndexFormat::UInt16 : IndexFormat::UInt32);
+	mesh->Bounds = file->GetBounds();
+	mesh->Lods.assign(file->GetLods(), file->GetLods() + file->GetLodCount());
+	mesh->File = file;
+	_loadCount++;
+	if (_device)
+	{
+		BuildBuffers(*mesh);
+	}
+	_meshes[key] = mesh;
+	return mesh;
+}
+
+// Wraps one of the generators in GeometricObject.h as a Builder
+template <typename Generator>
+static MeshRegistry::Builder GeometricBuilder(Generator generator)
+{
+	return [generator](Mesh& mesh)
+		{
+			vector<GeoStruct> vertices;
+			vector<UINT> indices;
+			generator(vertices, indices);
+			CalculateNormals(vertices, indices);
+			mesh.SetVertices(vertices.data(), vertices.size());
+			mesh.SetIndices(indices.data(), indices.size());
+		};
+}
+
+MeshPointer MeshRegistry::GetBox(const Vector3& size)
+{
+	return GetMesh(MakeKey("box", { { "x", size.x }, { "y", size.y }, { "z", size.z } }),
+				   GeometricBuilder([=](vector<GeoStruct>& vertices, vector<UINT>& indices) { ComputeBox(vertices, indices, size); }));
+}
+
+MeshPointer MeshRegistry::GetSphere(float diameter, size_t tessellation)
+{
+	return GetMesh(MakeKey("sphere", { { "diameter", diameter }, { "tessellation", static_cast<float>(tessellation) } }),
+				   GeometricBuilder([=](vector<GeoStruct>& vertices, vector<UINT>& indices) { ComputeSphere(vertices, indices, diameter, tessellation); }));
+}
+
+MeshPointer MeshRegistry::GetCylinder(float height, float diameter, size_t tessellation)
+{
+	return GetMesh(MakeKey("cylinder", { { "height", height }, { "diameter", diameter }, { "tessellation", static_cast<float>(tessellation) } }),
+				   GeometricBuilder([=](vector<GeoStruct>& vertices, vector<UINT>& indices) { ComputeCylinder(vertices, indices, height, diameter, tessellation); }));
+}
+
+MeshPointer MeshRegistry::GetCone(float diameter, float height, size_t tessellation)
+{
+	return GetMesh(MakeKey("cone", { { "diameter", diameter }, { "height", height }, { "tessellation", static_cast<float>(tessellation) } }),
+				   GeometricBuilder([=](vector<GeoStruct>& vertices, vector<UINT>& indices) { ComputeCone(vertices, indices, diameter, height, tessellation); }));
+}
+
+MeshPointer MeshRegistry::GetTeapot(float size)
+{
+	return GetMesh(MakeKey("teapot", { { "size", size } }),
+				   GeometricBuilder([=](vector<GeoStruct>& vertices, vector<UINT>& indices) { ComputeTeapot(vertices, indices, size); }));
+}
+
+string MeshRegistry::MakeKey(const string& generator, initializer_list<pair<const char*, float>> parameters)
+{
+	// The default stream formatting writes 3.0f as "3", so keys stay readable.  With enough digits to
+	// tell every float apart, sizes that differ only in the seventh digit still get meshes of their own.
+	ostringstream key;
+	key << setprecision(numeric_limits<float>::max_digits10) << generator;
+	for (const auto& parameter : parameters)
+	{
+		key << ' ' << parameter.first << '=' << parameter.second;
+	}
+	return key.str();
+}
+
+void MeshRegistry::BuildBuffers(Mesh& mesh)
+{
+	// Compressed vertices are only needed for the upload; the mesh keeps the full ones for anything done on the CPU.
+	// Meshes from files are uploaded straight from the mapped file as they were baked, rather than being read
+	// through and copied into a compressed buffer on every load.
+	const void* vertexData = mesh.GetVertexData();
+	vector<uint8_t> compressedVertices;
+	size_t compressedStride = _compressVertices && !mesh.File ? VertexCompression::GetCompressedStride(mesh.VertexStride) : 0;
+	mesh.BufferStride = mesh.VertexStride;
+	if (compressedStride != 0 && mesh.VertexCount > 0)
+	{
+		mesh.Quantisation = VertexCompression::GetQuantisation(mesh.Bounds);
+		compressedVertices.resize(mesh.VertexCount * compressedStride);
+		VertexCompression::Compress(vertexData, mesh.VertexCount, mesh.VertexStride, mesh.Quantisation, compressedVertices.data());
+		vertexData = compressedVertices.data();
+		mesh.BufferStride = static_cast<unsigned int>(compressedStride);
+		mesh.CompressedVertices = true;
+	}
+
+	// The data never changes once the mesh has been built, so the buffers are immutable
+	mesh.Device = _device;
+	mesh.VertexBuffer = _device->CreateBuffer(BufferType::Vertex, BufferUsage::Immutable, static_cast<size_t>(mesh.VertexCount) * mesh.BufferStride, vertexData);
+	mesh.IndexBuffer = _device->CreateBuffer(BufferType::Index, BufferUsage::Immutable, mesh.Indices.GetSize(), mesh.Indices.GetData());
+}
@@ -0,0 +1,175 @@
+#pragma once
+#include "SimpleMath.h"
+#include "Bounds.h"
+#include "NormalGenerator.h"
+#include "IndexData.h"
+#include "MeshOptimiser.h"
+#include "MeshSimplifier.h"
+#include "MeshFile.h"
+#include "VertexCompression.h"
+#include "RenderDevice.h"
+#include <cassert>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Vertex and index data for a mesh, together with the buffers it has been uploaded to.
+//
+// The vertices are stored as raw bytes so that meshes with different vertex structures
+// (GeoStruct, ObjectVertexStruct) can be held by the same registry.  Every vertex structure
+// must start with its position, followed by its normal.
+//
+// A mesh loaded from a mesh file uses the vertices and indices in the mapped file instead of
+// copying them into Vertices and Indices, so it cannot be modified.
+struct Mesh
+{
+	string							Key;
+	vector<uint8_t>					Vertices;
+	unsigned int					VertexStride{ 0 };
+	unsigned int					VertexCount{ 0 };
+	IndexData						Indices;
+	AxisAlignedBox					Bounds;
+	// Empty if the mesh only has one level of detail
+	vector<MeshLod>					Lods;
+	shared_ptr<MeshFile>			File;
+
+	// Created on, and released with, Device.  0 if the mesh has not been uploaded.
+	shared_ptr<RenderDevice>		Device;
+	RenderHandle					VertexBuffer{ 0 };
+	RenderHandle					IndexBuffer{ 0 };
+	// Stride of the vertex buffer.  If the buffer holds compressed vertices (see VertexCompression.h), this is
+	// smaller than VertexStride and Quantisation decodes the positions; the mesh itself keeps the full vertices.
+	unsigned int					BufferStride{ 0 };
+	bool							CompressedVertices{ false };
+	VertexQuantisation				Quantisation;
+
+	Mesh() = default;
+	Mesh(const Mesh&) = delete;
+	Mesh& operator=(const Mesh&) = delete;
+	~Mesh();
+
+	template <typename Vertex>
+	void SetVertices(const Vertex* vertices, size_t count)
+	{
+		VertexStride = sizeof(Vertex);
+		VertexCount = static_cast<unsigned int>(count);
+		Vertices.assign(reinterpret_cast<const uint8_t*>(vertices), reinterpret_cast<const uint8_t*>(vertices + count));
+	}
+
+	// The vertices must be set first, since the index format depends on the number of vertices
+	template <typename Index>
+	void SetIndices(const Index* indices, size_t count)
+	{
+		Indices.Assign(indices, count, VertexCount);
+	}
+
+	template <typename Vertex>
+	Vertex* GetVertices()
+	{
+		assert(sizeof(Vertex) == VertexStride && !File);
+		return reinterpret_cast<Vertex*>(Vertices.data());
+	}
+
+	// The full vertices, wherever they are stored
+	inline const uint8_t* GetVertexData() const { return File ? File->GetVertexData() : Vertices.data(); }
+	inline size_t GetVertexDataSize() const { return static_cast<size_t>(VertexCount) * VertexStride; }
+
+	// The number of indices in the index buffer, including those of every level of detail
+	inline unsigned int GetIndexCount() const { return static_cast<unsigned int>(Indices.GetCount()); }
+
+	inline size_t GetLodCount() const { return Lods.empty() ? 1 : Lods.size(); }
+	inline MeshLod GetLod(size_t level) const { return Lods.empty() ? MeshLod{ 0, GetIndexCount(), 0.0f, 0 } : Lods[level]; }
+
+	// Choose the level of detail to draw.  pixelsPerUnit is the size on screen, in pixels, of one unit of the mesh at
+	// its distance from the camera.  The coarsest level whose error would cover no more than pixelError pixels is
+	// chosen, but a coarser level than currentLevel is only chosen once its error is a fraction (hysteresis) below
+	// that, so that a mesh near the boundary between two levels does not switch between them every frame.
+	size_t SelectLod(float pixelsPerUnit, size_t currentLevel, float pixelError = 1.0f, float hysteresis = 0.25f) const;
+
+	void CalculateNormals(NormalWeighting weighting = NormalWeighting::Area, JobSystem* jobSystem = nullptr);
+
+	// Reorder the triangles and vertices for the post-transform cache, overdraw and vertex fetch (see MeshOptimiser.h)
+	void Optimise(const MeshOptimiser::Options& options = MeshOptimiser::Options());
+
+	// Build simplified levels of detail (see MeshSimplifier.h), which are added to the end of the indices.  This must
+	// be done after the mesh has been optimised, and does nothing if the mesh is too small to simplify.
+	void GenerateLods(const MeshSimplifier::Options& options = MeshSimplifier::Options());
+
+	// Write the mesh to a mesh file.  layout describes the vertex structure.
+	bool Save(const wstring& fileName, const vector<MeshVertexElement>& layout) const;
+};
+
+typedef shared_ptr<Mesh>	MeshPointer;
+
+// Process-wide registry of meshes, keyed by the generator that built them and its parameters
+// (for example "teapot size=3" or "sphere diameter=1 tessellation=32").
+//
+// Nodes ask the registry for their mesh rather than building their own buffers, so each
+// unique mesh is only generated and uploaded once however many nodes draw it.  Like the
+// ShaderCache, the registry only holds weak references; a mesh is released when the last
+// node using it is destroyed.
+//
+// Meshes are passed through the MeshOptimiser after they are built and then given levels of
+// detail, unless these are turned off with SetOptimiseMeshes and SetGenerateLods.  Vertices
+// that VertexCompression can handle are uploaded compressed unless SetCompressVertices is
+// turned off; nodes must then use the compressed input layouts and shaders.  Meshes loaded
+// from mesh files are never compressed, since their buffers are created from the mapped file.
+//
+// Buffers are created through a RenderDevice, so a RecordingRenderDevice can stand in for
+// the GPU.  Each mesh keeps a reference to the device, which therefore lives until the
+// last mesh is released.  If the registry is created without a device, meshes are built
+// but not uploaded.  This is used by the benchmarks and tools.
+
+class MeshRegistry
+{
+public:
+	// Fills in the vertices and indices of a mesh (with SetVertices and SetIndices).  The registry calculates
+	// the bounds and creates the buffers.
+	typedef function<void(Mesh&)>	Builder;
+
+	MeshRegistry(shared_ptr<RenderDevice> device);
+
+	// Returns the mesh with this key, calling builder to create it if it is not already in the registry
+	MeshPointer GetMesh(const string& key, const Builder& builder);
+
+	// Returns the mesh in a mesh file (see MeshFile.h), or nullptr if the file does not exist, is not valid or
+	// does not have the vertex layout and stride that the caller draws it with.  The buffers are created
+	// straight from the mapped file.
+	MeshPointer LoadMesh(const wstring& fileName, const vector<MeshVertexElement>& layout, uint32_t vertexStride);
+
+	// Meshes built by the functions in GeometricObject.h.  Normals are calculated.
+	MeshPointer GetBox(const Vector3& size);
+	MeshPointer GetSphere(float diameter, size_t tessellation);
+	MeshPointer GetCylinder(float height, float diameter, size_t tessellation);
+	MeshPointer GetCone(float diameter, float height, size_t tessellation);
+	MeshPointer GetTeapot(float size);
+
+	// Build a key from the name of a generator and its parameters, e.g. MakeKey("teapot", { { "size", 3.0f } })
+	static string MakeKey(const string& generator, initializer_list<pair<const char*, float>> parameters);
+
+	inline size_t GetBuildCount() const { return _buildCount; }
+	inline size_t GetLoadCount() const { return _loadCount; }
+	inline size_t GetHitCount() const { return _hitCount; }
+
+	// Only affect meshes built after they are called
+	inline void SetOptimiseMeshes(bool optimise) { _optimiseMeshes = optimise; }
+	inline void SetGenerateLods(bool generate) { _generateLods = generate; }
+	inline void SetCompressVertices(bool compress) { _compressVertices = compress; }
+
+private:
+	shared_ptr<RenderDevice>					_device;
+	unordered_map<string, weak_ptr<Mesh>>		_meshes;
+	size_t										_buildCount{ 0 };
+	size_t										_loadCount{ 0 };
+	size_t										_hitCount{ 0 };
+	bool										_optimiseMeshes{ true };
+	bool										_generateLods{ true };
+	bool										_compressVertices{ true };
+
+	void BuildBuffers(Mesh& mesh);
+};
@@ -0,0 +1,442 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimiser.h"
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+
+// Sum of squared distances to a set of weighted planes, stored as the symmetric matrix A, the vector B
+// and the constant C of the quadratic form p.A.p + 2 B.p + C
+struct Quadric
+{
+	double		A00{ 0 }, A01{ 0 }, A02{ 0 }, A11{ 0 }, A12{ 0 }, A22{ 0 };
+	double		B0{ 0 }, B1{ 0 }, B2{ 0 };
+	double		C{ 0 };
+	double		Weight{ 0 };
+
+	// Add the plane n.p + d = 0, where n has unit length
+	void AddPlane(const Vector3& n, double d, double weight)
+	{
+		A00 += weight * n.x * n.x;
+		A01 += weight * n.x * n.y;
+		A02 += weight * n.x * n.z;
+		A11 += weight * n.y * n.y;
+		A12 += weight * n.y * n.z;
+		A22 += weight * n.z * n.z;
+		B0 += weight * n.x * d;
+		B1 += weight * n.y * d;
+		B2 += weight * n.z * d;
+		C += weight * d * d;
+		Weight += weight;
+	}
+
+	Quadric& operator+=(const Quadric& other)
+	{
+		A00 += other.A00;
+		A01 += other.A01;
+		A02 += other.A02;
+		A11 += other.A11;
+		A12 += other.A12;
+		A22 += other.A22;
+		B0 += other.B0;
+		B1 += other.B1;
+		B2 += other.B2;
+		C += other.C;
+		Weight += other.Weight;
+		return *this;
+	}
+
+	// Squared distance from p to the planes, weighted by area
+	double Evaluate(const Vector3& p) const
+	{
+		double error = p.x * (A00 * p.x + 2.0 * (A01 * p.y + A02 * p.z + B0)) +
+					   p.y * (A11 * p.y + 2.0 * (A12 * p.z + B1)) +
+					   p.z * (A22 * p.z + 2.0 * B2) + C;
+		return max(error, 0.0);
+	}
+};
+
+struct EdgeCollapse
+{
+	UINT		Source;
+	UINT		Target;
+	float		Cost;
+};
+
+static inline size_t HashBytes(const uint8_t* bytes, size_t size)
+{
+	// FNV-1a
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+	}
+	return static_cast<size_t>(hash ^ (hash >> 32));
+}
+
+// Map every vertex to the first vertex whose first keySize bytes are the same, using an open addressing hash table
+static void BuildRemap(const uint8_t* vertices, size_t vertexCount, size_t stride, size_t keySize, vector<UINT>& remap)
+{
+	size_t tableSize = 1;
+	while (tableSize < vertexCount * 2)
+	{
+		tableSize *= 2;
+	}
+	vector<UINT> table(tableSize, UINT_MAX);
+	remap.resize(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		const uint8_t* key = vertices + i * stride;
+		size_t slot = HashBytes(key, keySize) & (tableSize - 1);
+		while (table[slot] != UINT_MAX && memcmp(vertices + table[slot] * stride, key, keySize) != 0)
+		{
+			slot = (slot + 1) & (tableSize - 1);
+		}
+		if (table[slot] == UINT_MAX)
+		{
+			table[slot] = static_cast<UINT>(i);
+		}
+		remap[i] = table[slot];
+	}
+}
+
+// The distinct vertices around a vertex, other than the vertex itself
+static void GatherRing(const vector<UINT>& triangles, size_t begin, size_t end, const vector<UINT>& corners, UINT centre, vector<UINT>& ring)
+{
+	ring.clear();
+	for (size_t i = begin; i < end; i++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			UINT vertex = corners[triangles[i] * 3 + k];
+			if (vertex != centre)
+			{
+				ring.push_back(vertex);
+			}
+		}
+	}
+	sort(ring.begin(), ring.end());
+	ring.erase(unique(ring.begin(), ring.end()), ring.end());
+}
+
+float MeshSimplifier::Simplify(const void* vertices, size_t vertexCount, size_t stride, const UINT* indices, size_t indexCount,
+							   size_t targetIndexCount, float targetError, vector<UINT>& simplified)
+{
+	const uint8_t* vertexBytes = static_cast<const uint8_t*>(vertices);
+	auto position = [=](UINT vertex) -> const Vector3& { return *reinterpret_cast<const Vector3*>(vertexBytes + vertex * stride); };
+
+	// Identical vertices are merged, and vertices at the same position are identified by the first of them.  A
+	// position with more than one distinct vertex is on a seam.
+	vector<UINT> vertexRemap;
+	vector<UINT> positionRemap;
+	BuildRemap(vertexBytes, vertexCount, stride, stride, vertexRemap);
+	BuildRemap(vertexBytes, vertexCount, stride, sizeof(Vector3), positionRemap);
+	vector<unsigned int> wedgeCounts(vertexCount, 0);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		if (vertexRemap[i] == i)
+		{
+			wedgeCounts[positionRemap[i]]++;
+		}
+	}
+
+	// Work on the triangles in terms of positions (corners) as well as vertices, dropping triangles that are already degenerate
+	vector<UINT> current;
+	vector<UINT> corners;
+	current.reserve(indexCount);
+	corners.reserve(indexCount);
+	for (size_t i = 0; i + 2 < indexCount; i += 3)
+	{
+		UINT p0 = positionRemap[indices[i]];
+		UINT p1 = positionRemap[indices[i + 1]];
+		UINT p2 = positionRemap[indices[i + 2]];
+		if (p0 != p1 && p1 != p2 && p2 != p0)
+		{
+			current.insert(current.end(), { vertexRemap[indices[i]], vertexRemap[indices[i + 1]], vertexRemap[indices[i + 2]] });
+			corners.insert(corners.end(), { p0, p1, p2 });
+		}
+	}
+
+	// Accumulate the planes of the triangles
+	vector<Quadric> quadrics(vertexCount);
+	for (size_t i = 0; i < corners.size(); i += 3)
+	{
+		const Vector3& p0 = position(corners[i]);
+		Vector3 normal = (position(corners[i + 1]) - p0).Cross(position(corners[i + 2]) - p0);
+		float length = normal.Length();
+		if (length > 0.0f)
+		{
+			normal /= length;
+			Quadric plane;
+			plane.AddPlane(normal, -normal.Dot(p0), length * 0.5f);
+			for (int k = 0; k < 3; k++)
+			{
+				quadrics[corners[i + k]] += plane;
+			}
+		}
+	}
+	vector<bool> locked(vertexCount, false);
+	for (UINT corner : corners)
+	{
+		locked[corner] = wedgeCounts[corner] > 1;
+	}
+
+	size_t targetTriangleCount = targetIndexCount / 3;
+	size_t triangleCount = corners.size() / 3;
+	double targetCost = static_cast<double>(targetError) * targetError;
+	double resultCost = 0.0;
+	vector<UINT> collapseRemap(vertexCount);
+	iota(collapseRemap.begin(), collapseRemap.end(), 0);
+	vector<size_t> triangleOffsets(vertexCount + 1);
+	vector<UINT> vertexTriangles;
+	vector<EdgeCollapse> candidates;
+	vector<bool> changed(vertexCount);
+	vector<UINT> sourceRing;
+	vector<UINT> targetRing;
+	vector<UINT> shared;
+	bool findBorders = true;
+	while (triangleCount > targetTriangleCount)
+	{
+		// The triangles around each position
+		fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+		for (UINT corner : corners)
+		{
+			triangleOffsets[corner + 1]++;
+		}
+		partial_sum(triangleOffsets.begin(), triangleOffsets.end(), triangleOffsets.begin());
+		vertexTriangles.resize(corners.size());
+		{
+			vector<size_t> cursors(triangleOffsets.begin(), triangleOffsets.end() - 1);
+			for (size_t i = 0; i < corners.size(); i++)
+			{
+				vertexTriangles[cursors[corners[i]]++] = static_cast<UINT>(i / 3);
+			}
+		}
+
+		// An edge is on a border if there is no triangle with the same edge the other way round.  Collapses never
+		// move border positions, so the borders only need to be found once.
+		if (findBorders)
+		{
+			for (size_t i = 0; i < corners.size(); i++)
+			{
+				UINT from = corners[i];
+				UINT to = corners[i - i % 3 + (i % 3 + 1) % 3];
+				bool matched = false;
+				for (size_t j = triangleOffsets[to]; j < triangleOffsets[to + 1] && !matched; j++)
+				{
+					const UINT* triangleCorners = &corners[vertexTriangles[j] * 3];
+					for (int k = 0; k < 3; k++)
+					{
+						matched = matched || (triangleCorners[k] == to && triangleCorners[(k + 1) % 3] == from);
+					}
+				}
+				if (!matched)
+				{
+					locked[from] = true;
+					locked[to] = true;
+				}
+			}
+			findBorders = false;
+		}
+
+		// Both directions of every edge, cheapest first.  Each edge is found from the triangle that has it in increasing order.
+		candidates.clear();
+		for (size_t i = 0; i < corners.size(); i++)
+		{
+			UINT a = corners[i];
+			UINT b = corners[i - i % 3 + (i % 3 + 1) % 3];
+			if (a < b)
+			{
+				for (int direction = 0; direction < 2; direction++)
+				{
+					UINT source = direction == 0 ? a : b;
+					UINT target = direction == 0 ? b : a;
+					if (!locked[source])
+					{
+						const Vector3& targetPosition = position(target);
+						double weight = quadrics[source].Weight + quadrics[target].Weight;
+						double cost = weight > 0.0 ? (quadrics[source].Evaluate(targetPosition) + quadrics[target].Evaluate(targetPosition)) / weight : 0.0;
+						candidates.push_back({ source, target, static_cast<float>(cost) });
+					}
+				}
+			}
+		}
+		// Each collapse removes about two triangles, and many are skipped because a neighbour has already been moved, so
+		// only the cheapest few times as many candidates as collapses are needed are sorted
+		if (candidates.empty())
+		{
+			break;
+		}
+		auto cheaper = [](const EdgeCollapse& a, const EdgeCollapse& b) { return a.Cost < b.Cost; };
+		size_t sortCount = min(candidates.size(), (triangleCount - targetTriangleCount) * 2 + 64);
+		nth_element(candidates.begin(), candidates.begin() + sortCount - 1, candidates.end(), cheaper);
+		sort(candidates.begin(), candidates.begin() + sortCount, cheaper);
+		candidates.resize(sortCount);
+
+		// Collapse the cheapest edges.  Once a position has been moved, its neighbours are left alone for the rest of
+		// the pass, so the triangles the checks below look at are always the current ones.
+		fill(changed.begin(), changed.end(), false);
+		size_t collapseCount = 0;
+		for (const EdgeCollapse& collapse : candidates)
+		{
+			if (triangleCount <= targetTriangleCount || collapse.Cost > targetCost)
+			{
+				break;
+			}
+			UINT source = collapse.Source;
+			UINT target = collapse.Target;
+			if (changed[source] || changed[target])
+			{
+				continue;
+			}
+			size_t begin = triangleOffsets[source];
+			size_t end = triangleOffsets[source + 1];
+
+			// The only positions next to both ends of the edge must be those of the triangles on the edge, or the
+			// collapse would join two sheets of the surface
+			size_t wingCount = 0;
+			UINT targetVertex = UINT_MAX;
+			bool flips = false;
+			const Vector3& targetPosition = position(target);
+			for (size_t i = begin; i < end && !flips; i++)
+			{
+				const UINT* triangleCorners = &corners[vertexTriangles[i] * 3];
+				if (triangleCorners[0] == target || triangleCorners[1] == target || triangleCorners[2] == target)
+				{
+					wingCount++;
+					for (int k = 0; k < 3; k++)
+					{
+						if (triangleCorners[k] == target)
+						{
+							targetVertex = current[vertexTriangles[i] * 3 + k];
+						}
+					}
+					continue;
+				}
+				// Moving the source must not turn the triangle over
+				Vector3 p[3];
+				for (int k = 0; k < 3; k++)
+				{
+					p[k] = position(triangleCorners[k]);
+				}
+				Vector3 before = (p[1] - p[0]).Cross(p[2] - p[0]);
+				for (int k = 0; k < 3; k++)
+				{
+					if (triangleCorners[k] == source)
+					{
+						p[k] = targetPosition;
+					}
+				}
+				Vector3 after = (p[1] - p[0]).Cross(p[2] - p[0]);
+				flips = before.Dot(after) <= 0.01f * before.Length() * after.Length();
+			}
+			if (flips || wingCount == 0)
+			{
+				continue;
+			}
+			GatherRing(vertexTriangles, begin, end, corners, source, sourceRing);
+			GatherRing(vertexTriangles, triangleOffsets[target], triangleOffsets[target + 1], corners, target, targetRing);
+			shared.clear();
+			set_intersection(sourceRing.begin(), sourceRing.end(), targetRing.begin(), targetRing.end(), back_inserter(shared));
+			if (shared.size() != wingCount)
+			{
+				continue;
+			}
+
+			// The source is not on a seam, so it is a single vertex; it takes the target's vertex on this side of any seam
+			// through the target
+			collapseRemap[source] = targetVertex;
+			quadrics[target] += quadrics[source];
+			resultCost = max(resultCost, static_cast<double>(collapse.Cost));
+			triangleCount -= wingCount;
+			collapseCount++;
+			changed[source] = true;
+			changed[target] = true;
+			for (UINT neighbour : sourceRing)
+			{
+				changed[neighbour] = true;
+			}
+		}
+		if (collapseCount == 0)
+		{
+			break;
+		}
+
+		// Move the collapsed vertices and remove the triangles that have become degenerate
+		size_t write = 0;
+		for (size_t i = 0; i < corners.size(); i += 3)
+		{
+			UINT v[3];
+			UINT p[3];
+			for (int k = 0; k < 3; k++)
+			{
+				v[k] = collapseRemap[current[i + k]];
+				p[k] = positionRemap[v[k]];
+			}
+			if (p[0] != p[1] && p[1] != p[2] && p[2] != p[0])
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					current[write + k] = v[k];
+					corners[write + k] = p[k];
+				}
+				write += 3;
+			}
+		}
+		current.resize(write);
+		corners.resize(write);
+		triangleCount = write / 3;
+	}
+	simplified.swap(current);
+	return static_cast<float>(sqrt(resultCost));
+}
+
+vector<MeshLod> MeshSimplifier::BuildLodChain(const void* vertices, size_t vertexCount, size_t stride, vector<UINT>& indices, const Options& options)
+{
+	vector<MeshLod> lods = { { 0, static_cast<uint32_t>(indices.size()), 0.0f, 0 } };
+	if (vertexCount == 0 || indices.empty())
+	{
+		return lods;
+	}
+
+	// The error limit scales with the size of the mesh
+	const uint8_t* vertexBytes = static_cast<const uint8_t*>(vertices);
+	Vector3 minimum(FLT_MAX, FLT_MAX, FLT_MAX);
+	Vector3 maximum(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		const Vector3& position = *reinterpret_cast<const Vector3*>(vertexBytes + i * stride);
+		minimum = Vector3::Min(minimum, position);
+		maximum = Vector3::Max(maximum, position);
+	}
+	float maximumError = options.MaximumError * Vector3::Distance(minimum, maximum) * 0.5f;
+
+	// Each level is simplified from the one before, which is much quicker than starting from full detail every time.
+	// The errors add up, so the error of each level is the sum of those before it.
+	vector<UINT> previous(indices);
+	vector<UINT> simplified;
+	float error = 0.0f;
+	for (unsigned int level = 0; level < options.MaximumLevels; level++)
+	{
+		size_t triangleCount = previous.size() / 3;
+		if (triangleCount < options.MinimumTriangles || error >= maximumError)
+		{
+			break;
+		}
+		size_t targetIndexCount = static_cast<size_t>(triangleCount * options.Reduction) * 3;
+		float levelError = Simplify(vertices, vertexCount, stride, previous.data(), previous.size(), targetIndexCount, maximumError - error, simplified);
+		if (simplified.empty() || simplified.size() * 4 > previous.size() * 3)
+		{
+			break;
+		}
+		MeshOptimiser::OptimiseVertexCache(simplified.data(), simplified.size(), vertexCount);
+		error += levelError;
+		lods.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplified.size()), error, 0 });
+		indices.insert(indices.end(), simplified.begin(), simplified.end());
+		previous.swap(simplified);
+	}
+	return lods;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "SimpleMath.h"
+#include "MeshFile.h"
+#include <vector>
+
+using namespace std;
+using namespace DirectX;
+using namespace SimpleMath;
+
+typedef unsigned int UINT;
+
+// Builds simplified versions of meshes for use as levels of detail.
+//
+// Simplify uses edge collapses ordered by a quadric error metric (Garland and Heckbert,
+// "Surface Simplification Using Quadric Error Metrics", 1997).  Each vertex accumulates
+// the planes of the triangles around it, weighted by area, and the cost of moving it onto
+// a neighbour is the mean squared distance from that neighbour to those planes.  Vertices
+// are only ever moved onto other existing vertices (half edge collapses), so every level
+// can share the vertex buffer of the full detail mesh and only needs its own indices.
+//
+// Vertices with the same position but different attributes (seams, such as the edges of
+// a cube's faces or a texture wrap) are never moved, although others may be moved onto
+// them; vertices on the open borders of a mesh are never moved either, so simplification
+// does not open holes or tear seams.  Collapses that would flip a triangle or join two
+// parts of the surface that were not joined are rejected.
+//
+// Collapses are made in passes.  Each pass sorts the candidate edges by cost and makes
+// the cheapest ones whose neighbourhoods have not already been changed in the same pass.
+//
+// Vertices may be of any structure that starts with its position.
+
+class MeshSimplifier
+{
+public:
+	struct Options
+	{
+		// Most levels to build, not counting full detail
+		unsigned int	MaximumLevels{ 6 };
+		// Each level aims for this fraction of the triangles in the one before
+		float			Reduction{ 0.5f };
+		// Levels stop once a mesh has fewer triangles than this, or a level removes less than a quarter of them
+		size_t			MinimumTriangles{ 64 };
+		// Largest error allowed for any level, as a fraction of the radius of the mesh's bounds
+		float			MaximumError{ 0.1f };
+	};
+
+	// Simplify a triangle list until it has no more than targetIndexCount indices or any further collapse would have
+	// an error greater than targetError.  simplified receives the new triangle list, which uses the same vertices.
+	// Returns the error of the result, as a distance in the same units as the positions.
+	static float Simplify(const void* vertices, size_t vertexCount, size_t stride, const UINT* indices, size_t indexCount,
+						  size_t targetIndexCount, float targetError, vector<UINT>& simplified);
+
+	// Append successively simpler levels of a triangle list to indices (each optimised for the vertex cache) and
+	// return the table of levels, starting with the original.  The errors in the table are cumulative.
+	static vector<MeshLod> BuildLodChain(const void* vertices, size_t vertexCount, size_t stride, vector<UINT>& indices, const Options& options);
+};
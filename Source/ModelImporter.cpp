@@ -0,0 +1,1251 @@
+#include "ModelImporter.h"
+#include "MappedFile.h"
+#include "JobSystem.h"
+#include "NormalGenerator.h"
+#include "Json.h"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <cwctype>
+#include <memory>
+
+// Run function(i) for i from 0 to count - 1, on the job system if there is one
+template <typename Function>
+static void ParallelFor(JobSystem* jobSystem, size_t count, const Function& function)
+{
+	if (jobSystem == nullptr || count <= 1)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			function(i);
+		}
+		return;
+	}
+	JobCounter counter{ 0 };
+	for (size_t i = 0; i < count; i++)
+	{
+		jobSystem->Submit([&function, i]() { function(i); }, counter);
+	}
+	jobSystem->Wait(counter);
+}
+
+static inline uint64_t MixHash(uint64_t hash)
+{
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDull;
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ull;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+// Hash of a value that is a whole number of 32 bit words
+template <typename Key>
+struct WordHasher
+{
+	inline size_t operator()(const Key& key) const
+	{
+		static_assert(sizeof(Key) % sizeof(uint32_t) == 0, "Keys must be a whole number of words");
+		uint32_t words[sizeof(Key) / sizeof(uint32_t)];
+		memcpy(words, &key, sizeof(Key));
+		uint64_t hash = 0;
+		for (uint32_t word : words)
+		{
+			hash = MixHash(hash ^ word);
+		}
+		return static_cast<size_t>(hash);
+	}
+};
+
+template <typename Key>
+struct BytewiseEqual
+{
+	inline bool operator()(const Key& a, const Key& b) const { return memcmp(&a, &b, sizeof(Key)) == 0; }
+};
+
+// Open addressing hash table that numbers unique keys in the order they are first seen.  This
+// is used to merge the corners of triangles that refer to the same vertex data.
+template <typename Key, typename Hasher = WordHasher<Key>, typename Equal = BytewiseEqual<Key>>
+class VertexTable
+{
+public:
+	VertexTable(size_t expectedCount)
+	{
+		size_t capacity = 16;
+		while (capacity < expectedCount * 2)
+		{
+			capacity *= 2;
+		}
+		_slots.assign(capacity, UINT_MAX);
+		_keys.reserve(expectedCount);
+	}
+
+	// Returns the number of the vertex with this key, adding one if there is no such vertex yet
+	UINT Insert(const Key& key)
+	{
+		size_t mask = _slots.size() - 1;
+		size_t slot = _hasher(key) & mask;
+		while (true)
+		{
+			UINT vertex = _slots[slot];
+			if (vertex == UINT_MAX)
+			{
+				vertex = static_cast<UINT>(_keys.size());
+				_keys.push_back(key);
+				_slots[slot] = vertex;
+				if (_keys.size() * 2 > _slots.size())
+				{
+					Grow();
+				}
+				return vertex;
+			}
+			if (_equal(_keys[vertex], key))
+			{
+				return vertex;
+			}
+			slot = (slot + 1) & mask;
+		}
+	}
+
+	inline const vector<Key>& GetKeys() const { return _keys; }
+
+private:
+	vector<UINT>	_slots;
+	vector<Key>		_keys;
+	Hasher			_hasher;
+	Equal			_equal;
+
+	void Grow()
+	{
+		_slots.assign(_slots.size() * 2, UINT_MAX);
+		size_t mask = _slots.size() - 1;
+		for (size_t vertex = 0; vertex < _keys.size(); vertex++)
+		{
+			size_t slot = _hasher(_keys[vertex]) & mask;
+			while (_slots[slot] != UINT_MAX)
+			{
+				slot = (slot + 1) & mask;
+			}
+			_slots[slot] = static_cast<UINT>(vertex);
+		}
+	}
+};
+
+// Calculate normals for a primitive whose file did not have them
+static void CalculatePrimitiveNormals(ImportedPrimitive& primitive)
+{
+	if (!primitive.Vertices.empty() && !primitive.Indices.empty())
+	{
+		NormalGenerator::Calculate(primitive.Vertices.data(), primitive.Vertices.size(), primitive.Indices.data(), primitive.Indices.size());
+	}
+}
+
+// Convert a transformation from right handed to left handed coordinates by negating Z before and after it
+static Matrix ToLeftHanded(Matrix transformation)
+{
+	transformation._13 = -transformation._13;
+	transformation._23 = -transformation._23;
+	transformation._31 = -transformation._31;
+	transformation._32 = -transformation._32;
+	transformation._43 = -transformation._43;
+	return transformation;
+}
+
+static wstring GetExtension(const wstring& fileName)
+{
+	size_t dot = fileName.find_last_of(L'.');
+	size_t separator = fileName.find_last_of(L"\\/");
+	if (dot == wstring::npos || (separator != wstring::npos && dot < separator))
+	{
+		return L"";
+	}
+	wstring extension = fileName.substr(dot);
+	transform(extension.begin(), extension.end(), extension.begin(), [](wchar_t c) { return static_cast<wchar_t>(towlower(c)); });
+	return extension;
+}
+
+bool ModelImporter::Import(const wstring& fileName, ImportedScene& scene, JobSystem* jobSystem)
+{
+	wstring extension = GetExtension(fileName);
+	if (extension == L".obj")
+	{
+		return ImportObj(fileName, scene, jobSystem);
+	}
+	if (extension == L".gltf" || extension == L".glb")
+	{
+		return ImportGltf(fileName, scene, jobSystem);
+	}
+	return false;
+}
+
+//--------------------------------------------------------------------------------------
+// Wavefront OBJ
+//--------------------------------------------------------------------------------------
+
+// Chunks are at least this big, so small files are not split into more jobs than they are worth
+constexpr size_t ObjMinimumChunkSize = 1 << 20;
+constexpr UINT ObjMissing = UINT_MAX;
+
+struct ObjCorner
+{
+	UINT	Position;
+	UINT	TextureCoordinate;
+	UINT	Normal;
+};
+
+// A change of group or material, which applies from the specified corner onwards
+struct ObjEvent
+{
+	size_t	Corner;
+	bool	IsMaterial;
+	string	Name;
+};
+
+struct ObjChunk
+{
+	const char*			Begin;
+	const char*			End;
+	// Counted by the first pass, and the number in the chunks before this one
+	size_t				PositionCount{ 0 };
+	size_t				TextureCoordinateCount{ 0 };
+	size_t				NormalCount{ 0 };
+	size_t				PositionBase{ 0 };
+	size_t				TextureCoordinateBase{ 0 };
+	size_t				NormalBase{ 0 };
+	// Three corners for each triangle
+	vector<ObjCorner>	Corners;
+	vector<ObjEvent>	Events;
+	bool				Valid{ true };
+};
+
+static inline bool IsSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* SkipSpaces(const char* position, const char* end)
+{
+	while (position < end && IsSpace(*position))
+	{
+		position++;
+	}
+	return position;
+}
+
+// Powers of ten that are exact in double precision
+static const double PowersOfTen[] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Parse a decimal number.  This is much faster than strtod, which has to handle the locale and round
+// exactly; the result is within a unit in the last place of the double, which is far more precise
+// than the float it is stored in.  Returns nullptr if there is no number.
+static const char* ParseFloat(const char* position, const char* end, float& value)
+{
+	bool negative = false;
+	if (position < end && (*position == '-' || *position == '+'))
+	{
+		negative = *position == '-';
+		position++;
+	}
+	uint64_t mantissa = 0;
+	int exponent = 0;
+	int digitCount = 0;
+	for (; position < end && *position >= '0' && *position <= '9'; position++, digitCount++)
+	{
+		if (mantissa < 1000000000000000000ull)
+		{
+			mantissa = mantissa * 10 + (*position - '0');
+		}
+		else
+		{
+			exponent++;
+		}
+	}
+	if (position < end && *position == '.')
+	{
+		for (position++; position < end && *position >= '0' && *position <= '9'; position++, digitCount++)
+		{
+			if (mantissa < 1000000000000000000ull)
+			{
+				mantissa = mantissa * 10 + (*position - '0');
+				exponent--;
+			}
+		}
+	}
+	if (digitCount == 0)
+	{
+		return nullptr;
+	}
+	if (position < end && (*position == 'e' || *position == 'E'))
+	{
+		const char* exponentStart = ++position;
+		bool negativeExponent = false;
+		if (position < end && (*position == '-' || *position == '+'))
+		{
+			negativeExponent = *position == '-';
+			position++;
+		}
+		int explicitExponent = 0;
+		for (; position < end && *position >= '0' && *position <= '9'; position++)
+		{
+			explicitExponent = min(explicitExponent * 10 + (*position - '0'), 1000);
+		}
+		if (position == exponentStart)
+		{
+			return nullptr;
+		}
+		exponent += negativeExponent ? -explicitExponent : explicitExponent;
+	}
+	double result = static_cast<double>(mantissa);
+	if (exponent < 0)
+	{
+		result = exponent >= -22 ? result / PowersOfTen[-exponent] : result * pow(10.0, exponent);
+	}
+	else if (exponent > 0)
+	{
+		result = exponent <= 22 ? result * PowersOfTen[exponent] : result * pow(10.0, exponent);
+	}
+	value = static_cast<float>(negative ? -result : result);
+	return position;
+}
+
+static const char* ParseInteger(const char* position, const char* end, long long& value)
+{
+	bool negative = position < end && *position == '-';
+	if (negative || (position < end && *position == '+'))
+	{
+		position++;
+	}
+	const char* start = position;
+	value = 0;
+	for (; position < end && *position >= '0' && *position <= '9'; position++)
+	{
+		value = min(value * 10 + (*position - '0'), static_cast<long long>(UINT_MAX));
+	}
+	if (position == start)
+	{
+		return nullptr;
+	}
+	if (negative)
+	{
+		value = -value;
+	}
+	return position;
+}
+
+// Convert a 1-based (or, if negative, relative) OBJ index to a 0-based index.  base is the number of
+// elements before the current chunk and count the number read so far in it.
+static inline bool ResolveObjIndex(long long index, size_t base, size_t count, size_t total, UINT& resolved)
+{
+	long long absolute = index > 0 ? index - 1 : static_cast<long long>(base + count) + index;
+	if (index == 0 || absolute < 0 || absolute >= static_cast<long long>(total))
+	{
+		return false;
+	}
+	resolved = static_cast<UINT>(absolute);
+	return true;
+}
+
+// The statement at the start of a line: "v", "vn", "f", etc.
+static inline const char* ReadKeyword(const char* position, const char* end, const char*& keywordEnd)
+{
+	position = SkipSpaces(position, end);
+	keywordEnd = position;
+	while (keywordEnd < end && !IsSpace(*keywordEnd) && *keywordEnd != '\n')
+	{
+		keywordEnd++;
+	}
+	return position;
+}
+
+static inline bool KeywordIs(const char* keyword, const char* keywordEnd, const char* expected)
+{
+	size_t length = strlen(expected);
+	return static_cast<size_t>(keywordEnd - keyword) == length && memcmp(keyword, expected, length) == 0;
+}
+
+static inline const char* FindLineEnd(const char* position, const char* end)
+{
+	const char* lineEnd = static_cast<const char*>(memchr(position, '\n', end - position));
+	return lineEnd != nullptr ? lineEnd : end;
+}
+
+// First pass: count the vertex attributes in a chunk
+static void CountObjChunk(ObjChunk& chunk)
+{
+	for (const char* line = chunk.Begin; line < chunk.End; )
+	{
+		const char* lineEnd = FindLineEnd(line, chunk.End);
+		const char* keywordEnd;
+		const char* keyword = ReadKeyword(line, lineEnd, keywordEnd);
+		if (keyword < lineEnd && *keyword == 'v')
+		{
+			size_t length = keywordEnd - keyword;
+			if (length == 1)
+			{
+				chunk.PositionCount++;
+			}
+			else if (length == 2 && keyword[1] == 'n')
+			{
+				chunk.NormalCount++;
+			}
+			else if (length == 2 && keyword[1] == 't')
+			{
+				chunk.TextureCoordinateCount++;
+			}
+		}
+		line = lineEnd + 1;
+	}
+}
+
+// Second pass: read the attributes into their final place and the faces into the chunk
+static void ParseObjChunk(ObjChunk& chunk, Vector3* positions, size_t positionCount, Vector2* textureCoordinates, size_t textureCoordinateCount,
+						  Vector3* normals, size_t normalCount)
+{
+	size_t chunkPositions = 0;
+	size_t chunkTextureCoordinates = 0;
+	size_t chunkNormals = 0;
+	vector<ObjCorner> polygon;
+	for (const char* line = chunk.Begin; line < chunk.End && chunk.Valid; )
+	{
+		const char* lineEnd = FindLineEnd(line, chunk.End);
+		const char* keywordEnd;
+		const char* keyword = ReadKeyword(line, lineEnd, keywordEnd);
+		const char* position = keywordEnd;
+		if (KeywordIs(keyword, keywordEnd, "v"))
+		{
+			Vector3& vertexPosition = positions[chunk.PositionBase + chunkPositions++];
+			position = ParseFloat(SkipSpaces(position, lineEnd), lineEnd, vertexPosition.x);
+			position = position ? ParseFloat(SkipSpaces(position, lineEnd), lineEnd, vertexPosition.y) : nullptr;
+			position = position ? ParseFloat(SkipSpaces(position, lineEnd), lineEnd, vertexPosition.z) : nullptr;
+			chunk.Valid = position != nullptr;
+			vertexPosition.z = -vertexPosition.z;
+		}
+		else if (KeywordIs(keyword, keywordEnd, "vn"))
+		{
+			Vector3& normal = normals[chunk.NormalBase + chunkNormals++];
+			position = ParseFloat(SkipSpaces(position, lineEnd), lineEnd, normal.x);
+			position = position ? ParseFloat(SkipSpaces(position, lineEnd), lineEnd, normal.y) : nullptr;
+			position = position ? ParseFloat(SkipSpaces(position, lineEnd), lineEnd, normal.z) : nullptr;
+			chunk.Valid = position != nullptr;
+			normal.z = -normal.z;
+		}
+		else if (KeywordIs(keyword, keywordEnd, "vt"))
+		{
+			// The second coordinate is optional
+			Vector2& textureCoordinate = textureCoordinates[chunk.TextureCoordinateBase + chunkTextureCoordinates++];
+			textureCoordinate.y = 0.0f;
+			position = ParseFloat(SkipSpaces(position, lineEnd), lineEnd, textureCoordinate.x);
+			chunk.Valid = position != nullptr;
+			if (position)
+			{
+				ParseFloat(SkipSpaces(position, lineEnd), lineEnd, textureCoordinate.y);
+			}
+			textureCoordinate.y = 1.0f - textureCoordinate.y;
+		}
+		else if (KeywordIs(keyword, keywordEnd, "f"))
+		{
+			// Each corner is v, v/vt, v//vn or v/vt/vn
+			polygon.clear();
+			while (chunk.Valid)
+			{
+				position = SkipSpaces(position, lineEnd);
+				if (position == lineEnd)
+				{
+					break;
+				}
+				ObjCorner corner = { ObjMissing, ObjMissing, ObjMissing };
+				long long index;
+				position = ParseInteger(position, lineEnd, index);
+				chunk.Valid = position != nullptr && ResolveObjIndex(index, chunk.PositionBase, chunkPositions, positionCount, corner.Position);
+				if (chunk.Valid && position < lineEnd && *position == '/')
+				{
+					position++;
+					if (position < lineEnd && *position != '/')
+					{
+						position = ParseInteger(position, lineEnd, index);
+						chunk.Valid = position != nullptr &&
+									  ResolveObjIndex(index, chunk.TextureCoordinateBase, chunkTextureCoordinates, textureCoordinateCount, corner.TextureCoordinate);
+					}
+					if (chunk.Valid && position < lineEnd && *position == '/')
+					{
+						position = ParseInteger(position + 1, lineEnd, index);
+						chunk.Valid = position != nullptr && ResolveObjIndex(index, chunk.NormalBase, chunkNormals, normalCount, corner.Normal);
+					}
+				}
+				polygon.push_back(corner);
+			}
+			chunk.Valid = chunk.Valid && polygon.size() >= 3;
+			for (size_t i = 2; i < polygon.size() && chunk.Valid; i++)
+			{
+				chunk.Corners.insert(chunk.Corners.end(), { polygon[0], polygon[i - 1], polygon[i] });
+			}
+		}
+		else if (KeywordIs(keyword, keywordEnd, "o") || KeywordIs(keyword, keywordEnd, "g") || KeywordIs(keyword, keywordEnd, "usemtl"))
+		{
+			const char* nameStart = SkipSpaces(position, lineEnd);
+			const char* nameEnd = lineEnd;
+			while (nameEnd > nameStart && IsSpace(nameEnd[-1]))
+			{
+				nameEnd--;
+			}
+			chunk.Events.push_back({ chunk.Corners.size(), *keyword == 'u', string(nameStart, nameEnd) });
+		}
+		// Everything else (comments, mtllib, smoothing groups, lines, points) is ignored
+		line = lineEnd + 1;
+	}
+}
+
+// The corners of one primitive, which may be spread over several chunks
+struct ObjPrimitiveRanges
+{
+	vector<pair<const ObjCorner*, size_t>>	Ranges;
+	size_t									CornerCount{ 0 };
+};
+
+static void BuildObjPrimitive(const ObjPrimitiveRanges& ranges, const vector<Vector3>& positions, const vector<Vector2>& textureCoordinates,
+							  const vector<Vector3>& normals, ImportedPrimitive& primitive)
+{
+	VertexTable<ObjCorner> table(ranges.CornerCount / 2);
+	primitive.Indices.reserve(ranges.CornerCount);
+	bool hasNormals = true;
+	for (const auto& range : ranges.Ranges)
+	{
+		for (size_t i = 0; i < range.second; i++)
+		{
+			const ObjCorner& corner = range.first[i];
+			hasNormals &= corner.Normal != ObjMissing;
+			primitive.Indices.push_back(table.Insert(corner));
+		}
+	}
+	const vector<ObjCorner>& corners = table.GetKeys();
+	primitive.Vertices.resize(corners.size());
+	for (size_t i = 0; i < corners.size(); i++)
+	{
+		ObjectVertexStruct& vertex = primitive.Vertices[i];
+		vertex.Position = positions[corners[i].Position];
+		vertex.Normal = corners[i].Normal != ObjMissing ? normals[corners[i].Normal] : Vector3(0, 0, 0);
+		vertex.TextureCoordinate = corners[i].TextureCoordinate != ObjMissing ? textureCoordinates[corners[i].TextureCoordinate] : Vector2(0, 0);
+	}
+	if (!hasNormals)
+	{
+		CalculatePrimitiveNormals(primitive);
+	}
+}
+
+bool ModelImporter::ImportObj(const wstring& fileName, ImportedScene& scene, JobSystem* jobSystem)
+{
+	scene = ImportedScene();
+	MappedFile file;
+	if (!file.Open(fileName))
+	{
+		return false;
+	}
+	const char* text = reinterpret_cast<const char*>(file.GetData());
+	size_t size = file.GetSize();
+
+	// Split the file into chunks that end at the end of a line
+	size_t threadCount = jobSystem != nullptr ? jobSystem->GetThreadCount() : 1;
+	size_t chunkCount = max<size_t>(1, min(threadCount * 4, size / ObjMinimumChunkSize));
+	vector<ObjChunk> chunks;
+	const char* chunkBegin = text;
+	for (size_t i = 1; i <= chunkCount && chunkBegin < text + size; i++)
+	{
+		const char* chunkEnd = text + size * i / chunkCount;
+		chunkEnd = i == chunkCount ? text + size : min(FindLineEnd(max(chunkEnd, chunkBegin), text + size) + 1, text + size);
+		ObjChunk chunk;
+		chunk.Begin = chunkBegin;
+		chunk.End = chunkEnd;
+		chunks.push_back(move(chunk));
+		chunkBegin = chunkEnd;
+	}
+
+	ParallelFor(jobSystem, chunks.size(), [&](size_t i) { CountObjChunk(chunks[i]); });
+	size_t positionCount = 0;
+	size_t textureCoordinateCount = 0;
+	size_t normalCount = 0;
+	for (ObjChunk& chunk : chunks)
+	{
+		chunk.PositionBase = positionCount;
+		chunk.TextureCoordinateBase = textureCoordinateCount;
+		chunk.NormalBase = normalCount;
+		positionCount += chunk.PositionCount;
+		textureCoordinateCount += chunk.TextureCoordinateCount;
+		normalCount += chunk.NormalCount;
+	}
+
+	vector<Vector3> positions(positionCount);
+	vector<Vector2> textureCoordinates(textureCoordinateCount);
+	vector<Vector3> normals(normalCount);
+	ParallelFor(jobSystem, chunks.size(), [&](size_t i)
+		{
+			ParseObjChunk(chunks[i], positions.data(), positionCount, textureCoordinates.data(), textureCoordinateCount, normals.data(), normalCount);
+		});
+	for (const ObjChunk& chunk : chunks)
+	{
+		if (!chunk.Valid)
+		{
+			return false;
+		}
+	}
+
+	// Split the triangles into meshes at each group and into primitives at each change of material
+	vector<ObjPrimitiveRanges> primitiveRanges;
+	vector<pair<size_t, size_t>> primitiveMeshes;
+	string group;
+	string material;
+	bool startMesh = true;
+	bool startPrimitive = true;
+	auto addCorners = [&](const ObjCorner* corners, size_t count)
+		{
+			if (count == 0)
+			{
+				return;
+			}
+			if (startMesh)
+			{
+				scene.Meshes.emplace_back();
+				scene.Meshes.back().Name = group.empty() ? "Mesh" + to_string(scene.Meshes.size() - 1) : group;
+				startMesh = false;
+				startPrimitive = true;
+			}
+			if (startPrimitive)
+			{
+				ImportedMesh& mesh = scene.Meshes.back();
+				mesh.Primitives.emplace_back();
+				mesh.Primitives.back().Material = material;
+				primitiveRanges.emplace_back();
+				primitiveMeshes.emplace_back(scene.Meshes.size() - 1, mesh.Primitives.size() - 1);
+				startPrimitive = false;
+			}
+			primitiveRanges.back().Ranges.emplace_back(corners, count);
+			primitiveRanges.back().CornerCount += count;
+		};
+	for (const ObjChunk& chunk : chunks)
+	{
+		size_t corner = 0;
+		for (const ObjEvent& event : chunk.Events)
+		{
+			addCorners(chunk.Corners.data() + corner, event.Corner - corner);
+			corner = event.Corner;
+			if (event.IsMaterial)
+			{
+				startPrimitive = startPrimitive || event.Name != material;
+				material = event.Name;
+			}
+			else
+			{
+				startMesh = true;
+				group = event.Name;
+			}
+		}
+		addCorners(chunk.Corners.data() + corner, chunk.Corners.size() - corner);
+	}
+
+	// Build the vertices of each primitive in parallel
+	ParallelFor(jobSystem, primitiveRanges.size(), [&](size_t i)
+		{
+			ImportedPrimitive& primitive = scene.Meshes[primitiveMeshes[i].first].Primitives[primitiveMeshes[i].second];
+			BuildObjPrimitive(primitiveRanges[i], positions, textureCoordinates, normals, primitive);
+		});
+
+	// OBJ files have no hierarchy, so every mesh gets a node of its own
+	for (size_t i = 0; i < scene.Meshes.size(); i++)
+	{
+		ImportedNode node;
+		node.Name = scene.Meshes[i].Name;
+		node.Mesh = static_cast<int>(i);
+		scene.Roots.push_back(static_cast<int>(scene.Nodes.size()));
+		scene.Nodes.push_back(move(node));
+	}
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// glTF 2.0
+//--------------------------------------------------------------------------------------
+
+constexpr uint32_t GlbMagic = 0x46546C67;			// "glTF"
+constexpr uint32_t GlbJsonChunk = 0x4E4F534A;		// "JSON"
+constexpr uint32_t GlbBinaryChunk = 0x004E4942;		// "BIN"
+
+constexpr int GltfUnsignedByte = 5121;
+constexpr int GltfUnsignedShort = 5123;
+constexpr int GltfUnsignedInt = 5125;
+constexpr int GltfFloat = 5126;
+constexpr int GltfTriangles = 4;
+
+struct GltfBuffer
+{
+	const uint8_t*		Data{ nullptr };
+	size_t				Size{ 0 };
+};
+
+// An accessor resolved to a pointer into its buffer
+struct GltfAccessor
+{
+	const uint8_t*		Data{ nullptr };
+	size_t				Count{ 0 };
+	size_t				Stride{ 0 };
+	int					ComponentType{ 0 };
+	int					ComponentCount{ 0 };
+	bool				Normalized{ false };
+
+	float ReadComponent(size_t element, int component) const
+	{
+		const uint8_t* value = Data + element * Stride;
+		switch (ComponentType)
+		{
+			case GltfFloat:
+			{
+				float result;
+				memcpy(&result, value + component * sizeof(float), sizeof(float));
+				return result;
+			}
+			case GltfUnsignedByte:
+				return Normalized ? value[component] / 255.0f : value[component];
+
+			case GltfUnsignedShort:
+			{
+				uint16_t result;
+				memcpy(&result, value + component * sizeof(uint16_t), sizeof(uint16_t));
+				return Normalized ? result / 65535.0f : result;
+			}
+		}
+		return 0.0f;
+	}
+
+	UINT ReadIndex(size_t element) const
+	{
+		const uint8_t* value = Data + element * Stride;
+		switch (ComponentType)
+		{
+			case GltfUnsignedByte:
+				return *value;
+
+			case GltfUnsignedShort:
+			{
+				uint16_t index;
+				memcpy(&index, value, sizeof(index));
+				return index;
+			}
+			case GltfUnsignedInt:
+			{
+				uint32_t index;
+				memcpy(&index, value, sizeof(index));
+				return index;
+			}
+		}
+		return UINT_MAX;
+	}
+};
+
+// Everything that has to stay alive while the primitives are read
+struct GltfDocument
+{
+	MappedFile							File;
+	vector<unique_ptr<MappedFile>>		ExternalFiles;
+	vector<vector<uint8_t>>				EmbeddedData;
+	JsonValue							Json;
+	vector<GltfBuffer>					Buffers;
+};
+
+// glTF objects refer to each other by index.  Missing or invalid indices give SIZE_MAX, which
+// looks up a null value
+static size_t GetIndex(const JsonValue& value)
+{
+	double index = value.GetNumber(-1.0);
+	return index >= 0.0 && index < 4294967296.0 && index == floor(index) ? static_cast<size_t>(index) : SIZE_MAX;
+}
+
+// Offsets, lengths and counts must be whole numbers that are not negative and fit in a size_t.  Anything else
+// (including a value that is not a number) fails, so that it cannot wrap around when it is converted.  Missing
+// values give defaultValue.
+static bool GetSize(const JsonValue& value, size_t defaultValue, size_t& size)
+{
+	if (value.IsNull())
+	{
+		size = defaultValue;
+		return true;
+	}
+	double number = value.GetNumber(-1.0);
+	if (!(number >= 0.0 && number <= 9007199254740992.0 && number <= static_cast<double>(SIZE_MAX)) || number != floor(number))
+	{
+		return false;
+	}
+	size = static_cast<size_t>(number);
+	return true;
+}
+
+static size_t GetComponentSize(int componentType)
+{
+	switch (componentType)
+	{
+		case GltfUnsignedByte:
+			return 1;
+		case GltfUnsignedShort:
+			return 2;
+		case GltfUnsignedInt:
+		case GltfFloat:
+			return 4;
+	}
+	return 0;
+}
+
+static int GetComponentCount(const string& type)
+{
+	if (type == "SCALAR")
+	{
+		return 1;
+	}
+	if (type == "VEC2")
+	{
+		return 2;
+	}
+	if (type == "VEC3")
+	{
+		return 3;
+	}
+	if (type == "VEC4")
+	{
+		return 4;
+	}
+	return 0;
+}
+
+static bool DecodeBase64(const char* text, size_t length, vector<uint8_t>& data)
+{
+	data.clear();
+	data.reserve(length * 3 / 4);
+	uint32_t bits = 0;
+	int bitCount = 0;
+	for (size_t i = 0; i < length && text[i] != '='; i++)
+	{
+		char c = text[i];
+		int value = c >= 'A' && c <= 'Z' ? c - 'A' :
+					c >= 'a' && c <= 'z' ? c - 'a' + 26 :
+					c >= '0' && c <= '9' ? c - '0' + 52 :
+					c == '+' ? 62 : c == '/' ? 63 : -1;
+		if (value < 0)
+		{
+			return false;
+		}
+		bits = (bits << 6) | value;
+		bitCount += 6;
+		if (bitCount >= 8)
+		{
+			bitCount -= 8;
+			data.push_back(static_cast<uint8_t>(bits >> bitCount));
+		}
+	}
+	return true;
+}
+
+// Turn a relative URI into a file name in the same directory as the glTF file
+static wstring ResolveUri(const wstring& fileName, const string& uri)
+{
+	wstring resolved = fileName.substr(0, fileName.find_last_of(L"\\/") + 1);
+	for (size_t i = 0; i < uri.size(); i++)
+	{
+		// Percent encoded characters (usually spaces)
+		if (uri[i] == '%' && i + 2 < uri.size() && isxdigit(static_cast<unsigned char>(uri[i + 1])) && isxdigit(static_cast<unsigned char>(uri[i + 2])))
+		{
+			resolved += static_cast<wchar_t>(stoi(uri.substr(i + 1, 2), nullptr, 16));
+			i += 2;
+		}
+		else
+		{
+			resolved += static_cast<wchar_t>(static_cast<unsigned char>(uri[i]));
+		}
+	}
+	return resolved;
+}
+
+static bool LoadGltfBuffers(const wstring& fileName, GltfDocument& document, const GltfBuffer& binaryChunk)
+{
+	const JsonValue& buffers = document.Json["buffers"];
+	for (size_t i = 0; i < buffers.GetSize(); i++)
+	{
+		const JsonValue& buffer = buffers[i];
+		const string& uri = buffer["uri"].GetString();
+		GltfBuffer data;
+		if (buffer["uri"].IsNull())
+		{
+			// The binary chunk of a .glb file
+			data = binaryChunk;
+		}
+		else if (uri.compare(0, 5, "data:") == 0)
+		{
+			size_t comma = uri.find(";base64,");
+			if (comma == string::npos)
+			{
+				return false;
+			}
+			document.EmbeddedData.emplace_back();
+			if (!DecodeBase64(uri.data() + comma + 8, uri.size() - comma - 8, document.EmbeddedData.back()))
+			{
+				return false;
+			}
+			data.Data = document.EmbeddedData.back().data();
+			data.Size = document.EmbeddedData.back().size();
+		}
+		else
+		{
+			document.ExternalFiles.push_back(make_unique<MappedFile>());
+			if (!document.ExternalFiles.back()->Open(ResolveUri(fileName, uri)))
+			{
+				return false;
+			}
+			data.Data = document.ExternalFiles.back()->GetData();
+			data.Size = document.ExternalFiles.back()->GetSize();
+		}
+		size_t byteLength;
+		if (data.Data == nullptr || !GetSize(buffer["byteLength"], SIZE_MAX, byteLength) || byteLength > data.Size)
+		{
+			return false;
+		}
+		data.Size = byteLength;
+		document.Buffers.push_back(data);
+	}
+	return true;
+}
+
+// Resolve an accessor to a pointer into its buffer, checking that every element is inside the buffer view
+static bool GetGltfAccessor(const GltfDocument& document, const JsonValue& index, GltfAccessor& accessor)
+{
+	const JsonValue& description = document.Json["accessors"][GetIndex(index)];
+	// Accessors without a buffer view (all zeroes) and sparse accessors are not supported
+	const JsonValue& view = document.Json["bufferViews"][GetIndex(description["bufferView"])];
+	if (!description.IsObject() || !view.IsObject() || !description["sparse"].IsNull())
+	{
+		return false;
+	}
+	size_t bufferIndex = GetIndex(view["buffer"]);
+	if (bufferIndex >= document.Buffers.size())
+	{
+		return false;
+	}
+	const GltfBuffer& buffer = document.Buffers[bufferIndex];
+	size_t viewOffset;
+	size_t viewLength;
+	if (!GetSize(view["byteOffset"], 0, viewOffset) || !GetSize(view["byteLength"], SIZE_MAX, viewLength) ||
+		viewOffset > buffer.Size || viewLength > buffer.Size - viewOffset)
+	{
+		return false;
+	}
+
+	size_t componentType;
+	if (!GetSize(description["componentType"], 0, componentType) || !GetSize(description["count"], SIZE_MAX, accessor.Count))
+	{
+		return false;
+	}
+	accessor.ComponentType = static_cast<int>(min(componentType, static_cast<size_t>(INT_MAX)));
+	accessor.ComponentCount = GetComponentCount(description["type"].GetString());
+	accessor.Normalized = description["normalized"].GetBoolean();
+	size_t elementSize = GetComponentSize(accessor.ComponentType) * accessor.ComponentCount;
+	size_t offset;
+	if (!GetSize(view["byteStride"], elementSize, accessor.Stride) || !GetSize(description["byteOffset"], 0, offset) ||
+		elementSize == 0 || accessor.Stride < elementSize || offset > viewLength)
+	{
+		return false;
+	}
+	if (accessor.Count > 0 && (accessor.Count - 1 > (viewLength - offset) / accessor.Stride || (accessor.Count - 1) * accessor.Stride + elementSize > viewLength - offset))
+	{
+		return false;
+	}
+	accessor.Data = buffer.Data + viewOffset + offset;
+	return true;
+}
+
+static bool ReadGltfPrimitive(const GltfDocument& document, const JsonValue& description, ImportedPrimitive& primitive)
+{
+	const JsonValue& attributes = description["attributes"];
+	GltfAccessor positions;
+	GltfAccessor normals;
+	GltfAccessor textureCoordinates;
+	if (!GetGltfAccessor(document, attributes["POSITION"], positions) || positions.ComponentType != GltfFloat || positions.ComponentCount != 3)
+	{
+		return false;
+	}
+	bool hasNormals = !attributes["NORMAL"].IsNull();
+	bool hasTextureCoordinates = !attributes["TEXCOORD_0"].IsNull();
+	if ((hasNormals && (!GetGltfAccessor(document, attributes["NORMAL"], normals) || normals.Count != positions.Count || normals.ComponentType != GltfFloat || normals.ComponentCount != 3)) ||
+		(hasTextureCoordinates && (!GetGltfAccessor(document, attributes["TEXCOORD_0"], textureCoordinates) || textureCoordinates.Count != positions.Count || textureCoordinates.ComponentCount != 2)))
+	{
+		return false;
+	}
+
+	// Exporters often write a separate copy of a vertex for every triangle that uses it, so identical
+	// vertices are merged
+	VertexTable<ObjectVertexStruct> table(positions.Count);
+	vector<UINT> remap(positions.Count);
+	for (size_t i = 0; i < positions.Count; i++)
+	{
+		ObjectVertexStruct vertex;
+		vertex.Position = Vector3(positions.ReadComponent(i, 0), positions.ReadComponent(i, 1), -positions.ReadComponent(i, 2));
+		vertex.Normal = hasNormals ? Vector3(normals.ReadComponent(i, 0), normals.ReadComponent(i, 1), -normals.ReadComponent(i, 2)) : Vector3(0, 0, 0);
+		vertex.TextureCoordinate = hasTextureCoordinates ? Vector2(textureCoordinates.ReadComponent(i, 0), textureCoordinates.ReadComponent(i, 1)) : Vector2(0, 0);
+		remap[i] = table.Insert(vertex);
+	}
+	primitive.Vertices = table.GetKeys();
+
+	if (description["indices"].IsNull())
+	{
+		primitive.Indices = remap;
+	}
+	else
+	{
+		GltfAccessor indices;
+		if (!GetGltfAccessor(document, description["indices"], indices) || indices.ComponentCount != 1)
+		{
+			return false;
+		}
+		primitive.Indices.resize(indices.Count);
+		for (size_t i = 0; i < indices.Count; i++)
+		{
+			UINT index = indices.ReadIndex(i);
+			if (index >= remap.size())
+			{
+				return false;
+			}
+			primitive.Indices[i] = remap[index];
+		}
+	}
+	if (primitive.Indices.size() % 3 != 0)
+	{
+		return false;
+	}
+	if (!hasNormals)
+	{
+		CalculatePrimitiveNormals(primitive);
+	}
+	return true;
+}
+
+// Read an array of numbers, leaving the defaults in values if the array is missing or the wrong size
+static void ReadGltfNumbers(const JsonValue& array, float* values, size_t count)
+{
+	if (array.GetSize() == count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			values[i] = static_cast<float>(array[i].GetNumber(values[i]));
+		}
+	}
+}
+
+static Matrix ReadGltfTransformation(const JsonValue& node)
+{
+	if (!node["matrix"].IsNull())
+	{
+		// glTF matrices are column major and transform column vectors, so read in order they are the row
+		// major, row vector matrices that SimpleMath uses
+		float elements[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+		ReadGltfNumbers(node["matrix"], elements, 16);
+		return ToLeftHanded(Matrix(elements));
+	}
+	float translation[3] = { 0, 0, 0 };
+	float rotation[4] = { 0, 0, 0, 1 };
+	float scale[3] = { 1, 1, 1 };
+	ReadGltfNumbers(node["translation"], translation, 3);
+	ReadGltfNumbers(node["rotation"], rotation, 4);
+	ReadGltfNumbers(node["scale"], scale, 3);
+	Matrix transformation = Matrix::CreateScale(scale[0], scale[1], scale[2]) *
+							Matrix::CreateFromQuaternion(Quaternion(rotation[0], rotation[1], rotation[2], rotation[3])) *
+							Matrix::CreateTranslation(translation[0], translation[1], translation[2]);
+	return ToLeftHanded(transformation);
+}
+
+// Check that the nodes form a forest (every node has at most one parent and there are no cycles), so
+// that building a scene graph from them terminates
+static bool IsForest(const vector<ImportedNode>& nodes, const vector<int>& roots)
+{
+	vector<int> parentCounts(nodes.size(), 0);
+	for (const ImportedNode& node : nodes)
+	{
+		for (int child : node.Children)
+		{
+			if (child < 0 || child >= static_cast<int>(nodes.size()) || ++parentCounts[child] > 1)
+			{
+				return false;
+			}
+		}
+	}
+	vector<bool> visited(nodes.size(), false);
+	vector<int> stack;
+	for (int root : roots)
+	{
+		if (root < 0 || root >= static_cast<int>(nodes.size()) || parentCounts[root] != 0)
+		{
+			return false;
+		}
+		stack.push_back(root);
+	}
+	while (!stack.empty())
+	{
+		int node = stack.back();
+		stack.pop_back();
+		if (visited[node])
+		{
+			return false;
+		}
+		visited[node] = true;
+		stack.insert(stack.end(), nodes[node].Children.begin(), nodes[node].Children.end());
+	}
+	return true;
+}
+
+bool ModelImporter::ImportGltf(const wstring& fileName, ImportedScene& scene, JobSystem* jobSystem)
+{
+	scene = ImportedScene();
+	GltfDocument document;
+	if (!document.File.Open(fileName))
+	{
+		return false;
+	}
+	const uint8_t* data = document.File.GetData();
+	size_t size = document.File.GetSize();
+
+	// A .glb file is a header followed by a JSON chunk and an optional binary chunk
+	const char* json = reinterpret_cast<const char*>(data);
+	size_t jsonLength = size;
+	GltfBuffer binaryChunk;
+	uint32_t header[3];
+	if (size >= sizeof(header) && (memcpy(header, data, sizeof(header)), header[0] == GlbMagic))
+	{
+		if (header[1] != 2 || header[2] > size)
+		{
+			return false;
+		}
+		size_t offset = sizeof(header);
+		jsonLength = 0;
+		while (offset + 8 <= header[2])
+		{
+			uint32_t chunk[2];
+			memcpy(chunk, data + offset, sizeof(chunk));
+			offset += sizeof(chunk);
+			if (chunk[0] > header[2] - offset)
+			{
+				return false;
+			}
+			if (chunk[1] == GlbJsonChunk && jsonLength == 0)
+			{
+				json = reinterpret_cast<const char*>(data + offset);
+				jsonLength = chunk[0];
+			}
+			else if (chunk[1] == GlbBinaryChunk && binaryChunk.Data == nullptr)
+			{
+				binaryChunk.Data = data + offset;
+				binaryChunk.Size = chunk[0];
+			}
+			offset += (chunk[0] + 3) & ~3u;
+		}
+	}
+	if (!JsonValue::Parse(json, jsonLength, document.Json) || !LoadGltfBuffers(fileName, document, binaryChunk))
+	{
+		return false;
+	}
+
+	// Read the triangle list primitives of every mesh, in parallel
+	const JsonValue& meshes = document.Json["meshes"];
+	const JsonValue& materials = document.Json["materials"];
+	vector<pair<size_t, const JsonValue*>> primitives;
+	scene.Meshes.resize(meshes.GetSize());
+	for (size_t i = 0; i < meshes.GetSize(); i++)
+	{
+		ImportedMesh& mesh = scene.Meshes[i];
+		mesh.Name = meshes[i]["name"].GetString();
+		if (mesh.Name.empty())
+		{
+			mesh.Name = "Mesh" + to_string(i);
+		}
+		const JsonValue& meshPrimitives = meshes[i]["primitives"];
+		for (size_t j = 0; j < meshPrimitives.GetSize(); j++)
+		{
+			if (meshPrimitives[j]["mode"].GetNumber(GltfTriangles) == GltfTriangles)
+			{
+				mesh.Primitives.emplace_back();
+				mesh.Primitives.back().Material = materials[GetIndex(meshPrimitives[j]["material"])]["name"].GetString();
+				primitives.emplace_back(i, &meshPrimitives[j]);
+			}
+		}
+	}
+	vector<ImportedPrimitive*> targets;
+	for (ImportedMesh& mesh : scene.Meshes)
+	{
+		for (ImportedPrimitive& primitive : mesh.Primitives)
+		{
+			targets.push_back(&primitive);
+		}
+	}
+	vector<char> read(primitives.size(), 0);
+	ParallelFor(jobSystem, primitives.size(), [&](size_t i) { read[i] = ReadGltfPrimitive(document, *primitives[i].second, *targets[i]); });
+	if (find(read.begin(), read.end(), 0) != read.end())
+	{
+		return false;
+	}
+
+	// The node hierarchy of the default scene
+	const JsonValue& nodes = document.Json["nodes"];
+	scene.Nodes.resize(nodes.GetSize());
+	for (size_t i = 0; i < nodes.GetSize(); i++)
+	{
+		ImportedNode& node = scene.Nodes[i];
+		node.Name = nodes[i]["name"].GetString();
+		if (node.Name.empty())
+		{
+			node.Name = "Node" + to_string(i);
+		}
+		node.Transformation = ReadGltfTransformation(nodes[i]);
+		size_t mesh = GetIndex(nodes[i]["mesh"]);
+		if (!nodes[i]["mesh"].IsNull() && mesh >= scene.Meshes.size())
+		{
+			return false;
+		}
+		node.Mesh = nodes[i]["mesh"].IsNull() ? -1 : static_cast<int>(mesh);
+		const JsonValue& children = nodes[i]["children"];
+		for (size_t j = 0; j < children.GetSize(); j++)
+		{
+			size_t child = GetIndex(children[j]);
+			node.Children.push_back(child < scene.Nodes.size() ? static_cast<int>(child) : -1);
+		}
+	}
+	const JsonValue& scenes = document.Json["scenes"];
+	if (scenes.GetSize() > 0)
+	{
+		const JsonValue& roots = scenes[document.Json["scene"].IsNull() ? 0 : GetIndex(document.Json["scene"])]["nodes"];
+		for (size_t i = 0; i < roots.GetSize(); i++)
+		{
+			size_t root = GetIndex(roots[i]);
+			scene.Roots.push_back(root < scene.Nodes.size() ? static_cast<int>(root) : -1);
+		}
+	}
+	else
+	{
+		// Without a scene, every node that is not a child of another is a root
+		vector<bool> isChild(scene.Nodes.size(), false);
+		for (const ImportedNode& node : scene.Nodes)
+		{
+			for (int child : node.Children)
+			{
+				if (child >= 0 && child < static_cast<int>(isChild.size()))
+				{
+					isChild[child] = true;
+				}
+			}
+		}
+		for (size_t i = 0; i < scene.Nodes.size(); i++)
+		{
+			if (!isChild[i])
+			{
+				scene.Roots.push_back(static_cast<int>(i));
+			}
+		}
+	}
+	return IsForest(scene.Nodes, scene.Roots);
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "ShaderTypes.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class JobSystem;
+
+typedef unsigned int UINT;
+
+// Part of a mesh that is drawn with one material
+struct ImportedPrimitive
+{
+	vector<ObjectVertexStruct>		Vertices;
+	vector<UINT>					Indices;
+	string							Material;
+};
+
+struct ImportedMesh
+{
+	string							Name;
+	vector<ImportedPrimitive>		Primitives;
+};
+
+struct ImportedNode
+{
+	string							Name;
+	// Relative to the parent node
+	Matrix							Transformation;
+	// Index into ImportedScene::Meshes, or -1 if the node has no mesh
+	int								Mesh{ -1 };
+	vector<int>						Children;
+};
+
+// The contents of a model file.  Nodes refer to meshes and to each other by index.
+struct ImportedScene
+{
+	vector<ImportedMesh>			Meshes;
+	vector<ImportedNode>			Nodes;
+	vector<int>						Roots;
+};
+
+// Imports Wavefront OBJ and glTF 2.0 (.gltf and .glb) files.
+//
+// OBJ files are memory mapped and split into chunks at line boundaries.  The chunks are
+// parsed in parallel on the job system: a first pass counts the positions, normals and
+// texture coordinates in each chunk so that a second pass can resolve relative indices
+// and write every attribute straight to its final place.  Each "o" or "g" statement
+// starts a new mesh (and node) and each "usemtl" a new primitive, and polygons are
+// triangulated as fans.
+//
+// glTF buffers are memory mapped too (the binary chunk of a .glb file, or the .bin files
+// a .gltf file refers to), and accessors are read through their buffer views in place.
+// Only triangle list primitives are imported; the node hierarchy and transformations of
+// the default scene are kept.
+//
+// Either way, corners that refer to the same data are merged into one vertex through a
+// hash table, and normals are calculated for primitives that do not have them.  Both
+// formats use right handed coordinates, so Z is negated (which also turns the
+// anticlockwise front faces clockwise) and OBJ texture coordinates are flipped vertically
+// to match Direct3D.
+
+class ModelImporter
+{
+public:
+	// Import a file, choosing the format from its extension.  Returns false if the file cannot be read or is
+	// not valid.  If jobSystem is not null, the work is spread across its threads.
+	static bool Import(const wstring& fileName, ImportedScene& scene, JobSystem* jobSystem = nullptr);
+
+	static bool ImportObj(const wstring& fileName, ImportedScene& scene, JobSystem* jobSystem = nullptr);
+	static bool ImportGltf(const wstring& fileName, ImportedScene& scene, JobSystem* jobSystem = nullptr);
+};
@@ -0,0 +1,441 @@
+#include "NormalGenerator.h"
+#include "JobSystem.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+// Number of triangles or vertices processed by each job
+constexpr size_t JobSize = 16384;
+
+constexpr float Pi = 3.14159265f;
+
+// The triangle normal kernel is written once against these small wrappers, so the same code
+// is used for each instruction set.  Width is the number of triangles processed at once.
+
+struct ScalarOps
+{
+	typedef float	Vector;
+	typedef bool	Mask;
+	static constexpr size_t Width = 1;
+
+	static inline Vector Splat(float value) { return value; }
+	static inline Vector Add(Vector a, Vector b) { return a + b; }
+	static inline Vector Subtract(Vector a, Vector b) { return a - b; }
+	static inline Vector Multiply(Vector a, Vector b) { return a * b; }
+	static inline Vector MultiplyAdd(Vector a, Vector b, Vector c) { return a * b + c; }
+	static inline Vector Divide(Vector a, Vector b) { return a / b; }
+	static inline Vector Sqrt(Vector a) { return sqrtf(a); }
+	static inline Vector Min(Vector a, Vector b) { return a < b ? a : b; }
+	static inline Vector Max(Vector a, Vector b) { return a > b ? a : b; }
+	static inline Vector Abs(Vector a) { return fabsf(a); }
+	static inline Mask Less(Vector a, Vector b) { return a < b; }
+	static inline Vector Select(Mask mask, Vector a, Vector b) { return mask ? a : b; }
+
+	// acos using the approximation from Abramowitz and Stegun (4.4.45), accurate to about 7e-5
+	// radians.  That is plenty for weighting normals and is much cheaper than acos.
+	static inline Vector Acos(Vector x)
+	{
+		Vector t = Abs(x);
+		Vector polynomial = MultiplyAdd(MultiplyAdd(MultiplyAdd(Splat(-0.0187293f), t, Splat(0.0742610f)), t, Splat(-0.2121144f)), t, Splat(1.5707288f));
+		Vector result = Multiply(Sqrt(Subtract(Splat(1.0f), t)), polynomial);
+		return Select(Less(x, Splat(0.0f)), Subtract(Splat(Pi), result), result);
+	}
+
+	// The angle between two vectors, given their dot product and squared lengths
+	static inline Vector Angle(Vector dot, Vector lengthSquaredA, Vector lengthSquaredB)
+	{
+		Vector cosine = Divide(dot, Sqrt(Max(Multiply(lengthSquaredA, lengthSquaredB), Splat(FLT_MIN))));
+		return Acos(Min(Max(cosine, Splat(-1.0f)), Splat(1.0f)));
+	}
+	// Store x, y, z and w of each lane as four consecutive floats
+	static inline void StoreInterleaved(float* destination, Vector x, Vector y, Vector z, Vector w)
+	{
+		destination[0] = x;
+		destination[1] = y;
+		destination[2] = z;
+		destination[3] = w;
+	}
+
+	// Load one corner of each triangle.  indices points to the first index of the first triangle plus the corner.
+	static inline void LoadCorner(const uint8_t* positions, size_t stride, const UINT* indices, Vector& x, Vector& y, Vector& z)
+	{
+		const float* position = reinterpret_cast<const float*>(positions + indices[0] * stride);
+		x = position[0];
+		y = position[1];
+		z = position[2];
+	}
+};
+
+#if defined(SIMD_SSE)
+struct SseOps
+{
+	typedef __m128	Vector;
+	typedef __m128	Mask;
+	static constexpr size_t Width = 4;
+
+	static inline Vector Splat(float value) { return _mm_set1_ps(value); }
+	static inline Vector Add(Vector a, Vector b) { return _mm_add_ps(a, b); }
+	static inline Vector Subtract(Vector a, Vector b) { return _mm_sub_ps(a, b); }
+	static inline Vector Multiply(Vector a, Vector b) { return _mm_mul_ps(a, b); }
+	static inline Vector MultiplyAdd(Vector a, Vector b, Vector c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+	static inline Vector Divide(Vector a, Vector b) { return _mm_div_ps(a, b); }
+	static inline Vector Sqrt(Vector a) { return _mm_sqrt_ps(a); }
+	static inline Vector Min(Vector a, Vector b) { return _mm_min_ps(a, b); }
+	static inline Vector Max(Vector a, Vector b) { return _mm_max_ps(a, b); }
+	static inline Vector Abs(Vector a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+	static inline Mask Less(Vector a, Vector b) { return _mm_cmplt_ps(a, b); }
+	static inline Vector Select(Mask mask, Vector a, Vector b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+
+	// As ScalarOps::Acos and ScalarOps::Angle
+	static inline Vector Acos(Vector x)
+	{
+		Vector t = Abs(x);
+		Vector polynomial = MultiplyAdd(MultiplyAdd(MultiplyAdd(Splat(-0.0187293f), t, Splat(0.0742610f)), t, Splat(-0.2121144f)), t, Splat(1.5707288f));
+		Vector result = Multiply(Sqrt(Subtract(Splat(1.0f), t)), polynomial);
+		return Select(Less(x, Splat(0.0f)), Subtract(Splat(Pi), result), result);
+	}
+
+	static inline Vector Angle(Vector dot, Vector lengthSquaredA, Vector lengthSquaredB)
+	{
+		Vector cosine = Divide(dot, Sqrt(Max(Multiply(lengthSquaredA, lengthSquaredB), Splat(FLT_MIN))));
+		return Acos(Min(Max(cosine, Splat(-1.0f)), Splat(1.0f)));
+	}
+	static inline void StoreInterleaved(float* destination, Vector x, Vector y, Vector z, Vector w)
+	{
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(destination, x);
+		_mm_storeu_ps(destination + 4, y);
+		_mm_storeu_ps(destination + 8, z);
+		_mm_storeu_ps(destination + 12, w);
+	}
+
+	static inline void LoadCorner(const uint8_t* positions, size_t stride, const UINT* indices, Vector& x, Vector& y, Vector& z)
+	{
+		// Load each of the four positions and transpose them
+		__m128 p[4];
+		for (int i = 0; i < 4; i++)
+		{
+			const float* position = reinterpret_cast<const float*>(positions + indices[i * 3] * stride);
+			p[i] = _mm_setr_ps(position[0], position[1], position[2], 0.0f);
+		}
+		_MM_TRANSPOSE4_PS(p[0], p[1], p[2], p[3]);
+		x = p[0];
+		y = p[1];
+		z = p[2];
+	}
+};
+#endif
+
+#if defined(SIMD_AVX2)
+struct Avx2Ops
+{
+	typedef __m256	Vector;
+	typedef __m256	Mask;
+	static constexpr size_t Width = 8;
+
+	SIMD_AVX2_TARGET static inline Vector Splat(float value) { return _mm256_set1_ps(value); }
+	SIMD_AVX2_TARGET static inline Vector Add(Vector a, Vector b) { return _mm256_add_ps(a, b); }
+	SIMD_AVX2_TARGET static inline Vector Subtract(Vector a, Vector b) { return _mm256_sub_ps(a, b); }
+	SIMD_AVX2_TARGET static inline Vector Multiply(Vector a, Vector b) { return _mm256_mul_ps(a, b); }
+	SIMD_AVX2_TARGET static inline Vector MultiplyAdd(Vector a, Vector b, Vector c) { return _mm256_fmadd_ps(a, b, c); }
+	SIMD_AVX2_TARGET static inline Vector Divide(Vector a, Vector b) { return _mm256_div_ps(a, b); }
+	SIMD_AVX2_TARGET static inline Vector Sqrt(Vector a) { return _mm256_sqrt_ps(a); }
+	SIMD_AVX2_TARGET static inline Vector Min(Vector a, Vector b) { return _mm256_min_ps(a, b); }
+	SIMD_AVX2_TARGET static inline Vector Max(Vector a, Vector b) { return _mm256_max_ps(a, b); }
+	SIMD_AVX2_TARGET static inline Vector Abs(Vector a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+	SIMD_AVX2_TARGET static inline Mask Less(Vector a, Vector b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	SIMD_AVX2_TARGET static inline Vector Select(Mask mask, Vector a, Vector b) { return _mm256_blendv_ps(b, a, mask); }
+
+	// As ScalarOps::Acos and ScalarOps::Angle
+	SIMD_AVX2_TARGET static inline Vector Acos(Vector x)
+	{
+		Vector t = Abs(x);
+		Vector polynomial = MultiplyAdd(MultiplyAdd(MultiplyAdd(Splat(-0.0187293f), t, Splat(0.0742610f)), t, Splat(-0.2121144f)), t, Splat(1.5707288f));
+		Vector result = Multiply(Sqrt(Subtract(Splat(1.0f), t)), polynomial);
+		return Select(Less(x, Splat(0.0f)), Subtract(Splat(Pi), result), result);
+	}
+
+	SIMD_AVX2_TARGET static inline Vector Angle(Vector dot, Vector lengthSquaredA, Vector lengthSquaredB)
+	{
+		Vector cosine = Divide(dot, Sqrt(Max(Multiply(lengthSquaredA, lengthSquaredB), Splat(FLT_MIN))));
+		return Acos(Min(Max(cosine, Splat(-1.0f)), Splat(1.0f)));
+	}
+	SIMD_AVX2_TARGET static inline void StoreInterleaved(float* destination, Vector x, Vector y, Vector z, Vector w)
+	{
+		// Transpose within each 128 bit half, giving lanes 0 and 4 in row0, 1 and 5 in row1, and so on
+		__m256 xy0 = _mm256_unpacklo_ps(x, y);
+		__m256 xy1 = _mm256_unpackhi_ps(x, y);
+		__m256 zw0 = _mm256_unpacklo_ps(z, w);
+		__m256 zw1 = _mm256_unpackhi_ps(z, w);
+		__m256 row0 = _mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 row1 = _mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 row2 = _mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 row3 = _mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(3, 2, 3, 2));
+		_mm256_storeu_ps(destination, _mm256_permute2f128_ps(row0, row1, 0x20));
+		_mm256_storeu_ps(destination + 8, _mm256_permute2f128_ps(row2, row3, 0x20));
+		_mm256_storeu_ps(destination + 16, _mm256_permute2f128_ps(row0, row1, 0x31));
+		_mm256_storeu_ps(destination + 24, _mm256_permute2f128_ps(row2, row3, 0x31));
+	}
+
+	SIMD_AVX2_TARGET static inline void LoadCorner(const uint8_t* positions, size_t stride, const UINT* indices, Vector& x, Vector& y, Vector& z)
+	{
+		// Gather the indices of this corner of the eight triangles, then gather the positions
+		// using them as byte offsets.  Generate checks that the offsets fit in 32 bits.
+		const __m256i triangleOffsets = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+		__m256i vertexIndices = _mm256_i32gather_epi32(reinterpret_cast<const int*>(indices), triangleOffsets, 4);
+		__m256i offsets = _mm256_mullo_epi32(vertexIndices, _mm256_set1_epi32(static_cast<int>(stride)));
+		const float* base = reinterpret_cast<const float*>(positions);
+		x = _mm256_i32gather_ps(base, offsets, 1);
+		y = _mm256_i32gather_ps(base + 1, offsets, 1);
+		z = _mm256_i32gather_ps(base + 2, offsets, 1);
+	}
+};
+#endif
+
+#if defined(SIMD_NEON)
+struct NeonOps
+{
+	typedef float32x4_t	Vector;
+	typedef uint32x4_t	Mask;
+	static constexpr size_t Width = 4;
+
+	static inline Vector Splat(float value) { return vdupq_n_f32(value); }
+	static inline Vector Add(Vector a, Vector b) { return vaddq_f32(a, b); }
+	static inline Vector Subtract(Vector a, Vector b) { return vsubq_f32(a, b); }
+	static inline Vector Multiply(Vector a, Vector b) { return vmulq_f32(a, b); }
+	static inline Vector MultiplyAdd(Vector a, Vector b, Vector c) { return vfmaq_f32(c, a, b); }
+	static inline Vector Divide(Vector a, Vector b) { return vdivq_f32(a, b); }
+	static inline Vector Sqrt(Vector a) { return vsqrtq_f32(a); }
+	static inline Vector Min(Vector a, Vector b) { return vminq_f32(a, b); }
+	static inline Vector Max(Vector a, Vector b) { return vmaxq_f32(a, b); }
+	static inline Vector Abs(Vector a) { return vabsq_f32(a); }
+	static inline Mask Less(Vector a, Vector b) { return vcltq_f32(a, b); }
+	static inline Vector Select(Mask mask, Vector a, Vector b) { return vbslq_f32(mask, a, b); }
+
+	// As ScalarOps::Acos and ScalarOps::Angle
+	static inline Vector Acos(Vector x)
+	{
+		Vector t = Abs(x);
+		Vector polynomial = MultiplyAdd(MultiplyAdd(MultiplyAdd(Splat(-0.0187293f), t, Splat(0.0742610f)), t, Splat(-0.2121144f)), t, Splat(1.5707288f));
+		Vector result = Multiply(Sqrt(Subtract(Splat(1.0f), t)), polynomial);
+		return Select(Less(x, Splat(0.0f)), Subtract(Splat(Pi), result), result);
+	}
+
+	static inline Vector Angle(Vector dot, Vector lengthSquaredA, Vector lengthSquaredB)
+	{
+		Vector cosine = Divide(dot, Sqrt(Max(Multiply(lengthSquaredA, lengthSquaredB), Splat(FLT_MIN))));
+		return Acos(Min(Max(cosine, Splat(-1.0f)), Splat(1.0f)));
+	}
+	static inline void StoreInterleaved(float* destination, Vector x, Vector y, Vector z, Vector w)
+	{
+		float32x4x4_t rows = { { x, y, z, w } };
+		vst4q_f32(destination, rows);
+	}
+
+	static inline void LoadCorner(const uint8_t* positions, size_t stride, const UINT* indices, Vector& x, Vector& y, Vector& z)
+	{
+		float32x4x3_t p;
+		for (int i = 0; i < 4; i++)
+		{
+			// Load the three floats of the position into lane i of x, y and z
+			p = vld3q_lane_f32(reinterpret_cast<const float*>(positions + indices[i * 3] * stride), p, i);
+		}
+		x = p.val[0];
+		y = p.val[1];
+		z = p.val[2];
+	}
+};
+#endif
+
+// Calculate the normals of triangles begin to end.  Any triangles left over after the last full group of
+// Ops::Width triangles are returned for the caller to finish.  GCC warns that the AVX2 instantiation
+// passes AVX vectors without AVX enabled, which cannot happen once it has been inlined.
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+template <typename Ops>
+static SIMD_FORCE_INLINE size_t FaceNormalKernel(const uint8_t* positions, size_t stride, const UINT* indices, size_t begin, size_t end, bool angleWeighted,
+												  float* faceNormals, float* angles)
+{
+	typedef typename Ops::Vector Vector;
+	size_t triangle = begin;
+	for (; triangle + Ops::Width <= end; triangle += Ops::Width)
+	{
+		const UINT* triangleIndices = indices + triangle * 3;
+		Vector x0, y0, z0, x1, y1, z1, x2, y2, z2;
+		Ops::LoadCorner(positions, stride, triangleIndices, x0, y0, z0);
+		Ops::LoadCorner(positions, stride, triangleIndices + 1, x1, y1, z1);
+		Ops::LoadCorner(positions, stride, triangleIndices + 2, x2, y2, z2);
+
+		// Edges from the first corner, and the cross product of them.  Its length is twice the area of the triangle.
+		Vector ax = Ops::Subtract(x1, x0), ay = Ops::Subtract(y1, y0), az = Ops::Subtract(z1, z0);
+		Vector bx = Ops::Subtract(x2, x0), by = Ops::Subtract(y2, y0), bz = Ops::Subtract(z2, z0);
+		Vector nx = Ops::Subtract(Ops::Multiply(ay, bz), Ops::Multiply(az, by));
+		Vector ny = Ops::Subtract(Ops::Multiply(az, bx), Ops::Multiply(ax, bz));
+		Vector nz = Ops::Subtract(Ops::Multiply(ax, by), Ops::Multiply(ay, bx));
+
+		if (angleWeighted)
+		{
+			Vector length = Ops::Sqrt(Ops::MultiplyAdd(nx, nx, Ops::MultiplyAdd(ny, ny, Ops::Multiply(nz, nz))));
+			Vector inverseLength = Ops::Divide(Ops::Splat(1.0f), Ops::Max(length, Ops::Splat(FLT_MIN)));
+			nx = Ops::Multiply(nx, inverseLength);
+			ny = Ops::Multiply(ny, inverseLength);
+			nz = Ops::Multiply(nz, inverseLength);
+
+			// The edge opposite the first corner
+			Vector cx = Ops::Subtract(x2, x1), cy = Ops::Subtract(y2, y1), cz = Ops::Subtract(z2, z1);
+			Vector aa = Ops::MultiplyAdd(ax, ax, Ops::MultiplyAdd(ay, ay, Ops::Multiply(az, az)));
+			Vector bb = Ops::MultiplyAdd(bx, bx, Ops::MultiplyAdd(by, by, Ops::Multiply(bz, bz)));
+			Vector cc = Ops::MultiplyAdd(cx, cx, Ops::MultiplyAdd(cy, cy, Ops::Multiply(cz, cz)));
+			Vector ab = Ops::MultiplyAdd(ax, bx, Ops::MultiplyAdd(ay, by, Ops::Multiply(az, bz)));
+			// The angle at the second corner is between -a and c
+			Vector ac = Ops::MultiplyAdd(ax, cx, Ops::MultiplyAdd(ay, cy, Ops::Multiply(az, cz)));
+			Vector angle0 = Ops::Angle(ab, aa, bb);
+			Vector angle1 = Ops::Angle(Ops::Subtract(Ops::Splat(0.0f), ac), aa, cc);
+			Vector angle2 = Ops::Max(Ops::Subtract(Ops::Subtract(Ops::Splat(Pi), angle0), angle1), Ops::Splat(0.0f));
+			Ops::StoreInterleaved(angles + triangle * 4, angle0, angle1, angle2, Ops::Splat(0.0f));
+		}
+		Ops::StoreInterleaved(faceNormals + triangle * 4, nx, ny, nz, Ops::Splat(0.0f));
+	}
+	return triangle;
+}
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+#if defined(SIMD_AVX2)
+SIMD_AVX2_KERNEL static size_t FaceNormalKernelAvx2(const uint8_t* positions, size_t stride, const UINT* indices, size_t begin, size_t end, bool angleWeighted,
+												   float* faceNormals, float* angles)
+{
+	return FaceNormalKernel<Avx2Ops>(positions, stride, indices, begin, end, angleWeighted, faceNormals, angles);
+}
+#endif
+
+const char* NormalGenerator::GetInstructionSet()
+{
+#if defined(SIMD_AVX2)
+	if (CpuSupportsAvx2())
+	{
+		return "AVX2";
+	}
+#endif
+#if defined(SIMD_SSE)
+	return "SSE";
+#elif defined(SIMD_NEON)
+	return "NEON";
+#else
+	return "Scalar";
+#endif
+}
+
+void NormalGenerator::SetTriangles(const UINT* indices, size_t indexCount, size_t vertexCount)
+{
+	_vertexCount = vertexCount;
+	_triangleCount = indexCount / 3;
+	_indices = indices;
+
+	// Count the corners that use each vertex, turn the counts into offsets, then fill in the corners
+	_offsets.assign(vertexCount + 1, 0);
+	for (size_t i = 0; i < _triangleCount * 3; i++)
+	{
+		if (indices[i] >= vertexCount)
+		{
+			throw out_of_range("Index refers to a vertex that does not exist");
+		}
+		_offsets[indices[i] + 1]++;
+	}
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		_offsets[i + 1] += _offsets[i];
+	}
+	_corners.resize(_triangleCount * 3);
+	vector<UINT> next(_offsets.begin(), _offsets.end() - 1);
+	for (size_t triangle = 0; triangle < _triangleCount; triangle++)
+	{
+		for (UINT corner = 0; corner < 3; corner++)
+		{
+			_corners[next[indices[triangle * 3 + corner]]++] = static_cast<UINT>(triangle * 4 + corner);
+		}
+	}
+	_faceNormals.resize(_triangleCount * 4);
+}
+
+void NormalGenerator::Generate(const Vector3* positions, Vector3* normals, size_t stride, NormalWeighting weighting, JobSystem* jobSystem)
+{
+	bool angleWeighted = weighting == NormalWeighting::Angle;
+	_angles.resize(angleWeighted ? _triangleCount * 4 : 0);
+
+	if (jobSystem == nullptr || (_triangleCount <= JobSize && _vertexCount <= JobSize))
+	{
+		CalculateFaceNormals(positions, stride, 0, _triangleCount, angleWeighted);
+		GatherNormals(normals, stride, 0, _vertexCount, angleWeighted);
+		return;
+	}
+
+	// Every triangle normal must be calculated before any vertex gathers them
+	JobCounter counter{ 0 };
+	for (size_t begin = 0; begin < _triangleCount; begin += JobSize)
+	{
+		size_t end = min(begin + JobSize, _triangleCount);
+		jobSystem->Submit([=]() { CalculateFaceNormals(positions, stride, begin, end, angleWeighted); }, counter);
+	}
+	jobSystem->Wait(counter);
+	for (size_t begin = 0; begin < _vertexCount; begin += JobSize)
+	{
+		size_t end = min(begin + JobSize, _vertexCount);
+		jobSystem->Submit([=]() { GatherNormals(normals, stride, begin, end, angleWeighted); }, counter);
+	}
+	jobSystem->Wait(counter);
+}
+
+void NormalGenerator::CalculateFaceNormals(const Vector3* positions, size_t stride, size_t begin, size_t end, bool angleWeighted)
+{
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(positions);
+	float* faceNormals = _faceNormals.data();
+	float* angles = _angles.data();
+	size_t next = begin;
+	if (_vectorised)
+	{
+#if defined(SIMD_AVX2)
+		// The gathers use 32 bit byte offsets
+		if (CpuSupportsAvx2() && _vertexCount * stride <= INT32_MAX)
+		{
+			next = FaceNormalKernelAvx2(bytes, stride, _indices, next, end, angleWeighted, faceNormals, angles);
+		}
+#endif
+#if defined(SIMD_SSE)
+		next = FaceNormalKernel<SseOps>(bytes, stride, _indices, next, end, angleWeighted, faceNormals, angles);
+#elif defined(SIMD_NEON)
+		next = FaceNormalKernel<NeonOps>(bytes, stride, _indices, next, end, angleWeighted, faceNormals, angles);
+#endif
+	}
+	FaceNormalKernel<ScalarOps>(bytes, stride, _indices, next, end, angleWeighted, faceNormals, angles);
+}
+
+void NormalGenerator::GatherNormals(Vector3* normals, size_t stride, size_t begin, size_t end, bool angleWeighted) const
+{
+	uint8_t* bytes = reinterpret_cast<uint8_t*>(normals);
+	for (size_t vertex = begin; vertex < end; vertex++)
+	{
+		float x = 0.0f;
+		float y = 0.0f;
+		float z = 0.0f;
+		for (UINT i = _offsets[vertex]; i < _offsets[vertex + 1]; i++)
+		{
+			UINT corner = _corners[i];
+			const float* faceNormal = &_faceNormals[corner & ~3u];
+			float weight = angleWeighted ? _angles[corner] : 1.0f;
+			x += faceNormal[0] * weight;
+			y += faceNormal[1] * weight;
+			z += faceNormal[2] * weight;
+		}
+		float lengthSquared = x * x + y * y + z * z;
+		float scale = lengthSquared > 0.0f ? 1.0f / sqrtf(lengthSquared) : 0.0f;
+		Vector3& normal = *reinterpret_cast<Vector3*>(bytes + vertex * stride);
+		normal = Vector3(x * scale, y * scale, z * scale);
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "SimpleMath.h"
+#include <vector>
+
+using namespace std;
+using namespace DirectX;
+using namespace SimpleMath;
+
+class JobSystem;
+
+typedef unsigned int UINT;
+
+// How the normals of the triangles that share a vertex are combined
+enum class NormalWeighting
+{
+	Area,				// Larger triangles contribute more
+	Angle				// Each triangle contributes in proportion to its angle at the vertex
+};
+
+// Calculates vertex normals for indexed triangle lists.
+//
+// The normals of the triangles are calculated first, several triangles at a time using
+// SIMD instructions (AVX2 or SSE on x86, NEON on ARM).  Each vertex then gathers the
+// normals of the triangles that use it, using an adjacency list built from the indices.
+// Since every vertex is only written once, both steps can be split across the job system
+// without atomics or per-thread copies of the normals.
+//
+// The adjacency only depends on the indices, so a generator can be kept with a mesh
+// whose vertices move (e.g. a deformed or animated mesh) and Generate called each time
+// the positions change.
+
+class NormalGenerator
+{
+public:
+	NormalGenerator() {};
+	~NormalGenerator(void) {};
+
+	// Build the adjacency for a triangle list.  Throws out_of_range if an index is not less than vertexCount.
+	// The indices are not copied, so they must not change or be freed while the generator is being used.
+	void SetTriangles(const UINT* indices, size_t indexCount, size_t vertexCount);
+
+	// Calculate the normals.  positions and normals point to the position and normal of the first vertex,
+	// and stride is the size of each vertex in bytes.  Vertices that are not used by any triangle get a
+	// zero normal.
+	void Generate(const Vector3* positions, Vector3* normals, size_t stride,
+				  NormalWeighting weighting = NormalWeighting::Area, JobSystem* jobSystem = nullptr);
+
+	// Convenience function for a vertex structure that has Position and Normal members
+	template <typename Vertex>
+	static void Calculate(Vertex* vertices, size_t vertexCount, const UINT* indices, size_t indexCount,
+						  NormalWeighting weighting = NormalWeighting::Area, JobSystem* jobSystem = nullptr)
+	{
+		NormalGenerator generator;
+		generator.SetTriangles(indices, indexCount, vertexCount);
+		generator.Generate(&vertices[0].Position, &vertices[0].Normal, sizeof(Vertex), weighting, jobSystem);
+	}
+
+	// When disabled, the portable version of the triangle normal kernel is used
+	inline void SetVectorised(bool vectorised) { _vectorised = vectorised; }
+	// The instruction set used when vectorised ("AVX2", "SSE", "NEON" or "Scalar")
+	static const char* GetInstructionSet();
+
+private:
+	size_t				_vertexCount{ 0 };
+	size_t				_triangleCount{ 0 };
+	const UINT*			_indices{ nullptr };
+	// The corners that use each vertex are _corners[_offsets[v]] to _corners[_offsets[v + 1] - 1].  Corners
+	// are numbered 4 x triangle + corner, so they index _angles directly.
+	vector<UINT>		_offsets;
+	vector<UINT>		_corners;
+
+	// Triangle normals, four floats per triangle so that each one is a single load when gathered
+	vector<float>		_faceNormals;
+	// Angle at each corner of each triangle, also four floats per triangle.  Only used for angle weighting.
+	vector<float>		_angles;
+
+	bool				_vectorised{ true };
+
+	void CalculateFaceNormals(const Vector3* positions, size_t stride, size_t begin, size_t end, bool angleWeighted);
+	void GatherNormals(Vector3* normals, size_t stride, size_t begin, size_t end, bool angleWeighted) const;
+};
@@ -0,0 +1,596 @@
+#include "OcclusionCuller.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+// The AVX2 code is compiled with FMA enabled (see Simd.h), and GCC would otherwise fuse its multiplies and adds, which
+// would make it hide different nodes from the portable code
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+constexpr unsigned int OcclusionCuller::TileWidth;
+constexpr unsigned int OcclusionCuller::TileHeight;
+
+// Boxes must be this much nearer (as a fraction of their depth) than the occluders to be visible.  This stops an
+// occluder hiding itself (its box is found by different arithmetic from its triangles).
+static constexpr float DepthBias = 1.0e-5f;
+// Vertices with a smaller w than this are too close to the plane of the camera to project
+static constexpr float MinimumW = 1.0e-5f;
+static constexpr uint32_t FullMask = 0xFFFFFFFF;
+// The bits of one row of a tile's mask
+static constexpr uint32_t RowMask = 0xFF;
+
+static OcclusionCuller::Path BestPath()
+{
+#if defined(SIMD_AVX2)
+	if (CpuSupportsAvx2())
+	{
+		return OcclusionCuller::Path::Avx2;
+	}
+#endif
+	return OcclusionCuller::Path::Portable;
+}
+
+static OcclusionCuller::Path CurrentPath = BestPath();
+
+void OcclusionCuller::SetPath(Path path)
+{
+	Path best = BestPath();
+	CurrentPath = path > best ? best : path;
+}
+
+OcclusionCuller::Path OcclusionCuller::GetPath()
+{
+	return CurrentPath;
+}
+
+const char* OcclusionCuller::GetPathName(Path path)
+{
+	switch (path)
+	{
+		case Path::Avx2:
+			return "AVX2";
+
+		default:
+			return "Portable";
+	}
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+// Portable versions
+
+// Merge a triangle that covers the pixels in coverage, and is no farther than depth in the tile, into the tile
+static inline void UpdateTile(uint32_t coverage, float depth, uint32_t& mask, float& workingDepth, float& referenceDepth)
+{
+	// A triangle that is behind the reference layer cannot hide anything more
+	if (coverage == 0 || !(depth > referenceDepth))
+	{
+		return;
+	}
+	// If the triangle is nearer to the reference layer than to the working layer, the working layer
+	// is thrown away, since merging would leave it farther away than the triangle
+	if (depth - workingDepth > workingDepth - referenceDepth)
+	{
+		workingDepth = FLT_MAX;
+		mask = 0;
+	}
+	workingDepth = min(workingDepth, depth);
+	mask |= coverage;
+	// Once the working layer covers the whole tile it becomes the reference layer
+	if (mask == FullMask)
+	{
+		referenceDepth = max(referenceDepth, workingDepth);
+		workingDepth = FLT_MAX;
+		mask = 0;
+	}
+}
+
+static void DrawTileRowPortable(uint32_t* masks, float* workingDepths, float* referenceDepths, unsigned int firstTile, unsigned int lastTile,
+								const int* spanStarts, const int* spanEnds, float rowDepth, float depthDx, float x0, float minDepth)
+{
+	for (unsigned int tile = firstTile; tile <= lastTile; tile++)
+	{
+		int tileX = static_cast<int>(tile * OcclusionCuller::TileWidth);
+		uint32_t coverage = 0;
+		for (unsigned int row = 0; row < OcclusionCuller::TileHeight; row++)
+		{
+			int start = min(max(spanStarts[row] - tileX, 0), 8);
+			int end = min(max(spanEnds[row] - tileX, 0), 8);
+			uint32_t bits = (RowMask << start) & (RowMask >> (8 - end));
+			coverage |= bits << (8 * row);
+		}
+		float depth = max(rowDepth + depthDx * (static_cast<float>(tileX) - x0), minDepth);
+		UpdateTile(coverage, depth, masks[tile], workingDepths[tile], referenceDepths[tile]);
+	}
+}
+
+static bool IsRectOccludedPortable(const float* referenceDepths, unsigned int tilesX, unsigned int firstTileX, unsigned int lastTileX,
+								   unsigned int firstTileY, unsigned int lastTileY, float depth)
+{
+	for (unsigned int tileY = firstTileY; tileY <= lastTileY; tileY++)
+	{
+		const float* row = referenceDepths + tileY * tilesX;
+		for (unsigned int tileX = firstTileX; tileX <= lastTileX; tileX++)
+		{
+			if (!(depth < row[tileX]))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+// AVX2 versions, eight tiles (or the eight corners of a box) at a time
+
+#if defined(SIMD_AVX2)
+SIMD_AVX2_TARGET static inline __m256 HorizontalMin(__m256 value)
+{
+	value = _mm256_min_ps(value, _mm256_permute2f128_ps(value, value, 1));
+	value = _mm256_min_ps(value, _mm256_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+	return _mm256_min_ps(value, _mm256_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+SIMD_AVX2_TARGET static inline __m256 HorizontalMax(__m256 value)
+{
+	value = _mm256_max_ps(value, _mm256_permute2f128_ps(value, value, 1));
+	value = _mm256_max_ps(value, _mm256_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+	return _mm256_max_ps(value, _mm256_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+SIMD_AVX2_KERNEL static void DrawTileRowAvx2(uint32_t* masks, float* workingDepths, float* referenceDepths, unsigned int firstTile, unsigned int lastTile,
+											 const int* spanStarts, const int* spanEnds, float rowDepth, float depthDx, float x0, float minDepth)
+{
+	const __m256i laneX = _mm256_setr_epi32(0, 8, 16, 24, 32, 40, 48, 56);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i eight = _mm256_set1_epi32(8);
+	const __m256i rowMask = _mm256_set1_epi32(RowMask);
+	const __m256i fullMask = _mm256_set1_epi32(-1);
+	const __m256 farthest = _mm256_set1_ps(FLT_MAX);
+	// Groups start on a multiple of eight tiles so that they never run off the end of the row (the buffer is a
+	// multiple of 64 pixels wide).  Tiles in the group that the triangle does not touch get no coverage.
+	for (unsigned int group = firstTile & ~7u; group <= lastTile; group += 8)
+	{
+		__m256i tileX = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(group * OcclusionCuller::TileWidth)), laneX);
+		__m256i coverage = zero;
+		for (unsigned int row = 0; row < OcclusionCuller::TileHeight; row++)
+		{
+			__m256i start = _mm256_min_epi32(_mm256_max_epi32(_mm256_sub_epi32(_mm256_set1_epi32(spanStarts[row]), tileX), zero), eight);
+			__m256i end = _mm256_min_epi32(_mm256_max_epi32(_mm256_sub_epi32(_mm256_set1_epi32(spanEnds[row]), tileX), zero), eight);
+			__m256i bits = _mm256_and_si256(_mm256_sllv_epi32(rowMask, start), _mm256_srlv_epi32(rowMask, _mm256_sub_epi32(eight, end)));
+			coverage = _mm256_or_si256(coverage, _mm256_sllv_epi32(bits, _mm256_set1_epi32(static_cast<int>(8 * row))));
+		}
+		__m256 depth = _mm256_max_ps(_mm256_add_ps(_mm256_set1_ps(rowDepth), _mm256_mul_ps(_mm256_set1_ps(depthDx), _mm256_sub_ps(_mm256_cvtepi32_ps(tileX), _mm256_set1_ps(x0)))),
+									 _mm256_set1_ps(minDepth));
+
+		__m256i* maskPointer = reinterpret_cast<__m256i*>(masks + group);
+		__m256i mask = _mm256_loadu_si256(maskPointer);
+		__m256 workingDepth = _mm256_loadu_ps(workingDepths + group);
+		__m256 referenceDepth = _mm256_loadu_ps(referenceDepths + group);
+
+		// The same steps as UpdateTile, with the lanes that would have returned early left alone
+		__m256 active = _mm256_andnot_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(coverage, zero)), _mm256_cmp_ps(depth, referenceDepth, _CMP_GT_OQ));
+		__m256 discard = _mm256_and_ps(active, _mm256_cmp_ps(_mm256_sub_ps(depth, workingDepth), _mm256_sub_ps(workingDepth, referenceDepth), _CMP_GT_OQ));
+		workingDepth = _mm256_blendv_ps(workingDepth, farthest, discard);
+		mask = _mm256_andnot_si256(_mm256_castps_si256(discard), mask);
+		workingDepth = _mm256_blendv_ps(workingDepth, _mm256_min_ps(workingDepth, depth), active);
+		mask = _mm256_blendv_epi8(mask, _mm256_or_si256(mask, coverage), _mm256_castps_si256(active));
+		__m256 full = _mm256_and_ps(active, _mm256_castsi256_ps(_mm256_cmpeq_epi32(mask, fullMask)));
+		referenceDepth = _mm256_blendv_ps(referenceDepth, _mm256_max_ps(referenceDepth, workingDepth), full);
+		workingDepth = _mm256_blendv_ps(workingDepth, farthest, full);
+		mask = _mm256_andnot_si256(_mm256_castps_si256(full), mask);
+
+		_mm256_storeu_si256(maskPointer, mask);
+		_mm256_storeu_ps(workingDepths + group, workingDepth);
+		_mm256_storeu_ps(referenceDepths + group, referenceDepth);
+	}
+}
+
+SIMD_AVX2_KERNEL static bool IsRectOccludedAvx2(const float* referenceDepths, unsigned int tilesX, unsigned int firstTileX, unsigned int lastTileX,
+												unsigned int firstTileY, unsigned int lastTileY, float depth)
+{
+	const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256 depths = _mm256_set1_ps(depth);
+	unsigned int firstGroup = firstTileX & ~7u;
+	for (unsigned int tileY = firstTileY; tileY <= lastTileY; tileY++)
+	{
+		const float* row = referenceDepths + tileY * tilesX;
+		for (unsigned int group = firstGroup; group <= lastTileX; group += 8)
+		{
+			// Lanes outside the rectangle count as hidden
+			__m256i tileX = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(group)), lane);
+			__m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(firstTileX)), tileX),
+											  _mm256_cmpgt_epi32(tileX, _mm256_set1_epi32(static_cast<int>(lastTileX))));
+			__m256 hidden = _mm256_or_ps(_mm256_cmp_ps(depths, _mm256_loadu_ps(row + group), _CMP_LT_OQ), _mm256_castsi256_ps(outside));
+			if (_mm256_movemask_ps(hidden) != 0xFF)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Project the corners of the box onto the buffer.  Returns false if a corner is too close to the camera to project.
+SIMD_AVX2_KERNEL static bool ProjectBoxAvx2(const AxisAlignedBox& box, const Matrix& m, float halfWidth, float halfHeight, float bounds[4], float& nearest)
+{
+	__m256 x = _mm256_setr_ps(box.Min.x, box.Max.x, box.Min.x, box.Max.x, box.Min.x, box.Max.x, box.Min.x, box.Max.x);
+	__m256 y = _mm256_setr_ps(box.Min.y, box.Min.y, box.Max.y, box.Max.y, box.Min.y, box.Min.y, box.Max.y, box.Max.y);
+	__m256 z = _mm256_setr_ps(box.Min.z, box.Min.z, box.Min.z, box.Min.z, box.Max.z, box.Max.z, box.Max.z, box.Max.z);
+	__m256 w = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(m._14)), _mm256_mul_ps(y, _mm256_set1_ps(m._24))),
+										   _mm256_mul_ps(z, _mm256_set1_ps(m._34))), _mm256_set1_ps(m._44));
+	if (_mm256_movemask_ps(_mm256_cmp_ps(w, _mm256_set1_ps(MinimumW), _CMP_GT_OQ)) != 0xFF)
+	{
+		return false;
+	}
+	__m256 clipX = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(m._11)), _mm256_mul_ps(y, _mm256_set1_ps(m._21))),
+											   _mm256_mul_ps(z, _mm256_set1_ps(m._31))), _mm256_set1_ps(m._41));
+	__m256 clipY = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(m._12)), _mm256_mul_ps(y, _mm256_set1_ps(m._22))),
+											   _mm256_mul_ps(z, _mm256_set1_ps(m._32))), _mm256_set1_ps(m._42));
+	__m256 inverseW = _mm256_div_ps(_mm256_set1_ps(1.0f), w);
+	__m256 halfWidths = _mm256_set1_ps(halfWidth);
+	__m256 halfHeights = _mm256_set1_ps(halfHeight);
+	__m256 screenX = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(clipX, inverseW), halfWidths), halfWidths);
+	__m256 screenY = _mm256_sub_ps(halfHeights, _mm256_mul_ps(_mm256_mul_ps(clipY, inverseW), halfHeights));
+	bounds[0] = _mm256_cvtss_f32(HorizontalMin(screenX));
+	bounds[1] = _mm256_cvtss_f32(HorizontalMin(screenY));
+	bounds[2] = _mm256_cvtss_f32(HorizontalMax(screenX));
+	bounds[3] = _mm256_cvtss_f32(HorizontalMax(screenY));
+	nearest = _mm256_cvtss_f32(HorizontalMax(inverseW));
+	return true;
+}
+#endif
+
+static bool ProjectBoxPortable(const AxisAlignedBox& box, const Matrix& m, float halfWidth, float halfHeight, float bounds[4], float& nearest)
+{
+	bounds[0] = bounds[1] = FLT_MAX;
+	bounds[2] = bounds[3] = -FLT_MAX;
+	nearest = 0.0f;
+	for (int corner = 0; corner < 8; corner++)
+	{
+		float x = (corner & 1) ? box.Max.x : box.Min.x;
+		float y = (corner & 2) ? box.Max.y : box.Min.y;
+		float z = (corner & 4) ? box.Max.z : box.Min.z;
+		float w = ((x * m._14 + y * m._24) + z * m._34) + m._44;
+		if (!(w > MinimumW))
+		{
+			return false;
+		}
+		float clipX = ((x * m._11 + y * m._21) + z * m._31) + m._41;
+		float clipY = ((x * m._12 + y * m._22) + z * m._32) + m._42;
+		float inverseW = 1.0f / w;
+		float screenX = (clipX * inverseW) * halfWidth + halfWidth;
+		float screenY = halfHeight - (clipY * inverseW) * halfHeight;
+		bounds[0] = min(bounds[0], screenX);
+		bounds[1] = min(bounds[1], screenY);
+		bounds[2] = max(bounds[2], screenX);
+		bounds[3] = max(bounds[3], screenY);
+		nearest = max(nearest, inverseW);
+	}
+	return true;
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+
+OcclusionCuller::OcclusionCuller(unsigned int width, unsigned int height)
+{
+	Resize(width, height);
+}
+
+void OcclusionCuller::Resize(unsigned int width, unsigned int height)
+{
+	if (width == 0 || height == 0 || width % (8 * TileWidth) != 0 || height % TileHeight != 0)
+	{
+		throw logic_error("The occlusion buffer must be a multiple of 64 pixels wide and 4 pixels high");
+	}
+	_width = width;
+	_height = height;
+	_tilesX = width / TileWidth;
+	_tilesY = height / TileHeight;
+	size_t tileCount = static_cast<size_t>(_tilesX) * _tilesY;
+	_masks.resize(tileCount);
+	_workingDepth.resize(tileCount);
+	_referenceDepth.resize(tileCount);
+	Clear();
+}
+
+void OcclusionCuller::AddOccluder(Occluder&& occluder)
+{
+	RemoveOccluder(occluder.Node.lock().get());
+	_occluders.push_back(move(occluder));
+	// The new occluder's entry is found by the next Cull
+	_hierarchy = nullptr;
+}
+
+void OcclusionCuller::RemoveOccluder(const SceneNode* node)
+{
+	_occluders.erase(remove_if(_occluders.begin(), _occluders.end(), [node](const Occluder& occluder)
+		{
+			shared_ptr<SceneNode> occluderNode = occluder.Node.lock();
+			return !occluderNode || occluderNode.get() == node;
+		}), _occluders.end());
+}
+
+void OcclusionCuller::Clear()
+{
+	fill(_masks.begin(), _masks.end(), 0u);
+	fill(_workingDepth.begin(), _workingDepth.end(), FLT_MAX);
+	// Nothing is hidden until the occluders cover a tile
+	fill(_referenceDepth.begin(), _referenceDepth.end(), 0.0f);
+	_statistics = OcclusionStatistics();
+}
+
+void OcclusionCuller::Cull(TransformHierarchy& hierarchy, const Matrix& viewProjection)
+{
+	Clear();
+	auto start = chrono::high_resolution_clock::now();
+	// Forget the occluders whose nodes have been destroyed
+	_occluders.erase(remove_if(_occluders.begin(), _occluders.end(), [](const Occluder& occluder) { return occluder.Node.expired(); }), _occluders.end());
+	if (&hierarchy != _hierarchy || hierarchy.GetRevision() != _hierarchyRevision)
+	{
+		FindOccluderEntries(hierarchy);
+	}
+	for (const Occluder& occluder : _occluders)
+	{
+		// Occluders outside the frustum cannot hide anything inside it
+		if (occluder.Entry >= 0 && hierarchy.IsVisible(occluder.Entry))
+		{
+			DrawOccluder(occluder, hierarchy.GetWorldTransformation(occluder.Entry) * viewProjection);
+		}
+	}
+	auto drawn = chrono::high_resolution_clock::now();
+
+	size_t testCount = 0;
+	hierarchy.Hide([this, &viewProjection, &testCount](const AxisAlignedBox& box)
+		{
+			testCount++;
+			return IsOccluded(box, viewProjection);
+		});
+	auto end = chrono::high_resolution_clock::now();
+
+	_statistics.TestCount = testCount;
+	_statistics.OccludedCount = hierarchy.GetOccludedCount();
+	_statistics.RasteriseTime = chrono::duration<double, milli>(drawn - start).count();
+	_statistics.TestTime = chrono::duration<double, milli>(end - drawn).count();
+}
+
+// Nodes move around the hierarchy when it is rebuilt, so the entries of the occluders are found again by looking
+// their nodes up as the entries are walked
+void OcclusionCuller::FindOccluderEntries(const TransformHierarchy& hierarchy)
+{
+	unordered_map<const SceneNode*, size_t> occluders;
+	for (size_t i = 0; i < _occluders.size(); i++)
+	{
+		_occluders[i].Entry = -1;
+		occluders[_occluders[i].Node.lock().get()] = i;
+	}
+	int count = static_cast<int>(hierarchy.GetCount());
+	for (int entry = 0; entry < count && !occluders.empty(); entry++)
+	{
+		auto found = occluders.find(hierarchy.GetNode(entry));
+		if (found != occluders.end())
+		{
+			_occluders[found->second].Entry = entry;
+		}
+	}
+	_hierarchy = &hierarchy;
+	_hierarchyRevision = hierarchy.GetRevision();
+}
+
+void OcclusionCuller::DrawOccluder(const Occluder& occluder, const Matrix& worldViewProjection)
+{
+	const Matrix& m = worldViewProjection;
+	_clipPositions.resize(occluder.Positions.size());
+	for (size_t i = 0; i < occluder.Positions.size(); i++)
+	{
+		const Vector3& position = occluder.Positions[i];
+		_clipPositions[i] = Vector4(position.x * m._11 + position.y * m._21 + position.z * m._31 + m._41,
+									position.x * m._12 + position.y * m._22 + position.z * m._32 + m._42,
+									position.x * m._13 + position.y * m._23 + position.z * m._33 + m._43,
+									position.x * m._14 + position.y * m._24 + position.z * m._34 + m._44);
+	}
+
+	// The indices were checked when the occluder was added
+	const vector<uint32_t>& indices = occluder.Indices;
+	size_t triangleCount = 0;
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		triangleCount += DrawTriangle(_clipPositions[indices[i]], _clipPositions[indices[i + 1]], _clipPositions[indices[i + 2]]);
+	}
+	_statistics.OccluderCount++;
+	_statistics.TriangleCount += triangleCount;
+}
+
+bool OcclusionCuller::DrawTriangle(const Vector4& vertex0, const Vector4& vertex1, const Vector4& vertex2)
+{
+	const Vector4* vertices[3] = { &vertex0, &vertex1, &vertex2 };
+	float x[3];
+	float y[3];
+	float depth[3];
+	float halfWidth = 0.5f * _width;
+	float halfHeight = 0.5f * _height;
+	for (int i = 0; i < 3; i++)
+	{
+		// Triangles that cross the near plane would need clipping.  Leaving them out just hides less.
+		if (!(vertices[i]->w > MinimumW) || vertices[i]->z < 0.0f)
+		{
+			return false;
+		}
+		depth[i] = 1.0f / vertices[i]->w;
+		x[i] = (vertices[i]->x * depth[i]) * halfWidth + halfWidth;
+		y[i] = halfHeight - (vertices[i]->y * depth[i]) * halfHeight;
+	}
+
+	// Twice the area, which is positive if the triangle is clockwise on the screen (and so faces the camera)
+	float dx1 = x[1] - x[0];
+	float dy1 = y[1] - y[0];
+	float dx2 = x[2] - x[0];
+	float dy2 = y[2] - y[0];
+	float area = dx1 * dy2 - dx2 * dy1;
+	if (!(area > 0.0f))
+	{
+		return false;
+	}
+
+	// The pixels whose centres are inside the bounding box, clamped to the buffer
+	float minX = min(min(x[0], x[1]), x[2]);
+	float maxX = max(max(x[0], x[1]), x[2]);
+	float minY = min(min(y[0], y[1]), y[2]);
+	float maxY = max(max(y[0], y[1]), y[2]);
+	float firstColumn = max(ceilf(minX - 0.5f), 0.0f);
+	float lastColumn = min(floorf(maxX - 0.5f), static_cast<float>(_width - 1));
+	float firstRow = max(ceilf(minY - 0.5f), 0.0f);
+	float lastRow = min(floorf(maxY - 0.5f), static_cast<float>(_height - 1));
+	if (firstColumn > lastColumn || firstRow > lastRow)
+	{
+		return false;
+	}
+
+	Triangle triangle;
+	for (int i = 0; i < 3; i++)
+	{
+		// Edge i runs between the other two vertices.  The inside of the triangle is where
+		// (y[from] - y[to]) * x + (x[to] - x[from]) * y + c is positive, so edges going up the screen
+		// bound the rows from the left and edges going down bound them from the right.  Horizontal edges are
+		// left to the bounding box.
+		int from = (i + 1) % 3;
+		int to = (i + 2) % 3;
+		float a = y[from] - y[to];
+		float slope = a != 0.0f ? (x[to] - x[from]) / (y[to] - y[from]) : 0.0f;
+		float offset = x[from] - slope * y[from];
+		bool left = a > 0.0f;
+		bool right = a < 0.0f;
+		triangle.LeftSlope[i] = left ? slope : 0.0f;
+		triangle.LeftOffset[i] = left ? offset : -FLT_MAX;
+		triangle.RightSlope[i] = right ? slope : 0.0f;
+		triangle.RightOffset[i] = right ? offset : FLT_MAX;
+	}
+	triangle.MinY = minY;
+	triangle.MaxY = maxY;
+	float inverseArea = 1.0f / area;
+	triangle.X0 = x[0];
+	triangle.Y0 = y[0];
+	triangle.Depth = depth[0];
+	triangle.DepthDx = ((depth[1] - depth[0]) * dy2 - (depth[2] - depth[0]) * dy1) * inverseArea;
+	triangle.DepthDy = ((depth[2] - depth[0]) * dx1 - (depth[1] - depth[0]) * dx2) * inverseArea;
+	triangle.MinDepth = min(min(depth[0], depth[1]), depth[2]);
+
+	int rowBegin = static_cast<int>(firstRow);
+	int rowEnd = static_cast<int>(lastRow) + 1;
+	int columnBegin = static_cast<int>(firstColumn);
+	int columnEnd = static_cast<int>(lastColumn) + 1;
+	for (int tileY = rowBegin / TileHeight; tileY * static_cast<int>(TileHeight) < rowEnd; tileY++)
+	{
+		// The pixels the triangle covers on each row of the tiles, from spanStarts up to (but not including) spanEnds
+		int spanStarts[TileHeight];
+		int spanEnds[TileHeight];
+		int tileRowStart = columnEnd;
+		int tileRowEnd = columnBegin;
+		for (int row = 0; row < static_cast<int>(TileHeight); row++)
+		{
+			int pixelY = tileY * TileHeight + row;
+			spanStarts[row] = 0;
+			spanEnds[row] = 0;
+			if (pixelY < rowBegin || pixelY >= rowEnd)
+			{
+				continue;
+			}
+			float centreY = pixelY + 0.5f;
+			float left = max(max(triangle.LeftSlope[0] * centreY + triangle.LeftOffset[0], triangle.LeftSlope[1] * centreY + triangle.LeftOffset[1]),
+							 triangle.LeftSlope[2] * centreY + triangle.LeftOffset[2]);
+			float right = min(min(triangle.RightSlope[0] * centreY + triangle.RightOffset[0], triangle.RightSlope[1] * centreY + triangle.RightOffset[1]),
+							  triangle.RightSlope[2] * centreY + triangle.RightOffset[2]);
+			// Pixels whose centres are inside the span, limited to the bounding box (which also keeps the values in range)
+			int start = static_cast<int>(max(ceilf(left - 0.5f), firstColumn));
+			int end = static_cast<int>(min(floorf(right - 0.5f), lastColumn)) + 1;
+			if (start < end)
+			{
+				spanStarts[row] = start;
+				spanEnds[row] = end;
+				tileRowStart = min(tileRowStart, start);
+				tileRowEnd = max(tileRowEnd, end);
+			}
+		}
+		if (tileRowStart < tileRowEnd)
+		{
+			DrawTileRow(triangle, tileY, tileRowStart / TileWidth, (tileRowEnd - 1) / TileWidth, spanStarts, spanEnds);
+		}
+	}
+	return true;
+}
+
+void OcclusionCuller::DrawTileRow(const Triangle& triangle, unsigned int tileY, unsigned int firstTile, unsigned int lastTile, const int spanStarts[TileHeight], const int spanEnds[TileHeight])
+{
+	// The farthest depth of the plane over each tile is at one of its corners, so the depth at the tile's top left
+	// corner is moved by whichever of its steps across and down the tile goes away from the camera
+	float tileTop = static_cast<float>(tileY * TileHeight);
+	float rowDepth = ((triangle.Depth + triangle.DepthDy * (tileTop - triangle.Y0)) + min(triangle.DepthDy * TileHeight, 0.0f)) + min(triangle.DepthDx * TileWidth, 0.0f);
+	size_t rowOffset = static_cast<size_t>(tileY) * _tilesX;
+#if defined(SIMD_AVX2)
+	if (CurrentPath == Path::Avx2)
+	{
+		DrawTileRowAvx2(_masks.data() + rowOffset, _workingDepth.data() + rowOffset, _referenceDepth.data() + rowOffset, firstTile, lastTile,
+						spanStarts, spanEnds, rowDepth, triangle.DepthDx, triangle.X0, triangle.MinDepth);
+		return;
+	}
+#endif
+	DrawTileRowPortable(_masks.data() + rowOffset, _workingDepth.data() + rowOffset, _referenceDepth.data() + rowOffset, firstTile, lastTile,
+						spanStarts, spanEnds, rowDepth, triangle.DepthDx, triangle.X0, triangle.MinDepth);
+}
+
+bool OcclusionCuller::IsOccluded(const AxisAlignedBox& box, const Matrix& viewProjection) const
+{
+	if (box.IsEmpty() || box.IsInfinite())
+	{
+		return false;
+	}
+	float halfWidth = 0.5f * _width;
+	float halfHeight = 0.5f * _height;
+	// minimum x, minimum y, maximum x, maximum y
+	float bounds[4];
+	float nearest;
+	bool projected;
+#if defined(SIMD_AVX2)
+	if (CurrentPath == Path::Avx2)
+	{
+		projected = ProjectBoxAvx2(box, viewProjection, halfWidth, halfHeight, bounds, nearest);
+	}
+	else
+#endif
+	{
+		projected = ProjectBoxPortable(box, viewProjection, halfWidth, halfHeight, bounds, nearest);
+	}
+	if (!projected)
+	{
+		return false;
+	}
+
+	// The tiles that contain the centres of pixels the box could cover.  A box that is off the buffer or covers no
+	// pixel centres should have been culled by the frustum, so it is left visible.
+	float firstColumn = max(ceilf(bounds[0] - 0.5f), 0.0f);
+	float lastColumn = min(floorf(bounds[2] - 0.5f), static_cast<float>(_width - 1));
+	float firstRow = max(ceilf(bounds[1] - 0.5f), 0.0f);
+	float lastRow = min(floorf(bounds[3] - 0.5f), static_cast<float>(_height - 1));
+	if (!(firstColumn <= lastColumn && firstRow <= lastRow))
+	{
+		return false;
+	}
+	unsigned int firstTileX = static_cast<unsigned int>(firstColumn) / TileWidth;
+	unsigned int lastTileX = static_cast<unsigned int>(lastColumn) / TileWidth;
+	unsigned int firstTileY = static_cast<unsigned int>(firstRow) / TileHeight;
+	unsigned int lastTileY = static_cast<unsigned int>(lastRow) / TileHeight;
+	float depth = nearest + nearest * DepthBias;
+#if defined(SIMD_AVX2)
+	if (CurrentPath == Path::Avx2)
+	{
+		return IsRectOccludedAvx2(_referenceDepth.data(), _tilesX, firstTileX, lastTileX, firstTileY, lastTileY, depth);
+	}
+#endif
+	return IsRectOccludedPortable(_referenceDepth.data(), _tilesX, firstTileX, lastTileX, firstTileY, lastTileY, depth);
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include "SimpleMath.h"
+#include "Bounds.h"
+#include "TransformHierarchy.h"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+class SceneNode;
+
+struct OcclusionStatistics
+{
+	// Occluders drawn, and the triangles of theirs that were rasterised (the others faced away, were off the
+	// screen or crossed the near plane)
+	size_t				OccluderCount{ 0 };
+	size_t				TriangleCount{ 0 };
+	// Bounding boxes tested, and the entries with geometry that were hidden (see TransformHierarchy::Hide)
+	size_t				TestCount{ 0 };
+	size_t				OccludedCount{ 0 };
+	// Time taken to draw the occluders and to test the bounding boxes, in milliseconds
+	double				RasteriseTime{ 0 };
+	double				TestTime{ 0 };
+};
+
+// CPU occlusion culling in the style of Masked Software Occlusion Culling (Hasselgren, Andersson and
+// Akenine-Moller, 2016).
+//
+// A few large meshes (the occluders, see SceneNode::SetOccluder) are drawn each frame into a small
+// depth buffer, and nodes whose bounding boxes are entirely behind them are hidden before the scene
+// graph is rendered, so that the GPU does not draw what would be covered anyway.  The culler keeps
+// its own copy of the positions and indices of each occluder, and places it with the world
+// transformation of the occluder's node in the TransformHierarchy.
+//
+// The depth buffer is divided into tiles of 8 x 4 pixels.  Rather than a depth for every pixel, each
+// tile holds a mask of the pixels covered by a working layer of triangles, the farthest depth of
+// that layer, and the farthest depth of a reference layer that covers the whole tile.  Triangles
+// are merged into the working layer; when it covers the whole tile it becomes the reference layer,
+// and if a triangle is much nearer than the working layer, the working layer is thrown away and
+// started again from that triangle.  Boxes are tested against the reference depths of the tiles
+// they cover, so the test is conservative: a box is only hidden if it is behind the occluders at
+// every pixel it could cover.
+//
+// Depths are stored as 1/w, which (unlike z/w) keeps its precision far from the camera and can be
+// interpolated linearly across the screen.  Larger values are nearer.  Occluder triangles that
+// cross the near plane are not drawn, and boxes that cross it are never hidden.
+//
+// Triangles are rasterised for eight tiles at a time with AVX2 (chosen at run time, see Simd.h),
+// and boxes have their eight corners projected at once and are compared with eight tiles at a
+// time.  The portable version does the same arithmetic in the same order, so both hide exactly
+// the same nodes.
+
+class OcclusionCuller
+{
+public:
+	enum class Path
+	{
+		Portable,
+		Avx2
+	};
+
+	// The width must be a multiple of 64 and the height a multiple of 4.  The buffer covers the whole viewport
+	// whatever its shape, so a low resolution with the same aspect ratio as the viewport works best.
+	OcclusionCuller(unsigned int width = 320, unsigned int height = 180);
+
+	void Resize(unsigned int width, unsigned int height);
+
+	// Draw the triangles of a mesh into the buffer when Cull is called.  Each vertex starts with its position.  The
+	// positions and indices are copied, after checking that every index is less than vertexCount; if one is not, the
+	// occluder is not added and false is returned.  The occluder is dropped when node is destroyed.
+	template <typename Index>
+	bool AddOccluder(const shared_ptr<SceneNode>& node, const uint8_t* vertexData, size_t vertexCount, size_t vertexStride,
+					 const Index* indices, size_t indexCount);
+	void RemoveOccluder(const SceneNode* node);
+	inline size_t GetOccluderCount() const { return _occluders.size(); }
+
+	// Draw the occluders that survived frustum culling and hide the subtrees of the hierarchy that are behind them.
+	// This must be called after TransformHierarchy::Cull.
+	void Cull(TransformHierarchy& hierarchy, const Matrix& viewProjection);
+
+	// Empties the buffer and resets the statistics, as Cull does first
+	void Clear();
+	// True if the box (in world space) is hidden behind what has been drawn
+	bool IsOccluded(const AxisAlignedBox& box, const Matrix& viewProjection) const;
+
+	inline unsigned int GetWidth() const { return _width; }
+	inline unsigned int GetHeight() const { return _height; }
+	// The farthest depth (1/w) of the occluders in the tile that contains a pixel, or 0 if the tile is not
+	// yet covered completely
+	inline float GetTileDepth(unsigned int x, unsigned int y) const { return _referenceDepth[(y / TileHeight) * _tilesX + x / TileWidth]; }
+	inline const OcclusionStatistics& GetStatistics() const { return _statistics; }
+
+	// The culler uses AVX2 where it can unless told otherwise.  This is not thread safe, and is meant for
+	// comparing the paths.
+	static void SetPath(Path path);
+	static Path GetPath();
+	static const char* GetPathName(Path path);
+
+	static constexpr unsigned int TileWidth = 8;
+	static constexpr unsigned int TileHeight = 4;
+
+private:
+	struct Occluder
+	{
+		weak_ptr<SceneNode>		Node;
+		// The node's entry in the hierarchy, or -1 if it is not in it
+		int						Entry;
+		vector<Vector3>			Positions;
+		vector<uint32_t>		Indices;
+	};
+
+	// A triangle after set up, in pixels with y down the screen
+	struct Triangle
+	{
+		// Each edge bounds the pixels covered on a row from the left or the right at x = Slope * y + Offset.
+		// The other bound is infinite.
+		float			LeftSlope[3];
+		float			LeftOffset[3];
+		float			RightSlope[3];
+		float			RightOffset[3];
+		float			MinY;
+		float			MaxY;
+		// 1/w = Depth + DepthDx * (x - X0) + DepthDy * (y - Y0)
+		float			X0;
+		float			Y0;
+		float			Depth;
+		float			DepthDx;
+		float			DepthDy;
+		// The farthest vertex, which limits the depth found for a tile
+		float			MinDepth;
+	};
+
+	unsigned int				_width{ 0 };
+	unsigned int				_height{ 0 };
+	unsigned int				_tilesX{ 0 };
+	unsigned int				_tilesY{ 0 };
+	// For each tile: the pixels covered by the working layer (bit x + 8 * y) and its farthest depth, and the
+	// farthest depth of the reference layer
+	vector<uint32_t>			_masks;
+	vector<float>				_workingDepth;
+	vector<float>				_referenceDepth;
+	vector<Occluder>			_occluders;
+	// The hierarchy the entries of the occluders were found in.  They are found again when it is rebuilt.
+	const TransformHierarchy*	_hierarchy{ nullptr };
+	unsigned int				_hierarchyRevision{ 0 };
+	// The occluder's vertices in clip space
+	vector<Vector4>				_clipPositions;
+	OcclusionStatistics			_statistics;
+
+	void AddOccluder(Occluder&& occluder);
+	void FindOccluderEntries(const TransformHierarchy& hierarchy);
+	void DrawOccluder(const Occluder& occluder, const Matrix& worldViewProjection);
+	// Returns false if the triangle was not drawn
+	bool DrawTriangle(const Vector4& vertex0, const Vector4& vertex1, const Vector4& vertex2);
+	void DrawTileRow(const Triangle& triangle, unsigned int tileY, unsigned int firstTile, unsigned int lastTile, const int spanStarts[TileHeight], const int spanEnds[TileHeight]);
+};
+
+template <typename Index>
+bool OcclusionCuller::AddOccluder(const shared_ptr<SceneNode>& node, const uint8_t* vertexData, size_t vertexCount, size_t vertexStride,
+								  const Index* indices, size_t indexCount)
+{
+	Occluder occluder{ node, -1, vector<Vector3>(vertexCount), vector<uint32_t>(indexCount - indexCount % 3) };
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		memcpy(&occluder.Positions[i], vertexData + i * vertexStride, sizeof(Vector3));
+	}
+	for (size_t i = 0; i < occluder.Indices.size(); i++)
+	{
+		if (indices[i] >= vertexCount)
+		{
+			return false;
+		}
+		occluder.Indices[i] = indices[i];
+	}
+	AddOccluder(move(occluder));
+	return true;
+}
@@ -0,0 +1,141 @@
+#include "RecordingRenderDevice.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+void RecordingRenderDevice::Record(RenderCommandType type, RenderHandle handle0, RenderHandle handle1, int64_t value0, int64_t value1, int64_t value2, int64_t value3, int64_t value4)
+{
+	RenderCommand command;
+	command.Type = type;
+	command.Handles[0] = handle0;
+	command.Handles[1] = handle1;
+	command.Values[0] = value0;
+	command.Values[1] = value1;
+	command.Values[2] = value2;
+	command.Values[3] = value3;
+	command.Values[4] = value4;
+	_commands.push_back(command);
+}
+
+int64_t RecordingRenderDevice::LogData(const void* data, size_t size)
+{
+	// Keep a copy of the data, since the caller's copy may not live as long as the log
+	size_t offset = _data.size();
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	_data.insert(_data.end(), bytes, bytes + size);
+	return static_cast<int64_t>(offset);
+}
+
+RenderHandle RecordingRenderDevice::CreateBuffer(BufferType type, BufferUsage usage, size_t size, const void* data)
+{
+	if (data == nullptr && usage == BufferUsage::Immutable)
+	{
+		throw logic_error("Immutable buffers must be created with their contents");
+	}
+	RenderHandle buffer = _nextBuffer++;
+	_buffers.insert(buffer);
+	int64_t dataOffset = data != nullptr ? LogData(data, size) : -1;
+	Record(RenderCommandType::CreateBuffer, buffer, 0, dataOffset, static_cast<int64_t>(type), static_cast<int64_t>(usage), static_cast<int64_t>(size));
+	return buffer;
+}
+
+void RecordingRenderDevice::ReleaseBuffer(RenderHandle buffer)
+{
+	if (buffer == 0)
+	{
+		return;
+	}
+	if (_buffers.erase(buffer) == 0)
+	{
+		throw logic_error("Released a buffer that does not exist");
+	}
+	Record(RenderCommandType::ReleaseBuffer, buffer, 0, 0, 0, 0);
+}
+
+void RecordingRenderDevice::ClearTargets(const float colour[4], float depth)
+{
+	uint32_t depthBits;
+	memcpy(&depthBits, &depth, sizeof(depthBits));
+	Record(RenderCommandType::ClearTargets, 0, 0, LogData(colour, 4 * sizeof(float)), depthBits, 0);
+}
+
+void RecordingRenderDevice::SetViewport(float width, float height)
+{
+	Record(RenderCommandType::SetViewport, 0, 0, static_cast<int64_t>(width + 0.5f), static_cast<int64_t>(height + 0.5f), 0);
+}
+
+void RecordingRenderDevice::SetShaders(RenderHandle vertexShader, RenderHandle pixelShader)
+{
+	Record(RenderCommandType::SetShaders, vertexShader, pixelShader, 0, 0, 0);
+}
+
+void RecordingRenderDevice::SetInputLayout(RenderHandle inputLayout)
+{
+	Record(RenderCommandType::SetInputLayout, inputLayout, 0, 0, 0, 0);
+}
+
+void RecordingRenderDevice::SetPrimitiveTopology(PrimitiveTopology topology)
+{
+	Record(RenderCommandType::SetPrimitiveTopology, 0, 0, static_cast<int64_t>(topology), 0, 0);
+}
+
+void RecordingRenderDevice::SetVertexBuffer(RenderHandle vertexBuffer, unsigned int stride, unsigned int offset)
+{
+	Record(RenderCommandType::SetVertexBuffer, vertexBuffer, 0, stride, offset, 0);
+}
+
+void RecordingRenderDevice::SetInstanceBuffer(RenderHandle instanceBuffer, unsigned int stride, unsigned int offset)
+{
+	Record(RenderCommandType::SetInstanceBuffer, instanceBuffer, 0, stride, offset, 0);
+}
+
+void RecordingRenderDevice::SetIndexBuffer(RenderHandle indexBuffer, IndexFormat format, unsigned int offset)
+{
+	Record(RenderCommandType::SetIndexBuffer, indexBuffer, 0, static_cast<int64_t>(format), offset, 0);
+}
+
+void RecordingRenderDevice::SetTexture(unsigned int slot, RenderHandle texture)
+{
+	Record(RenderCommandType::SetTexture, texture, 0, slot, 0, 0);
+}
+
+void RecordingRenderDevice::SetConstantBuffer(unsigned int slot, RenderHandle constantBuffer)
+{
+	Record(RenderCommandType::SetConstantBuffer, constantBuffer, 0, slot, 0, 0);
+}
+
+void RecordingRenderDevice::SetConstantBufferRange(unsigned int slot, RenderHandle constantBuffer, unsigned int offset, unsigned int size)
+{
+	Record(RenderCommandType::SetConstantBufferRange, constantBuffer, 0, slot, offset, size);
+}
+
+void RecordingRenderDevice::UpdateBuffer(RenderHandle buffer, const void* data, size_t size)
+{
+	Record(RenderCommandType::UpdateBuffer, buffer, 0, LogData(data, size), static_cast<int64_t>(size), 0);
+}
+
+void RecordingRenderDevice::WriteBuffer(RenderHandle buffer, size_t offset, const void* data, size_t size, bool discard)
+{
+	Record(RenderCommandType::WriteBuffer, buffer, 0, LogData(data, size), static_cast<int64_t>(size), static_cast<int64_t>(offset), discard ? 1 : 0);
+}
+
+void RecordingRenderDevice::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	Record(RenderCommandType::DrawIndexed, 0, 0, indexCount, startIndex, baseVertex);
+}
+
+void RecordingRenderDevice::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance)
+{
+	Record(RenderCommandType::DrawIndexedInstanced, 0, 0, indexCount, instanceCount, startIndex, baseVertex, startInstance);
+}
+
+void RecordingRenderDevice::Clear()
+{
+	_commands.clear();
+	_data.clear();
+}
+
+size_t RecordingRenderDevice::CountCommands(RenderCommandType type) const
+{
+	return count_if(_commands.begin(), _commands.end(), [type](const RenderCommand& command) { return command.Type == type; });
+}
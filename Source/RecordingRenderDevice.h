@@ -0,0 +1,108 @@
+#pragma once
+#include "RenderDevice.h"
+#include <vector>
+#include <unordered_set>
+
+using namespace std;
+
+enum class RenderCommandType : uint8_t
+{
+	CreateBuffer,
+	ReleaseBuffer,
+	ClearTargets,
+	SetViewport,
+	SetShaders,
+	SetInputLayout,
+	SetPrimitiveTopology,
+	SetVertexBuffer,
+	SetInstanceBuffer,
+	SetIndexBuffer,
+	SetTexture,
+	SetConstantBuffer,
+	SetConstantBufferRange,
+	UpdateBuffer,
+	WriteBuffer,
+	DrawIndexed,
+	DrawIndexedInstanced
+};
+
+// A single recorded call.  The meaning of the handles and values depends on the type:
+//
+//   CreateBuffer           Handles[0] = new buffer, Values = offset of the initial data in the data log (-1 if none), type, usage, size
+//   ReleaseBuffer          Handles[0] = buffer
+//   ClearTargets           Values = offset of the colour (4 floats) in the data log, depth as the bits of a float
+//   SetViewport            Values = width, height (rounded to whole pixels)
+//   SetShaders             Handles = vertex shader, pixel shader
+//   SetInputLayout         Handles[0] = input layout
+//   SetPrimitiveTopology   Values[0] = topology
+//   SetVertexBuffer        Handles[0] = buffer, Values = stride, offset
+//   SetInstanceBuffer      Handles[0] = buffer, Values = stride, offset
+//   SetIndexBuffer         Handles[0] = buffer, Values = format, offset
+//   SetTexture             Handles[0] = texture, Values[0] = slot
+//   SetConstantBuffer      Handles[0] = buffer, Values[0] = slot
+//   SetConstantBufferRange Handles[0] = buffer, Values = slot, offset, size
+//   UpdateBuffer           Handles[0] = buffer, Values = offset of the data in the data log, size
+//   WriteBuffer            Handles[0] = buffer, Values = offset of the data in the data log, size, offset in the buffer, discard
+//   DrawIndexed            Values = index count, start index, base vertex
+//   DrawIndexedInstanced   Values = index count, instance count, start index, base vertex, start instance
+struct RenderCommand
+{
+	RenderCommandType	Type;
+	RenderHandle		Handles[2];
+	int64_t				Values[5];
+};
+
+// Render device that does not draw anything, but records every call made to it so
+// that what would have been sent to the GPU can be inspected.  This does not depend
+// on Direct3D, so it can be used on machines without a GPU.
+//
+// Buffers are given handles counting up from FirstBufferHandle, which is well above
+// the made-up handles the benchmarks use for shaders and textures.  Releasing a buffer
+// that was not created by the device, or releasing it twice, throws a logic_error.
+
+class RecordingRenderDevice : public RenderDevice
+{
+public:
+	static constexpr RenderHandle FirstBufferHandle = 0x10000000;
+
+	RenderHandle CreateBuffer(BufferType type, BufferUsage usage, size_t size, const void* data);
+	void ReleaseBuffer(RenderHandle buffer);
+	void ClearTargets(const float colour[4], float depth);
+	void SetViewport(float width, float height);
+
+	void SetShaders(RenderHandle vertexShader, RenderHandle pixelShader);
+	void SetInputLayout(RenderHandle inputLayout);
+	void SetPrimitiveTopology(PrimitiveTopology topology);
+	void SetVertexBuffer(RenderHandle vertexBuffer, unsigned int stride, unsigned int offset);
+	void SetInstanceBuffer(RenderHandle instanceBuffer, unsigned int stride, unsigned int offset);
+	void SetIndexBuffer(RenderHandle indexBuffer, IndexFormat format, unsigned int offset);
+	void SetTexture(unsigned int slot, RenderHandle texture);
+	void SetConstantBuffer(unsigned int slot, RenderHandle constantBuffer);
+	void SetConstantBufferRange(unsigned int slot, RenderHandle constantBuffer, unsigned int offset, unsigned int size);
+	void UpdateBuffer(RenderHandle buffer, const void* data, size_t size);
+	void WriteBuffer(RenderHandle buffer, size_t offset, const void* data, size_t size, bool discard);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance);
+
+	// Clear the log.  Buffers that have been created stay alive.
+	void Clear();
+
+	inline const vector<RenderCommand>& GetCommands() const { return _commands; }
+	// Returns the data logged by a recorded CreateBuffer, ClearTargets, UpdateBuffer or WriteBuffer command
+	// (nullptr for a buffer created without data)
+	inline const uint8_t* GetData(const RenderCommand& command) const { return command.Values[0] >= 0 ? _data.data() + command.Values[0] : nullptr; }
+	// Buffers created and not yet released, which should be none once everything has been shut down
+	inline size_t GetBufferCount() const { return _buffers.size(); }
+	inline bool IsBuffer(RenderHandle buffer) const { return _buffers.count(buffer) != 0; }
+
+	size_t CountCommands(RenderCommandType type) const;
+
+private:
+	vector<RenderCommand>		_commands;
+	vector<uint8_t>				_data;
+	unordered_set<RenderHandle>	_buffers;
+	RenderHandle				_nextBuffer{ FirstBufferHandle };
+
+	int64_t LogData(const void* data, size_t size);
+	void Record(RenderCommandType type, RenderHandle handle0, RenderHandle handle1, int64_t value0, int64_t value1, int64_t value2, int64_t value3 = 0, int64_t value4 = 0);
+};
@@ -0,0 +1,153 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+// Opaque handle to a device object (shader, buffer, input layout or texture).  For the
+// Direct3D 11 device this is the interface pointer; other devices can use any value
+// that is unique to the object.  0 means no object.
+typedef uintptr_t RenderHandle;
+
+enum class PrimitiveTopology : uint8_t
+{
+	TriangleList,
+	LineList,
+	PointList
+};
+
+enum class IndexFormat : uint8_t
+{
+	UInt16,
+	UInt32
+};
+
+enum class BufferType : uint8_t
+{
+	Vertex,
+	Index,
+	Constant
+};
+
+// How the contents of a buffer are changed after it has been created
+enum class BufferUsage : uint8_t
+{
+	// Set when the buffer is created and never changed
+	Immutable,
+	// Changed with UpdateBuffer
+	Default,
+	// Written by the CPU with WriteBuffer
+	Dynamic
+};
+
+// Constant buffers bound with SetConstantBufferRange start on, and are a multiple of, this many bytes (16 constants)
+constexpr unsigned int ConstantBufferAlignment = 256;
+
+// Interface used to create buffers and to issue state changes and draws.
+//
+// The render queue submits its packets through this rather than directly to an
+// ID3D11DeviceContext, and the mesh registry and framework create their buffers
+// through it, so that everything from building meshes to submitting a frame can be
+// captured by a recording device and inspected without a GPU (or Windows).
+//
+// Shaders, input layouts and textures are still created by the ShaderCache and the
+// nodes, since they need the shader compiler; any unique value can stand in for them
+// when recording.
+//
+// When frames are pipelined (see FramePipeline), the update stage can let go of a buffer
+// that the draw packets of the frame being rendered still refer to.  Such buffers are
+// released with RetireBuffer rather than ReleaseBuffer.  While retired buffers are being
+// kept, they are only released by the second call to EndFrame after they were retired:
+// only the frame being rendered and the frame being updated can still be using them, and
+// both have been submitted by then.
+
+class RenderDevice
+{
+public:
+	virtual ~RenderDevice() {};
+
+	// Create a buffer of size bytes.  data holds the initial contents, and may only be null if the buffer is not
+	// Immutable.  Every buffer created must be released with ReleaseBuffer or RetireBuffer.
+	virtual RenderHandle CreateBuffer(BufferType type, BufferUsage usage, size_t size, const void* data) = 0;
+	virtual void ReleaseBuffer(RenderHandle buffer) = 0;
+
+	// Release a buffer that draw packets may still refer to.  This can be called by the update stage while the
+	// render stage is submitting a frame.
+	inline void RetireBuffer(RenderHandle buffer)
+	{
+		unique_lock<mutex> lock(_retiredLock);
+		if (_keepRetiredBuffers)
+		{
+			_retiredBuffers[0].push_back(buffer);
+			return;
+		}
+		lock.unlock();
+		ReleaseBuffer(buffer);
+	}
+
+	// Called by the render stage when it has finished submitting a frame
+	inline void EndFrame()
+	{
+		vector<RenderHandle> buffers;
+		{
+			lock_guard<mutex> lock(_retiredLock);
+			buffers.swap(_retiredBuffers[1]);
+			_retiredBuffers[1].swap(_retiredBuffers[0]);
+		}
+		for (RenderHandle buffer : buffers)
+		{
+			ReleaseBuffer(buffer);
+		}
+	}
+
+	// Turned on while frames may be rendered at the same time as the next one is updated.  Turning it off
+	// releases the buffers that are being kept, so it must only be done once no frame is being rendered.
+	inline void SetKeepRetiredBuffers(bool keep)
+	{
+		{
+			lock_guard<mutex> lock(_retiredLock);
+			_keepRetiredBuffers = keep;
+		}
+		if (!keep)
+		{
+			EndFrame();
+			EndFrame();
+		}
+	}
+
+	// Clear the render target to colour and the depth buffer to depth
+	virtual void ClearTargets(const float colour[4], float depth) = 0;
+	virtual void SetViewport(float width, float height) = 0;
+
+	virtual void SetShaders(RenderHandle vertexShader, RenderHandle pixelShader) = 0;
+	virtual void SetInputLayout(RenderHandle inputLayout) = 0;
+	virtual void SetPrimitiveTopology(PrimitiveTopology topology) = 0;
+	virtual void SetVertexBuffer(RenderHandle vertexBuffer, unsigned int stride, unsigned int offset) = 0;
+	// Bind a buffer of per-instance data to the second vertex buffer slot
+	virtual void SetInstanceBuffer(RenderHandle instanceBuffer, unsigned int stride, unsigned int offset) = 0;
+	virtual void SetIndexBuffer(RenderHandle indexBuffer, IndexFormat format, unsigned int offset) = 0;
+	// Bind a texture to a pixel shader slot
+	virtual void SetTexture(unsigned int slot, RenderHandle texture) = 0;
+	// Bind a constant buffer to the same slot in both the vertex and pixel shaders
+	virtual void SetConstantBuffer(unsigned int slot, RenderHandle constantBuffer) = 0;
+	// Bind size bytes of a constant buffer, starting at offset, to the same slot in both shaders.
+	// The offset and size must be multiples of ConstantBufferAlignment.
+	virtual void SetConstantBufferRange(unsigned int slot, RenderHandle constantBuffer, unsigned int offset, unsigned int size) = 0;
+	// Replace the contents of a buffer.  Constant buffers are always replaced completely;
+	// for other buffers, only the first size bytes are replaced.
+	virtual void UpdateBuffer(RenderHandle buffer, const void* data, size_t size) = 0;
+	// Copy data into part of a dynamic buffer without waiting for the GPU.  Nothing the GPU may still
+	// be reading can be written to unless discard is true, in which case the whole of the previous
+	// contents are thrown away (see RingAllocator).
+	virtual void WriteBuffer(RenderHandle buffer, size_t offset, const void* data, size_t size, bool discard) = 0;
+	virtual void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex) = 0;
+	virtual void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance) = 0;
+
+private:
+	mutex					_retiredLock;
+	bool					_keepRetiredBuffers{ false };
+	// Buffers retired since the last EndFrame, and those retired in the frame before that
+	vector<RenderHandle>	_retiredBuffers[2];
+};
@@ -0,0 +1,410 @@
+#include "RenderQueue.h"
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+// Number of bits in the sort key used for each field
+constexpr int ShaderBits = 12;
+constexpr int TextureBits = 12;
+constexpr int MaterialBits = 8;
+constexpr int DepthBits = 32;
+
+// Returns the id for a key, allocating the next one if this key has not been seen before this frame.
+// Once all ids have been used, the remaining keys share the last id; this only affects how well the
+// packets are grouped, not what is drawn.
+template <typename Key>
+static uint32_t GetId(unordered_map<Key, uint32_t>& ids, Key key, int bits)
+{
+	auto result = ids.emplace(key, static_cast<uint32_t>(ids.size()));
+	return min(result.first->second, (1u << bits) - 1);
+}
+
+uint64_t RenderQueue::MakeSortKey(uint32_t shader, uint32_t texture, uint32_t material, float depth)
+{
+	// The bit patterns of non-negative floats sort in the same order as the values
+	// themselves, so the depth can be used directly
+	depth = depth > 0.0f ? depth : 0.0f;
+	uint32_t depthBits;
+	memcpy(&depthBits, &depth, sizeof(depthBits));
+
+	return (static_cast<uint64_t>(shader) << (TextureBits + MaterialBits + DepthBits)) |
+		   (static_cast<uint64_t>(texture) << (MaterialBits + DepthBits)) |
+		   (static_cast<uint64_t>(material) << DepthBits) |
+		   depthBits;
+}
+
+uint32_t RenderQueue::HashMaterial(const void* parameters, size_t size)
+{
+	// 32-bit FNV-1a
+	const uint8_t* bytes = static_cast<const uint8_t*>(parameters);
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+	return hash;
+}
+
+void RenderQueue::Clear()
+{
+	_packets.clear();
+	_constantOffsets.clear();
+	_constantSizes.clear();
+	_constantData.clear();
+	_packetMaterials.clear();
+	_materials.clear();
+	_materialData.clear();
+	_materialIndices.clear();
+	_instanceOffsets.clear();
+	_instanceSizes.clear();
+	_instanceData.clear();
+	_entries.clear();
+	// The ids are given out again each frame, so that they stay small however many shaders, textures and
+	// materials have been used before, and none are kept for resources that have been released
+	_shaderIds.clear();
+	_textureIds.clear();
+	_materialIds.clear();
+	_meshIds.clear();
+}
+
+void RenderQueue::SetInstanceBuffer(RenderHandle instanceBuffer, size_t capacity)
+{
+	_instanceBuffer = instanceBuffer;
+	_instanceBufferCapacity = capacity;
+}
+
+void RenderQueue::SetFrameConstants(const void* constants, size_t size)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(constants);
+	_frameConstants.assign(bytes, bytes + size);
+}
+
+void RenderQueue::SetConstantBuffer(RenderHandle constantBuffer, size_t capacity)
+{
+	_constantBuffer = constantBuffer;
+	_constantRing.Reset(capacity, ConstantBufferAlignment);
+}
+
+// Combine two handles into one value to look up an id with (for example, both shaders identify the program)
+static inline RenderHandle CombineHandles(RenderHandle a, RenderHandle b)
+{
+	return a ^ static_cast<RenderHandle>(b * 0x9E3779B97F4A7C15ull);
+}
+
+uint32_t RenderQueue::AddMaterial(const void* constants, size_t size, uint32_t& hash)
+{
+	// Materials are looked up by the hash of their constants.  In the unlikely event of two different
+	// materials having the same hash, the second one is given the next hash value instead.
+	hash = HashMaterial(constants, size);
+	while (true)
+	{
+		auto result = _materialIndices.emplace(hash, static_cast<uint32_t>(_materials.size()));
+		if (result.second)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(constants);
+			_materials.push_back({ _materialData.size(), size });
+			_materialData.insert(_materialData.end(), bytes, bytes + size);
+			return result.first->second;
+		}
+		const MaterialBlock& material = _materials[result.first->second];
+		if (material.Size == size && memcmp(&_materialData[material.Offset], constants, size) == 0)
+		{
+			return result.first->second;
+		}
+		hash++;
+	}
+}
+
+void RenderQueue::Add(const DrawPacket& packet, const void* materialConstants, size_t materialSize, const void* objectConstants, size_t objectSize)
+{
+	DrawPacket materialPacket = packet;
+	uint32_t material = materialSize > 0 ? AddMaterial(materialConstants, materialSize, materialPacket.Material) : NoConstants;
+	uint32_t shader = GetId(_shaderIds, CombineHandles(packet.VertexShader, packet.PixelShader), ShaderBits);
+	uint32_t texture = GetId(_textureIds, packet.Texture, TextureBits);
+	uint32_t materialId = GetId(_materialIds, materialPacket.Material, MaterialBits);
+	AddPacket(materialPacket, MakeSortKey(shader, texture, materialId, packet.Depth), material, objectConstants, objectSize, nullptr, 0);
+}
+
+void RenderQueue::AddInstance(const DrawPacket& packet, const void* instanceData, size_t instanceSize, const void* materialConstants, size_t materialSize,
+							  const void* objectConstants, size_t objectSize)
+{
+	// Instances are not sorted by depth, so the depth bits are used for the mesh instead
+	DrawPacket materialPacket = packet;
+	uint32_t material = materialSize > 0 ? AddMaterial(materialConstants, materialSize, materialPacket.Material) : NoConstants;
+	uint32_t shader = GetId(_shaderIds, CombineHandles(packet.VertexShader, packet.PixelShader), ShaderBits);
+	uint32_t texture = GetId(_textureIds, packet.Texture, TextureBits);
+	uint32_t materialId = GetId(_materialIds, materialPacket.Material, MaterialBits);
+	uint32_t mesh = GetId(_meshIds, CombineHandles(packet.VertexBuffer, packet.IndexBuffer), DepthBits - 1);
+	AddPacket(materialPacket, MakeSortKey(shader, texture, materialId, 0.0f) | mesh, material, objectConstants, objectSize, instanceData, instanceSize);
+}
+
+void RenderQueue::AddPacket(const DrawPacket& packet, uint64_t key, uint32_t material, const void* objectConstants, size_t objectSize, const void* instanceData, size_t instanceSize)
+{
+	_entries.push_back({ key, static_cast<uint32_t>(_packets.size()) });
+	_packets.push_back(packet);
+	_packetMaterials.push_back(material);
+	_constantOffsets.push_back(_constantData.size());
+	_constantSizes.push_back(objectSize);
+	const uint8_t* bytes = static_cast<const uint8_t*>(objectConstants);
+	_constantData.insert(_constantData.end(), bytes, bytes + objectSize);
+	_instanceOffsets.push_back(_instanceData.size());
+	_instanceSizes.push_back(instanceSize);
+	bytes = static_cast<const uint8_t*>(instanceData);
+	_instanceData.insert(_instanceData.end(), bytes, bytes + instanceSize);
+}
+
+void RenderQueue::Sort()
+{
+	// Least significant digit radix sort, one byte at a time.  Each pass is stable, so after
+	// the last pass the entries are sorted by the whole key.
+	size_t count = _entries.size();
+	_sortBuffer.resize(count);
+	SortEntry* source = _entries.data();
+	SortEntry* destination = _sortBuffer.data();
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		size_t counts[256] = { 0 };
+		for (size_t i = 0; i < count; i++)
+		{
+			counts[(source[i].Key >> shift) & 0xFF]++;
+		}
+		// If every key has the same value for this byte, the pass would not change anything.
+		// This is common, since the ids in the upper bytes are usually small.
+		if (count == 0 || counts[(source[0].Key >> shift) & 0xFF] == count)
+		{
+			continue;
+		}
+		size_t offset = 0;
+		for (size_t& bucket : counts)
+		{
+			size_t bucketCount = bucket;
+			bucket = offset;
+			offset += bucketCount;
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			destination[counts[(source[i].Key >> shift) & 0xFF]++] = source[i];
+		}
+		swap(source, destination);
+	}
+	if (source != _entries.data())
+	{
+		_entries.swap(_sortBuffer);
+	}
+}
+
+// Returns true if two packets can be drawn as instances of the same draw.  The object constants
+// are not compared, since only those of the first instance are used.
+static bool IsSameDraw(const DrawPacket& a, const DrawPacket& b)
+{
+	return a.VertexShader == b.VertexShader && a.PixelShader == b.PixelShader && a.InputLayout == b.InputLayout &&
+		   a.VertexBuffer == b.VertexBuffer && a.IndexBuffer == b.IndexBuffer && a.Texture == b.Texture &&
+		   a.VertexStride == b.VertexStride && a.IndexCount == b.IndexCount &&
+		   a.StartIndex == b.StartIndex && a.BaseVertex == b.BaseVertex && a.Topology == b.Topology &&
+		   a.IndexBufferFormat == b.IndexBufferFormat && a.Material == b.Material;
+}
+
+// Returns the entry after the last one that is drawn along with the one at entryIndex.  For an
+// instanced packet, this takes in the following packets that can be drawn as instances of it.
+size_t RenderQueue::GetDrawEnd(size_t entryIndex) const
+{
+	uint32_t packetIndex = _entries[entryIndex].Packet;
+	size_t instanceSize = _instanceSizes[packetIndex];
+	size_t drawEnd = entryIndex + 1;
+	if (instanceSize > 0)
+	{
+		while (drawEnd < _entries.size() && _instanceSizes[_entries[drawEnd].Packet] == instanceSize &&
+			   IsSameDraw(_packets[packetIndex], _packets[_entries[drawEnd].Packet]))
+		{
+			drawEnd++;
+		}
+	}
+	return drawEnd;
+}
+
+// Copy a block of constants to the end of the staging buffer, starting on a boundary that it can be bound at.
+// Returns the offset of the block.
+uint32_t RenderQueue::StageConstants(const void* constants, size_t size)
+{
+	size_t offset = _constantStaging.size();
+	_constantStaging.resize(offset + _constantRing.Align(size));
+	memcpy(&_constantStaging[offset], constants, size);
+	return static_cast<uint32_t>(offset);
+}
+
+// Lay out the constants needed by the draws starting at firstEntry, for as many draws as will fit in the constant
+// buffer, and write them to it with one call.  The offsets of each draw's constants (relative to baseOffset, where
+// they were written) are left in _drawConstants.  Returns the entry after the last draw whose constants were written.
+size_t RenderQueue::WriteConstants(RenderDevice& device, size_t firstEntry, size_t& baseOffset)
+{
+	// The frame constants and the first material are written again at the start of every write,
+	// since starting again at the beginning of the buffer throws away everything already in it
+	_constantStaging.clear();
+	if (!_frameConstants.empty())
+	{
+		StageConstants(_frameConstants.data(), _frameConstants.size());
+	}
+	uint32_t currentMaterial = NoConstants;
+	size_t capacity = _constantRing.GetCapacity();
+	size_t entryCount = _entries.size();
+	size_t entryIndex = firstEntry;
+	while (entryIndex < entryCount)
+	{
+		uint32_t packetIndex = _entries[entryIndex].Packet;
+		uint32_t material = _packetMaterials[packetIndex];
+		bool materialChanged = material != NoConstants && material != currentMaterial;
+		size_t objectSize = _constantSizes[packetIndex];
+		size_t size = (materialChanged ? _constantRing.Align(_materials[material].Size) : 0) + _constantRing.Align(objectSize);
+		if (entryIndex > firstEntry && _constantStaging.size() + size > capacity)
+		{
+			break;
+		}
+		DrawConstants& constants = _drawConstants[entryIndex];
+		constants.Material = materialChanged ? StageConstants(&_materialData[_materials[material].Offset], _materials[material].Size) : NoConstants;
+		constants.Object = objectSize > 0 ? StageConstants(&_constantData[_constantOffsets[packetIndex]], objectSize) : NoConstants;
+		if (materialChanged)
+		{
+			currentMaterial = material;
+		}
+		entryIndex = GetDrawEnd(entryIndex);
+	}
+
+	if (!_constantStaging.empty())
+	{
+		if (_constantBuffer == 0)
+		{
+			throw logic_error("SetConstantBuffer must be called before submitting packets with constants");
+		}
+		// If this starts again at the beginning of the buffer, the GPU may still be reading the
+		// previous contents, so the buffer is discarded rather than overwritten
+		bool wrapped;
+		baseOffset = _constantRing.Allocate(_constantStaging.size(), wrapped);
+		device.WriteBuffer(_constantBuffer, baseOffset, _constantStaging.data(), _constantStaging.size(), wrapped);
+		_statistics.ConstantWrites++;
+		_statistics.ConstantBytes += _constantStaging.size();
+	}
+	return entryIndex;
+}
+
+void RenderQueue::Submit(RenderDevice& device)
+{
+	_statistics = RenderQueueStatistics();
+
+	// The state that has been set on the device.  The state before the queue is
+	// submitted is unknown, so everything is set for the first packet.
+	bool first = true;
+	DrawPacket current;
+	RenderHandle currentInstanceBuffer = 0;
+	unsigned int currentInstanceStride = 0;
+
+	// Set a piece of state if it differs from what is already set
+	auto change = [&](bool changed, auto setState)
+		{
+			if (first || changed)
+			{
+				setState();
+				_statistics.StateChanges++;
+				return true;
+			}
+			_statistics.StateChangesAvoided++;
+			return false;
+		};
+
+	size_t entryCount = _entries.size();
+	_drawConstants.resize(entryCount);
+	size_t entryIndex = 0;
+	while (entryIndex < entryCount)
+	{
+		// Write the constants for as many draws as will fit in the constant buffer, then draw them
+		size_t baseOffset = 0;
+		size_t writeEnd = WriteConstants(device, entryIndex, baseOffset);
+		if (!_frameConstants.empty())
+		{
+			device.SetConstantBufferRange(FrameConstantsSlot, _constantBuffer, static_cast<unsigned int>(baseOffset),
+										  static_cast<unsigned int>(_constantRing.Align(_frameConstants.size())));
+			_statistics.StateChanges++;
+		}
+
+		while (entryIndex < writeEnd)
+		{
+			uint32_t packetIndex = _entries[entryIndex].Packet;
+			const DrawPacket& packet = _packets[packetIndex];
+			if (change(packet.VertexShader != current.VertexShader || packet.PixelShader != current.PixelShader,
+					   [&] { device.SetShaders(packet.VertexShader, packet.PixelShader); }))
+			{
+				_statistics.ShaderChanges++;
+			}
+			change(packet.InputLayout != current.InputLayout, [&] { device.SetInputLayout(packet.InputLayout); });
+			change(packet.Topology != current.Topology, [&] { device.SetPrimitiveTopology(packet.Topology); });
+			change(packet.VertexBuffer != current.VertexBuffer || packet.VertexStride != current.VertexStride,
+				   [&] { device.SetVertexBuffer(packet.VertexBuffer, packet.VertexStride, 0); });
+			change(packet.IndexBuffer != current.IndexBuffer || packet.IndexBufferFormat != current.IndexBufferFormat,
+				   [&] { device.SetIndexBuffer(packet.IndexBuffer, packet.IndexBufferFormat, 0); });
+			if (packet.Texture != 0)
+			{
+				if (change(packet.Texture != current.Texture, [&] { device.SetTexture(0, packet.Texture); }))
+				{
+					_statistics.TextureChanges++;
+				}
+				current.Texture = packet.Texture;
+			}
+
+			// Materials are only bound when they change, while every draw has its own object constants
+			const DrawConstants& constants = _drawConstants[entryIndex];
+			if (constants.Material != NoConstants)
+			{
+				size_t size = _materials[_packetMaterials[packetIndex]].Size;
+				device.SetConstantBufferRange(MaterialConstantsSlot, _constantBuffer, static_cast<unsigned int>(baseOffset + constants.Material),
+											  static_cast<unsigned int>(_constantRing.Align(size)));
+				_statistics.StateChanges++;
+				_statistics.MaterialChanges++;
+			}
+			if (constants.Object != NoConstants)
+			{
+				device.SetConstantBufferRange(ObjectConstantsSlot, _constantBuffer, static_cast<unsigned int>(baseOffset + constants.Object),
+											  static_cast<unsigned int>(_constantRing.Align(_constantSizes[packetIndex])));
+			}
+
+			size_t drawEnd = GetDrawEnd(entryIndex);
+			size_t instanceSize = _instanceSizes[packetIndex];
+			if (instanceSize == 0)
+			{
+				device.DrawIndexed(packet.IndexCount, packet.StartIndex, packet.BaseVertex);
+				_statistics.DrawCount++;
+			}
+			else
+			{
+				unsigned int instanceStride = static_cast<unsigned int>(instanceSize);
+				change(_instanceBuffer != currentInstanceBuffer || instanceStride != currentInstanceStride,
+					   [&] { device.SetInstanceBuffer(_instanceBuffer, instanceStride, 0); });
+				currentInstanceBuffer = _instanceBuffer;
+				currentInstanceStride = instanceStride;
+
+				// Copy as many instances as will fit in the instance buffer, and draw them
+				size_t maximumInstances = max<size_t>(_instanceBufferCapacity / instanceSize, 1);
+				for (size_t instanceIndex = entryIndex; instanceIndex < drawEnd;)
+				{
+					size_t instanceCount = min(drawEnd - instanceIndex, maximumInstances);
+					_instanceStaging.resize(instanceCount * instanceSize);
+					for (size_t i = 0; i < instanceCount; i++)
+					{
+						memcpy(&_instanceStaging[i * instanceSize], &_instanceData[_instanceOffsets[_entries[instanceIndex + i].Packet]], instanceSize);
+					}
+					device.UpdateBuffer(_instanceBuffer, _instanceStaging.data(), _instanceStaging.size());
+					device.DrawIndexedInstanced(packet.IndexCount, static_cast<unsigned int>(instanceCount), packet.StartIndex, packet.BaseVertex, 0);
+					_statistics.DrawCount++;
+					_statistics.InstancedDrawCount++;
+					_statistics.InstanceCount += instanceCount;
+					instanceIndex += instanceCount;
+				}
+			}
+
+			// Remember what is now set.  The texture is only changed above when used.
+			RenderHandle texture = current.Texture;
+			current = packet;
+			current.Texture = texture;
+			first = false;
+			entryIndex = drawEnd;
+		}
+	}
+}
@@ -0,0 +1,183 @@
+#pragma once
+#include "RenderDevice.h"
+#include "RingAllocator.h"
+#include <vector>
+#include <unordered_map>
+
+using namespace std;
+
+// Everything needed to issue one draw call.  Nodes fill one of these in during
+// Render and add it to the render queue rather than drawing immediately.
+struct DrawPacket
+{
+	RenderHandle		VertexShader{ 0 };
+	RenderHandle		PixelShader{ 0 };
+	RenderHandle		InputLayout{ 0 };
+	RenderHandle		VertexBuffer{ 0 };
+	RenderHandle		IndexBuffer{ 0 };
+	// Bound to pixel shader slot 0.  0 means the shader does not use a texture, so whatever is bound is left alone.
+	RenderHandle		Texture{ 0 };
+	unsigned int		VertexStride{ 0 };
+	unsigned int		IndexCount{ 0 };
+	unsigned int		StartIndex{ 0 };
+	int					BaseVertex{ 0 };
+	PrimitiveTopology	Topology{ PrimitiveTopology::TriangleList };
+	IndexFormat			IndexBufferFormat{ IndexFormat::UInt32 };
+	// Identifies the material parameters.  Packets with the same material are drawn together.  If material
+	// constants are passed to RenderQueue::Add, this is replaced with a hash of them.
+	uint32_t			Material{ 0 };
+	// View space depth, used to draw front to back within each group of packets with the same state
+	float				Depth{ 0 };
+};
+
+struct RenderQueueStatistics
+{
+	size_t				DrawCount{ 0 };
+	// State changes sent to the device
+	size_t				StateChanges{ 0 };
+	// State changes that were skipped because the state was already set
+	size_t				StateChangesAvoided{ 0 };
+	size_t				ShaderChanges{ 0 };
+	size_t				TextureChanges{ 0 };
+	// Draws made with DrawIndexedInstanced (included in DrawCount) and the number of instances they drew
+	size_t				InstancedDrawCount{ 0 };
+	size_t				InstanceCount{ 0 };
+	// Writes to the constant buffer, and the number of bytes written
+	size_t				ConstantWrites{ 0 };
+	size_t				ConstantBytes{ 0 };
+	size_t				MaterialChanges{ 0 };
+};
+
+// The constant buffer slots used for each block of constants
+constexpr unsigned int FrameConstantsSlot = 0;
+constexpr unsigned int MaterialConstantsSlot = 1;
+constexpr unsigned int ObjectConstantsSlot = 2;
+
+// Collects the draw packets for a frame, sorts them to minimise state changes and
+// submits them to a render device.
+//
+// Each packet is given a 64-bit sort key made up of (from most to least significant)
+// the shader, texture, material and depth.  Only the keys and packet indices are
+// sorted (using a radix sort), not the packets themselves.  When the packets are
+// submitted, any state that is already set on the device is not set again.
+//
+// Instanced packets are sorted by mesh rather than depth, so that all of the instances
+// of a mesh end up next to each other.  Each run of instances with the same state is
+// copied into the instance buffer and drawn with a single DrawIndexedInstanced.
+//
+// Constants are split into three blocks: the frame constants (camera and lights) are the
+// same for every draw, material constants are shared by every packet with the same material,
+// and object constants belong to one draw.  When the packets are submitted, the constants
+// they need are laid out one after another and copied into a single dynamic constant buffer
+// with one write, using a RingAllocator so that the GPU can still be reading the previous
+// frame's constants.  Each draw then binds its part of the buffer.  The frame constants are
+// written once and each material once per run of packets that use it, rather than every
+// draw updating a whole buffer of its own.
+
+class RenderQueue
+{
+public:
+	// Remove all packets.  Called at the start of each frame.
+	void Clear();
+
+	// Add a packet.  The material and object constants are bound to MaterialConstantsSlot and
+	// ObjectConstantsSlot; either can be left out by passing a size of 0.  The constants are
+	// copied, so do not need to outlive the call.
+	void Add(const DrawPacket& packet, const void* materialConstants, size_t materialSize, const void* objectConstants, size_t objectSize);
+
+	// Add one instance of an instanced packet.  The instance data is streamed to the second vertex buffer
+	// slot.  Only the object constants of the first instance in each group are used, so they must be the
+	// same for every instance (anything that varies per instance belongs in the instance data).
+	void AddInstance(const DrawPacket& packet, const void* instanceData, size_t instanceSize, const void* materialConstants, size_t materialSize,
+					 const void* objectConstants, size_t objectSize);
+
+	// Constants bound to FrameConstantsSlot for every draw.  These are kept until they are next set.
+	void SetFrameConstants(const void* constants, size_t size);
+
+	// Dynamic constant buffer that the constants are written into.  Frames with more constants than
+	// will fit are split into several writes.
+	void SetConstantBuffer(RenderHandle constantBuffer, size_t capacity);
+
+	// Buffer that instance data is copied into before each instanced draw.  Groups of instances
+	// larger than the buffer are split into several draws.
+	void SetInstanceBuffer(RenderHandle instanceBuffer, size_t capacity);
+
+	// Sort the packets by their keys.  If this is not called, packets are submitted in the order they were added.
+	void Sort();
+
+	void Submit(RenderDevice& device);
+
+	inline size_t GetPacketCount() const { return _packets.size(); }
+	inline uint64_t GetSortKey(size_t position) const { return _entries[position].Key; }
+	// Statistics for the last call to Submit
+	inline const RenderQueueStatistics& GetStatistics() const { return _statistics; }
+
+	static uint64_t MakeSortKey(uint32_t shader, uint32_t texture, uint32_t material, float depth);
+	// Helper for calculating DrawPacket::Material from the material parameters
+	static uint32_t HashMaterial(const void* parameters, size_t size);
+
+private:
+	struct SortEntry
+	{
+		uint64_t		Key;
+		uint32_t		Packet;
+	};
+
+	// Where the constants of a draw were put in the constant buffer for the current write.  NoConstants
+	// means the draw has none (or, for materials, uses the material that is already bound).
+	struct DrawConstants
+	{
+		uint32_t		Material;
+		uint32_t		Object;
+	};
+
+	struct MaterialBlock
+	{
+		size_t			Offset;
+		size_t			Size;
+	};
+
+	static constexpr uint32_t NoConstants = UINT32_MAX;
+
+	vector<DrawPacket>		_packets;
+	vector<size_t>			_constantOffsets;
+	vector<size_t>			_constantSizes;
+	vector<uint8_t>			_constantData;
+	// The material of each packet, as an index into _materials
+	vector<uint32_t>		_packetMaterials;
+	// The constants of each material used this frame, which are kept in _materialData
+	vector<MaterialBlock>	_materials;
+	vector<uint8_t>			_materialData;
+	unordered_map<uint32_t, uint32_t>	_materialIndices;
+	vector<uint8_t>			_frameConstants;
+	RenderHandle			_constantBuffer{ 0 };
+	RingAllocator			_constantRing;
+	// The constants for one write are laid out here before they are copied to the constant buffer
+	vector<uint8_t>			_constantStaging;
+	vector<DrawConstants>	_drawConstants;
+	// Instance data for instanced packets.  The size is 0 for packets that are not instanced.
+	vector<size_t>			_instanceOffsets;
+	vector<size_t>			_instanceSizes;
+	vector<uint8_t>			_instanceData;
+	// Instance data for one draw is gathered here before it is copied to the instance buffer
+	vector<uint8_t>			_instanceStaging;
+	RenderHandle			_instanceBuffer{ 0 };
+	size_t					_instanceBufferCapacity{ 0 };
+	vector<SortEntry>		_entries;
+	vector<SortEntry>		_sortBuffer;
+
+	// Small ids for the shaders, textures, materials and meshes that appear in the sort keys, in the
+	// order they were first added this frame.  They are cleared by Clear.
+	unordered_map<RenderHandle, uint32_t>	_shaderIds;
+	unordered_map<RenderHandle, uint32_t>	_textureIds;
+	unordered_map<uint32_t, uint32_t>		_materialIds;
+	unordered_map<RenderHandle, uint32_t>	_meshIds;
+
+	RenderQueueStatistics	_statistics;
+
+	void AddPacket(const DrawPacket& packet, uint64_t key, uint32_t material, const void* objectConstants, size_t objectSize, const void* instanceData, size_t instanceSize);
+	uint32_t AddMaterial(const void* constants, size_t size, uint32_t& hash);
+	size_t GetDrawEnd(size_t entryIndex) const;
+	uint32_t StageConstants(const void* constants, size_t size);
+	size_t WriteConstants(RenderDevice& device, size_t firstEntry, size_t& baseOffset);
+};
@@ -0,0 +1,35 @@
+#include "RingAllocator.h"
+#include <stdexcept>
+
+void RingAllocator::Reset(size_t capacity, size_t alignment)
+{
+	if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+	{
+		throw logic_error("Ring buffer alignment must be a power of two");
+	}
+	_alignment = alignment;
+	// Only whole aligned blocks can be handed out
+	_capacity = capacity & ~(alignment - 1);
+	_offset = 0;
+	_wrapCount = 0;
+	_started = false;
+}
+
+size_t RingAllocator::Allocate(size_t size, bool& wrapped)
+{
+	size_t alignedSize = Align(size);
+	if (alignedSize > _capacity)
+	{
+		throw logic_error("Allocation is larger than the ring buffer");
+	}
+	wrapped = !_started || _offset + alignedSize > _capacity;
+	if (wrapped)
+	{
+		_wrapCount += _started;
+		_started = true;
+		_offset = 0;
+	}
+	size_t offset = _offset;
+	_offset += alignedSize;
+	return offset;
+}
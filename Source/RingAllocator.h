@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+
+using namespace std;
+
+// Hands out space in a buffer that is filled from start to end and then starts again at the beginning.
+//
+// Used for data that the CPU writes every frame for the GPU to read, such as per-object constants.
+// Space is not handed out twice in one pass through the buffer, so new data can be written while the
+// GPU is still reading earlier allocations (D3D11_MAP_WRITE_NO_OVERWRITE).  When an allocation does
+// not fit in the space that is left, the allocator starts again at the beginning and says so, so the
+// buffer can be discarded (D3D11_MAP_WRITE_DISCARD).  The driver then gives the CPU fresh memory to
+// write to while the GPU finishes with the old contents.
+//
+// This only does the bookkeeping, so it does not depend on Direct3D.
+
+class RingAllocator
+{
+public:
+	RingAllocator() {};
+	RingAllocator(size_t capacity, size_t alignment) { Reset(capacity, alignment); }
+
+	// Start again with an empty buffer.  alignment must be a power of two.
+	void Reset(size_t capacity, size_t alignment);
+
+	// Returns the offset of size bytes (rounded up to the alignment).  wrapped is set to true if the
+	// allocation starts a new pass through the buffer (as the first one always does), which means that
+	// everything allocated before it may be overwritten.  Throws logic_error if size is larger than the buffer.
+	size_t Allocate(size_t size, bool& wrapped);
+
+	inline size_t Align(size_t size) const { return (size + _alignment - 1) & ~(_alignment - 1); }
+	inline size_t GetCapacity() const { return _capacity; }
+	inline size_t GetAlignment() const { return _alignment; }
+	// The offset that the next allocation will start at if it fits
+	inline size_t GetOffset() const { return _offset; }
+	// Number of times the allocator has started again at the beginning
+	inline size_t GetWrapCount() const { return _wrapCount; }
+
+private:
+	size_t		_capacity{ 0 };
+	size_t		_alignment{ 1 };
+	size_t		_offset{ 0 };
+	size_t		_wrapCount{ 0 };
+	bool		_started{ false };
+};
@@ -1,68 +1,165 @@
-// SceneGraph.cpp
-
-#include "SceneGraph.h"
-
-bool SceneGraph::Initialise() {
-    for (SceneNodePointer child : _children) {
-        if (!child->Initialise()) {
-            return false;
-        }
-    }
-    return true;
-}
-
-void SceneGraph::Update(const Matrix& worldTransformation) {
-    // Update the cumulative world transformation for itself
-    SceneNode::Update(worldTransformation);
-
-    // Call the Update method for each child node, passing the combined world transformation
-    for (SceneNodePointer child : _children) {
-        child->Update(_cumulativeWorldTransformation);
-    }
-}
-
-void SceneGraph::Render() {
-    // Call the Render method on each child node
-    for (SceneNodePointer child : _children) {
-        child->Render();
-    }
-}
-
-void SceneGraph::Shutdown() {
-    // Call the Shutdown method on each child node
-    for (SceneNodePointer child : _children) {
-        child->Shutdown();
-    }
-}
-
-void SceneGraph::Add(SceneNodePointer node) {
-    // Add the specified node to the collection of child nodes
-    _children.push_back(node);
-}
-
-void SceneGraph::Remove(SceneNodePointer node) {
-    // Call Remove on all child nodes
-    for (auto it = _children.begin(); it != _children.end(); ++it) {
-        (*it)->Remove(node);
-    }
-
-    // If the child node is the one to remove, remove it from the list of child nodes
-    _children.erase(std::remove(_children.begin(), _children.end(), node), _children.end());
-}
-
-SceneNodePointer SceneGraph::Find(wstring name) {
-    // If we are the node being searched for, return a pointer to ourselves
-    if (_name == name) {
-        return shared_from_this();
-    }
-
-    // If not, call Find on all child nodes
-    for (SceneNodePointer child : _children) {
-        SceneNodePointer foundNode = child->Find(name);
-        if (foundNode != nullptr) {
-            return foundNode;
-        }
-    }
-
-    return nullptr; // Node not found
-}
+// SceneGraph.cpp
+
+#include "SceneGraph.h"
+#include <stdexcept>
+
+SceneGraph::~SceneGraph(void) {
+    // Our children may outlive us if something else holds a pointer to them
+    for (const SceneNodePointer& child : _children) {
+        child->SetParent(nullptr);
+    }
+}
+
+bool SceneGraph::Initialise() {
+    for (const SceneNodePointer& child : _children) {
+        if (!child->Initialise()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Recursive update.  This is only used for graphs that have not been bound to a
+// TransformHierarchy - the framework updates its scene graph through the flattened hierarchy.
+void SceneGraph::Update(const Matrix& worldTransformation) {
+    // Update the cumulative world transformation for itself
+    SceneNode::Update(worldTransformation);
+
+    // Call the Update method for each child node, passing the combined world transformation
+    for (const SceneNodePointer& child : _children) {
+        child->Update(_cumulativeWorldTransformation);
+    }
+}
+
+void SceneGraph::Render() {
+    // Call the Render method on each child node that survived culling
+    for (const SceneNodePointer& child : _children) {
+        if (child->IsVisible()) {
+            child->Render();
+        }
+    }
+}
+
+void SceneGraph::Shutdown() {
+    // Call the Shutdown method on each child node
+    for (const SceneNodePointer& child : _children) {
+        child->Shutdown();
+    }
+}
+
+void SceneGraph::BindTransform(TransformHierarchy* hierarchy, int parentIndex) {
+    // Add ourselves first so that our children can refer to our index as their parent
+    SceneNode::BindTransform(hierarchy, parentIndex);
+    for (const SceneNodePointer& child : _children) {
+        child->BindTransform(hierarchy, _transformIndex);
+    }
+}
+
+void SceneGraph::Add(SceneNodePointer node) {
+    // A node can only belong to one graph at a time, and a graph cannot be added below itself
+    if (node == nullptr || node->GetParent() != nullptr) {
+        throw logic_error("Added a node that is null or already in a scene graph");
+    }
+    if (node.get() == GetRoot()) {
+        throw logic_error("Added a scene graph to itself");
+    }
+
+    // Add the specified node to the collection of child nodes
+    _children.push_back(node);
+    node->SetParent(this);
+
+    // Add the new node and any descendants it has to the name index of this graph and every graph above it
+    for (SceneGraph* graph = this; graph != nullptr; graph = graph->GetParent()) {
+        node->IndexNames(graph->_nameIndex);
+    }
+
+    // The flattened hierarchy needs to be rebuilt to include the new node
+    if (_transformHierarchy != nullptr) {
+        _transformHierarchy->Invalidate();
+    }
+}
+
+void SceneGraph::Remove(SceneNodePointer node) {
+    // The node knows which graph it belongs to, so there is no need to search our children for it.
+    // We just need to check that graph is part of this one.
+    SceneGraph* parent = node->GetParent();
+    if (parent == nullptr || !Contains(parent)) {
+        return;
+    }
+
+    // Remove the node from the list of child nodes of its parent
+    vector<SceneNodePointer>& siblings = parent->_children;
+    siblings.erase(std::remove(siblings.begin(), siblings.end(), node), siblings.end());
+
+    // Remove the node and its descendants from the name indexes of the graphs it was in.  If it is a graph,
+    // its own index already covers just its subtree, so it can be used as it is.
+    for (SceneGraph* graph = parent; graph != nullptr; graph = graph->GetParent()) {
+        node->UnindexNames(graph->_nameIndex);
+    }
+    node->SetParent(nullptr);
+
+    // Detach the removed subtree from the flattened hierarchy and rebuild it before the next update
+    if (parent->_transformHierarchy != nullptr) {
+        parent->_transformHierarchy->Invalidate();
+    }
+    node->BindTransform(nullptr, -1);
+}
+
+SceneNodePointer SceneGraph::Find(const wstring& name) {
+    // Look the name up in our index rather than searching every node.  It only holds the nodes in this graph.
+    auto entry = _nameIndex.find(HashName(name));
+    if (entry != _nameIndex.end()) {
+        for (SceneNode* node : entry->second) {
+            // Compare the names as well in case of a hash collision
+            if (node->GetName() == name) {
+                return node->shared_from_this();
+            }
+        }
+    }
+    return nullptr; // Node not found
+}
+
+vector<SceneNodePointer> SceneGraph::FindAll(const wstring& name) {
+    vector<SceneNodePointer> foundNodes;
+    auto entry = _nameIndex.find(HashName(name));
+    if (entry != _nameIndex.end()) {
+        for (SceneNode* node : entry->second) {
+            if (node->GetName() == name) {
+                foundNodes.push_back(node->shared_from_this());
+            }
+        }
+    }
+    return foundNodes;
+}
+
+void SceneGraph::IndexNames(SceneNodeNameIndex& nameIndex) {
+    SceneNode::IndexNames(nameIndex);
+    for (const SceneNodePointer& child : _children) {
+        child->IndexNames(nameIndex);
+    }
+}
+
+void SceneGraph::UnindexNames(SceneNodeNameIndex& nameIndex) {
+    SceneNode::UnindexNames(nameIndex);
+    for (const SceneNodePointer& child : _children) {
+        child->UnindexNames(nameIndex);
+    }
+}
+
+bool SceneGraph::Contains(const SceneNode* node) const {
+    // Walk up from the node towards the root of the tree looking for ourselves
+    for (const SceneNode* current = node; current != nullptr; current = current->GetParent()) {
+        if (current == this) {
+            return true;
+        }
+    }
+    return false;
+}
+
+SceneGraph* SceneGraph::GetRoot() {
+    SceneGraph* root = this;
+    while (root->GetParent() != nullptr) {
+        root = root->GetParent();
+    }
+    return root;
+}
@@ -1,25 +1,44 @@
-#pragma once
-#include "SceneNode.h"
-#include <vector>
-
-class SceneGraph : public SceneNode
-{
-public:
-	SceneGraph() : SceneNode(L"Root") {};
-	SceneGraph(wstring name) : SceneNode(name) {};
-	~SceneGraph(void) {};
-
-	virtual bool Initialise(void);
-	virtual void Update(const Matrix& worldTransformation);
-	virtual void Render(void);
-	virtual void Shutdown(void);
-
-	void Add(SceneNodePointer node);
-	void Remove(SceneNodePointer node);
-	SceneNodePointer Find(wstring name);
-
-private:
-	vector<SceneNodePointer> _children;
-};
-
-typedef shared_ptr<SceneGraph>			 SceneGraphPointer;
+#pragma once
+#include "SceneNode.h"
+#include <vector>
+
+class SceneGraph : public SceneNode
+{
+public:
+	SceneGraph() : SceneGraph(L"Root") {};
+	// Graphs have no geometry of their own, so their bounds are just those of their children
+	SceneGraph(wstring name) : SceneNode(name) { _nameIndex[_nameHash].push_back(this); _localBounds = AxisAlignedBox::Empty(); };
+	~SceneGraph(void);
+
+	virtual bool Initialise(void);
+	virtual void Update(const Matrix& worldTransformation);
+	virtual void Render(void);
+	virtual void Shutdown(void);
+	virtual void BindTransform(TransformHierarchy* hierarchy, int parentIndex);
+
+	// Adding a node that already belongs to a graph (this one or another), or the root of this graph, throws a logic_error
+	void Add(SceneNodePointer node);
+	void Remove(SceneNodePointer node);
+
+	// Find a node in this graph by name.  If there is more than one node with the
+	// same name, Find returns one of them and FindAll returns all of them.
+	SceneNodePointer Find(const wstring& name);
+	vector<SceneNodePointer> FindAll(const wstring& name);
+
+	virtual void IndexNames(SceneNodeNameIndex& nameIndex);
+	virtual void UnindexNames(SceneNodeNameIndex& nameIndex);
+
+	// Returns true if node is this graph or one of its descendants
+	bool Contains(const SceneNode* node) const;
+	SceneGraph* GetRoot();
+
+private:
+	vector<SceneNodePointer> _children;
+
+	// Name index covering this graph and every node below it.  Add and Remove keep the index of each
+	// graph above a subtree in step as it is attached and detached, so Find never has to check
+	// where a node is, at the cost of a node being in the index of every graph above it.
+	SceneNodeNameIndex		 _nameIndex;
+};
+
+typedef shared_ptr<SceneGraph>			 SceneGraphPointer;
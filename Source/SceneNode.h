@@ -1,40 +1,140 @@
-#pragma once
-#include "core.h"
-#include "DirectXCore.h"
-
-using namespace std;
-
-// Abstract base class for all nodes of the scene graph.  
-// This scene graph implements the Composite Design Pattern
-
-class SceneNode;
-
-typedef shared_ptr<SceneNode>	SceneNodePointer;
-
-class SceneNode : public enable_shared_from_this<SceneNode>
-{
-public:
-	SceneNode(wstring name) {_name = name;};
-	~SceneNode(void) {};
-
-	// Core methods
-	virtual bool Initialise() = 0;
-	virtual void Update(const Matrix& worldTransformation) { _cumulativeWorldTransformation = _thisWorldTransformation * worldTransformation; }	
-	virtual void Render() = 0;
-	virtual void Shutdown() {}
-
-	void SetWorldTransform(const Matrix& worldTransformation) { _thisWorldTransformation = worldTransformation; }
-		
-	// Although only required in the composite class, these are provided
-	// in order to simplify the code base for recursive operations
-
-	virtual void Add(SceneNodePointer node) {}
-	virtual void Remove(SceneNodePointer node) {};
-	virtual	SceneNodePointer Find(wstring name) { return (_name == name) ? shared_from_this() : nullptr; }
-
-protected:
-	Matrix				_thisWorldTransformation;
-	Matrix				_cumulativeWorldTransformation;
-	wstring				_name;
-};
-
+#pragma once
+#include "SimpleMath.h"
+#include "Bounds.h"
+#include "TransformHierarchy.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+// Abstract base class for all nodes of the scene graph.  
+// This scene graph implements the Composite Design Pattern
+
+class SceneNode;
+class SceneGraph;
+
+typedef shared_ptr<SceneNode>	SceneNodePointer;
+
+// Index from the hash of a node name to all of the nodes with that name
+typedef unordered_map<uint64_t, vector<SceneNode*>>	SceneNodeNameIndex;
+
+class SceneNode : public enable_shared_from_this<SceneNode>
+{
+public:
+	SceneNode(wstring name) {_name = name; _nameHash = HashName(name); };
+	~SceneNode(void) {};
+
+	// Core methods
+	virtual bool Initialise() = 0;
+	virtual void Update(const Matrix& worldTransformation) { _cumulativeWorldTransformation = _thisWorldTransformation * worldTransformation; }	
+	virtual void Render() = 0;
+	virtual void Shutdown() {}
+
+	void SetWorldTransform(const Matrix& worldTransformation) 
+	{ 
+		_thisWorldTransformation = worldTransformation; 
+		if (_transformHierarchy != nullptr)
+		{
+			_transformHierarchy->SetLocalTransformation(_transformIndex, worldTransformation);
+		}
+	}
+
+	// Returns the world transformation calculated by the last update.  If the node has been
+	// bound to a flattened transform hierarchy, the matrix is held there rather than in the node.
+	const Matrix& GetCumulativeWorldTransformation() const 
+	{ 
+		return (_transformHierarchy != nullptr) ? _transformHierarchy->GetWorldTransformation(_transformIndex) : _cumulativeWorldTransformation; 
+	}
+
+	// Returns world x viewProjection for rendering.  If the node is visible in a flattened transform hierarchy,
+	// this was calculated along with every other visible node's after culling.
+	Matrix GetWorldViewProjection(const Matrix& viewProjection) const
+	{
+		return (_transformHierarchy != nullptr && IsVisible()) ? _transformHierarchy->GetWorldViewProjection(_transformIndex) : GetCumulativeWorldTransformation() * viewProjection;
+	}
+
+	// Add this node to a flattened transform hierarchy (or detach it if hierarchy is nullptr)
+	virtual void BindTransform(TransformHierarchy* hierarchy, int parentIndex) 
+	{ 
+		_transformHierarchy = hierarchy;
+		_transformIndex = (hierarchy != nullptr) ? hierarchy->Add(this, parentIndex, _thisWorldTransformation, _localBounds) : -1;
+	}
+
+	// Set the bounds of the node's geometry in its own coordinate space.  Nodes that do
+	// not set their bounds are treated as infinitely large so that they are never culled.
+	void SetLocalBounds(const AxisAlignedBox& localBounds)
+	{
+		_localBounds = localBounds;
+		if (_transformHierarchy != nullptr)
+		{
+			_transformHierarchy->SetLocalBounds(_transformIndex, localBounds);
+		}
+	}
+	inline const AxisAlignedBox& GetLocalBounds() const { return _localBounds; }
+
+	// Returns false if the node was culled during the last frame
+	inline bool IsVisible() const { return (_transformHierarchy != nullptr) ? _transformHierarchy->IsVisible(_transformIndex) : true; }
+
+	// Occluders are drawn into the framework's OcclusionCuller to hide the nodes behind them.  Only nodes that draw
+	// a mesh can be occluders, and this must be set before the node is initialised.
+	inline void SetOccluder(bool occluder) { _occluder = occluder; }
+	inline bool IsOccluder() const { return _occluder; }
+		
+	// Although only required in the composite class, these are provided
+	// in order to simplify the code base for recursive operations
+
+	virtual void Add(SceneNodePointer node) {}
+	virtual void Remove(SceneNodePointer node) {};
+	virtual	SceneNodePointer Find(const wstring& name) { return (_name == name) ? shared_from_this() : nullptr; }
+
+	inline const wstring& GetName() const { return _name; }
+	inline uint64_t GetNameHash() const { return _nameHash; }
+	inline SceneGraph* GetParent() const { return _parent; }
+
+	// Called by SceneGraph when this node is added to or removed from a graph
+	virtual void SetParent(SceneGraph* parent) { _parent = parent; }
+
+	// Add or remove this node (and, for composites, all of their descendants) from a name index
+	virtual void IndexNames(SceneNodeNameIndex& nameIndex) { nameIndex[_nameHash].push_back(this); }
+	virtual void UnindexNames(SceneNodeNameIndex& nameIndex)
+	{
+		auto entry = nameIndex.find(_nameHash);
+		if (entry != nameIndex.end())
+		{
+			vector<SceneNode*>& nodes = entry->second;
+			nodes.erase(std::remove(nodes.begin(), nodes.end(), this), nodes.end());
+			if (nodes.empty())
+			{
+				nameIndex.erase(entry);
+			}
+		}
+	}
+
+	// 64-bit FNV-1a hash of a node name
+	static uint64_t HashName(const wstring& name)
+	{
+		uint64_t hash = 14695981039346656037ULL;
+		for (wchar_t character : name)
+		{
+			hash ^= static_cast<uint64_t>(character);
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+
+protected:
+	Matrix				_thisWorldTransformation;
+	Matrix				_cumulativeWorldTransformation;
+	wstring				_name;
+	uint64_t			_nameHash;
+	SceneGraph*			_parent{ nullptr };
+	AxisAlignedBox		_localBounds{ AxisAlignedBox::Infinite() };
+	bool				_occluder{ false };
+
+	TransformHierarchy*	_transformHierarchy{ nullptr };
+	int					_transformIndex{ -1 };
+};
+
@@ -0,0 +1,287 @@
+#include "ShaderBytecodeCache.h"
+#include <algorithm>
+#include <cstring>
+
+// The archive is a header, followed by a table of entries sorted by key, followed by the
+// bytecode.  All values are little endian.
+//
+// Change ArchiveVersion if the format changes, and KeyVersion if anything changes that
+// affects the compiled bytecode but is not part of the key (such as the compiler version).
+
+constexpr uint32_t ArchiveMagic = 0x43424853;		// "SHBC"
+constexpr uint32_t ArchiveVersion = 1;
+constexpr uint64_t KeyVersion = 1;
+
+struct ArchiveHeader
+{
+	uint32_t	Magic;
+	uint32_t	Version;
+	uint64_t	EntryCount;
+};
+
+struct ShaderBytecodeCache::ArchiveEntry
+{
+	uint64_t	Key;
+	// Offset of the bytecode from the start of the archive
+	uint64_t	Offset;
+	uint64_t	Size;
+	uint64_t	Checksum;
+};
+
+// 64-bit FNV-1a
+constexpr uint64_t HashBasis = 14695981039346656037ull;
+
+static uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+// Strings are hashed with their length so that, for example, ("ab", "c") and ("a", "bc") give different hashes
+template <typename String>
+static uint64_t HashString(uint64_t hash, const String& text)
+{
+	uint64_t length = text.size();
+	hash = HashBytes(hash, &length, sizeof(length));
+	for (auto character : text)
+	{
+		uint32_t c = static_cast<uint32_t>(character);
+		hash = HashBytes(hash, &c, sizeof(c));
+	}
+	return hash;
+}
+
+wstring ShaderDescription::GetKey() const
+{
+	// None of the parts can contain a newline, so use that as the separator
+	wstring key = FileName + L'\n' + wstring(EntryPoint.begin(), EntryPoint.end()) + L'\n' + wstring(Profile.begin(), Profile.end()) + L'\n' + to_wstring(Flags);
+	for (const pair<string, string>& define : Defines)
+	{
+		key += L'\n' + wstring(define.first.begin(), define.first.end()) + L'=' + wstring(define.second.begin(), define.second.end());
+	}
+	return key;
+}
+
+bool ShaderBytecodeCache::Load(const wstring& archiveFileName)
+{
+	_archive.Close();
+	_archiveEntries = nullptr;
+	_archiveEntryCount = 0;
+	_usedArchiveEntries.clear();
+	if (!_archive.Open(archiveFileName))
+	{
+		return false;
+	}
+
+	// Check that everything in the archive is consistent before using any of it
+	const uint8_t* data = _archive.GetData();
+	size_t size = _archive.GetSize();
+	bool valid = size >= sizeof(ArchiveHeader);
+	const ArchiveHeader* header = reinterpret_cast<const ArchiveHeader*>(data);
+	valid = valid && header->Magic == ArchiveMagic && header->Version == ArchiveVersion;
+	valid = valid && header->EntryCount <= (size - sizeof(ArchiveHeader)) / sizeof(ArchiveEntry);
+	if (valid)
+	{
+		const ArchiveEntry* entries = reinterpret_cast<const ArchiveEntry*>(data + sizeof(ArchiveHeader));
+		size_t entryCount = static_cast<size_t>(header->EntryCount);
+		uint64_t dataStart = sizeof(ArchiveHeader) + entryCount * sizeof(ArchiveEntry);
+		for (size_t i = 0; i < entryCount && valid; i++)
+		{
+			const ArchiveEntry& entry = entries[i];
+			valid = (i == 0 || entries[i - 1].Key < entry.Key) &&
+					entry.Offset >= dataStart && entry.Offset <= size && entry.Size <= size - entry.Offset &&
+					HashBytes(HashBasis, data + entry.Offset, static_cast<size_t>(entry.Size)) == entry.Checksum;
+		}
+		if (valid)
+		{
+			_archiveEntries = entries;
+			_archiveEntryCount = entryCount;
+		}
+	}
+	if (!valid)
+	{
+		_archive.Close();
+	}
+	return valid;
+}
+
+bool ShaderBytecodeCache::Save(const wstring& archiveFileName)
+{
+	if (_compiledEntries.empty() && _usedArchiveEntries.size() == _archiveEntryCount)
+	{
+		return true;
+	}
+
+	// Gather the entries to keep.  Archive entries that were not used this session are
+	// probably for old versions of the shaders, so are dropped.
+	vector<pair<uint64_t, vector<uint8_t>>> entries;
+	for (size_t i = 0; i < _archiveEntryCount; i++)
+	{
+		const ArchiveEntry& entry = _archiveEntries[i];
+		if (_usedArchiveEntries.count(entry.Key) != 0)
+		{
+			const uint8_t* byteCode = _archive.GetData() + entry.Offset;
+			entries.emplace_back(entry.Key, vector<uint8_t>(byteCode, byteCode + entry.Size));
+		}
+	}
+	for (const auto& compiled : _compiledEntries)
+	{
+		entries.emplace_back(compiled.first, compiled.second);
+	}
+	sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	ArchiveHeader header = { ArchiveMagic, ArchiveVersion, entries.size() };
+	uint64_t offset = sizeof(ArchiveHeader) + entries.size() * sizeof(ArchiveEntry);
+	vector<uint8_t> archive(static_cast<size_t>(offset));
+	memcpy(archive.data(), &header, sizeof(header));
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		const vector<uint8_t>& byteCode = entries[i].second;
+		ArchiveEntry entry = { entries[i].first, offset, byteCode.size(), HashBytes(HashBasis, byteCode.data(), byteCode.size()) };
+		memcpy(archive.data() + sizeof(ArchiveHeader) + i * sizeof(ArchiveEntry), &entry, sizeof(entry));
+		archive.insert(archive.end(), byteCode.begin(), byteCode.end());
+		offset += byteCode.size();
+	}
+
+	// The archive has to be closed before it can be replaced
+	_archive.Close();
+	_archiveEntries = nullptr;
+	_archiveEntryCount = 0;
+	bool saved = MappedFile::WriteFile(archiveFileName, archive.data(), archive.size());
+	if (saved && Load(archiveFileName))
+	{
+		// Everything in the new archive was used this session
+		for (size_t i = 0; i < _archiveEntryCount; i++)
+		{
+			_usedArchiveEntries.insert(_archiveEntries[i].Key);
+		}
+		_compiledEntries.clear();
+	}
+	return saved;
+}
+
+const ShaderBytecodeCache::ArchiveEntry* ShaderBytecodeCache::FindArchiveEntry(uint64_t key) const
+{
+	const ArchiveEntry* end = _archiveEntries + _archiveEntryCount;
+	const ArchiveEntry* entry = lower_bound(_archiveEntries, end, key, [](const ArchiveEntry& a, uint64_t b) { return a.Key < b; });
+	return entry != end && entry->Key == key ? entry : nullptr;
+}
+
+bool ShaderBytecodeCache::GetByteCode(const ShaderDescription& description, vector<uint8_t>& byteCode)
+{
+	uint64_t key = CalculateKey(description);
+	if (key != 0)
+	{
+		auto compiled = _compiledEntries.find(key);
+		if (compiled != _compiledEntries.end())
+		{
+			byteCode = compiled->second;
+			_hitCount++;
+			return true;
+		}
+		const ArchiveEntry* entry = FindArchiveEntry(key);
+		if (entry != nullptr)
+		{
+			const uint8_t* data = _archive.GetData() + entry->Offset;
+			byteCode.assign(data, data + entry->Size);
+			_usedArchiveEntries.insert(key);
+			_hitCount++;
+			return true;
+		}
+	}
+
+	_missCount++;
+	if (!_compiler(description, byteCode))
+	{
+		return false;
+	}
+	// If the source could not be read, there is nothing reliable to key the bytecode on, so it is not cached
+	if (key != 0)
+	{
+		_compiledEntries[key] = byteCode;
+	}
+	return true;
+}
+
+uint64_t ShaderBytecodeCache::CalculateKey(const ShaderDescription& description) const
+{
+	uint64_t hash = HashBytes(HashBasis, &KeyVersion, sizeof(KeyVersion));
+	unordered_set<wstring> visited;
+	HashSourceFile(description.FileName, hash, visited);
+	if (hash == 0)
+	{
+		return 0;
+	}
+	hash = HashString(hash, description.EntryPoint);
+	hash = HashString(hash, description.Profile);
+	hash = HashBytes(hash, &description.Flags, sizeof(description.Flags));
+	for (const pair<string, string>& define : description.Defines)
+	{
+		hash = HashString(hash, define.first);
+		hash = HashString(hash, define.second);
+	}
+	// 0 is used to mean that there is no key
+	return hash != 0 ? hash : 1;
+}
+
+void ShaderBytecodeCache::HashSourceFile(const wstring& fileName, uint64_t& hash, unordered_set<wstring>& visited) const
+{
+	// Only hash each file once, which also stops recursive includes from looping forever
+	if (!visited.insert(fileName).second)
+	{
+		return;
+	}
+	MappedFile source;
+	if (!source.Open(fileName))
+	{
+		// The main file must exist.  Missing includes may be inside an #if, so just hash the name.
+		hash = visited.size() == 1 ? 0 : HashString(hash, fileName);
+		return;
+	}
+	const char* text = reinterpret_cast<const char*>(source.GetData());
+	size_t size = source.GetSize();
+	hash = HashString(hash, fileName);
+	hash = HashBytes(hash, text, size);
+
+	// Includes are found relative to the directory of the file that includes them, in the same
+	// way as the standard include handler.  Only #include "file" is handled; system includes
+	// are not used by shaders.
+	size_t directoryEnd = fileName.find_last_of(L"/\\");
+	wstring directory = directoryEnd == wstring::npos ? L"" : fileName.substr(0, directoryEnd + 1);
+	size_t position = 0;
+	while (position < size && hash != 0)
+	{
+		size_t lineEnd = position;
+		while (lineEnd < size && text[lineEnd] != '\n')
+		{
+			lineEnd++;
+		}
+		size_t i = position;
+		while (i < lineEnd && (text[i] == ' ' || text[i] == '\t'))
+		{
+			i++;
+		}
+		if (i < lineEnd && text[i] == '#')
+		{
+			i++;
+			while (i < lineEnd && (text[i] == ' ' || text[i] == '\t'))
+			{
+				i++;
+			}
+			if (lineEnd - i > 7 && strncmp(text + i, "include", 7) == 0)
+			{
+				size_t nameStart = find(text + i + 7, text + lineEnd, '"') - text + 1;
+				size_t nameEnd = find(text + min(nameStart, lineEnd), text + lineEnd, '"') - text;
+				if (nameStart < lineEnd && nameEnd < lineEnd)
+				{
+					HashSourceFile(directory + wstring(text + nameStart, text + nameEnd), hash, visited);
+				}
+			}
+		}
+		position = lineEnd + 1;
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "MappedFile.h"
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace std;
+
+// Everything that affects the result of compiling a shader
+struct ShaderDescription
+{
+	wstring							FileName;
+	string							EntryPoint;
+	string							Profile;
+	vector<pair<string, string>>	Defines;
+	unsigned int					Flags{ 0 };
+
+	// Unique string for this description, used as the key in the in-memory cache
+	wstring GetKey() const;
+};
+
+// Persistent cache of compiled shader bytecode.
+//
+// Bytecode is stored in a single archive file that is memory mapped when loaded.  Each
+// entry is keyed by a hash of the shader source, the source of every file it includes,
+// the entry point, profile, defines and flags, so editing a shader or any of its
+// includes means the old entry is no longer found and the shader is recompiled.
+// Entries that were not used are dropped the next time the archive is saved.
+//
+// The archive is validated when it is loaded (header, table and a checksum of every
+// entry); if anything is wrong, the whole archive is ignored.  The compiler is passed
+// in, so this does not depend on Direct3D.
+
+class ShaderBytecodeCache
+{
+public:
+	// Compile a shader, returning false if it failed.  Exceptions thrown by the compiler are passed on to the
+	// caller of GetByteCode.
+	typedef function<bool(const ShaderDescription& description, vector<uint8_t>& byteCode)> Compiler;
+
+	ShaderBytecodeCache(Compiler compiler) : _compiler(compiler) {};
+
+	// Returns false if the archive does not exist or is not valid.  Either way, the cache can still be used.
+	bool Load(const wstring& archiveFileName);
+	// Write every entry used since the archive was loaded.  Does nothing if nothing has changed.
+	bool Save(const wstring& archiveFileName);
+
+	// Get the bytecode for a shader, compiling it if it is not in the cache
+	bool GetByteCode(const ShaderDescription& description, vector<uint8_t>& byteCode);
+
+	// Hash of everything that affects the compiled shader.  Returns 0 if the source cannot be read.
+	uint64_t CalculateKey(const ShaderDescription& description) const;
+
+	inline size_t GetHitCount() const { return _hitCount; }
+	inline size_t GetMissCount() const { return _missCount; }
+	inline size_t GetArchiveEntryCount() const { return _archiveEntryCount; }
+
+private:
+	struct ArchiveEntry;
+
+	Compiler								_compiler;
+	MappedFile								_archive;
+	// Points into the archive
+	const ArchiveEntry*						_archiveEntries{ nullptr };
+	size_t									_archiveEntryCount{ 0 };
+	// Keys of the archive entries used this session, and shaders compiled this session
+	unordered_set<uint64_t>					_usedArchiveEntries;
+	unordered_map<uint64_t, vector<uint8_t>>	_compiledEntries;
+	size_t									_hitCount{ 0 };
+	size_t									_missCount{ 0 };
+
+	const ArchiveEntry* FindArchiveEntry(uint64_t key) const;
+	void HashSourceFile(const wstring& fileName, uint64_t& hash, unordered_set<wstring>& visited) const;
+};
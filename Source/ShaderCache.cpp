@@ -0,0 +1,133 @@
+#include "ShaderCache.h"
+#include <cstring>
+
+// Compiled bytecode is kept in this file in the working directory
+#define ShaderArchiveFileName	L"ShaderCache.bin"
+
+ShaderCache::ShaderCache(ComPtr<ID3D11Device> device) :
+	_device(device),
+	_byteCodeCache([this](const ShaderDescription& description, vector<uint8_t>& byteCode) { return CompileFromFile(description, byteCode); })
+{
+	_byteCodeCache.Load(ShaderArchiveFileName);
+}
+
+void ShaderCache::SaveByteCode()
+{
+	_byteCodeCache.Save(ShaderArchiveFileName);
+}
+
+unsigned int ShaderCache::GetDefaultFlags()
+{
+	unsigned int shaderCompileFlags = 0;
+#if defined( _DEBUG )
+	shaderCompileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#endif
+	return shaderCompileFlags;
+}
+
+CompiledShaderPointer ShaderCache::GetShader(const ShaderDescription& description)
+{
+	wstring key = description.GetKey();
+	CompiledShaderPointer shader = _shaders[key].lock();
+	if (shader)
+	{
+		_hitCount++;
+		return shader;
+	}
+
+	shader = make_shared<CompiledShader>();
+	shader->Key = key;
+	shader->ByteCode = Compile(description);
+	if (description.Profile.compare(0, 2, "vs") == 0)
+	{
+		ThrowIfFailed(_device->CreateVertexShader(shader->ByteCode->GetBufferPointer(), shader->ByteCode->GetBufferSize(), NULL, shader->VertexShader.GetAddressOf()));
+	}
+	else
+	{
+		ThrowIfFailed(_device->CreatePixelShader(shader->ByteCode->GetBufferPointer(), shader->ByteCode->GetBufferSize(), NULL, shader->PixelShader.GetAddressOf()));
+	}
+	_shaders[key] = shader;
+	return shader;
+}
+
+CompiledShaderPointer ShaderCache::GetVertexShader(const wstring& fileName, const string& entryPoint, const vector<pair<string, string>>& defines)
+{
+	return GetShader({ fileName, entryPoint, "vs_5_0", defines, GetDefaultFlags() });
+}
+
+CompiledShaderPointer ShaderCache::GetPixelShader(const wstring& fileName, const string& entryPoint, const vector<pair<string, string>>& defines)
+{
+	return GetShader({ fileName, entryPoint, "ps_5_0", defines, GetDefaultFlags() });
+}
+
+ComPtr<ID3DBlob> ShaderCache::Compile(const ShaderDescription& description)
+{
+	// Look in the bytecode cache first, and only compile the shader if it is not there
+	// CompileFromFile throws if the shader does not compile
+	vector<uint8_t> byteCode;
+	if (!_byteCodeCache.GetByteCode(description, byteCode))
+	{
+		ThrowIfFailed(E_FAIL);
+	}
+	ComPtr<ID3DBlob> blob;
+	ThrowIfFailed(D3DCreateBlob(byteCode.size(), blob.GetAddressOf()));
+	memcpy(blob->GetBufferPointer(), byteCode.data(), byteCode.size());
+	return blob;
+}
+
+bool ShaderCache::CompileFromFile(const ShaderDescription& description, vector<uint8_t>& byteCode)
+{
+	// D3DCompileFromFile needs the defines as a null terminated array
+	vector<D3D_SHADER_MACRO> macros;
+	for (const pair<string, string>& define : description.Defines)
+	{
+		macros.push_back({ define.first.c_str(), define.second.c_str() });
+	}
+	macros.push_back({ nullptr, nullptr });
+
+	ComPtr<ID3DBlob> byteCodeBlob = nullptr;
+	ComPtr<ID3DBlob> compilationMessages = nullptr;
+	HRESULT hr = D3DCompileFromFile(description.FileName.c_str(),
+		macros.data(), D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		description.EntryPoint.c_str(), description.Profile.c_str(),
+		description.Flags, 0,
+		byteCodeBlob.GetAddressOf(),
+		compilationMessages.GetAddressOf());
+
+	if (compilationMessages.Get() != nullptr)
+	{
+		// If there were any compilation messages, display them
+		MessageBoxA(0, (char*)compilationMessages->GetBufferPointer(), 0, 0);
+	}
+	// Throw here rather than returning false, so that the failure is not lost on the way out of the bytecode cache
+	ThrowIfFailed(hr);
+	const uint8_t* data = static_cast<const uint8_t*>(byteCodeBlob->GetBufferPointer());
+	byteCode.assign(data, data + byteCodeBlob->GetBufferSize());
+	_compileCount++;
+	return true;
+}
+
+InputLayoutPointer ShaderCache::GetInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, unsigned int elementCount, const CompiledShaderPointer& vertexShader)
+{
+	// The layout can be shared by any vertex shader with the same input signature, but
+	// comparing signatures is more work than it saves, so the vertex shader is part of the key
+	wstring key = vertexShader->Key;
+	for (unsigned int i = 0; i < elementCount; i++)
+	{
+		const D3D11_INPUT_ELEMENT_DESC& element = elements[i];
+		key += L'\n' + wstring(element.SemanticName, element.SemanticName + strlen(element.SemanticName));
+		key += L' ' + to_wstring(element.SemanticIndex) + L' ' + to_wstring(element.Format) + L' ' + to_wstring(element.InputSlot);
+		key += L' ' + to_wstring(element.AlignedByteOffset) + L' ' + to_wstring(element.InputSlotClass) + L' ' + to_wstring(element.InstanceDataStepRate);
+	}
+
+	InputLayoutPointer inputLayout = _inputLayouts[key].lock();
+	if (inputLayout)
+	{
+		_hitCount++;
+		return inputLayout;
+	}
+	inputLayout = make_shared<InputLayout>();
+	ThrowIfFailed(_device->CreateInputLayout(elements, elementCount, vertexShader->ByteCode->GetBufferPointer(), vertexShader->ByteCode->GetBufferSize(), inputLayout->Layout.GetAddressOf()));
+	_inputLayouts[key] = inputLayout;
+	return inputLayout;
+}
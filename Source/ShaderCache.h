@@ -0,0 +1,70 @@
+#pragma once
+#include "DirectXCore.h"
+#include "ShaderBytecodeCache.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+using namespace std;
+
+// A compiled shader.  Only one of VertexShader and PixelShader is set, depending on the profile.
+struct CompiledShader
+{
+	wstring							Key;
+	ComPtr<ID3DBlob>				ByteCode;
+	ComPtr<ID3D11VertexShader>		VertexShader;
+	ComPtr<ID3D11PixelShader>		PixelShader;
+};
+
+struct InputLayout
+{
+	ComPtr<ID3D11InputLayout>		Layout;
+};
+
+typedef shared_ptr<CompiledShader>	CompiledShaderPointer;
+typedef shared_ptr<InputLayout>		InputLayoutPointer;
+
+// Process-wide cache of compiled shaders and input layouts.
+//
+// Nodes ask the cache for their shaders rather than compiling them themselves, so each
+// unique combination of file, entry point, profile, defines and flags is only compiled
+// once no matter how many nodes use it.  The cache only holds weak references; a shader
+// or layout is released when the last node using it is destroyed.
+//
+// Compiled bytecode is also kept on disk between runs (see ShaderBytecodeCache), so
+// shaders are only compiled from source when they, or a file they include, change.
+
+class ShaderCache
+{
+public:
+	ShaderCache(ComPtr<ID3D11Device> device);
+
+	// Write any newly compiled bytecode to the archive on disk.  Called once the scene has been initialised.
+	void SaveByteCode();
+
+	CompiledShaderPointer GetShader(const ShaderDescription& description);
+	// Helpers for shader model 5 shaders compiled with the default flags
+	CompiledShaderPointer GetVertexShader(const wstring& fileName, const string& entryPoint, const vector<pair<string, string>>& defines = {});
+	CompiledShaderPointer GetPixelShader(const wstring& fileName, const string& entryPoint, const vector<pair<string, string>>& defines = {});
+
+	// Input layouts depend on the elements and the input signature of the vertex shader
+	InputLayoutPointer GetInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, unsigned int elementCount, const CompiledShaderPointer& vertexShader);
+
+	// Flags used to compile shaders (debug information in debug builds)
+	static unsigned int GetDefaultFlags();
+
+	inline size_t GetCompileCount() const { return _compileCount; }
+	inline size_t GetHitCount() const { return _hitCount; }
+
+private:
+	ComPtr<ID3D11Device>								_device;
+	ShaderBytecodeCache									_byteCodeCache;
+	unordered_map<wstring, weak_ptr<CompiledShader>>	_shaders;
+	unordered_map<wstring, weak_ptr<InputLayout>>		_inputLayouts;
+	size_t												_compileCount{ 0 };
+	size_t												_hitCount{ 0 };
+
+	ComPtr<ID3DBlob> Compile(const ShaderDescription& description);
+	bool CompileFromFile(const ShaderDescription& description, vector<uint8_t>& byteCode);
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include "SimpleMath.h"
+
+using namespace DirectX;
+using namespace SimpleMath;
+
+// The structures shared by the CPU and shader.hlsl and texturedShader.hlsl.  These are kept apart from
+// the input layouts in Geometry.h so that code that does not use Direct3D (such as the software
+// rasteriser) can use them.
+
+// The constants used by the shaders (see Constants.hlsli), in three blocks that are bound to the
+// slots given in RenderQueue.h
+
+// The same for everything drawn in a frame
+struct FrameConstants
+{
+	Matrix		View;
+	Matrix		Projection;
+	Matrix		ViewProjection;
+	Vector4		EyePosition;
+	Vector4		AmbientLightColour;
+	Vector4		DirectionalLightColour;
+	Vector4		DirectionalLightVector;
+};
+
+// Shared by everything drawn with the same material
+struct MaterialConstants
+{
+	Vector4		MaterialColour;
+	Vector4		SpecularColour;
+	float		SpecularPower;
+	Vector3		pad;
+};
+
+// Different for each object drawn
+struct ObjectConstants
+{
+	Matrix		WorldViewProjection;
+	Matrix		World;
+	// Decode the positions of meshes with compressed vertices (from Mesh::Quantisation)
+	Vector4		PositionScale;
+	Vector4		PositionOffset;
+};
+
+struct ObjectVertexStruct
+{
+	Vector3		Position;
+	Vector3		Normal;
+	Vector2		TextureCoordinate;
+};
+
+// Per-instance data used by the instanced version of shader.hlsl
+struct InstanceData
+{
+	Matrix		World;
+	Vector4		MaterialColour;
+};
@@ -0,0 +1,78 @@
+#pragma once
+// Instruction set selection for the hand-vectorised kernels.
+//
+// SSE (x86/x64) or NEON (ARM) is chosen at compile time.  AVX2 is chosen at run time,
+// since the project is not built with /arch:AVX2; functions that use AVX2 intrinsics
+// must be marked with SIMD_AVX2_TARGET (or SIMD_AVX2_KERNEL for the entry point of a kernel)
+// and only called if CpuSupportsAvx2() is true.
+//
+// Defining SIMD_SCALAR forces the portable versions of the kernels, which is useful
+// when checking the vectorised versions against them.
+
+#if !defined(SIMD_SCALAR)
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_SSE 1
+#define SIMD_AVX2 1
+#include <immintrin.h>
+#elif defined(_M_ARM64) || defined(__aarch64__) || defined(__ARM_NEON)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
+#if defined(SIMD_AVX2)
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC allows AVX2 intrinsics to be used in any function
+#define SIMD_AVX2_TARGET
+#define SIMD_AVX2_KERNEL
+#else
+#define SIMD_AVX2_TARGET __attribute__((target("avx2,fma")))
+// GCC and Clang only inline AVX2 functions into functions that are themselves AVX2, so the entry
+// point of a kernel that is shared with other instruction sets (through a template) must pull
+// everything it calls inline
+#define SIMD_AVX2_KERNEL __attribute__((target("avx2,fma"), flatten))
+#endif
+#endif
+
+// A kernel template shared with AVX2 is not compiled for AVX2 itself, so passing AVX2 vectors to or
+// from it would use a different calling convention from the SIMD_AVX2_TARGET functions it calls.
+// Marking it SIMD_FORCE_INLINE makes inlining it into its SIMD_AVX2_KERNEL entry point an error if it
+// cannot be done, rather than something flatten happens to do.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SIMD_FORCE_INLINE __forceinline
+#else
+#define SIMD_FORCE_INLINE inline __attribute__((always_inline))
+#endif
+
+// True if the processor (and operating system) support AVX2 and FMA
+inline bool CpuSupportsAvx2()
+{
+#if defined(SIMD_AVX2)
+#if defined(_MSC_VER) && !defined(__clang__)
+	static const bool supported = []()
+		{
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7)
+			{
+				return false;
+			}
+			__cpuid(info, 1);
+			bool fma = (info[2] & (1 << 12)) != 0;
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			// The operating system must save the YMM registers
+			bool ymmEnabled = osxsave && (_xgetbv(0) & 6) == 6;
+			__cpuidex(info, 7, 0);
+			bool avx2 = (info[1] & (1 << 5)) != 0;
+			return fma && ymmEnabled && avx2;
+		}();
+	return supported;
+#else
+	static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	return supported;
+#endif
+#else
+	return false;
+#endif
+}
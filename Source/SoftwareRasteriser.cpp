@@ -0,0 +1,602 @@
+#include "SoftwareRasteriser.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+// The SSE and portable paths must calculate the edge functions and depth in exactly the same way, so the
+// compiler must not fuse their multiplies and adds
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+// Vertices are snapped to 1/SubpixelSteps of a pixel, which keeps the edge functions of triangles that share
+// vertices consistent
+constexpr float SubpixelSteps = 256.0f;
+
+// How far outside the view (in multiples of its half width and height) triangles can reach before they are
+// clipped.  Most triangles that cross the edge of the view are inside this, and are left to the edge functions.
+constexpr float GuardBand = 4.0f;
+
+// Triangles with w below this are clipped, so that nothing is divided by 0
+constexpr float MinimumW = 1e-5f;
+
+// Clipping against each plane can add one vertex
+constexpr size_t ClipPlaneCount = 6;
+constexpr size_t MaxClippedVertices = 3 + ClipPlaneCount;
+
+static SoftwareRasteriser::Path BestPath()
+{
+#if defined(SIMD_SSE)
+	return SoftwareRasteriser::Path::Sse;
+#else
+	return SoftwareRasteriser::Path::Portable;
+#endif
+}
+
+static SoftwareRasteriser::Path CurrentPath = BestPath();
+
+void SoftwareRasteriser::SetPath(Path path)
+{
+	Path best = BestPath();
+	CurrentPath = path > best ? best : path;
+}
+
+SoftwareRasteriser::Path SoftwareRasteriser::GetPath()
+{
+	return CurrentPath;
+}
+
+const char* SoftwareRasteriser::GetPathName(Path path)
+{
+	switch (path)
+	{
+		case Path::Sse:
+			return "SSE";
+
+		default:
+			return "Portable";
+	}
+}
+
+SoftwareRasteriser::SoftwareRasteriser(unsigned int width, unsigned int height, unsigned int tileSize) :
+	_tileSize(tileSize)
+{
+	if (tileSize == 0 || tileSize % 4 != 0)
+	{
+		throw logic_error("The tile size must be a multiple of 4");
+	}
+	Resize(width, height);
+}
+
+void SoftwareRasteriser::Resize(unsigned int width, unsigned int height)
+{
+	_width = width;
+	_height = height;
+	_stride = (width + 3) & ~3u;
+	_tilesX = (width + _tileSize - 1) / _tileSize;
+	_tilesY = (height + _tileSize - 1) / _tileSize;
+	_colour.assign(static_cast<size_t>(_stride) * height, 0);
+	_depth.assign(static_cast<size_t>(_stride) * height, 1.0f);
+	_bins.clear();
+	_bins.resize(static_cast<size_t>(_tilesX) * _tilesY);
+	_triangles.clear();
+	_planes.clear();
+	_statistics = RasteriserStatistics();
+}
+
+static inline uint8_t ToUnorm8(float value)
+{
+	// NaN is stored as 0
+	float clamped = value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+	return static_cast<uint8_t>(clamped * 255.0f + 0.5f);
+}
+
+uint32_t SoftwareRasteriser::PackColour(const float colour[4])
+{
+	return static_cast<uint32_t>(ToUnorm8(colour[0])) | (static_cast<uint32_t>(ToUnorm8(colour[1])) << 8) |
+		   (static_cast<uint32_t>(ToUnorm8(colour[2])) << 16) | (static_cast<uint32_t>(ToUnorm8(colour[3])) << 24);
+}
+
+void SoftwareRasteriser::Clear(const float colour[4], float depth)
+{
+	fill(_colour.begin(), _colour.end(), PackColour(colour));
+	fill(_depth.begin(), _depth.end(), depth);
+	for (vector<uint32_t>& bin : _bins)
+	{
+		bin.clear();
+	}
+	_triangles.clear();
+	_planes.clear();
+	_statistics = RasteriserStatistics();
+}
+
+vector<uint32_t> SoftwareRasteriser::GetImage() const
+{
+	vector<uint32_t> image(static_cast<size_t>(_width) * _height);
+	for (unsigned int y = 0; y < _height; y++)
+	{
+		memcpy(image.data() + static_cast<size_t>(y) * _width, _colour.data() + static_cast<size_t>(y) * _stride, _width * sizeof(uint32_t));
+	}
+	return image;
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+// Clipping
+
+// The signed distance of a clip space position from one of the clip planes, which is positive on the inside
+static inline float ClipDistance(size_t plane, const Vector4& position)
+{
+	switch (plane)
+	{
+		case 0:
+			// Near plane
+			return position.z;
+
+		case 1:
+			return position.w - MinimumW;
+
+		case 2:
+			return GuardBand * position.w - position.x;
+
+		case 3:
+			return GuardBand * position.w + position.x;
+
+		case 4:
+			return GuardBand * position.w - position.y;
+
+		default:
+			return GuardBand * position.w + position.y;
+	}
+}
+
+static inline RasterVertex Interpolate(const RasterVertex& from, const RasterVertex& to, float t, size_t varyingCount)
+{
+	RasterVertex result;
+	result.Position.x = from.Position.x + (to.Position.x - from.Position.x) * t;
+	result.Position.y = from.Position.y + (to.Position.y - from.Position.y) * t;
+	result.Position.z = from.Position.z + (to.Position.z - from.Position.z) * t;
+	result.Position.w = from.Position.w + (to.Position.w - from.Position.w) * t;
+	for (size_t i = 0; i < varyingCount; i++)
+	{
+		result.Varyings[i] = from.Varyings[i] + (to.Varyings[i] - from.Varyings[i]) * t;
+	}
+	return result;
+}
+
+// Sutherland-Hodgman clipping of a convex polygon against one plane.  The point where an edge crosses the plane is
+// always calculated from its inside end, so an edge shared by two triangles is cut at the same point for both.
+static size_t ClipPolygon(const RasterVertex* input, size_t count, size_t plane, size_t varyingCount, RasterVertex* output)
+{
+	size_t outputCount = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		const RasterVertex& current = input[i];
+		const RasterVertex& next = input[(i + 1) % count];
+		float currentDistance = ClipDistance(plane, current.Position);
+		float nextDistance = ClipDistance(plane, next.Position);
+		if (currentDistance >= 0.0f)
+		{
+			output[outputCount++] = current;
+			if (nextDistance < 0.0f)
+			{
+				output[outputCount++] = Interpolate(current, next, currentDistance / (currentDistance - nextDistance), varyingCount);
+			}
+		}
+		else if (nextDistance >= 0.0f)
+		{
+			output[outputCount++] = Interpolate(next, current, nextDistance / (nextDistance - currentDistance), varyingCount);
+		}
+	}
+	return outputCount;
+}
+
+void SoftwareRasteriser::AddTriangle(const RasterVertex& vertex0, const RasterVertex& vertex1, const RasterVertex& vertex2, size_t varyingCount, uint32_t draw)
+{
+	if (varyingCount > MaxVaryings)
+	{
+		throw logic_error("Too many varyings");
+	}
+	_statistics.TriangleCount++;
+
+	// Triangles entirely outside one of the planes are dropped, and only those that cross a plane are clipped
+	const RasterVertex* vertices[3] = { &vertex0, &vertex1, &vertex2 };
+	bool crossesPlane = false;
+	for (size_t plane = 0; plane < ClipPlaneCount; plane++)
+	{
+		int outsideCount = 0;
+		for (const RasterVertex* vertex : vertices)
+		{
+			outsideCount += ClipDistance(plane, vertex->Position) < 0.0f ? 1 : 0;
+		}
+		if (outsideCount == 3)
+		{
+			_statistics.CulledCount++;
+			return;
+		}
+		crossesPlane |= outsideCount != 0;
+	}
+	if (!crossesPlane)
+	{
+		SetUpTriangle(vertices, varyingCount, draw);
+		return;
+	}
+
+	_statistics.ClippedCount++;
+	RasterVertex polygons[2][MaxClippedVertices];
+	polygons[0][0] = vertex0;
+	polygons[0][1] = vertex1;
+	polygons[0][2] = vertex2;
+	size_t count = 3;
+	int current = 0;
+	for (size_t plane = 0; plane < ClipPlaneCount && count >= 3; plane++)
+	{
+		count = ClipPolygon(polygons[current], count, plane, varyingCount, polygons[1 - current]);
+		current = 1 - current;
+	}
+	// The clipped polygon is convex, so is drawn as a fan
+	for (size_t i = 1; i + 1 < count; i++)
+	{
+		const RasterVertex* fan[3] = { &polygons[current][0], &polygons[current][i], &polygons[current][i + 1] };
+		SetUpTriangle(fan, varyingCount, draw);
+	}
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+// Set up and binning
+
+static inline float Snap(float value)
+{
+	return floorf(value * SubpixelSteps + 0.5f) / SubpixelSteps;
+}
+
+// The plane through (0, 0, q0), (dx1, dy1, q1) and (dx2, dy2, q2), as its value at the origin and its gradients
+static inline void MakePlane(float q0, float q1, float q2, float dx1, float dy1, float dx2, float dy2, float inverseArea, float* plane)
+{
+	plane[0] = q0;
+	plane[1] = ((q1 - q0) * dy2 - (q2 - q0) * dy1) * inverseArea;
+	plane[2] = ((q2 - q0) * dx1 - (q1 - q0) * dx2) * inverseArea;
+}
+
+void SoftwareRasteriser::SetUpTriangle(const RasterVertex* vertices[3], size_t varyingCount, uint32_t draw)
+{
+	// Map to pixels, with y going down the screen
+	float x[3];
+	float y[3];
+	float z[3];
+	float inverseW[3];
+	for (int i = 0; i < 3; i++)
+	{
+		const Vector4& position = vertices[i]->Position;
+		inverseW[i] = 1.0f / position.w;
+		x[i] = Snap((position.x * inverseW[i] * 0.5f + 0.5f) * _width);
+		y[i] = Snap((0.5f - position.y * inverseW[i] * 0.5f) * _height);
+		z[i] = position.z * inverseW[i];
+	}
+
+	// Twice the area, which is positive if the triangle is clockwise on the screen (and so faces the camera)
+	float dx1 = x[1] - x[0];
+	float dy1 = y[1] - y[0];
+	float dx2 = x[2] - x[0];
+	float dy2 = y[2] - y[0];
+	float area = dx1 * dy2 - dx2 * dy1;
+	Triangle triangle;
+	triangle.MinX = max(0, static_cast<int>(floorf(min(x[0], min(x[1], x[2])))));
+	triangle.MinY = max(0, static_cast<int>(floorf(min(y[0], min(y[1], y[2])))));
+	triangle.MaxX = min(static_cast<int>(_width), static_cast<int>(ceilf(max(x[0], max(x[1], x[2])))));
+	triangle.MaxY = min(static_cast<int>(_height), static_cast<int>(ceilf(max(y[0], max(y[1], y[2])))));
+	if (!(area > 0.0f) || triangle.MinX >= triangle.MaxX || triangle.MinY >= triangle.MaxY)
+	{
+		_statistics.CulledCount++;
+		return;
+	}
+
+	// Edge i is the one opposite vertex i.  An edge shared with another triangle runs the other way in that triangle,
+	// so its coefficients (and so its edge function) are exactly negated, and the top-left rule gives the pixels
+	// exactly on it to only one of the two.
+	for (int i = 0; i < 3; i++)
+	{
+		int from = (i + 1) % 3;
+		int to = (i + 2) % 3;
+		triangle.EdgeA[i] = y[from] - y[to];
+		triangle.EdgeB[i] = x[to] - x[from];
+		triangle.EdgeC[i] = x[from] * y[to] - x[to] * y[from];
+		triangle.TopLeft[i] = triangle.EdgeA[i] > 0.0f || (triangle.EdgeA[i] == 0.0f && triangle.EdgeB[i] > 0.0f);
+	}
+
+	// Depth, 1/w and varying/w are linear across the screen
+	float inverseArea = 1.0f / area;
+	triangle.X0 = x[0];
+	triangle.Y0 = y[0];
+	MakePlane(z[0], z[1], z[2], dx1, dy1, dx2, dy2, inverseArea, triangle.Z);
+	MakePlane(inverseW[0], inverseW[1], inverseW[2], dx1, dy1, dx2, dy2, inverseArea, triangle.InverseW);
+	triangle.PlaneOffset = static_cast<uint32_t>(_planes.size());
+	triangle.VaryingCount = static_cast<uint32_t>(varyingCount);
+	triangle.Draw = draw;
+	_planes.resize(_planes.size() + varyingCount * 3);
+	float* planes = _planes.data() + triangle.PlaneOffset;
+	for (size_t i = 0; i < varyingCount; i++)
+	{
+		MakePlane(vertices[0]->Varyings[i] * inverseW[0], vertices[1]->Varyings[i] * inverseW[1], vertices[2]->Varyings[i] * inverseW[2],
+				  dx1, dy1, dx2, dy2, inverseArea, planes + i * 3);
+	}
+	_triangles.push_back(triangle);
+	BinTriangle(static_cast<uint32_t>(_triangles.size() - 1));
+}
+
+void SoftwareRasteriser::BinTriangle(uint32_t triangleIndex)
+{
+	const Triangle& triangle = _triangles[triangleIndex];
+	unsigned int firstTileX = triangle.MinX / _tileSize;
+	unsigned int lastTileX = (triangle.MaxX - 1) / _tileSize;
+	unsigned int firstTileY = triangle.MinY / _tileSize;
+	unsigned int lastTileY = (triangle.MaxY - 1) / _tileSize;
+	for (unsigned int tileY = firstTileY; tileY <= lastTileY; tileY++)
+	{
+		for (unsigned int tileX = firstTileX; tileX <= lastTileX; tileX++)
+		{
+			// The centres of the pixels in both the tile and the bounds of the triangle
+			float left = static_cast<float>(max(static_cast<int>(tileX * _tileSize), triangle.MinX)) + 0.5f;
+			float right = static_cast<float>(min(static_cast<int>((tileX + 1) * _tileSize), triangle.MaxX)) - 0.5f;
+			float top = static_cast<float>(max(static_cast<int>(tileY * _tileSize), triangle.MinY)) + 0.5f;
+			float bottom = static_cast<float>(min(static_cast<int>((tileY + 1) * _tileSize), triangle.MaxY)) - 0.5f;
+
+			// Skip the tile if the corner that is furthest inside one of the edges is still outside it.  A little
+			// leeway is allowed for rounding, since missing a tile would leave a hole.
+			bool outside = false;
+			for (int edge = 0; edge < 3 && !outside; edge++)
+			{
+				float a = triangle.EdgeA[edge];
+				float b = triangle.EdgeB[edge];
+				float x = a >= 0.0f ? right : left;
+				float y = b >= 0.0f ? bottom : top;
+				float value = (a * x + b * y) + triangle.EdgeC[edge];
+				float tolerance = (fabsf(a * x) + fabsf(b * y) + fabsf(triangle.EdgeC[edge])) * 1e-6f;
+				outside = value < -tolerance;
+			}
+			if (!outside)
+			{
+				_bins[static_cast<size_t>(tileY) * _tilesX + tileX].push_back(triangleIndex);
+				_statistics.BinnedCount++;
+			}
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+// Rasterisation
+
+// Test four pixels, starting at x on a row whose centres are at py.  Returns a mask with a bit set for each pixel
+// that is inside the triangle and passes the depth test, and the depth of the pixels in z.
+static inline unsigned int CoverQuadPortable(const float* edgeA, const float* edgeB, const float* edgeC, const bool* topLeft, const float* plane,
+											 float x0, float y0, int x, float py, float minX, float maxX, const float* depth, float* z)
+{
+	unsigned int mask = 0;
+	for (int lane = 0; lane < 4; lane++)
+	{
+		float px = static_cast<float>(x + lane) + 0.5f;
+		bool inside = px > minX && px < maxX;
+		for (int edge = 0; edge < 3; edge++)
+		{
+			float value = (edgeA[edge] * px + edgeB[edge] * py) + edgeC[edge];
+			inside = inside && (value > 0.0f || (value == 0.0f && topLeft[edge]));
+		}
+		z[lane] = plane[0] + (plane[1] * (px - x0) + plane[2] * (py - y0));
+		if (inside && z[lane] < depth[lane] && z[lane] <= 1.0f)
+		{
+			mask |= 1u << lane;
+		}
+	}
+	return mask;
+}
+
+#if defined(SIMD_SSE)
+static inline unsigned int CoverQuadSse(const __m128* edgeA, const __m128* edgeB, const __m128* edgeC, const __m128* topLeft, const float* plane,
+										float x0, float y0, int x, float py, __m128 minX, __m128 maxX, const float* depth, float* z)
+{
+	__m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+	__m128 pyVector = _mm_set1_ps(py);
+	__m128 zero = _mm_setzero_ps();
+	__m128 inside = _mm_and_ps(_mm_cmpgt_ps(px, minX), _mm_cmplt_ps(px, maxX));
+	for (int edge = 0; edge < 3; edge++)
+	{
+		__m128 value = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeA[edge], px), _mm_mul_ps(edgeB[edge], pyVector)), edgeC[edge]);
+		inside = _mm_and_ps(inside, _mm_or_ps(_mm_cmpgt_ps(value, zero), _mm_and_ps(_mm_cmpeq_ps(value, zero), topLeft[edge])));
+	}
+	__m128 dx = _mm_sub_ps(px, _mm_set1_ps(x0));
+	__m128 depthValue = _mm_add_ps(_mm_set1_ps(plane[0]), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[1]), dx), _mm_set1_ps(plane[2] * (py - y0))));
+	inside = _mm_and_ps(inside, _mm_cmplt_ps(depthValue, _mm_loadu_ps(depth)));
+	inside = _mm_and_ps(inside, _mm_cmple_ps(depthValue, _mm_set1_ps(1.0f)));
+	_mm_storeu_ps(z, depthValue);
+	return static_cast<unsigned int>(_mm_movemask_ps(inside));
+}
+#endif
+
+size_t SoftwareRasteriser::RasteriseTile(unsigned int tileIndex, const PixelShading& shading)
+{
+	int tileLeft = static_cast<int>((tileIndex % _tilesX) * _tileSize);
+	int tileTop = static_cast<int>((tileIndex / _tilesX) * _tileSize);
+	int tileRight = min(tileLeft + static_cast<int>(_tileSize), static_cast<int>(_width));
+	int tileBottom = min(tileTop + static_cast<int>(_tileSize), static_cast<int>(_height));
+	bool useSse = CurrentPath == Path::Sse;
+	size_t pixelCount = 0;
+	float varyings[MaxVaryings];
+	float z[4];
+
+	for (uint32_t triangleIndex : _bins[tileIndex])
+	{
+		const Triangle& triangle = _triangles[triangleIndex];
+		const float* planes = _planes.data() + triangle.PlaneOffset;
+		// Rows are drawn in groups of four pixels, starting on a multiple of four
+		int left = max(tileLeft, triangle.MinX) & ~3;
+		int right = min(tileRight, triangle.MaxX);
+		int top = max(tileTop, triangle.MinY);
+		int bottom = min(tileBottom, triangle.MaxY);
+		float minX = static_cast<float>(triangle.MinX);
+		float maxX = static_cast<float>(right);
+#if defined(SIMD_SSE)
+		__m128 edgeA[3];
+		__m128 edgeB[3];
+		__m128 edgeC[3];
+		__m128 topLeft[3];
+		for (int edge = 0; edge < 3; edge++)
+		{
+			edgeA[edge] = _mm_set1_ps(triangle.EdgeA[edge]);
+			edgeB[edge] = _mm_set1_ps(triangle.EdgeB[edge]);
+			edgeC[edge] = _mm_set1_ps(triangle.EdgeC[edge]);
+			topLeft[edge] = _mm_castsi128_ps(_mm_set1_epi32(triangle.TopLeft[edge] ? -1 : 0));
+		}
+		__m128 minXVector = _mm_set1_ps(minX);
+		__m128 maxXVector = _mm_set1_ps(maxX);
+#endif
+		for (int y = top; y < bottom; y++)
+		{
+			float py = static_cast<float>(y) + 0.5f;
+			float dy = py - triangle.Y0;
+			float* depthRow = _depth.data() + static_cast<size_t>(y) * _stride;
+			uint32_t* colourRow = _colour.data() + static_cast<size_t>(y) * _stride;
+			for (int x = left; x < right; x += 4)
+			{
+				unsigned int mask;
+#if defined(SIMD_SSE)
+				if (useSse)
+				{
+					mask = CoverQuadSse(edgeA, edgeB, edgeC, topLeft, triangle.Z, triangle.X0, triangle.Y0, x, py, minXVector, maxXVector, depthRow + x, z);
+				}
+				else
+#endif
+				{
+					mask = CoverQuadPortable(triangle.EdgeA, triangle.EdgeB, triangle.EdgeC, triangle.TopLeft, triangle.Z, triangle.X0, triangle.Y0,
+											 x, py, minX, maxX, depthRow + x, z);
+				}
+				for (int lane = 0; mask != 0; lane++, mask >>= 1)
+				{
+					if ((mask & 1) == 0)
+					{
+						continue;
+					}
+					// Interpolate varying/w and 1/w, and divide to correct for perspective
+					float dx = static_cast<float>(x + lane) + 0.5f - triangle.X0;
+					float w = 1.0f / (triangle.InverseW[0] + (triangle.InverseW[1] * dx + triangle.InverseW[2] * dy));
+					for (uint32_t i = 0; i < triangle.VaryingCount; i++)
+					{
+						const float* plane = planes + i * 3;
+						varyings[i] = (plane[0] + (plane[1] * dx + plane[2] * dy)) * w;
+					}
+					Vector4 colour = shading.Shade(triangle.Draw, varyings);
+					colourRow[x + lane] = PackColour(&colour.x);
+					depthRow[x + lane] = z[lane];
+					pixelCount++;
+				}
+			}
+		}
+	}
+	return pixelCount;
+}
+
+void SoftwareRasteriser::Rasterise(const PixelShading& shading, JobSystem* jobSystem)
+{
+	// Each tile only touches its own pixels, so tiles can be drawn in any order, or at the same time
+	vector<size_t> pixelCounts(_bins.size(), 0);
+	if (jobSystem == nullptr)
+	{
+		for (unsigned int tile = 0; tile < _bins.size(); tile++)
+		{
+			pixelCounts[tile] = RasteriseTile(tile, shading);
+		}
+	}
+	else
+	{
+		JobCounter counter{ 0 };
+		for (unsigned int tile = 0; tile < _bins.size(); tile++)
+		{
+			if (!_bins[tile].empty())
+			{
+				jobSystem->Submit([this, tile, &shading, &pixelCounts]() { pixelCounts[tile] = RasteriseTile(tile, shading); }, counter);
+			}
+		}
+		jobSystem->Wait(counter);
+	}
+
+	for (size_t tile = 0; tile < _bins.size(); tile++)
+	{
+		_statistics.PixelCount += pixelCounts[tile];
+		_bins[tile].clear();
+	}
+	_triangles.clear();
+	_planes.clear();
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+// Images
+
+constexpr size_t TgaHeaderSize = 18;
+constexpr uint8_t TgaTrueColour = 2;
+// Bit 5 of the image descriptor is set if the first row is the top of the image
+constexpr uint8_t TgaTopToBottom = 0x20;
+
+bool SoftwareRasteriser::SaveImage(const wstring& fileName) const
+{
+	if (_width > 0xFFFF || _height > 0xFFFF)
+	{
+		return false;
+	}
+	vector<uint8_t> file(TgaHeaderSize + static_cast<size_t>(_width) * _height * 4, 0);
+	file[2] = TgaTrueColour;
+	file[12] = static_cast<uint8_t>(_width & 0xFF);
+	file[13] = static_cast<uint8_t>(_width >> 8);
+	file[14] = static_cast<uint8_t>(_height & 0xFF);
+	file[15] = static_cast<uint8_t>(_height >> 8);
+	file[16] = 32;
+	// 8 bits of alpha
+	file[17] = TgaTopToBottom | 8;
+	uint8_t* pixel = file.data() + TgaHeaderSize;
+	for (unsigned int y = 0; y < _height; y++)
+	{
+		for (unsigned int x = 0; x < _width; x++, pixel += 4)
+		{
+			// TGA pixels are stored as blue, green, red, alpha
+			uint32_t colour = GetPixel(x, y);
+			pixel[0] = static_cast<uint8_t>(colour >> 16);
+			pixel[1] = static_cast<uint8_t>(colour >> 8);
+			pixel[2] = static_cast<uint8_t>(colour);
+			pixel[3] = static_cast<uint8_t>(colour >> 24);
+		}
+	}
+	return MappedFile::WriteFile(fileName, file.data(), file.size());
+}
+
+bool SoftwareRasteriser::LoadImage(const wstring& fileName, unsigned int& width, unsigned int& height, vector<uint32_t>& pixels)
+{
+	MappedFile file;
+	if (!file.Open(fileName) || file.GetSize() < TgaHeaderSize)
+	{
+		return false;
+	}
+	const uint8_t* data = file.GetData();
+	size_t idLength = data[0];
+	unsigned int bytesPerPixel = data[16] / 8;
+	width = data[12] | (data[13] << 8);
+	height = data[14] | (data[15] << 8);
+	size_t pixelSize = static_cast<size_t>(width) * height * bytesPerPixel;
+	if (data[1] != 0 || data[2] != TgaTrueColour || (data[16] != 24 && data[16] != 32) || file.GetSize() < TgaHeaderSize + idLength + pixelSize)
+	{
+		return false;
+	}
+	const uint8_t* pixel = data + TgaHeaderSize + idLength;
+	bool topToBottom = (data[17] & TgaTopToBottom) != 0;
+	pixels.resize(static_cast<size_t>(width) * height);
+	for (unsigned int row = 0; row < height; row++)
+	{
+		uint32_t* target = pixels.data() + static_cast<size_t>(topToBottom ? row : height - 1 - row) * width;
+		for (unsigned int x = 0; x < width; x++, pixel += bytesPerPixel)
+		{
+			uint32_t alpha = bytesPerPixel == 4 ? pixel[3] : 0xFF;
+			target[x] = pixel[2] | (pixel[1] << 8) | (pixel[0] << 16) | (alpha << 24);
+		}
+	}
+	return true;
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include "SimpleMath.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace DirectX;
+using namespace SimpleMath;
+
+class JobSystem;
+
+// The most values that can be interpolated across a triangle, which is enough for the ports of the shaders
+constexpr size_t MaxVaryings = 8;
+
+// A vertex as it leaves the vertex shader: its position in clip space and the values to interpolate
+struct RasterVertex
+{
+	Vector4			Position;
+	float			Varyings[MaxVaryings];
+};
+
+// Colours the pixels of the triangles that are drawn (the software equivalent of a pixel shader)
+class PixelShading
+{
+public:
+	virtual ~PixelShading() {};
+
+	// Called for each pixel that passes the depth test, from several threads at once.  draw is the value that was
+	// passed to AddTriangle and varyings are the values interpolated (with perspective correction) at the centre
+	// of the pixel.  The colour is clamped to 0..1 when it is stored.
+	virtual Vector4 Shade(uint32_t draw, const float* varyings) const = 0;
+};
+
+struct RasteriserStatistics
+{
+	size_t				TriangleCount{ 0 };
+	// Triangles that faced away from the camera, were outside the view or covered no area
+	size_t				CulledCount{ 0 };
+	// Triangles that crossed the near plane or the guard band and were clipped
+	size_t				ClippedCount{ 0 };
+	// The number of tiles each triangle was put in, summed over the triangles
+	size_t				BinnedCount{ 0 };
+	// Pixels that passed the depth test and were shaded
+	size_t				PixelCount{ 0 };
+};
+
+// Tile based software rasteriser, used as a reference for the Direct3D 11 renderer (through the
+// SoftwareRenderDevice) and to render images on machines without a GPU.
+//
+// The rules follow Direct3D 11 with its default state, so the images can be compared with the
+// GPU's: pixels are sampled at their centres and the top-left fill rule decides pixels on an
+// edge, so triangles that share an edge never both cover (or both miss) a pixel along it;
+// clockwise triangles face the camera and the others are culled; depth is a 32 bit float with
+// a LESS test, and values are interpolated with perspective correction.  Triangles are clipped
+// against the near plane and a guard band around the view, and pixels beyond the far plane
+// are discarded.
+//
+// Triangles are set up and put into bins for the tiles they touch as they are added.  When
+// they are rasterised, each tile is a separate job that draws the triangles in its bin in the
+// order they were added, so the image is the same whatever the number of threads.  The edge
+// functions and depth test are evaluated for four pixels at a time with SSE (or one at a time
+// with plain C++ elsewhere, adding the terms in the same order so both give the same image),
+// and the pixels that pass are shaded one at a time.
+//
+// Colours are stored as 8 bits per channel, with red in the lowest byte.
+
+class SoftwareRasteriser
+{
+public:
+	enum class Path
+	{
+		Portable,
+		Sse
+	};
+
+	// tileSize must be a multiple of 4
+	SoftwareRasteriser(unsigned int width, unsigned int height, unsigned int tileSize = 64);
+
+	// Resizing discards the image and any triangles that have not been rasterised
+	void Resize(unsigned int width, unsigned int height);
+
+	// Fill the colour buffer with colour and the depth buffer with depth.  Triangles that have been added but not
+	// rasterised are discarded, since they would be cleared anyway.
+	void Clear(const float colour[4], float depth);
+
+	// Add a triangle whose first varyingCount varyings are interpolated.  draw is passed to the PixelShading.
+	void AddTriangle(const RasterVertex& vertex0, const RasterVertex& vertex1, const RasterVertex& vertex2, size_t varyingCount, uint32_t draw);
+
+	// Draw the triangles that have been added, using jobSystem to draw tiles in parallel if it is given
+	void Rasterise(const PixelShading& shading, JobSystem* jobSystem = nullptr);
+
+	inline unsigned int GetWidth() const { return _width; }
+	inline unsigned int GetHeight() const { return _height; }
+	inline size_t GetPendingTriangleCount() const { return _triangles.size(); }
+	inline uint32_t GetPixel(unsigned int x, unsigned int y) const { return _colour[static_cast<size_t>(y) * _stride + x]; }
+	inline float GetDepth(unsigned int x, unsigned int y) const { return _depth[static_cast<size_t>(y) * _stride + x]; }
+	// The image with no padding between the rows
+	vector<uint32_t> GetImage() const;
+	// Statistics since the last Clear
+	inline const RasteriserStatistics& GetStatistics() const { return _statistics; }
+
+	// Write the image as an uncompressed 32 bit TGA file
+	bool SaveImage(const wstring& fileName) const;
+	// Read an uncompressed 24 or 32 bit TGA file into pixels in the same format as GetImage
+	static bool LoadImage(const wstring& fileName, unsigned int& width, unsigned int& height, vector<uint32_t>& pixels);
+
+	static uint32_t PackColour(const float colour[4]);
+
+	// The rasteriser uses SSE where it can unless told otherwise.  This is not thread safe, and is meant for
+	// comparing the paths.
+	static void SetPath(Path path);
+	static Path GetPath();
+	static const char* GetPathName(Path path);
+
+private:
+	// A triangle after set up.  The edge functions are E(x, y) = A * x + B * y + C, which is positive inside the
+	// triangle.  Depth, 1/w and each varying/w are planes: value = Value + (DxDx * (x - X0) + DxDy * (y - Y0)).
+	struct Triangle
+	{
+		float			EdgeA[3];
+		float			EdgeB[3];
+		float			EdgeC[3];
+		// True for the top and left edges, which cover pixels whose centres lie exactly on them
+		bool			TopLeft[3];
+		float			X0;
+		float			Y0;
+		// Depth and 1/w
+		float			Z[3];
+		float			InverseW[3];
+		// Pixels that the triangle may cover, from Min up to (but not including) Max
+		int				MinX;
+		int				MinY;
+		int				MaxX;
+		int				MaxY;
+		// The planes of the varyings are kept in _planes, 3 floats each
+		uint32_t		PlaneOffset;
+		uint32_t		VaryingCount;
+		uint32_t		Draw;
+	};
+
+	unsigned int				_width{ 0 };
+	unsigned int				_height{ 0 };
+	// Rows are padded to a multiple of 4 pixels
+	unsigned int				_stride{ 0 };
+	unsigned int				_tileSize;
+	unsigned int				_tilesX{ 0 };
+	unsigned int				_tilesY{ 0 };
+	vector<uint32_t>			_colour;
+	vector<float>				_depth;
+	vector<Triangle>			_triangles;
+	vector<float>				_planes;
+	// The triangles that touch each tile, in the order they were added
+	vector<vector<uint32_t>>	_bins;
+	RasteriserStatistics		_statistics;
+
+	void SetUpTriangle(const RasterVertex* vertices[3], size_t varyingCount, uint32_t draw);
+	void BinTriangle(uint32_t triangleIndex);
+	size_t RasteriseTile(unsigned int tileIndex, const PixelShading& shading);
+};
@@ -0,0 +1,452 @@
+#include "SoftwareRenderDevice.h"
+#include "RenderQueue.h"
+#include "VertexCompression.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+// Varyings passed from the vertex shader to the pixel shader, as in the VertexOut structures of the shaders
+constexpr size_t NormalVarying = 0;
+constexpr size_t WorldPositionVarying = 3;
+constexpr size_t TextureCoordinateVarying = 6;
+constexpr size_t LitVaryingCount = 6;
+constexpr size_t TexturedVaryingCount = 8;
+
+SoftwareRenderDevice::SoftwareRenderDevice(unsigned int width, unsigned int height, JobSystem* jobSystem) :
+	_rasteriser(width, height), _jobSystem(jobSystem)
+{
+}
+
+vector<uint8_t>& SoftwareRenderDevice::GetBuffer(RenderHandle buffer)
+{
+	auto found = _buffers.find(buffer);
+	if (found == _buffers.end())
+	{
+		throw logic_error("Used a buffer that does not exist");
+	}
+	return found->second;
+}
+
+const vector<uint8_t>* SoftwareRenderDevice::FindBuffer(RenderHandle buffer) const
+{
+	auto found = _buffers.find(buffer);
+	return found != _buffers.end() ? &found->second : nullptr;
+}
+
+RenderHandle SoftwareRenderDevice::CreateBuffer(BufferType type, BufferUsage usage, size_t size, const void* data)
+{
+	if (data == nullptr && usage == BufferUsage::Immutable)
+	{
+		throw logic_error("Immutable buffers must be created with their contents");
+	}
+	RenderHandle buffer = _nextBuffer++;
+	vector<uint8_t>& contents = _buffers[buffer];
+	contents.resize(size, 0);
+	if (data != nullptr && size > 0)
+	{
+		memcpy(contents.data(), data, size);
+	}
+	return buffer;
+}
+
+void SoftwareRenderDevice::ReleaseBuffer(RenderHandle buffer)
+{
+	if (buffer == 0)
+	{
+		return;
+	}
+	if (_buffers.erase(buffer) == 0)
+	{
+		throw logic_error("Released a buffer that does not exist");
+	}
+}
+
+void SoftwareRenderDevice::ClearTargets(const float colour[4], float depth)
+{
+	_rasteriser.Clear(colour, depth);
+	_draws.clear();
+}
+
+void SoftwareRenderDevice::SetViewport(float width, float height)
+{
+	unsigned int pixelWidth = static_cast<unsigned int>(width + 0.5f);
+	unsigned int pixelHeight = static_cast<unsigned int>(height + 0.5f);
+	if (pixelWidth != _rasteriser.GetWidth() || pixelHeight != _rasteriser.GetHeight())
+	{
+		_rasteriser.Resize(pixelWidth, pixelHeight);
+		_draws.clear();
+	}
+}
+
+void SoftwareRenderDevice::SetShaders(RenderHandle vertexShader, RenderHandle pixelShader)
+{
+	// Both shaders have the same vertex shader, so only the pixel shader matters
+	_pixelShader = pixelShader;
+}
+
+void SoftwareRenderDevice::SetInputLayout(RenderHandle inputLayout)
+{
+	// The vertex format is worked out from the stride
+}
+
+void SoftwareRenderDevice::SetPrimitiveTopology(PrimitiveTopology topology)
+{
+	_topology = topology;
+}
+
+void SoftwareRenderDevice::SetVertexBuffer(RenderHandle vertexBuffer, unsigned int stride, unsigned int offset)
+{
+	_vertexBuffer = vertexBuffer;
+	_vertexStride = stride;
+	_vertexOffset = offset;
+}
+
+void SoftwareRenderDevice::SetInstanceBuffer(RenderHandle instanceBuffer, unsigned int stride, unsigned int offset)
+{
+	_instanceBuffer = instanceBuffer;
+	_instanceStride = stride;
+	_instanceOffset = offset;
+}
+
+void SoftwareRenderDevice::SetIndexBuffer(RenderHandle indexBuffer, IndexFormat format, unsigned int offset)
+{
+	_indexBuffer = indexBuffer;
+	_indexFormat = format;
+	_indexOffset = offset;
+}
+
+void SoftwareRenderDevice::SetTexture(unsigned int slot, RenderHandle texture)
+{
+	// The shaders only use slot 0
+	if (slot == 0)
+	{
+		_texture = texture;
+	}
+}
+
+void SoftwareRenderDevice::SetConstantBuffer(unsigned int slot, RenderHandle constantBuffer)
+{
+	SetConstantBufferRange(slot, constantBuffer, 0, UINT_MAX);
+}
+
+void SoftwareRenderDevice::SetConstantBufferRange(unsigned int slot, RenderHandle constantBuffer, unsigned int offset, unsigned int size)
+{
+	if (slot < ConstantSlotCount)
+	{
+		_constants[slot].Buffer = constantBuffer;
+		_constants[slot].Offset = offset;
+		_constants[slot].Size = size;
+	}
+}
+
+void SoftwareRenderDevice::UpdateBuffer(RenderHandle buffer, const void* data, size_t size)
+{
+	vector<uint8_t>& contents = GetBuffer(buffer);
+	memcpy(contents.data(), data, min(size, contents.size()));
+}
+
+void SoftwareRenderDevice::WriteBuffer(RenderHandle buffer, size_t offset, const void* data, size_t size, bool discard)
+{
+	// Draws are transformed as they are made, so nothing can still be reading the buffer
+	vector<uint8_t>& contents = GetBuffer(buffer);
+	if (offset > contents.size() || size > contents.size() - offset)
+	{
+		throw logic_error("Wrote past the end of a buffer");
+	}
+	memcpy(contents.data() + offset, data, size);
+}
+
+void SoftwareRenderDevice::SetPixelShader(RenderHandle pixelShader, SoftwareShader shader)
+{
+	_shaders[pixelShader] = shader;
+}
+
+void SoftwareRenderDevice::SetTextureImage(RenderHandle texture, unsigned int width, unsigned int height, const uint32_t* pixels)
+{
+	// Draws that have already been made keep the image they were made with
+	shared_ptr<Texture> image = make_shared<Texture>();
+	image->Width = width;
+	image->Height = height;
+	image->Texels.resize(static_cast<size_t>(width) * height);
+	for (size_t i = 0; i < image->Texels.size(); i++)
+	{
+		uint32_t pixel = pixels[i];
+		image->Texels[i] = Vector4(static_cast<float>(pixel & 0xFF), static_cast<float>((pixel >> 8) & 0xFF),
+								   static_cast<float>((pixel >> 16) & 0xFF), static_cast<float>(pixel >> 24)) * (1.0f / 255.0f);
+	}
+	_textures[texture] = image;
+}
+
+void SoftwareRenderDevice::Flush()
+{
+	_rasteriser.Rasterise(*this, _jobSystem);
+	_draws.clear();
+}
+
+void SoftwareRenderDevice::ReadConstants(unsigned int slot, void* constants, size_t size) const
+{
+	// Anything that is not bound reads as 0, as it does on the GPU
+	memset(constants, 0, size);
+	const ConstantRange& range = _constants[slot];
+	const vector<uint8_t>* buffer = FindBuffer(range.Buffer);
+	if (buffer != nullptr && range.Offset < buffer->size())
+	{
+		size_t available = min(static_cast<size_t>(range.Size), buffer->size() - range.Offset);
+		memcpy(constants, buffer->data() + range.Offset, min(size, available));
+	}
+}
+
+void SoftwareRenderDevice::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	Draw(indexCount, startIndex, baseVertex, nullptr);
+}
+
+void SoftwareRenderDevice::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance)
+{
+	const vector<uint8_t>* instanceBuffer = FindBuffer(_instanceBuffer);
+	if (instanceBuffer == nullptr || _instanceStride == 0)
+	{
+		return;
+	}
+	// Each instance is drawn as a separate draw with the world transformation and colour from the instance buffer
+	for (unsigned int i = 0; i < instanceCount; i++)
+	{
+		size_t offset = _instanceOffset + static_cast<size_t>(startInstance + i) * _instanceStride;
+		if (offset + _instanceStride > instanceBuffer->size())
+		{
+			break;
+		}
+		InstanceData instance{};
+		memcpy(&instance, instanceBuffer->data() + offset, min(static_cast<size_t>(_instanceStride), sizeof(instance)));
+		Draw(indexCount, startIndex, baseVertex, &instance);
+	}
+}
+
+static inline Vector4 Saturate(const Vector4& value)
+{
+	return Vector4(min(max(value.x, 0.0f), 1.0f), min(max(value.y, 0.0f), 1.0f), min(max(value.z, 0.0f), 1.0f), min(max(value.w, 0.0f), 1.0f));
+}
+
+static inline float Saturate(float value)
+{
+	return min(max(value, 0.0f), 1.0f);
+}
+
+// position * matrix, with vectors as rows as elsewhere.  The shaders' mul(matrix, vector) gives the same result,
+// since the matrices are uploaded without being transposed.
+static inline Vector4 TransformPoint(const Vector3& position, const Matrix& matrix)
+{
+	return Vector4(position.x * matrix._11 + position.y * matrix._21 + position.z * matrix._31 + matrix._41,
+				   position.x * matrix._12 + position.y * matrix._22 + position.z * matrix._32 + matrix._42,
+				   position.x * matrix._13 + position.y * matrix._23 + position.z * matrix._33 + matrix._43,
+				   position.x * matrix._14 + position.y * matrix._24 + position.z * matrix._34 + matrix._44);
+}
+
+static inline Vector4 TransformPoint(const Vector4& position, const Matrix& matrix)
+{
+	return Vector4(position.x * matrix._11 + position.y * matrix._21 + position.z * matrix._31 + position.w * matrix._41,
+				   position.x * matrix._12 + position.y * matrix._22 + position.z * matrix._32 + position.w * matrix._42,
+				   position.x * matrix._13 + position.y * matrix._23 + position.z * matrix._33 + position.w * matrix._43,
+				   position.x * matrix._14 + position.y * matrix._24 + position.z * matrix._34 + position.w * matrix._44);
+}
+
+// normal * the upper 3x3 part of matrix
+static inline Vector3 TransformNormal(const Vector3& normal, const Matrix& matrix)
+{
+	return Vector3(normal.x * matrix._11 + normal.y * matrix._21 + normal.z * matrix._31,
+				   normal.x * matrix._12 + normal.y * matrix._22 + normal.z * matrix._32,
+				   normal.x * matrix._13 + normal.y * matrix._23 + normal.z * matrix._33);
+}
+
+RasterVertex SoftwareRenderDevice::ShadeVertex(const uint8_t* vertex, const ObjectConstants& object, const DrawState& state, const InstanceData* instance) const
+{
+	// Decode the vertex, which starts with its position and normal, followed by its texture coordinates if the
+	// stride allows (see VertexCompression.h for the compressed formats)
+	Vector3 position;
+	Vector3 normal;
+	float textureCoordinate[2] = { 0.0f, 0.0f };
+	if (_vertexStride == sizeof(CompressedGeoStruct) || _vertexStride == sizeof(CompressedObjectVertexStruct))
+	{
+		CompressedObjectVertexStruct compressed;
+		memcpy(&compressed, vertex, _vertexStride);
+		position = Vector3(VertexCompression::DecodeSnorm16(compressed.Position[0]) * object.PositionScale.x + object.PositionOffset.x,
+						   VertexCompression::DecodeSnorm16(compressed.Position[1]) * object.PositionScale.y + object.PositionOffset.y,
+						   VertexCompression::DecodeSnorm16(compressed.Position[2]) * object.PositionScale.z + object.PositionOffset.z);
+		normal = VertexCompression::DecodeOctahedral(compressed.Normal);
+		if (_vertexStride == sizeof(CompressedObjectVertexStruct))
+		{
+			textureCoordinate[0] = VertexCompression::DecodeHalf(compressed.TextureCoordinate[0]);
+			textureCoordinate[1] = VertexCompression::DecodeHalf(compressed.TextureCoordinate[1]);
+		}
+	}
+	else
+	{
+		memcpy(&position, vertex, sizeof(Vector3));
+		memcpy(&normal, vertex + sizeof(Vector3), sizeof(Vector3));
+		if (_vertexStride >= sizeof(ObjectVertexStruct))
+		{
+			memcpy(textureCoordinate, vertex + offsetof(ObjectVertexStruct, TextureCoordinate), sizeof(textureCoordinate));
+		}
+	}
+
+	// The vertex shader
+	RasterVertex output;
+	Vector3 worldNormal;
+	Vector4 worldPosition;
+	if (instance != nullptr)
+	{
+		worldPosition = TransformPoint(position, instance->World);
+		output.Position = TransformPoint(worldPosition, state.Frame.ViewProjection);
+		worldNormal = TransformNormal(normal, instance->World);
+	}
+	else
+	{
+		output.Position = TransformPoint(position, object.WorldViewProjection);
+		worldNormal = TransformNormal(normal, object.World);
+		worldPosition = TransformPoint(position, object.World);
+	}
+	output.Varyings[NormalVarying] = worldNormal.x;
+	output.Varyings[NormalVarying + 1] = worldNormal.y;
+	output.Varyings[NormalVarying + 2] = worldNormal.z;
+	output.Varyings[WorldPositionVarying] = worldPosition.x;
+	output.Varyings[WorldPositionVarying + 1] = worldPosition.y;
+	output.Varyings[WorldPositionVarying + 2] = worldPosition.z;
+	output.Varyings[TextureCoordinateVarying] = textureCoordinate[0];
+	output.Varyings[TextureCoordinateVarying + 1] = textureCoordinate[1];
+	return output;
+}
+
+void SoftwareRenderDevice::Draw(unsigned int indexCount, unsigned int startIndex, int baseVertex, const InstanceData* instance)
+{
+	const vector<uint8_t>* vertexBuffer = FindBuffer(_vertexBuffer);
+	const vector<uint8_t>* indexBuffer = FindBuffer(_indexBuffer);
+	if (_topology != PrimitiveTopology::TriangleList || vertexBuffer == nullptr || indexBuffer == nullptr || _vertexStride < sizeof(CompressedGeoStruct) ||
+		_vertexOffset > vertexBuffer->size())
+	{
+		return;
+	}
+
+	// Copy what the pixel shader needs, since the constant buffer will have been reused by the time the draw is rasterised
+	DrawState state;
+	ReadConstants(FrameConstantsSlot, &state.Frame, sizeof(state.Frame));
+	ReadConstants(MaterialConstantsSlot, &state.Material, sizeof(state.Material));
+	ObjectConstants object;
+	ReadConstants(ObjectConstantsSlot, &object, sizeof(object));
+	state.Instanced = instance != nullptr;
+	state.Colour = Saturate(instance != nullptr ? instance->MaterialColour : state.Material.MaterialColour);
+	auto shader = _shaders.find(_pixelShader);
+	state.Shader = shader != _shaders.end() ? shader->second : SoftwareShader::Lit;
+	auto texture = _textures.find(_texture);
+	state.Image = texture != _textures.end() ? texture->second : nullptr;
+	uint32_t draw = static_cast<uint32_t>(_draws.size());
+	_draws.push_back(state);
+	size_t varyingCount = state.Shader == SoftwareShader::Textured ? TexturedVaryingCount : LitVaryingCount;
+
+	// Each vertex is only transformed once per draw, however many triangles use it
+	_vertexCacheDraw++;
+	size_t vertexCount = (vertexBuffer->size() - _vertexOffset) / _vertexStride;
+	if (_vertexCache.size() < vertexCount)
+	{
+		_vertexCache.resize(vertexCount);
+		_vertexCacheDraws.resize(vertexCount, 0);
+	}
+	const uint8_t* vertices = vertexBuffer->data() + _vertexOffset;
+	size_t indexSize = _indexFormat == IndexFormat::UInt16 ? sizeof(uint16_t) : sizeof(uint32_t);
+	size_t indexEnd = _indexOffset + (static_cast<size_t>(startIndex) + indexCount) * indexSize;
+	if (indexEnd > indexBuffer->size())
+	{
+		return;
+	}
+	const uint8_t* indices = indexBuffer->data() + _indexOffset + static_cast<size_t>(startIndex) * indexSize;
+	const RasterVertex* triangle[3];
+	for (unsigned int i = 0; i + 2 < indexCount; i += 3)
+	{
+		bool valid = true;
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			uint32_t index;
+			if (indexSize == sizeof(uint16_t))
+			{
+				uint16_t shortIndex;
+				memcpy(&shortIndex, indices + (i + corner) * indexSize, sizeof(shortIndex));
+				index = shortIndex;
+			}
+			else
+			{
+				memcpy(&index, indices + (i + corner) * indexSize, sizeof(index));
+			}
+			int64_t vertexIndex = static_cast<int64_t>(index) + baseVertex;
+			valid = valid && vertexIndex >= 0 && vertexIndex < static_cast<int64_t>(vertexCount);
+			if (!valid)
+			{
+				break;
+			}
+			if (_vertexCacheDraws[vertexIndex] != _vertexCacheDraw)
+			{
+				_vertexCache[vertexIndex] = ShadeVertex(vertices + vertexIndex * _vertexStride, object, state, instance);
+				_vertexCacheDraws[vertexIndex] = _vertexCacheDraw;
+			}
+			triangle[corner] = &_vertexCache[vertexIndex];
+		}
+		if (valid)
+		{
+			_rasteriser.AddTriangle(*triangle[0], *triangle[1], *triangle[2], varyingCount, draw);
+		}
+	}
+}
+
+Vector4 SoftwareRenderDevice::Sample(const Texture& texture, float u, float v) const
+{
+	// Bilinear filtering between the centres of the four nearest texels, clamping at the edges
+	float x = u * texture.Width - 0.5f;
+	float y = v * texture.Height - 0.5f;
+	x = x > -1.0f ? (x < static_cast<float>(texture.Width) ? x : static_cast<float>(texture.Width)) : -1.0f;
+	y = y > -1.0f ? (y < static_cast<float>(texture.Height) ? y : static_cast<float>(texture.Height)) : -1.0f;
+	float left = floorf(x);
+	float top = floorf(y);
+	float fractionX = x - left;
+	float fractionY = y - top;
+	int maxX = static_cast<int>(texture.Width) - 1;
+	int maxY = static_cast<int>(texture.Height) - 1;
+	int x0 = min(max(static_cast<int>(left), 0), maxX);
+	int x1 = min(max(static_cast<int>(left) + 1, 0), maxX);
+	int y0 = min(max(static_cast<int>(top), 0), maxY);
+	int y1 = min(max(static_cast<int>(top) + 1, 0), maxY);
+	const Vector4* row0 = texture.Texels.data() + static_cast<size_t>(y0) * texture.Width;
+	const Vector4* row1 = texture.Texels.data() + static_cast<size_t>(y1) * texture.Width;
+	Vector4 upper = row0[x0] + (row0[x1] - row0[x0]) * fractionX;
+	Vector4 lower = row1[x0] + (row1[x1] - row1[x0]) * fractionX;
+	return upper + (lower - upper) * fractionY;
+}
+
+Vector4 SoftwareRenderDevice::Shade(uint32_t draw, const float* varyings) const
+{
+	// The pixel shaders of shader.hlsl and texturedShader.hlsl, which share their lighting
+	const DrawState& state = _draws[draw];
+	Vector3 worldPosition(varyings[WorldPositionVarying], varyings[WorldPositionVarying + 1], varyings[WorldPositionVarying + 2]);
+	Vector3 toEye = Vector3(state.Frame.EyePosition.x, state.Frame.EyePosition.y, state.Frame.EyePosition.z) - worldPosition;
+	toEye.Normalize();
+
+	Vector3 worldNormal(varyings[NormalVarying], varyings[NormalVarying + 1], varyings[NormalVarying + 2]);
+	worldNormal.Normalize();
+	Vector3 lightDirection(state.Frame.DirectionalLightVector.x, state.Frame.DirectionalLightVector.y, state.Frame.DirectionalLightVector.z);
+	lightDirection.Normalize();
+	float diffuseFactor = Saturate(max(worldNormal.Dot(-lightDirection), 0.0f));
+
+	// reflect(-toEye, worldNormal)
+	Vector3 reflected = -toEye + worldNormal * (2.0f * worldNormal.Dot(toEye));
+	float specularFactor = powf(Saturate(reflected.Dot(toEye)), state.Material.SpecularPower);
+
+	Vector4 totalLight = Saturate(state.Frame.AmbientLightColour + state.Frame.DirectionalLightColour * diffuseFactor + state.Material.SpecularColour * specularFactor);
+	if (state.Shader == SoftwareShader::Textured)
+	{
+		Vector4 finalColour = Saturate(totalLight * state.Material.MaterialColour);
+		Vector4 texel = state.Image ? Sample(*state.Image, varyings[TextureCoordinateVarying], varyings[TextureCoordinateVarying + 1]) : Vector4(1.0f, 1.0f, 1.0f, 1.0f);
+		return finalColour * texel;
+	}
+	// The instanced shader uses the instance colour in place of the material colour
+	Vector4 finalColour = Saturate(totalLight * (state.Instanced ? state.Colour : state.Material.MaterialColour));
+	return finalColour * state.Colour;
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include "RenderDevice.h"
+#include "SoftwareRasteriser.h"
+#include "ShaderTypes.h"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// The shaders that the software render device can stand in for
+enum class SoftwareShader : uint8_t
+{
+	// shader.hlsl
+	Lit,
+	// texturedShader.hlsl
+	Textured
+};
+
+// Render device that draws with the SoftwareRasteriser instead of a GPU, so that frames built by the
+// render queue can be turned into images on any machine (for example to compare against reference
+// images) and so that the rasteriser's speed can be measured.
+//
+// The vertex and pixel shaders are C++ ports of shader.hlsl and texturedShader.hlsl.  Shaders are
+// only handles here, so the device is told which of the two each pixel shader handle stands for;
+// the vertex format is worked out from the stride (GeoStruct, ObjectVertexStruct or their
+// compressed versions from VertexCompression.h), and DrawIndexedInstanced uses the instanced
+// version of shader.hlsl.  Textures are also only handles, so their images are given to the
+// device with SetTextureImage, and are sampled bilinearly with clamped coordinates like the
+// default Direct3D sampler.
+//
+// Vertices are transformed when each draw is made, reading the constants, buffers and state that
+// are bound at the time, and the triangles are collected by the rasteriser.  Nothing is drawn
+// into the image until Flush is called.  Only triangle lists are drawn.
+
+class SoftwareRenderDevice : public RenderDevice, private PixelShading
+{
+public:
+	// If a job system is given, tiles are drawn on it in parallel
+	SoftwareRenderDevice(unsigned int width, unsigned int height, JobSystem* jobSystem = nullptr);
+
+	RenderHandle CreateBuffer(BufferType type, BufferUsage usage, size_t size, const void* data);
+	void ReleaseBuffer(RenderHandle buffer);
+	void ClearTargets(const float colour[4], float depth);
+	void SetViewport(float width, float height);
+
+	void SetShaders(RenderHandle vertexShader, RenderHandle pixelShader);
+	void SetInputLayout(RenderHandle inputLayout);
+	void SetPrimitiveTopology(PrimitiveTopology topology);
+	void SetVertexBuffer(RenderHandle vertexBuffer, unsigned int stride, unsigned int offset);
+	void SetInstanceBuffer(RenderHandle instanceBuffer, unsigned int stride, unsigned int offset);
+	void SetIndexBuffer(RenderHandle indexBuffer, IndexFormat format, unsigned int offset);
+	void SetTexture(unsigned int slot, RenderHandle texture);
+	void SetConstantBuffer(unsigned int slot, RenderHandle constantBuffer);
+	void SetConstantBufferRange(unsigned int slot, RenderHandle constantBuffer, unsigned int offset, unsigned int size);
+	void UpdateBuffer(RenderHandle buffer, const void* data, size_t size);
+	void WriteBuffer(RenderHandle buffer, size_t offset, const void* data, size_t size, bool discard);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance);
+
+	// Pixel shaders that have not been given a shader are drawn as shader.hlsl
+	void SetPixelShader(RenderHandle pixelShader, SoftwareShader shader);
+	// Set the image of a texture, in the same format as SoftwareRasteriser::GetImage.  Textures without an image are white.
+	void SetTextureImage(RenderHandle texture, unsigned int width, unsigned int height, const uint32_t* pixels);
+
+	// Draw everything since the last Flush (or ClearTargets) into the image
+	void Flush();
+
+	inline void SetJobSystem(JobSystem* jobSystem) { _jobSystem = jobSystem; }
+	inline const SoftwareRasteriser& GetRasteriser() const { return _rasteriser; }
+	inline SoftwareRasteriser& GetRasteriser() { return _rasteriser; }
+	// Buffers created and not yet released
+	inline size_t GetBufferCount() const { return _buffers.size(); }
+
+private:
+	struct Texture
+	{
+		unsigned int			Width;
+		unsigned int			Height;
+		vector<Vector4>			Texels;
+	};
+
+	struct ConstantRange
+	{
+		RenderHandle			Buffer{ 0 };
+		unsigned int			Offset{ 0 };
+		unsigned int			Size{ 0 };
+	};
+
+	// Everything the pixel shader needs for one draw (or one instance of an instanced draw)
+	struct DrawState
+	{
+		FrameConstants			Frame;
+		MaterialConstants		Material;
+		// The colour output by the vertex shader
+		Vector4					Colour;
+		bool					Instanced;
+		SoftwareShader			Shader;
+		shared_ptr<Texture>		Image;
+	};
+
+	static constexpr unsigned int ConstantSlotCount = 3;
+
+	SoftwareRasteriser								_rasteriser;
+	JobSystem*										_jobSystem;
+	unordered_map<RenderHandle, vector<uint8_t>>	_buffers;
+	RenderHandle									_nextBuffer{ 1 };
+	unordered_map<RenderHandle, SoftwareShader>		_shaders;
+	unordered_map<RenderHandle, shared_ptr<Texture>>	_textures;
+
+	RenderHandle			_pixelShader{ 0 };
+	PrimitiveTopology		_topology{ PrimitiveTopology::TriangleList };
+	RenderHandle			_vertexBuffer{ 0 };
+	unsigned int			_vertexStride{ 0 };
+	unsigned int			_vertexOffset{ 0 };
+	RenderHandle			_instanceBuffer{ 0 };
+	unsigned int			_instanceStride{ 0 };
+	unsigned int			_instanceOffset{ 0 };
+	RenderHandle			_indexBuffer{ 0 };
+	IndexFormat				_indexFormat{ IndexFormat::UInt32 };
+	unsigned int			_indexOffset{ 0 };
+	RenderHandle			_texture{ 0 };
+	ConstantRange			_constants[ConstantSlotCount];
+
+	vector<DrawState>		_draws;
+	// Vertices that have already been through the vertex shader, marked with the draw they were transformed for.
+	// Draws are numbered from 1 here, separately from _draws, which starts again after every Flush.
+	vector<RasterVertex>	_vertexCache;
+	vector<uint32_t>		_vertexCacheDraws;
+	uint32_t				_vertexCacheDraw{ 0 };
+
+	vector<uint8_t>& GetBuffer(RenderHandle buffer);
+	const vector<uint8_t>* FindBuffer(RenderHandle buffer) const;
+	void ReadConstants(unsigned int slot, void* constants, size_t size) const;
+	void Draw(unsigned int indexCount, unsigned int startIndex, int baseVertex, const InstanceData* instance);
+	RasterVertex ShadeVertex(const uint8_t* vertex, const ObjectConstants& object, const DrawState& state, const InstanceData* instance) const;
+	Vector4 Shade(uint32_t draw, const float* varyings) const;
+	Vector4 Sample(const Texture& texture, float u, float v) const;
+};
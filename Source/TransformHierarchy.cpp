@@ -0,0 +1,311 @@
+#include "TransformHierarchy.h"
+#include "SceneNode.h"
+#include "MatrixKernels.h"
+#include <algorithm>
+
+void TransformHierarchy::Rebuild(SceneNode* root)
+{
+	Clear();
+	// Walk the scene graph depth first so that parents are always added before their children
+	root->BindTransform(this, -1);
+	_structureChanged = false;
+	_revision++;
+}
+
+void TransformHierarchy::Clear()
+{
+	_parents.clear();
+	_subtreeEnds.clear();
+	_localTransformations.clear();
+	_worldTransformations.clear();
+	_worldViewProjections.clear();
+	_nodes.clear();
+	_dirty.clear();
+	_localBounds.clear();
+	_worldBounds.clear();
+	_subtreeBounds.clear();
+	_visible.clear();
+	_boundsChanged.clear();
+	_recomputedCount = 0;
+	_structureChanged = true;
+}
+
+int TransformHierarchy::Add(SceneNode* node, int parentIndex, const Matrix& localTransformation, const AxisAlignedBox& localBounds)
+{
+	int index = static_cast<int>(_parents.size());
+	assert(parentIndex < index);
+	_parents.push_back(parentIndex);
+	// The new entry extends the subtree of each of its ancestors
+	_subtreeEnds.push_back(index + 1);
+	for (int ancestor = parentIndex; ancestor >= 0; ancestor = _parents[ancestor])
+	{
+		_subtreeEnds[ancestor] = index + 1;
+	}
+	_localTransformations.push_back(localTransformation);
+	_worldTransformations.push_back(localTransformation);
+	_worldViewProjections.push_back(localTransformation);
+	_nodes.push_back(node);
+	// New entries always need their world transformation calculating
+	_dirty.push_back(1);
+	_localBounds.push_back(localBounds);
+	_worldBounds.push_back(localBounds);
+	_subtreeBounds.push_back(localBounds);
+	// Everything is visible until the first time we cull
+	_visible.push_back(1);
+	_boundsChanged.push_back(0);
+	return index;
+}
+
+void TransformHierarchy::SetLocalBounds(int index, const AxisAlignedBox& localBounds)
+{
+	// The world space bounds are recalculated along with the world transformation
+	_localBounds[index] = localBounds;
+	_dirty[index] = 1;
+	// An entry gaining or losing its bounds changes which entries are in spatial structures
+	_revision++;
+}
+
+void TransformHierarchy::SetLocalTransformation(int index, const Matrix& localTransformation)
+{
+	// Nodes are often given the same transformation every frame, so only mark
+	// the entry as dirty if the transformation has actually changed
+	if (memcmp(&_localTransformations[index], &localTransformation, sizeof(Matrix)) != 0)
+	{
+		_localTransformations[index] = localTransformation;
+		_dirty[index] = 1;
+	}
+}
+
+void TransformHierarchy::Update(const Matrix& rootTransformation, JobSystem* jobSystem)
+{
+	// If the root transformation has changed, every entry at the top of the hierarchy is dirty
+	bool rootChanged = memcmp(&_rootTransformation, &rootTransformation, sizeof(Matrix)) != 0;
+	_rootTransformation = rootTransformation;
+
+	int count = static_cast<int>(_parents.size());
+	if (jobSystem == nullptr || static_cast<size_t>(count) < _grainSize)
+	{
+		_recomputedCount = UpdateRange(0, count, rootChanged, nullptr, nullptr, nullptr);
+	}
+	else
+	{
+		// Large subtrees are added to the job system as we come across them.  Tasks add their
+		// counts to recomputedCount, so we only need to add in the count for the serial part.
+		JobCounter counter{ 0 };
+		atomic<size_t> recomputedCount{ 0 };
+		recomputedCount += UpdateRange(0, count, rootChanged, jobSystem, &counter, &recomputedCount);
+		jobSystem->Wait(counter);
+		_recomputedCount = recomputedCount;
+	}
+
+	// If anything has moved, the bounds of the subtrees containing it have changed
+	if (_recomputedCount > 0)
+	{
+		UpdateSubtreeBounds();
+		_boundsRevision++;
+	}
+
+	// Everything is now up to date
+	fill(_dirty.begin(), _dirty.end(), static_cast<uint8_t>(0));
+}
+
+size_t TransformHierarchy::UpdateRange(int begin, int end, bool rootChanged, JobSystem* jobSystem, JobCounter* counter, atomic<size_t>* recomputedCount)
+{
+	// Since parents are stored before their children, the parent's dirty flag has always been
+	// updated by the time we reach any of its children.  Dirty flags therefore propagate down to
+	// the descendants of a changed node in the same pass.  Consecutive entries that need
+	// recalculating are collected into runs and passed to the batched kernels, which go through
+	// each run in order, so parents in a run are calculated before their children.  The order
+	// of multiplication is the same as the recursive SceneGraph::Update, so the results are identical.
+	size_t recomputed = 0;
+	int runBegin = begin;
+	int i = begin;
+	while (i < end)
+	{
+		// A subtree starting here only depends on entries we have already updated, so if it is
+		// large enough, it can be updated by another thread while we carry on past it.  Its
+		// parent may be in the current run, so that has to be finished first.
+		int subtreeEnd = _subtreeEnds[i];
+		if (jobSystem != nullptr && i != begin && static_cast<size_t>(subtreeEnd - i) >= _grainSize)
+		{
+			Recompute(runBegin, i);
+			jobSystem->Submit([this, i, subtreeEnd, rootChanged, jobSystem, counter, recomputedCount]()
+				{
+					*recomputedCount += UpdateRange(i, subtreeEnd, rootChanged, jobSystem, counter, recomputedCount);
+				}, *counter);
+			i = subtreeEnd;
+			runBegin = i;
+			continue;
+		}
+
+		int parentIndex = _parents[i];
+		bool parentDirty = parentIndex < 0 ? rootChanged : _dirty[parentIndex] != 0;
+		if (_dirty[i] || parentDirty)
+		{
+			_dirty[i] = 1;
+			recomputed++;
+		}
+		else
+		{
+			Recompute(runBegin, i);
+			runBegin = i + 1;
+		}
+		i++;
+	}
+	Recompute(runBegin, end);
+	return recomputed;
+}
+
+void TransformHierarchy::Recompute(int begin, int end)
+{
+	if (begin < end)
+	{
+		MatrixKernels::MultiplyByParents(_localTransformations.data(), _parents.data(), begin, end, _rootTransformation, _worldTransformations.data());
+		MatrixKernels::TransformBoxes(&_localBounds[begin], &_worldTransformations[begin], end - begin, &_worldBounds[begin]);
+	}
+}
+
+void TransformHierarchy::UpdateSubtreeBounds()
+{
+	// Dirty flags have been passed down to every descendant, so the entries that moved form whole subtrees.  The
+	// subtree bounds are recalculated within each of those, and then for each of their ancestors in turn.
+	vector<int>& ancestors = _boundsAncestors;
+	ancestors.clear();
+	int count = static_cast<int>(_parents.size());
+	int i = 0;
+	while (i < count)
+	{
+		if (!_dirty[i])
+		{
+			i++;
+			continue;
+		}
+		// Working backwards means that every entry has been merged with all of its
+		// descendants before it is merged into its own parent
+		int subtreeEnd = _subtreeEnds[i];
+		copy(_worldBounds.begin() + i, _worldBounds.begin() + subtreeEnd, _subtreeBounds.begin() + i);
+		for (int j = subtreeEnd; --j > i;)
+		{
+			_subtreeBounds[_parents[j]].Merge(_subtreeBounds[j]);
+		}
+		// Each ancestor chain only has to be followed until it meets one that has already been collected
+		for (int ancestor = _parents[i]; ancestor >= 0 && !_boundsChanged[ancestor]; ancestor = _parents[ancestor])
+		{
+			_boundsChanged[ancestor] = 1;
+			ancestors.push_back(ancestor);
+		}
+		i = subtreeEnd;
+	}
+
+	// Children come after their parents, so going from the last ancestor to the first merges every child before its
+	// parent.  Only the direct children of an ancestor are merged into it, by skipping over each child's subtree.
+	sort(ancestors.begin(), ancestors.end(), greater<int>());
+	for (int ancestor : ancestors)
+	{
+		AxisAlignedBox bounds = _worldBounds[ancestor];
+		for (int child = ancestor + 1; child < _subtreeEnds[ancestor]; child = _subtreeEnds[child])
+		{
+			bounds.Merge(_subtreeBounds[child]);
+		}
+		_subtreeBounds[ancestor] = bounds;
+		_boundsChanged[ancestor] = 0;
+	}
+}
+
+void TransformHierarchy::Cull(const Frustum& frustum)
+{
+	size_t visibleCount = 0;
+	size_t culledCount = 0;
+	// Entries before insideEnd are in a subtree that is entirely inside the frustum, so need no testing
+	int insideEnd = 0;
+	int count = static_cast<int>(_parents.size());
+	int i = 0;
+	while (i < count)
+	{
+		// Only entries with bounds of their own (i.e. that have geometry) are counted
+		bool hasGeometry = !_localBounds[i].IsEmpty();
+		if (i < insideEnd)
+		{
+			_visible[i] = 1;
+			visibleCount += hasGeometry;
+			i++;
+			continue;
+		}
+		FrustumTest result = frustum.Test(_subtreeBounds[i]);
+		if (result == FrustumTest::Outside)
+		{
+			// Skip the whole subtree
+			int subtreeEnd = _subtreeEnds[i];
+			for (int j = i; j < subtreeEnd; j++)
+			{
+				_visible[j] = 0;
+				culledCount += !_localBounds[j].IsEmpty();
+			}
+			i = subtreeEnd;
+			continue;
+		}
+		if (result == FrustumTest::Inside)
+		{
+			insideEnd = _subtreeEnds[i];
+		}
+		_visible[i] = 1;
+		visibleCount += hasGeometry;
+		i++;
+	}
+	_visibleCount = visibleCount;
+	_culledCount = culledCount;
+	_occludedCount = 0;
+}
+
+void TransformHierarchy::Hide(const function<bool(const AxisAlignedBox&)>& isHidden)
+{
+	size_t occludedCount = 0;
+	int count = static_cast<int>(_parents.size());
+	int i = 0;
+	while (i < count)
+	{
+		// Cull only leaves whole subtrees out, so nothing below an entry that is not visible needs looking at
+		if (!_visible[i])
+		{
+			i = _subtreeEnds[i];
+			continue;
+		}
+		// Only whole subtrees are hidden, since a graph that is not visible is not rendered at all
+		int subtreeEnd = _subtreeEnds[i];
+		if (!_subtreeBounds[i].IsEmpty() && isHidden(_subtreeBounds[i]))
+		{
+			for (int j = i; j < subtreeEnd; j++)
+			{
+				occludedCount += _visible[j] && !_localBounds[j].IsEmpty();
+				_visible[j] = 0;
+			}
+			i = subtreeEnd;
+			continue;
+		}
+		i++;
+	}
+	_visibleCount -= occludedCount;
+	_occludedCount = occludedCount;
+}
+
+void TransformHierarchy::UpdateWorldViewProjections(const Matrix& viewProjection)
+{
+	// Visible entries tend to come in long runs, since whole subtrees are culled together
+	int count = static_cast<int>(_parents.size());
+	int i = 0;
+	while (i < count)
+	{
+		if (!_visible[i])
+		{
+			i++;
+			continue;
+		}
+		int runEnd = i + 1;
+		while (runEnd < count && _visible[runEnd])
+		{
+			runEnd++;
+		}
+		MatrixKernels::MultiplyAll(&_worldTransformations[i], runEnd - i, viewProjection, &_worldViewProjections[i]);
+		i = runEnd;
+	}
+}
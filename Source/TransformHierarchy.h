@@ -0,0 +1,140 @@
+#pragma once
+#include "SimpleMath.h"
+#include "Bounds.h"
+#include "Frustum.h"
+#include <vector>
+#include <cstdint>
+#include <atomic>
+#include <functional>
+#include "JobSystem.h"
+
+using namespace std;
+using namespace DirectX;
+using namespace SimpleMath;
+
+// Flattened store for the transformations of every node in a scene graph.
+//
+// Nodes are added in depth-first order, so every parent is stored before any of
+// its children.  This means that the cumulative world transformations can be
+// calculated with a single linear sweep over contiguous arrays rather than by
+// recursing through the scene graph.  Scene nodes hold the index of their entry.
+//
+// Each entry also has a dirty flag that is set when its local transformation changes.
+// Update only recalculates the world transformations of dirty entries and their
+// descendants, so static parts of the scene cost almost nothing.  Runs of consecutive
+// entries that need recalculating are passed to the batched kernels in MatrixKernels.
+//
+// Since each subtree occupies a contiguous range of entries, independent subtrees can
+// also be updated in parallel.  If a JobSystem is passed to Update, any subtree with
+// at least the grain size number of entries is handed to the job system as a separate
+// task.  Smaller subtrees are updated serially by the task that contains them.
+//
+// Every entry also has a bounding box in local space.  Update transforms the boxes of
+// dirty entries to world space and then merges them so that each entry also has a box
+// enclosing its entire subtree.  Only the subtree boxes of dirty entries and their
+// ancestors are merged again, so when a single node moves, only the children of each of
+// its ancestors are visited.  Cull uses these to skip whole subtrees that are outside the
+// view frustum, and Hide to skip whole subtrees that are hidden behind occluders.
+
+class SceneNode;
+
+class TransformHierarchy
+{
+public:
+	TransformHierarchy() {};
+	~TransformHierarchy(void) {};
+
+	// Rebuild the flattened arrays from the scene graph rooted at the specified node
+	void Rebuild(SceneNode* root);
+	void Clear();
+
+	// Add a node to the end of the hierarchy.  The parent (if any) must already have been added.
+	// Returns the index of the new entry.
+	int Add(SceneNode* node, int parentIndex, const Matrix& localTransformation, const AxisAlignedBox& localBounds);
+
+	// Calculate the world transformations of all dirty nodes (and their descendants) in one pass.
+	// If jobSystem is not nullptr, large subtrees are updated in parallel.
+	void Update(const Matrix& rootTransformation, JobSystem* jobSystem = nullptr);
+
+	// Minimum number of entries in a subtree before it is updated as a separate task
+	inline void SetGrainSize(size_t grainSize) { _grainSize = grainSize > 0 ? grainSize : 1; }
+	inline size_t GetGrainSize() const { return _grainSize; }
+
+	// Work out which entries are visible.  Entries in subtrees whose bounds are
+	// outside the frustum are marked as not visible without being tested.
+	void Cull(const Frustum& frustum);
+
+	// Hide the visible subtrees whose bounds isHidden returns true for (such as those behind the occluders drawn
+	// by an OcclusionCuller).  The entries of a hidden subtree are not tested.  This must be called after Cull.
+	void Hide(const function<bool(const AxisAlignedBox&)>& isHidden);
+
+	// Calculate world x viewProjection for every visible entry in one batch, after culling, so
+	// that nodes do not each have to multiply the three matrices when they are rendered
+	void UpdateWorldViewProjections(const Matrix& viewProjection);
+
+	void SetLocalTransformation(int index, const Matrix& localTransformation);
+	inline const Matrix& GetLocalTransformation(int index) const { return _localTransformations[index]; }
+	inline const Matrix& GetWorldTransformation(int index) const { return _worldTransformations[index]; }
+	// Only valid for entries that were visible when UpdateWorldViewProjections was last called
+	inline const Matrix& GetWorldViewProjection(int index) const { return _worldViewProjections[index]; }
+	void SetLocalBounds(int index, const AxisAlignedBox& localBounds);
+	inline const AxisAlignedBox& GetWorldBounds(int index) const { return _worldBounds[index]; }
+	inline const AxisAlignedBox& GetSubtreeBounds(int index) const { return _subtreeBounds[index]; }
+	inline bool IsVisible(int index) const { return _visible[index] != 0; }
+	inline int GetParentIndex(int index) const { return _parents[index]; }
+	// The entries for the descendants of an entry are those from index + 1 to GetSubtreeEnd(index) - 1
+	inline int GetSubtreeEnd(int index) const { return _subtreeEnds[index]; }
+	inline SceneNode* GetNode(int index) const { return _nodes[index]; }
+	inline size_t GetCount() const { return _parents.size(); }
+
+	// Number of world transformations that were recalculated by the last call to Update
+	inline size_t GetRecomputedCount() const { return _recomputedCount; }
+
+	// Number of entries with geometry that were found to be visible or were culled by the last call to Cull
+	inline size_t GetVisibleCount() const { return _visibleCount; }
+	inline size_t GetCulledCount() const { return _culledCount; }
+	// Number of entries with geometry that were hidden by the last call to Hide (and are not in the visible count)
+	inline size_t GetOccludedCount() const { return _occludedCount; }
+
+	// Called when nodes are added to or removed from the scene graph so that
+	// the flattened arrays are rebuilt before the next update
+	inline void Invalidate() { _structureChanged = true; }
+	inline bool IsStructureChanged() const { return _structureChanged; }
+
+	// Incremented whenever the entries are rebuilt or their local bounds change, so that
+	// structures built from the hierarchy (such as the BVH) know when to rebuild
+	inline unsigned int GetRevision() const { return _revision; }
+	// Incremented by each call to Update that moves any entries, so that structures built from the
+	// world bounds know whether they need refitting without having to see every update
+	inline unsigned int GetBoundsRevision() const { return _boundsRevision; }
+
+private:
+	vector<int>				_parents;
+	vector<int>				_subtreeEnds;
+	vector<Matrix>			_localTransformations;
+	vector<Matrix>			_worldTransformations;
+	vector<Matrix>			_worldViewProjections;
+	vector<SceneNode*>		_nodes;
+	vector<uint8_t>			_dirty;
+	vector<AxisAlignedBox>	_localBounds;
+	vector<AxisAlignedBox>	_worldBounds;
+	vector<AxisAlignedBox>	_subtreeBounds;
+	vector<uint8_t>			_visible;
+	// Ancestors of moved entries, whose subtree bounds are recalculated by UpdateSubtreeBounds
+	vector<uint8_t>			_boundsChanged;
+	vector<int>				_boundsAncestors;
+
+	Matrix					_rootTransformation;
+	size_t					_recomputedCount{ 0 };
+	size_t					_grainSize{ 1024 };
+	size_t					_visibleCount{ 0 };
+	size_t					_culledCount{ 0 };
+	size_t					_occludedCount{ 0 };
+	bool					_structureChanged{ true };
+	unsigned int			_revision{ 0 };
+	unsigned int			_boundsRevision{ 0 };
+
+	void UpdateSubtreeBounds();
+	size_t UpdateRange(int begin, int end, bool rootChanged, JobSystem* jobSystem, JobCounter* counter, atomic<size_t>* recomputedCount);
+	void Recompute(int begin, int end);
+};
@@ -0,0 +1,235 @@
+#include "VertexCompression.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+// The vertex structures that can be compressed.  Their layouts are fixed by the input layouts in Geometry.h, so
+// they are declared here rather than including the Direct3D headers.
+constexpr size_t GeoStructStride = 24;
+constexpr size_t ObjectVertexStride = 32;
+constexpr size_t TextureCoordinateOffset = 24;
+
+static_assert(sizeof(CompressedGeoStruct) == GeoStructStride / 2, "CompressedGeoStruct must be half the size of GeoStruct");
+static_assert(sizeof(CompressedObjectVertexStruct) == ObjectVertexStride / 2, "CompressedObjectVertexStruct must be half the size of ObjectVertexStruct");
+
+size_t VertexCompression::GetCompressedStride(size_t stride)
+{
+	switch (stride)
+	{
+		case GeoStructStride:
+			return sizeof(CompressedGeoStruct);
+
+		case ObjectVertexStride:
+			return sizeof(CompressedObjectVertexStruct);
+
+		default:
+			return 0;
+	}
+}
+
+VertexQuantisation VertexCompression::GetQuantisation(const AxisAlignedBox& bounds)
+{
+	VertexQuantisation quantisation;
+	if (bounds.IsEmpty())
+	{
+		return quantisation;
+	}
+	Vector3 centre = bounds.GetCentre();
+	Vector3 extents = bounds.GetExtents();
+	quantisation.Scale = Vector4(extents.x > 0.0f ? extents.x : 1.0f, extents.y > 0.0f ? extents.y : 1.0f, extents.z > 0.0f ? extents.z : 1.0f, 0.0f);
+	quantisation.Offset = Vector4(centre.x, centre.y, centre.z, 0.0f);
+	return quantisation;
+}
+
+void VertexCompression::Compress(const void* vertices, size_t count, size_t stride, const VertexQuantisation& quantisation, void* compressed)
+{
+	size_t compressedStride = GetCompressedStride(stride);
+	Vector3 offset(quantisation.Offset.x, quantisation.Offset.y, quantisation.Offset.z);
+	Vector3 inverseScale(1.0f / quantisation.Scale.x, 1.0f / quantisation.Scale.y, 1.0f / quantisation.Scale.z);
+	const uint8_t* source = static_cast<const uint8_t*>(vertices);
+	uint8_t* destination = static_cast<uint8_t*>(compressed);
+	for (size_t i = 0; i < count; i++, source += stride, destination += compressedStride)
+	{
+		const Vector3* attributes = reinterpret_cast<const Vector3*>(source);
+		// Both compressed structures start with the members of CompressedGeoStruct
+		CompressedGeoStruct* vertex = reinterpret_cast<CompressedGeoStruct*>(destination);
+		Vector3 position = (attributes[0] - offset) * inverseScale;
+		vertex->Position[0] = EncodeSnorm16(position.x);
+		vertex->Position[1] = EncodeSnorm16(position.y);
+		vertex->Position[2] = EncodeSnorm16(position.z);
+		vertex->Position[3] = 0;
+		EncodeOctahedral(attributes[1], vertex->Normal);
+		if (stride == ObjectVertexStride)
+		{
+			const Vector2* textureCoordinate = reinterpret_cast<const Vector2*>(source + TextureCoordinateOffset);
+			CompressedObjectVertexStruct* objectVertex = reinterpret_cast<CompressedObjectVertexStruct*>(destination);
+			objectVertex->TextureCoordinate[0] = EncodeHalf(textureCoordinate->x);
+			objectVertex->TextureCoordinate[1] = EncodeHalf(textureCoordinate->y);
+		}
+	}
+}
+
+void VertexCompression::Decompress(const void* compressed, size_t count, size_t stride, const VertexQuantisation& quantisation, void* vertices)
+{
+	size_t compressedStride = GetCompressedStride(stride);
+	Vector3 offset(quantisation.Offset.x, quantisation.Offset.y, quantisation.Offset.z);
+	Vector3 scale(quantisation.Scale.x, quantisation.Scale.y, quantisation.Scale.z);
+	const uint8_t* source = static_cast<const uint8_t*>(compressed);
+	uint8_t* destination = static_cast<uint8_t*>(vertices);
+	for (size_t i = 0; i < count; i++, source += compressedStride, destination += stride)
+	{
+		const CompressedGeoStruct* vertex = reinterpret_cast<const CompressedGeoStruct*>(source);
+		Vector3* attributes = reinterpret_cast<Vector3*>(destination);
+		attributes[0] = Vector3(DecodeSnorm16(vertex->Position[0]), DecodeSnorm16(vertex->Position[1]), DecodeSnorm16(vertex->Position[2])) * scale + offset;
+		attributes[1] = DecodeOctahedral(vertex->Normal);
+		if (stride == ObjectVertexStride)
+		{
+			const CompressedObjectVertexStruct* objectVertex = reinterpret_cast<const CompressedObjectVertexStruct*>(source);
+			Vector2* textureCoordinate = reinterpret_cast<Vector2*>(destination + TextureCoordinateOffset);
+			*textureCoordinate = Vector2(DecodeHalf(objectVertex->TextureCoordinate[0]), DecodeHalf(objectVertex->TextureCoordinate[1]));
+		}
+	}
+}
+
+int16_t VertexCompression::EncodeSnorm16(float value)
+{
+	// NaN is stored as 0
+	if (!(value == value))
+	{
+		return 0;
+	}
+	return static_cast<int16_t>(lrintf(min(max(value, -1.0f), 1.0f) * 32767.0f));
+}
+
+float VertexCompression::DecodeSnorm16(int16_t value)
+{
+	// -32768 and -32767 both mean -1
+	return max(static_cast<float>(value) / 32767.0f, -1.0f);
+}
+
+static inline float SignNotZero(float value)
+{
+	return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+// The unit vector for a point on the unfolded octahedron
+static Vector3 UnfoldOctahedron(float u, float v)
+{
+	Vector3 normal(u, v, 1.0f - fabs(u) - fabs(v));
+	// The lower half of the octahedron is folded over the corners of the square
+	if (normal.z < 0.0f)
+	{
+		float x = normal.x;
+		normal.x = (1.0f - fabs(normal.y)) * SignNotZero(x);
+		normal.y = (1.0f - fabs(x)) * SignNotZero(normal.y);
+	}
+	normal.Normalize();
+	return normal;
+}
+
+void VertexCompression::EncodeOctahedral(const Vector3& normal, int16_t encoded[2])
+{
+	float length = fabs(normal.x) + fabs(normal.y) + fabs(normal.z);
+	if (!(length > 0.0f))
+	{
+		encoded[0] = 0;
+		encoded[1] = 0;
+		return;
+	}
+	// Project onto the octahedron |x| + |y| + |z| = 1 and fold the lower half out
+	float u = normal.x / length;
+	float v = normal.y / length;
+	if (normal.z < 0.0f)
+	{
+		float x = u;
+		u = (1.0f - fabs(v)) * SignNotZero(x);
+		v = (1.0f - fabs(x)) * SignNotZero(v);
+	}
+
+	// Rounding each coordinate to the nearest step is not always the closest direction once the result is unfolded
+	// and normalised, so try the four neighbouring points and keep the best.  They are compared by distance rather
+	// than by dot product, which cannot tell such small angles apart in single precision.
+	float scaledU = min(max(u, -1.0f), 1.0f) * 32767.0f;
+	float scaledV = min(max(v, -1.0f), 1.0f) * 32767.0f;
+	Vector3 unitNormal = normal / normal.Length();
+	float bestDistance = FLT_MAX;
+	for (int i = 0; i < 4; i++)
+	{
+		int16_t candidateU = static_cast<int16_t>((i & 1) ? ceilf(scaledU) : floorf(scaledU));
+		int16_t candidateV = static_cast<int16_t>((i & 2) ? ceilf(scaledV) : floorf(scaledV));
+		float distance = Vector3::DistanceSquared(UnfoldOctahedron(DecodeSnorm16(candidateU), DecodeSnorm16(candidateV)), unitNormal);
+		if (distance < bestDistance)
+		{
+			bestDistance = distance;
+			encoded[0] = candidateU;
+			encoded[1] = candidateV;
+		}
+	}
+}
+
+Vector3 VertexCompression::DecodeOctahedral(const int16_t encoded[2])
+{
+	return UnfoldOctahedron(DecodeSnorm16(encoded[0]), DecodeSnorm16(encoded[1]));
+}
+
+static inline uint32_t FloatBits(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+static inline float BitsFloat(uint32_t bits)
+{
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// Rounds to the nearest half, with ties to even, as the hardware conversions do
+uint16_t VertexCompression::EncodeHalf(float value)
+{
+	uint32_t bits = FloatBits(value);
+	uint32_t sign = (bits >> 16) & 0x8000;
+	bits &= 0x7FFFFFFF;
+	uint16_t half;
+	if (bits >= 0x47800000)
+	{
+		// 65536 or more (which rounds to infinity), infinity or NaN
+		half = bits > 0x7F800000 ? 0x7E00 : 0x7C00;
+	}
+	else if (bits < 0x38800000)
+	{
+		// Smaller than the smallest normal half.  Adding 0.5 lines the denormal half's bits up with the bottom of
+		// the float's mantissa, and lets the floating point addition do the rounding.
+		half = static_cast<uint16_t>(FloatBits(BitsFloat(bits) + 0.5f) - FloatBits(0.5f));
+	}
+	else
+	{
+		// Rebias the exponent and round the mantissa to 10 bits.  A carry out of the mantissa correctly moves up to
+		// the next exponent (or to infinity).
+		uint32_t odd = (bits >> 13) & 1;
+		bits = bits - ((127 - 15) << 23) + 0xFFF + odd;
+		half = static_cast<uint16_t>(bits >> 13);
+	}
+	return static_cast<uint16_t>(half | sign);
+}
+
+float VertexCompression::DecodeHalf(uint16_t value)
+{
+	uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1F;
+	uint32_t mantissa = value & 0x3FF;
+	if (exponent == 0)
+	{
+		// Zero or denormal
+		float magnitude = ldexpf(static_cast<float>(mantissa), -24);
+		return sign ? -magnitude : magnitude;
+	}
+	if (exponent == 31)
+	{
+		return BitsFloat(sign | 0x7F800000 | (mantissa << 13));
+	}
+	return BitsFloat(sign | ((exponent + 127 - 15) << 23) | (mantissa << 13));
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "SimpleMath.h"
+#include "Bounds.h"
+#include <cstdint>
+
+using namespace std;
+using namespace DirectX;
+using namespace SimpleMath;
+
+// Compressed versions of GeoStruct (24 bytes) and ObjectVertexStruct (32 bytes).  The formats of the
+// members match compressedGeoVertexDesc and compressedVertexDesc in Geometry.h.
+struct CompressedGeoStruct
+{
+	int16_t			Position[4];			// DXGI_FORMAT_R16G16B16A16_SNORM, relative to the bounds (w is 0)
+	int16_t			Normal[2];				// DXGI_FORMAT_R16G16_SNORM, octahedral
+};
+
+struct CompressedObjectVertexStruct
+{
+	int16_t			Position[4];			// DXGI_FORMAT_R16G16B16A16_SNORM, relative to the bounds (w is 0)
+	int16_t			Normal[2];				// DXGI_FORMAT_R16G16_SNORM, octahedral
+	uint16_t		TextureCoordinate[2];	// DXGI_FORMAT_R16G16_FLOAT
+};
+
+// Maps compressed positions back to object space: position = compressed * Scale + Offset.  The
+// members are Vector4s so that they can be copied straight into a constant buffer.
+struct VertexQuantisation
+{
+	Vector4			Scale{ 1.0f, 1.0f, 1.0f, 0.0f };
+	Vector4			Offset{ 0.0f, 0.0f, 0.0f, 0.0f };
+};
+
+// Encodes vertices in compressed formats that the input assembler can expand.
+//
+// Positions are stored as 16 bit normalised integers relative to the bounds of the mesh, so
+// the error is at most 1/65534 of the size of the bounds on each axis.  Normals are mapped
+// onto an octahedron, which is unfolded into a square (Cigolle et al., "A Survey of
+// Efficient Representations for Independent Unit Vectors", 2014), and the two coordinates
+// stored as 16 bit normalised integers, which keeps the direction to within a few thousandths
+// of a degree.  Texture coordinates are stored as half floats.
+//
+// Either vertex structure is halved in size.  The vertex shaders decode the positions with
+// the VertexQuantisation of the mesh and unfold the normals when they are compiled with
+// COMPRESSED_VERTICES defined.
+//
+// As everywhere else, a vertex is taken to start with its position, followed by its normal
+// and then (if the stride allows) its texture coordinates.
+
+class VertexCompression
+{
+public:
+	// The stride of the compressed version of vertices with the given stride: GeoStruct and ObjectVertexStruct can
+	// be compressed, and 0 is returned for anything else
+	static size_t GetCompressedStride(size_t stride);
+
+	// The quantisation that covers the bounds as exactly as possible.  Flat bounds are given a scale of 1 on the
+	// flat axis so that the positions can still be decoded.
+	static VertexQuantisation GetQuantisation(const AxisAlignedBox& bounds);
+
+	// Compress count vertices of the given stride (which GetCompressedStride must accept).  compressed must have
+	// room for count vertices of the compressed stride.
+	static void Compress(const void* vertices, size_t count, size_t stride, const VertexQuantisation& quantisation, void* compressed);
+	// The reverse of Compress, writing vertices of the given (uncompressed) stride
+	static void Decompress(const void* compressed, size_t count, size_t stride, const VertexQuantisation& quantisation, void* vertices);
+
+	// The conversions used by Compress and Decompress.  Each decode matches the way the input assembler
+	// expands the format.
+	static int16_t EncodeSnorm16(float value);
+	static float DecodeSnorm16(int16_t value);
+	static void EncodeOctahedral(const Vector3& normal, int16_t encoded[2]);
+	static Vector3 DecodeOctahedral(const int16_t encoded[2]);
+	static uint16_t EncodeHalf(float value);
+	static float DecodeHalf(uint16_t value);
+};
@@ -0,0 +1,18 @@
+// Decodes the compressed vertex formats written by VertexCompression (see VertexCompression.h).
+// Included by the shaders, which use it when they are compiled with COMPRESSED_VERTICES defined.
+
+// Positions are 16 bit normalised integers relative to the bounds of the mesh
+float3 DecodePosition(float4 position, float4 scale, float4 offset)
+{
+    return position.xyz * scale.xyz + offset.xyz;
+}
+
+// Normals are stored as a point on an octahedron that has been unfolded into a square.  The
+// corners of the square are folded back over to make the lower half.
+float3 DecodeNormal(float2 encoded)
+{
+    float3 normal = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float fold = saturate(-normal.z);
+    normal.xy += normal.xy >= 0.0f ? -fold : fold;
+    return normalize(normal);
+}
@@ -1,24 +1,24 @@
-//{{NO_DEPENDENCIES}}
-// Microsoft Visual C++ generated include file.
-// Used by DirectXApp.rc
-//
-#define IDC_MYICON                      2
-#define IDS_APP_TITLE                   103
-#define IDI_DirectXApp                  107
-#define IDI_SMALL                       108
-#define IDC_DirectXApp                  109
-#define IDR_MAINFRAME                   128
-#define IDB_BITMAP1                     129
-#define IDC_STATIC                      -1
-
-// Next default values for new objects
-// 
-#ifdef APSTUDIO_INVOKED
-#ifndef APSTUDIO_READONLY_SYMBOLS
-#define _APS_NO_MFC                     1
-#define _APS_NEXT_RESOURCE_VALUE        130
-#define _APS_NEXT_COMMAND_VALUE         32771
-#define _APS_NEXT_CONTROL_VALUE         1000
-#define _APS_NEXT_SYMED_VALUE           110
-#endif
-#endif
+//{{NO_DEPENDENCIES}}
+// Microsoft Visual C++ generated include file.
+// Used by DirectXApp.rc
+//
+#define IDC_MYICON                      2
+#define IDS_APP_TITLE                   103
+#define IDI_DirectXApp                  107
+#define IDI_SMALL                       108
+#define IDC_DirectXApp                  109
+#define IDR_MAINFRAME                   128
+#define IDB_BITMAP1                     129
+#define IDC_STATIC                      -1
+
+// Next default values for new objects
+// 
+#ifdef APSTUDIO_INVOKED
+#ifndef APSTUDIO_READONLY_SYMBOLS
+#define _APS_NO_MFC                     1
+#define _APS_NEXT_RESOURCE_VALUE        130
+#define _APS_NEXT_COMMAND_VALUE         32771
+#define _APS_NEXT_CONTROL_VALUE         1000
+#define _APS_NEXT_SYMED_VALUE           110
+#endif
+#endif
@@ -1,67 +1,119 @@
-cbuffer ConstantBuffer
-{
-    matrix worldViewProjection;
-    matrix world;
-    float4 materialColour;
-    float4 ambientLightColour;
-    float4 DirectionalLightColour;
-    float4 DirectionalLightVector;
-    float4 specColour;
-
-    float SpecularPower;
-    float3 pad;
-};
-
-
-struct VertexIn
-{
-    float3 InputPosition : POSITION;
-    float3 Normal : NORMAL;
-};
-
-struct VertexOut
-{
-    float4 OutputPosition : SV_POSITION;
-    float4 Colour : COLOR;
-    float3 Normal : TEXCOORD0;
-    float3 WorldPosition : TEXCOORD1;
-};
-
-// Add these lines to the existing Vertex Shader
-VertexOut VS(VertexIn vin)
-{
-    VertexOut vout;
-
-    // Transform to homogeneous clip space.
-    vout.OutputPosition = mul(worldViewProjection, float4(vin.InputPosition, 1.0f));
-
-    // Transform normal to world space as float3 using the world matrix
-    vout.Normal = mul((float3x3) world, vin.Normal);
-    vout.WorldPosition = mul(world, float4(vin.InputPosition, 1.0f)).xyz;
-
-    // Multiply by the material colour
-    vout.Colour = saturate(materialColour);
-    return vout;
-}
-
-float4 PS(VertexOut pin) : SV_Target
-{
-    //return pin.Colour;
-    float3 eyePosition = float3(20.0f, 20.0f, -90.0f); //more control
-    float3 toEye = normalize(eyePosition - pin.WorldPosition);
-
-    float3 worldNormal = normalize(pin.Normal);
-    float diffuseFactor = max(dot(worldNormal, -normalize(DirectionalLightVector.xyz)), 0.0);
-    diffuseFactor = saturate(diffuseFactor);
-
-    float3 lightDir = normalize(DirectionalLightVector.xyz);
-    float3 reflected = reflect(-toEye, worldNormal);
-    float specularFactor = pow(saturate(dot(reflected, toEye)), SpecularPower);
-
-    // Incorporate specColour into the final color calculation
-    float4 totalLight = saturate(ambientLightColour + diffuseFactor * DirectionalLightColour + specularFactor * specColour);
-
-    float4 finalColor = saturate(totalLight * materialColour);
-
-    return finalColor * pin.Colour; 
+#include "Constants.hlsli"
+
+#ifdef COMPRESSED_VERTICES
+#include "VertexDecode.hlsli"
+
+struct VertexIn
+{
+    float4 InputPosition : POSITION;
+    float2 Normal : NORMAL;
+};
+#else
+struct VertexIn
+{
+    float3 InputPosition : POSITION;
+    float3 Normal : NORMAL;
+};
+#endif
+
+// The position and normal in object space
+void GetVertex(VertexIn vin, out float3 position, out float3 normal)
+{
+#ifdef COMPRESSED_VERTICES
+    position = DecodePosition(vin.InputPosition, positionScale, positionOffset);
+    normal = DecodeNormal(vin.Normal);
+#else
+    position = vin.InputPosition;
+    normal = vin.Normal;
+#endif
+}
+
+#ifdef INSTANCED
+// When compiled with INSTANCED defined, the world transformation and material colour come
+// from the instance buffer rather than the constant buffers.
+struct InstanceIn
+{
+    float4 World0 : WORLD0;
+    float4 World1 : WORLD1;
+    float4 World2 : WORLD2;
+    float4 World3 : WORLD3;
+    float4 MaterialColour : INSTANCECOLOUR;
+};
+#endif
+
+struct VertexOut
+{
+    float4 OutputPosition : SV_POSITION;
+    float4 Colour : COLOR;
+    float3 Normal : TEXCOORD0;
+    float3 WorldPosition : TEXCOORD1;
+};
+
+#ifdef INSTANCED
+VertexOut VS(VertexIn vin, InstanceIn instance)
+{
+    VertexOut vout;
+
+    // The instance data holds the rows of the world matrix in the same order as it is stored on the CPU
+    float4x4 instanceWorld = float4x4(instance.World0, instance.World1, instance.World2, instance.World3);
+    float3 position, normal;
+    GetVertex(vin, position, normal);
+    float4 worldPosition = mul(float4(position, 1.0f), instanceWorld);
+
+    // Transform to homogeneous clip space.
+    vout.OutputPosition = mul(viewProjection, worldPosition);
+
+    // Transform normal to world space as float3 using the world matrix
+    vout.Normal = mul(normal, (float3x3) instanceWorld);
+    vout.WorldPosition = worldPosition.xyz;
+
+    // Multiply by the material colour
+    vout.Colour = saturate(instance.MaterialColour);
+    return vout;
+}
+#else
+// Add these lines to the existing Vertex Shader
+VertexOut VS(VertexIn vin)
+{
+    VertexOut vout;
+    float3 position, normal;
+    GetVertex(vin, position, normal);
+
+    // Transform to homogeneous clip space.
+    vout.OutputPosition = mul(worldViewProjection, float4(position, 1.0f));
+
+    // Transform normal to world space as float3 using the world matrix
+    vout.Normal = mul((float3x3) world, normal);
+    vout.WorldPosition = mul(world, float4(position, 1.0f)).xyz;
+
+    // Multiply by the material colour
+    vout.Colour = saturate(materialColour);
+    return vout;
+}
+#endif
+
+float4 PS(VertexOut pin) : SV_Target
+{
+    //return pin.Colour;
+    float3 toEye = normalize(eyePosition.xyz - pin.WorldPosition);
+
+    float3 worldNormal = normalize(pin.Normal);
+    float diffuseFactor = max(dot(worldNormal, -normalize(DirectionalLightVector.xyz)), 0.0);
+    diffuseFactor = saturate(diffuseFactor);
+
+    float3 lightDir = normalize(DirectionalLightVector.xyz);
+    float3 reflected = reflect(-toEye, worldNormal);
+    float specularFactor = pow(saturate(dot(reflected, toEye)), SpecularPower);
+
+    // Incorporate specColour into the final color calculation
+    float4 totalLight = saturate(ambientLightColour + diffuseFactor * DirectionalLightColour + specularFactor * specColour);
+
+#ifdef INSTANCED
+    // The material colour is per instance, and has already been saturated by the vertex shader
+    float4 finalColor = saturate(totalLight * pin.Colour);
+#else
+    float4 finalColor = saturate(totalLight * materialColour);
+#endif
+
+    return finalColor * pin.Colour; 
 }
\ No newline at end of file